@@ -0,0 +1,87 @@
+#pragma once
+#include "RadFiled3D/VoxelBuffer.hpp"
+#include "RadFiled3D/helpers/SIMDKernels.hpp"
+#include <memory>
+#include <string>
+
+
+namespace RadFiled3D {
+	/** A lazily evaluated element-wise expression over voxel layers, e.g. (a * w1 + b * w2) / n.
+	* Combining expressions by the arithmetic operators only builds the expression tree. No layer is touched until the expression is evaluated into a destination layer.
+	* The evaluation streams all operand layers once and computes the whole expression tile by tile in a small scratch buffer, which stays in the cache,
+	* instead of creating a temporary copy of a whole buffer per operator.
+	*
+	* Operands are either a named layer of a buffer, all layers of a buffer, which resolve to the layer of the same name as the destination layer, or constants.
+	* The expression is computed in double precision, if the destination or any operand layer stores doubles or 32-bit or 64-bit integers, and in single precision otherwise.
+	* Multi component layers such as vec3 or histogram layers are computed component-wise. Operand layers must either have as many components per voxel as the destination layer or a single one, which is then used for all components.
+	* The operand buffers must be kept alive until the expression is evaluated. Evaluation uses up to VoxelBuffer::get_worker_count() threads.
+	*/
+	class LayerExpression {
+	public:
+		struct Node;
+
+		/** Creates a constant expression
+		* @param value The value of the constant
+		*/
+		LayerExpression(double value);
+
+		/** Creates an expression of a single layer of a buffer
+		* @param buffer The buffer, which holds the layer
+		* @param layer_name The name of the layer
+		*/
+		static LayerExpression layer(const VoxelBuffer& buffer, const std::string& layer_name);
+
+		/** Creates an expression of all layers of a buffer. It resolves to the layer of the same name as the destination layer during evaluation.
+		* @param buffer The buffer
+		*/
+		static LayerExpression buffer(const VoxelBuffer& buffer);
+
+		/** Creates a constant expression
+		* @param value The value of the constant
+		*/
+		static LayerExpression constant(double value);
+
+		/** Divides like operator/, but yields 0 wherever the divisor is 0, as the division of histogram layers does
+		* @param dividend The dividend
+		* @param divisor The divisor
+		*/
+		static LayerExpression divide_or_zero(const LayerExpression& dividend, const LayerExpression& divisor);
+
+		/** Evaluates the expression into a layer
+		* @param target The buffer, which holds the destination layer. May be an operand of the expression as well.
+		* @param layer_name The name of the destination layer
+		* @throws VoxelBufferException if a layer does not exist, the voxel counts of the buffers differ or the components of a layer do not match the destination
+		*/
+		void evaluate(VoxelBuffer& target, const std::string& layer_name) const;
+
+		/** Evaluates the expression into all layers of a buffer.
+		* All layers are validated before the first one is written.
+		* The layers are evaluated one after another, so named layers of the target, which are operands of the expression, are read with the values already written to them.
+		* @param target The buffer, which holds the destination layers. May be an operand of the expression as well.
+		* @throws VoxelBufferException if a layer does not exist, the voxel counts of the buffers differ or the components of a layer do not match the destination
+		*/
+		void evaluate(VoxelBuffer& target) const;
+
+		/** Returns a readable representation of the expression, e.g. ((doserate * 2) + <buffer>) */
+		std::string to_string() const;
+
+		friend LayerExpression operator +(const LayerExpression& lhs, const LayerExpression& rhs);
+		friend LayerExpression operator -(const LayerExpression& lhs, const LayerExpression& rhs);
+		friend LayerExpression operator *(const LayerExpression& lhs, const LayerExpression& rhs);
+		friend LayerExpression operator /(const LayerExpression& lhs, const LayerExpression& rhs);
+		friend LayerExpression operator -(const LayerExpression& operand);
+
+	protected:
+		std::shared_ptr<const Node> root;
+
+		LayerExpression(std::shared_ptr<const Node> root);
+
+		static LayerExpression combine(Kernels::Operation op, const LayerExpression& lhs, const LayerExpression& rhs);
+	};
+
+	LayerExpression operator +(const LayerExpression& lhs, const LayerExpression& rhs);
+	LayerExpression operator -(const LayerExpression& lhs, const LayerExpression& rhs);
+	LayerExpression operator *(const LayerExpression& lhs, const LayerExpression& rhs);
+	LayerExpression operator /(const LayerExpression& lhs, const LayerExpression& rhs);
+	LayerExpression operator -(const LayerExpression& operand);
+}
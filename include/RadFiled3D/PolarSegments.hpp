@@ -131,7 +131,7 @@ namespace RadFiled3D
 			if (found == this->layers.end())
 				throw std::runtime_error("Layer: '" + layer_name + "' not found");
 
-			return *(VoxelT*)(found->second.voxels + idx * found->second.bytes_per_voxel);
+			return found->second.get_voxel_flat<VoxelT>(idx);
 		};
 
 		/** get the number of segments */
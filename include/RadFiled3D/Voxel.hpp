@@ -70,7 +70,8 @@ namespace RadFiled3D {
 		*/
 		virtual void init_from_header(const void* header) = 0;
 
-		//virtual ~IVoxel() {}
+		/** Voxels of layers are views, which are never destroyed, but voxels handed out by accessors are owning and deleted by the caller through this interface */
+		virtual ~IVoxel() {}
 	};
 
 	/** A ScalarVoxel is a Voxel that contains a single scalar value. It is a simple wrapper around a single value, and is used to
@@ -3,9 +3,14 @@
 #include <map>
 #include <cstring>
 #include "RadFiled3D/Voxel.hpp"
+#include "RadFiled3D/helpers/LayerAllocator.hpp"
+#include "RadFiled3D/helpers/SIMDKernels.hpp"
 #include <stdexcept>
 #include <functional>
 #include <algorithm>
+#include <memory>
+#include <type_traits>
+#include <atomic>
 
 
 namespace RadFiled3D {
@@ -16,6 +21,7 @@ namespace RadFiled3D {
 
 	/** A VoxelLayer is a layer of voxels in a VoxelBuffer
 	* A VoxelLayer contains a buffer of voxels and a buffer of data values.
+	* Compact layers do not hold a voxel object per voxel, but only a single prototype voxel. Their voxels are handed out as views onto the data buffer, which are created on demand.
 	* It is NOT intendet to be used directly, but rather through the VoxelBuffer class.
 	* @see VoxelBuffer
 	*/
@@ -24,28 +30,125 @@ namespace RadFiled3D {
 		friend class PolarSegmentsBuffer;
 		friend class VoxelGridBuffer;
 
+	public:
+		/** The number of bytes of the largest voxel object a compact layer can hold a prototype of */
+		static constexpr size_t MAX_VOXEL_OBJECT_BYTES = 64;
+		/** The number of voxel objects of a compact layer, which are created at once, when one of them is first accessed by reference.
+		* Use get_voxel_view_flat to access voxels of compact layers without creating voxel objects.
+		*/
+		static constexpr size_t VOXEL_PAGE_SIZE = 1024;
+
 	protected:
 		size_t voxel_count;
+		/** The voxel objects of the layer. nullptr for compact layers. */
 		char* voxels;
 		char* data;
 		std::string unit;
 		size_t bytes_per_voxel;
 		size_t bytes_per_data_element;
+		/** The number of bytes of the data of a single voxel */
+		size_t bytes_per_voxel_data = 0;
 		float statistical_error = 0.f;
 		bool shall_free_buffers;
+		/** A copy of the voxel object all views of a compact layer are created from. Its data pointer is not used. */
+		alignas(16) char prototype[MAX_VOXEL_OBJECT_BYTES];
+		static std::atomic<bool> compact_by_default;
+		/** The pages of voxel objects of a compact layer, which were accessed by reference */
+		struct VoxelPages;
+		/** The voxel objects of a compact layer accessed by reference so far. nullptr for layers, which are not compact. */
+		std::shared_ptr<VoxelPages> voxel_pages;
+		/** Keeps an externally owned data buffer alive, e.g. a memory mapped file the layer is a view onto.
+		* If set, the data buffer will not be deleted by free_buffers, only the reference to its owner is dropped.
+		*/
+		std::shared_ptr<void> data_owner;
+		/** The allocator the data buffer was obtained from. If nullptr, the data buffer was allocated by new[]. */
+		std::shared_ptr<ILayerAllocator> data_allocator;
+		/** The allocator the voxel objects were obtained from. If nullptr, the voxel objects were allocated by new[]. */
+		std::shared_ptr<ILayerAllocator> voxel_allocator;
 
 		/** Destructor of the layer data buffers.
 		* Will NOT be called by the VoxelBuffer destructor by default. Set shall_free_buffers to true to enable this.
 		*/
 		void free_buffers() noexcept;
 
+		/** Returns the voxel objects to their allocator, if any */
+		void free_voxels() noexcept;
+
+		/** Creates a copy of the layer, which owns a copy of the data buffer obtained from the default allocator.
+		* The copy is compact, if this layer is compact.
+		*/
+		VoxelLayer deep_copy() const;
+
+		/** Returns the voxel object of a voxel of a compact layer, which stays valid as long as the layer.
+		* Creates the page of voxel objects the voxel belongs to, if none of them was accessed before.
+		*/
+		IVoxel* get_paged_voxel(size_t idx) const;
+
 	public:
 		VoxelLayer();
 		VoxelLayer(size_t bytes_per_voxel, size_t bytes_per_data_element, char* voxels, char* data, const std::string& unit, float statistical_error, size_t voxel_count, bool shall_free_buffers = false);
+
+		/** Constructs a layer onto a data buffer from a template voxel.
+		* Creates a voxel object per voxel, unless compact layers are created by default.
+		* @param voxel_template The template voxel, which defines the type of the voxels
+		* @param bytes_per_data_element The number of bytes of a single data element of the voxels
+		* @param data The data buffer of the layer
+		* @param unit The unit of the layer
+		* @param statistical_error The statistical error of the layer
+		* @param voxel_count The number of voxels in the layer
+		* @param shall_free_buffers If true, the buffers will be freed by the destructor
+		* @throws VoxelBufferException if the voxel object of the template is larger than MAX_VOXEL_OBJECT_BYTES
+		*/
+		VoxelLayer(const IVoxel& voxel_template, size_t bytes_per_data_element, char* data, const std::string& unit, float statistical_error, size_t voxel_count, bool shall_free_buffers = false);
+
+		/** Constructs a layer onto a data buffer from a template voxel
+		* @param compact If true, no voxel objects are created and the voxels are handed out as views
+		* @see VoxelLayer(const IVoxel&, size_t, char*, const std::string&, float, size_t, bool)
+		*/
+		VoxelLayer(const IVoxel& voxel_template, size_t bytes_per_data_element, char* data, const std::string& unit, float statistical_error, size_t voxel_count, bool shall_free_buffers, bool compact);
 		~VoxelLayer();
 
+		/** Sets if layers, which are created from now on, are compact.
+		* Layers of a single voxel always keep their voxel object, as there is nothing to save.
+		* Default is false
+		* @param compact True to create compact layers
+		*/
+		static void set_compact_by_default(bool compact);
+
+		/** Checks if layers, which are created from now on, are compact
+		* @return True if compact layers are created
+		*/
+		static bool is_compact_by_default();
+
+		/** Drops the voxel objects of the layer and only keeps a single prototype voxel.
+		* All references to voxels of the layer become invalid. Voxel objects are only created again for pages of voxels accessed by reference.
+		*/
+		void compact();
+
+		/** Checks if the layer is compact
+		* @return True if the layer holds no voxel object per voxel
+		*/
+		inline bool is_compact() const {
+			return this->voxels == nullptr && this->bytes_per_voxel > 0;
+		}
+
+		/** Returns a voxel object, which describes the type of the voxels of the layer. Its data must not be accessed.
+		* @return The first voxel object or the prototype of compact layers
+		*/
+		inline const IVoxel* get_prototype() const {
+			return (this->voxels != nullptr) ? (const IVoxel*)this->voxels : (const IVoxel*)this->prototype;
+		}
+
+		/** Accesses a voxel by its flat index.
+		* For compact layers, the voxel objects of the page of VOXEL_PAGE_SIZE voxels the voxel belongs to are created on first access.
+		* Use get_voxel_view_flat for a view, which does not create voxel objects.
+		* @param idx The flat index of the voxel
+		* @return A pointer to the voxel
+		*/
 		inline IVoxel* get_voxel_flat_raw(size_t idx) const {
-			return (IVoxel*)(this->voxels + idx * this->bytes_per_voxel);
+			if (this->voxels != nullptr)
+				return (IVoxel*)(this->voxels + idx * this->bytes_per_voxel);
+			return this->get_paged_voxel(idx);
 		}
 
 		/** Create a new VoxelLayer with a given number of voxels and a statistical error
@@ -58,16 +161,13 @@ namespace RadFiled3D {
 		*/
 		template<typename dtype = float, class VoxelT = ScalarVoxel<dtype>>
 		static VoxelLayer* Construct(const std::string& unit, size_t voxel_count, float statistical_error, const dtype& initial_voxel_data, bool shall_free_buffers = false) {
-			VoxelT* voxels = new VoxelT[voxel_count];
-			dtype* data_buffer = new dtype[voxel_count];
-
+			std::shared_ptr<ILayerAllocator> allocator = ILayerAllocator::get_default();
+			dtype* data_buffer = (dtype*)allocator->allocate(voxel_count * sizeof(dtype));
 			std::fill(data_buffer, data_buffer + voxel_count, initial_voxel_data);
-			std::fill(voxels, voxels + voxel_count, VoxelT(nullptr));
-			for (size_t i = 0; i < voxel_count; i++) {
-				voxels[i].set_data(data_buffer + i);
-			}
 
-			return new VoxelLayer(sizeof(VoxelT), sizeof(dtype), (char*)voxels, (char*)data_buffer, unit, statistical_error, voxel_count, shall_free_buffers);
+			VoxelLayer* layer = new VoxelLayer(VoxelT(nullptr), sizeof(dtype), (char*)data_buffer, unit, statistical_error, voxel_count, shall_free_buffers);
+			layer->data_allocator = allocator;
+			return layer;
 		}
 
 		/** Create a new VoxelLayer with a given number of voxels and a statistical error from a template voxel instance
@@ -80,16 +180,12 @@ namespace RadFiled3D {
 		*/
 		template<typename dtype = float, class VoxelT = ScalarVoxel<dtype>>
 		static VoxelLayer* ConstructRaw(const std::string& unit, size_t voxel_count, float statistical_error, const VoxelT& voxel_template, bool shall_free_buffers = false) {
-			VoxelT* voxels = new VoxelT[voxel_count];
-			std::fill(voxels, voxels + voxel_count, voxel_template);
-			size_t voxel_size = voxels[0].get_bytes();
-			size_t elements_per_voxel = voxel_size / sizeof(dtype);
-			dtype* data_buffer = new dtype[elements_per_voxel * voxel_count];
-			for (size_t i = 0; i < voxel_count; i++) {
-				voxels[i].set_data(((char*)data_buffer) + i * voxel_size);
-			}
+			std::shared_ptr<ILayerAllocator> allocator = ILayerAllocator::get_default();
+			char* data_buffer = allocator->allocate(voxel_template.get_bytes() * voxel_count);
 
-			return new VoxelLayer(sizeof(VoxelT), sizeof(dtype), (char*)voxels, (char*)data_buffer, unit, statistical_error, voxel_count, shall_free_buffers);
+			VoxelLayer* layer = new VoxelLayer(voxel_template, sizeof(dtype), data_buffer, unit, statistical_error, voxel_count, shall_free_buffers);
+			layer->data_allocator = allocator;
+			return layer;
 		}
 
 		/** Create a new VoxelLayer with a given number of voxels and a statistical error from a template voxel instance and a data buffer
@@ -103,29 +199,65 @@ namespace RadFiled3D {
 		*/
 		template<typename dtype = float, class VoxelT = ScalarVoxel<dtype>>
 		static VoxelLayer* ConstructFromBufferRaw(const std::string& unit, size_t voxel_count, float statistical_error, const char* src_data_buffer, bool shall_free_buffers = false, const VoxelT& voxel_template = VoxelT()) {
-			VoxelT* voxels = new VoxelT[voxel_count];
-			std::fill(voxels, voxels + voxel_count, voxel_template);
-			size_t voxel_size = voxels[0].get_bytes();
-			size_t elements_per_voxel = voxel_size / sizeof(dtype);
-			dtype* data_buffer = new dtype[elements_per_voxel * voxel_count];
-			std::memcpy(data_buffer, src_data_buffer, elements_per_voxel * voxel_count * sizeof(dtype));
-			for (size_t i = 0; i < voxel_count; i++) {
-				voxels[i].set_data(((char*)data_buffer) + i * voxel_size);
-			}
+			std::shared_ptr<ILayerAllocator> allocator = ILayerAllocator::get_default();
+			char* data_buffer = allocator->allocate(voxel_template.get_bytes() * voxel_count);
+			std::memcpy(data_buffer, src_data_buffer, voxel_template.get_bytes() * voxel_count);
 
-			return new VoxelLayer(sizeof(VoxelT), sizeof(dtype), (char*)voxels, (char*)data_buffer, unit, statistical_error, voxel_count, shall_free_buffers);
+			VoxelLayer* layer = new VoxelLayer(voxel_template, sizeof(dtype), data_buffer, unit, statistical_error, voxel_count, shall_free_buffers);
+			layer->data_allocator = allocator;
+			return layer;
+		}
+
+		/** Create a new VoxelLayer as a view onto an externally owned data buffer without copying it.
+		* Only the voxel objects are allocated, if any, the data buffer is referenced directly and kept alive by the data owner.
+		* @param unit The unit of the layer
+		* @param voxel_count The number of voxels in the layer
+		* @param statistical_error The statistical error of the layer
+		* @param data_buffer The data buffer to reference. Must be suitably aligned for dtype.
+		* @param data_owner The owner of the data buffer, e.g. a memory mapped file. Will be kept alive as long as the layer exists.
+		* @param shall_free_buffers If true, the voxel buffer will be freed by the destructor
+		* @param voxel_template The template voxel to use for each voxel in the layer
+		* @return A pointer to the new VoxelLayer
+		*/
+		template<typename dtype = float, class VoxelT = ScalarVoxel<dtype>>
+		static VoxelLayer* ConstructView(const std::string& unit, size_t voxel_count, float statistical_error, char* data_buffer, std::shared_ptr<void> data_owner, bool shall_free_buffers = false, const VoxelT& voxel_template = VoxelT()) {
+			VoxelLayer* layer = new VoxelLayer(voxel_template, sizeof(dtype), data_buffer, unit, statistical_error, voxel_count, shall_free_buffers);
+			layer->data_owner = data_owner;
+			return layer;
+		}
+
+		/** Checks if the layer is a view onto an externally owned data buffer
+		* @return True if the data buffer is not owned by the layer
+		*/
+		inline bool is_view() const {
+			return this->data_owner != nullptr;
 		}
 
 
 		/** Accesses a voxel in a layer by its flat index
+		* The reference stays valid as long as the layer, also for compact layers, whose voxel objects are created page by page on first access.
 		* @param idx The flat index of the voxel
 		* @return A reference to the voxel
+		* @see get_voxel_view_flat
 		*/
 		template<class VoxelT = IVoxel>
 		VoxelT& get_voxel_flat(size_t idx) const {
 			return *(VoxelT*)this->get_voxel_flat_raw(idx);
 		};
 
+		/** Creates a voxel object onto a voxel in a layer by its flat index.
+		* The view stays valid as long as the data buffer of the layer. Other than get_voxel_flat, it never creates voxel objects of compact layers.
+		* @param idx The flat index of the voxel
+		* @return A view onto the voxel
+		*/
+		template<class VoxelT>
+		VoxelT get_voxel_view_flat(size_t idx) const {
+			static_assert(!std::is_abstract_v<VoxelT>, "Views are returned by value and need a concrete voxel type");
+			VoxelT view(*(const VoxelT*)this->get_prototype());
+			view.set_data((void*)(this->data + idx * this->bytes_per_voxel_data));
+			return view;
+		};
+
 		const std::string get_unit() const {
 			return this->unit;
 		}
@@ -149,13 +281,42 @@ namespace RadFiled3D {
 		const size_t get_bytes_per_voxel() const {
 			return this->bytes_per_voxel;
 		}
+
+		/** Returns the number of bytes of the data of a single voxel */
+		size_t get_bytes_per_voxel_data() const {
+			return this->bytes_per_voxel_data;
+		}
 	};
 
+	class LayerExpression;
+	namespace Storage {
+		class ExporterHelpers;
+	}
+
 	class VoxelBuffer {
+		friend class LayerExpression;
+		friend class Storage::ExporterHelpers;
+
 	protected:
 		std::map<std::string, VoxelLayer> layers;
 		const size_t voxel_count;
+		static std::atomic<size_t> worker_count;
+
+		/** Splits a loop over the voxels of a layer into chunks of about CHUNK_BYTES and runs them on up to get_worker_count() threads, including the calling thread.
+		* Each voxel is processed by exactly one call of the body, so element-wise operations yield the same result for any number of threads.
+		* Small loops run on the calling thread only. The first exception thrown by the body is rethrown after all threads finished.
+		* @param count The number of voxels
+		* @param bytes_per_voxel The number of bytes processed per voxel, used to size the chunks
+		* @param body The loop body, which processes the voxels [begin, end)
+		*/
+		static void for_each_chunk(size_t count, size_t bytes_per_voxel, const std::function<void(size_t begin, size_t end)>& body);
+
 	public:
+		/** The number of bytes processed as one chunk by a thread, which is sized to stay within the L2 cache */
+		static constexpr size_t CHUNK_BYTES = 256 * 1024;
+		/** The minimum number of bytes a loop must process per thread in order to spawn an additional thread */
+		static constexpr size_t MIN_BYTES_PER_WORKER = 4 * CHUNK_BYTES;
+
 		/** Construct a voxel buffer with a given number of voxels
 		* @param voxel_count The number of voxels in the buffer
 		*/
@@ -164,6 +325,27 @@ namespace RadFiled3D {
 		/** Destructor */
 		~VoxelBuffer();
 
+		/** Sets the number of threads, which the arithmetic operators, clear_layer, reinitialize_layer, merge_data_buffer and merge_voxel_buffer of all buffers use.
+		* The results do not depend on the number of threads. Merge functions must be safe to be called concurrently, if more than one thread is used.
+		* @param worker_count The number of threads. 0 uses one thread per hardware thread. Default is 1, which runs all loops on the calling thread.
+		*/
+		static void set_worker_count(size_t worker_count);
+
+		/** Returns the number of threads, which are used by the layer operations
+		* @return The number of threads, resolved to the number of hardware threads if set to 0
+		*/
+		static size_t get_worker_count();
+
+		/** Runs a loop body for each index in [0, count) on up to the given number of threads, including the calling thread.
+		* Each thread takes the next index that is not yet processed, so the indices are processed in no particular order.
+		* Once the body threw, no further indices are started. The first exception is rethrown after all threads finished.
+		* The threads are started by each call and joined before it returns.
+		* @param count The number of indices
+		* @param workers The maximum number of threads. At most count threads are used and 0 or 1 runs the loop on the calling thread.
+		* @param body The loop body, which processes a single index. Called concurrently, if more than one thread is used.
+		*/
+		static void parallel_for(size_t count, size_t workers, const std::function<void(size_t index)>& body);
+
 		/** Adds a layer to the voxel buffer.
 		* @param name The name of the layer
 		* @param initial_voxel_data The initial value to assign to each voxel of the new layer
@@ -180,6 +362,14 @@ namespace RadFiled3D {
 			delete layer;
 		}
 
+		/** Adds an already constructed layer to the voxel buffer.
+		* The buffer takes over the ownership of the layers buffers and deletes the passed layer object.
+		* @param name The name of the layer
+		* @param layer The layer to add. Must hold the same number of voxels as the buffer.
+		* @throws VoxelBufferException if the layer holds a different number of voxels or a layer of the same name exists. The passed layer is freed in either case.
+		*/
+		void insert_layer(const std::string& name, VoxelLayer* layer);
+
 		/** Tests if a layer exists in the buffer
 		* @param layer_name The name of the layer
 		* @return True if the layer exists, false otherwise
@@ -201,6 +391,20 @@ namespace RadFiled3D {
 			return found->second.get_voxel_flat<VoxelT>(idx);
 		};
 
+		/** Creates a view onto a voxel in a layer by its flat index, which stays valid as long as the layer
+		* @param layer_name The name of the layer
+		* @param idx The flat index of the voxel
+		* @return A view onto the voxel
+		* @see VoxelLayer::get_voxel_view_flat
+		*/
+		template<class VoxelT>
+		inline VoxelT get_voxel_view_flat(const std::string& layer_name, size_t idx) const {
+			auto found = this->layers.find(layer_name);
+			if (found == this->layers.end())
+				throw VoxelBufferException("Layer: '" + layer_name + "' not found");
+			return found->second.get_voxel_view_flat<VoxelT>(idx);
+		};
+
 		/** Accesses a layer in the buffer by its name
 		* @param layer_name The name of the layer
 		* @return A reference to the layer
@@ -230,7 +434,10 @@ namespace RadFiled3D {
 			auto found = this->layers.find(layer_name);
 			if (found == this->layers.end())
 				throw VoxelBufferException("Layer: '" + layer_name + "' not found");
-			std::fill((T*)found->second.data, ((T*)found->second.data) + this->voxel_count * elements_per_voxel, clear_value);
+			T* data = (T*)found->second.data;
+			VoxelBuffer::for_each_chunk(this->voxel_count, sizeof(T) * elements_per_voxel, [data, &clear_value, elements_per_voxel](size_t begin, size_t end) {
+				std::fill(data + begin * elements_per_voxel, data + end * elements_per_voxel, clear_value);
+			});
 		}
 
 		/** Adds a custom layer to the voxel buffer using a preconstructed voxel as a template for each Voxel.
@@ -243,28 +450,26 @@ namespace RadFiled3D {
 		template<class VoxelT, typename dtype>
 		void add_custom_layer(const std::string& name, const VoxelT& voxel_template, dtype initial_voxel_scalar_value, const std::string& unit = "") {
 			const size_t elements_per_voxel = voxel_template.get_bytes() / sizeof(dtype);
-			VoxelT* voxels = new VoxelT[this->voxel_count];
-			dtype* data_buffer = new dtype[this->voxel_count * elements_per_voxel];
+			std::shared_ptr<ILayerAllocator> allocator = ILayerAllocator::get_default();
+			dtype* data_buffer = (dtype*)allocator->allocate(this->voxel_count * voxel_template.get_bytes());
 
 			std::fill(data_buffer, data_buffer + this->voxel_count * elements_per_voxel, initial_voxel_scalar_value);
-			std::fill(voxels, voxels + this->voxel_count, voxel_template);
 
-			for (size_t i = 0; i < this->voxel_count; i++) {
-				voxels[i].set_data(data_buffer + i * elements_per_voxel);
-			}
-
-			this->layers.insert({
+			auto inserted = this->layers.insert({
 				name,
 				VoxelLayer(
-					sizeof(VoxelT),
+					voxel_template,
 					sizeof(dtype),
-					(char*)voxels,
 					(char*)data_buffer,
 					unit,
 					-1.f,
 					this->voxel_count
 				)
 			});
+			if (inserted.second)
+				inserted.first->second.data_allocator = allocator;
+			else
+				allocator->deallocate((char*)data_buffer, this->voxel_count * voxel_template.get_bytes());
 		}
 
 		/** Adds a custom layer to the voxel buffer using a preconstructed voxel as a template for each Voxel.
@@ -275,32 +480,28 @@ namespace RadFiled3D {
 		*/
 		void add_custom_layer_unsafe(const std::string& name, const IVoxel* voxel_template, const std::string& unit = "") {
 			const size_t data_bytes = voxel_template->get_bytes();
-			const size_t data_buffer_size = this->voxel_count * data_bytes;
-			const size_t vx_bytes = voxel_template->get_voxel_bytes();
-			const size_t voxel_buffer_size = this->voxel_count * vx_bytes;
 			const char* initial_data = (char*)voxel_template->get_raw();
 
-			char* voxels = new char[voxel_buffer_size];
-			char* data_buffer = new char[data_buffer_size];
-
-			for (size_t i = 0; i < this->voxel_count; i++) {
-				std::memcpy(voxels + i * vx_bytes, (void*)voxel_template, vx_bytes);
+			std::shared_ptr<ILayerAllocator> allocator = ILayerAllocator::get_default();
+			char* data_buffer = allocator->allocate(this->voxel_count * data_bytes);
+			for (size_t i = 0; i < this->voxel_count; i++)
 				std::memcpy(data_buffer + i * data_bytes, initial_data, data_bytes);
-				((IVoxel*)(voxels + i * vx_bytes))->set_data((void*)(data_buffer + i * data_bytes));
-			}
 
-			this->layers.insert({
+			auto inserted = this->layers.insert({
 				name,
 				VoxelLayer(
-					vx_bytes,
+					*voxel_template,
 					data_bytes,
-					voxels,
 					data_buffer,
 					unit,
 					-1.f,
 					this->voxel_count
 				)
 			});
+			if (inserted.second)
+				inserted.first->second.data_allocator = allocator;
+			else
+				allocator->deallocate(data_buffer, this->voxel_count * data_bytes);
 		}
 
 		/** Returns the pointer to the value data buffer of a layer
@@ -348,6 +549,11 @@ namespace RadFiled3D {
 			found->second.statistical_error = statistical_error;
 		}
 
+		/** Drops the voxel objects of all layers, so that their voxels are handed out as views
+		* @see VoxelLayer::compact
+		*/
+		void compact_layers();
+
 		/** Returns a list of the names of the layers in the buffer
 		* @return A list of the names of the layers in the buffer
 		*/
@@ -374,7 +580,10 @@ namespace RadFiled3D {
 			auto found = this->layers.find(layer_name);
 			if (found == this->layers.end())
 				throw VoxelBufferException("Layer: '" + layer_name + "' not found");
-			std::fill((dtype*)found->second.data, ((dtype*)found->second.data) + this->voxel_count, new_value);
+			dtype* data = (dtype*)found->second.data;
+			VoxelBuffer::for_each_chunk(this->voxel_count, sizeof(dtype), [data, &new_value](size_t begin, size_t end) {
+				std::fill(data + begin, data + end, new_value);
+			});
 		}
 
 		/** Merge two layers data buffers directly together using a custom merge function
@@ -398,9 +607,40 @@ namespace RadFiled3D {
 			dtype* this_data = (dtype*)found->second.data;
 			dtype* other_data = (dtype*)other_layer->second.data;
 
-			for (size_t i = 0; i < this->voxel_count; i++) {
-				this_data[i] = merge_function(this_data[i], other_data[i]);
-			}
+			VoxelBuffer::for_each_chunk(this->voxel_count, sizeof(dtype), [this_data, other_data, &merge_function](size_t begin, size_t end) {
+				for (size_t i = begin; i < end; i++) {
+					this_data[i] = merge_function(this_data[i], other_data[i]);
+				}
+			});
+		}
+
+		/** Merge two layers data buffers directly together using a kernel, which processes whole ranges of data elements at once.
+		* In contrast to merge_data_buffer, the kernel is called once per chunk of voxels instead of once per element, so it can be inlined and vectorized.
+		* @param layer_name The name of the layer to merge into
+		* @param other The other voxel buffer to merge with
+		* @param kernel The kernel (dtype* this_data, const dtype* other_data, size_t element_count) -> void. Called concurrently for disjoint ranges, if more than one thread is used.
+		* @tparam dtype The type of the data elements. Multi component voxels such as vec3 or histogram voxels are passed as flat arrays of their elements.
+		*/
+		template<typename dtype, typename KernelT>
+		void merge_data_chunks(const std::string& layer_name, const VoxelBuffer& other, const KernelT& kernel) {
+			auto found = this->layers.find(layer_name);
+			if (found == this->layers.end())
+				throw VoxelBufferException("Layer: '" + layer_name + "' not found");
+
+			auto other_layer = other.layers.find(layer_name);
+			if (other_layer == other.layers.end())
+				throw VoxelBufferException("Layer: '" + layer_name + "' not found in the other buffer");
+
+			if (found->second.bytes_per_voxel_data != other_layer->second.bytes_per_voxel_data || this->voxel_count != other.voxel_count)
+				throw VoxelBufferException("Layer: '" + layer_name + "' has different data sizes");
+
+			const size_t elements_per_voxel = found->second.bytes_per_voxel_data / sizeof(dtype);
+			dtype* this_data = (dtype*)found->second.data;
+			const dtype* other_data = (const dtype*)other_layer->second.data;
+
+			VoxelBuffer::for_each_chunk(this->voxel_count, found->second.bytes_per_voxel_data, [this_data, other_data, elements_per_voxel, &kernel](size_t begin, size_t end) {
+				kernel(this_data + begin * elements_per_voxel, other_data + begin * elements_per_voxel, (end - begin) * elements_per_voxel);
+			});
 		}
 
 		/** Merge layer voxels with a custom voxel type.
@@ -422,12 +662,17 @@ namespace RadFiled3D {
 			if (found->second.bytes_per_data_element != other_layer->second.bytes_per_data_element)
 				throw VoxelBufferException("Layer: '" + layer_name + "' has different data element sizes");
 
-			VoxelT* this_data = (VoxelT*)found->second.voxels;
-			VoxelT* other_data = (VoxelT*)other_layer->second.voxels;
-
-			for (size_t i = 0; i < this->voxel_count; i++) {
-				this_data[i] = merge_function(this_data[i], other_data[i]);
-			}
+			const VoxelLayer& this_layer = found->second;
+			const VoxelLayer& other_voxel_layer = other_layer->second;
+			VoxelBuffer::for_each_chunk(this->voxel_count, this_layer.bytes_per_voxel_data, [&this_layer, &other_voxel_layer, &merge_function](size_t begin, size_t end) {
+				for (size_t i = begin; i < end; i++) {
+					VoxelT this_voxel = this_layer.get_voxel_view_flat<VoxelT>(i);
+					const VoxelT merged = merge_function(this_voxel, other_voxel_layer.get_voxel_view_flat<VoxelT>(i));
+					// the merged voxel may be a view onto the data of the target voxel already
+					if (merged.get_raw() != this_voxel.get_raw())
+						std::memmove(this_voxel.get_raw(), merged.get_raw(), this_voxel.get_bytes());
+				}
+			});
 		}
 
 		/** Returns the type string of a layer
@@ -439,7 +684,7 @@ namespace RadFiled3D {
 			auto found = this->layers.find(layer_name);
 			if (found == this->layers.end())
 				throw VoxelBufferException("Layer: '" + layer_name + "' not found");
-			return ((IVoxel*)found->second.voxels)->get_type();
+			return found->second.get_prototype()->get_type();
 		}
 
 		/** Create a deep copy of the voxel buffer
@@ -456,5 +701,19 @@ namespace RadFiled3D {
 		VoxelBuffer& operator -=(const float& scalar);
 		VoxelBuffer& operator *=(const float& scalar);
 		VoxelBuffer& operator /=(const float& scalar);
+
+	protected:
+		/** Applies an operation to all layers of this buffer and the layers of the same name of another buffer
+		* @param other The buffer of the second operands
+		* @param op The operation to apply
+		* @throws std::runtime_error if the voxel counts, or the units or data types of any layers do not match
+		*/
+		void apply_operation(const VoxelBuffer& other, Kernels::Operation op);
+
+		/** Applies an operation with a scalar to all layers of this buffer
+		* @param scalar The second operand
+		* @param op The operation to apply
+		*/
+		void apply_operation(float scalar, Kernels::Operation op);
 	};
 };
\ No newline at end of file
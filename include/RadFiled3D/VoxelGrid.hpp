@@ -14,6 +14,13 @@ namespace RadFiled3D
 	public:
 		VoxelGrid(const glm::vec3& field_dimensions, const glm::vec3& voxel_dimensions, std::shared_ptr<VoxelLayer> layer = std::shared_ptr<VoxelLayer>(nullptr));
 
+		/** Create a grid from the number of voxels in each dimension instead of the dimensions of the field
+		* @param voxel_counts The number of voxels in each dimension
+		* @param voxel_dimensions The dimensions of the voxels
+		* @param layer The layer holding the voxels of the grid
+		*/
+		VoxelGrid(const glm::uvec3& voxel_counts, const glm::vec3& voxel_dimensions, std::shared_ptr<VoxelLayer> layer = std::shared_ptr<VoxelLayer>(nullptr));
+
 		/** Access a voxels flat index at the given quantized coordinates within the range (0, 0, 0) to (voxel_counts.x - 1, voxel_counts.y - 1, voxel_counts.z - 1)
 		* @param x The x coordinate of the voxel
 		* @param y The y coordinate of the voxel
@@ -87,6 +94,20 @@ namespace RadFiled3D
 			return this->layer->get_voxel_flat<VoxelT>(this->get_voxel_idx_by_coord(x, y, z));
 		};
 
+		/** Creates a view onto a voxel at the given quantized coordinates, which stays valid as long as the layer
+		* @param x The x coordinate of the voxel
+		* @param y The y coordinate of the voxel
+		* @param z The z coordinate of the voxel
+		* @return A view onto the voxel at the given coordinates
+		* @see VoxelLayer::get_voxel_view_flat
+		*/
+		template<class VoxelT>
+		inline VoxelT get_voxel_view(size_t x, size_t y, size_t z) const {
+			if (this->layer.get() == nullptr)
+				throw std::runtime_error("Layer not set");
+			return this->layer->get_voxel_view_flat<VoxelT>(this->get_voxel_idx(x, y, z));
+		};
+
 		/** Returns the dimensions of the voxels in the grid
 		* @return The dimensions of the voxels in the grid
 		*/
@@ -152,7 +173,23 @@ namespace RadFiled3D
 			auto found = this->layers.find(layer_name);
 			if (found == this->layers.end())
 				throw std::runtime_error("Layer: '" + layer_name + "' not found");
-			return *(VoxelT*)(found->second.voxels + this->get_voxel_idx(x, y, z) * found->second.bytes_per_voxel);
+			return found->second.get_voxel_flat<VoxelT>(this->get_voxel_idx(x, y, z));
+		};
+
+		/** Creates a view onto a voxel at the given quantized coordinates, which stays valid as long as the layer
+		* @param layer_name The name of the layer to access
+		* @param x The x coordinate of the voxel
+		* @param y The y coordinate of the voxel
+		* @param z The z coordinate of the voxel
+		* @return A view onto the voxel at the given coordinates
+		* @see VoxelLayer::get_voxel_view_flat
+		*/
+		template<class VoxelT>
+		inline VoxelT get_voxel_view(const std::string& layer_name, size_t x, size_t y, size_t z) const {
+			auto found = this->layers.find(layer_name);
+			if (found == this->layers.end())
+				throw std::runtime_error("Layer: '" + layer_name + "' not found");
+			return found->second.get_voxel_view_flat<VoxelT>(this->get_voxel_idx(x, y, z));
 		};
 
 		/** Access a voxel at the given spatial coordinates within the range (0, 0, 0) to (field_dimensions.x, field_dimensions.y, field_dimensions.z)
@@ -2,6 +2,7 @@
 #include <RadFiled3D/Voxel.hpp>
 #include <memory>
 #include <map>
+#include <mutex>
 #include <stdexcept>
 #include <string>
 
@@ -9,6 +10,7 @@ namespace RadFiled3D {
 	namespace Storage {
 		class FieldAccessor;
 	}
+	class BatchReader;
 }
 
 using namespace RadFiled3D;
@@ -28,12 +30,42 @@ namespace RadFiled3D::Dataset {
 
 	/** A collection of voxels organized by channels and layers.
 	* Returned by VoxelCollectionAccessor::access.
-	* Provides a way to extract a dense data buffer from a specific channel and layer.
+	* The voxels of each layer are stored in a single contiguous buffer, which is aligned to DATA_ALIGNMENT bytes.
 	*/
 	struct VoxelCollection {
+		/** The alignment of the buffer of each layer in bytes */
+		static constexpr size_t DATA_ALIGNMENT = 64;
+
 		struct Layer {
 			std::string name;
-			std::vector<std::shared_ptr<IVoxel>> voxels;
+			Typing::DType dtype = Typing::DType::Char;
+			size_t elements_per_voxel = 0;
+			size_t voxel_bytes = 0;
+			size_t voxel_count = 0;
+			/** The number of bins of histogram layers, 0 for all other layers */
+			size_t histogram_bins = 0;
+			/** The width of the bins of histogram layers, 0 for all other layers */
+			float histogram_bin_width = 0.f;
+			/** The data of all voxels of the layer in the order they were requested. Shared, so that views onto the buffer can keep it alive. */
+			std::shared_ptr<char> data;
+
+			/** Sets the voxel type of the layer and allocates the buffer for voxel_count voxels of that type
+			* @param dtype The data type of the voxels
+			* @param elements_per_voxel The number of elements of dtype per voxel
+			* @param voxel_header_data The header data of the voxels, which holds the histogram definition of histogram layers. May be nullptr.
+			*/
+			void allocate(Typing::DType dtype, size_t elements_per_voxel, const char* voxel_header_data);
+
+			/** Returns the number of bytes of the buffer */
+			inline size_t get_bytes() const {
+				return this->voxel_count * this->voxel_bytes;
+			}
+
+			/** Returns the buffer interpreted as elements of type T */
+			template<typename T>
+			inline T* get_data() const {
+				return reinterpret_cast<T*>(this->data.get());
+			}
 		};
 
 		struct Channel {
@@ -43,13 +75,15 @@ namespace RadFiled3D::Dataset {
 		std::map<std::string, Channel> channels;
 
 		/** Constructs a VoxelCollection with the specified channels and layers.
+		* The buffers of the layers are allocated by Layer::allocate, as soon as the type of their voxels is known.
 		* @param channels The names of the channels to include in the collection
 		* @param layers The names of the layers to include in each channel
 		* @param voxelCount The number of voxels in each layer
 		*/
 		VoxelCollection(const std::vector<std::string>& channels, const std::vector<std::string>& layers, size_t voxelCount);
 
-		/** Extracts a dense data buffer from the specified channel and layer.
+		/** Extracts a copy of the dense data buffer of the specified channel and layer.
+		* Prefer accessing Layer::data directly, which avoids the copy.
 		* @param channel The name of the channel to extract from
 		* @param layer The name of the layer to extract from
 		* @return A pointer to the extracted data buffer. The caller is responsible for deallocating the buffer.
@@ -58,22 +92,91 @@ namespace RadFiled3D::Dataset {
 	};
 
 	class VoxelCollectionAccessor {
+	public:
+		/** The maximum number of files kept open at once by a batch of reads */
+		static constexpr size_t MAX_BATCH_FILES = 256;
+
 	protected:
 		std::shared_ptr<Storage::FieldAccessor> accessor;
 		std::vector<std::string> channels;
 		std::vector<std::string> layers;
+		size_t worker_count;
+		size_t io_queue_depth = 0;
+		/** The idle readers of batched reads, which are kept across calls to access(), so that their io_uring instances are set up only once.
+		* Each call to access() takes an idle reader or creates one and returns it afterwards, so that concurrent calls never share a reader.
+		*/
+		struct BatchReaderPool {
+			std::mutex mutex;
+			std::vector<std::shared_ptr<BatchReader>> idle_readers;
+		};
+		std::shared_ptr<BatchReaderPool> batch_readers = std::make_shared<BatchReaderPool>();
 
 	public:
-		VoxelCollectionAccessor(std::shared_ptr<Storage::FieldAccessor> accessor, const std::vector<std::string>& channels, const std::vector<std::string>& layers)
-			: accessor(accessor), channels(channels), layers(layers) {
+		/** Constructs an accessor for collections of voxels
+		* @param accessor The field accessor matching the structure of all requested files
+		* @param channels The names of the channels to load
+		* @param layers The names of the layers to load from each channel
+		* @param worker_count The number of threads loading requests in parallel. 0 uses one thread per hardware thread. Default is 1, which loads all requests on the calling thread.
+		*/
+		VoxelCollectionAccessor(std::shared_ptr<Storage::FieldAccessor> accessor, const std::vector<std::string>& channels, const std::vector<std::string>& layers, size_t worker_count = 1)
+			: accessor(accessor), channels(channels), layers(layers), worker_count(worker_count) {
+		}
+
+		// copies do not share the readers of batched reads
+		VoxelCollectionAccessor(const VoxelCollectionAccessor& other)
+			: accessor(other.accessor), channels(other.channels), layers(other.layers), worker_count(other.worker_count), io_queue_depth(other.io_queue_depth) {
 		}
 
-		VoxelCollectionAccessor(const VoxelCollectionAccessor&) = default;
-		VoxelCollectionAccessor& operator=(const VoxelCollectionAccessor&) = default;
+		VoxelCollectionAccessor& operator=(const VoxelCollectionAccessor& other) {
+			if (this != &other) {
+				this->accessor = other.accessor;
+				this->channels = other.channels;
+				this->layers = other.layers;
+				this->worker_count = other.worker_count;
+				this->io_queue_depth = other.io_queue_depth;
+				this->batch_readers = std::make_shared<BatchReaderPool>();
+			}
+			return *this;
+		}
 		VoxelCollectionAccessor(VoxelCollectionAccessor&&) = default;
 		VoxelCollectionAccessor& operator=(VoxelCollectionAccessor&&) = default;
 		virtual ~VoxelCollectionAccessor() = default;
 
+		/** Sets the number of threads loading requests in parallel
+		* @param worker_count The number of threads. 0 uses one thread per hardware thread, 1 loads all requests on the calling thread.
+		*/
+		inline void set_worker_count(size_t worker_count) {
+			this->worker_count = worker_count;
+			this->batch_readers = std::make_shared<BatchReaderPool>();
+		}
+
+		/** Returns the number of threads used to load requests in parallel */
+		size_t get_worker_count() const;
+
+		/** Sets the number of reads in flight at once, if all reads of a call to access() are issued as one batch by a BatchReader.
+		* On Linux, the batch is submitted to io_uring, otherwise it is read by get_worker_count() threads issuing positional reads.
+		* Batching pays off with many small, scattered voxel reads across many files, e.g. on network or NVMe storage.
+		* Each file is opened once per batch. Requests spanning more than MAX_BATCH_FILES files are read in several batches, so that the number of open files stays bounded.
+		* The readers are kept by the accessor and reused by later calls. Concurrent calls to access() use a reader each.
+		* @param io_queue_depth The maximum number of reads in flight. 0 disables batching and loads the requests one after another per thread.
+		*/
+		inline void set_io_queue_depth(size_t io_queue_depth) {
+			this->io_queue_depth = io_queue_depth;
+			this->batch_readers = std::make_shared<BatchReaderPool>();
+		}
+
+		/** Returns the number of reads in flight at once, if the reads are batched. 0, if batching is disabled. */
+		inline size_t get_io_queue_depth() const {
+			return this->io_queue_depth;
+		}
+
+		/** Loads the requested voxels of all channels and layers.
+		* The voxel data is written directly to the contiguous buffer of each layer of the collection.
+		* The requests are spread over get_worker_count() threads, each writing to its own slice of the collection.
+		* If an I/O queue depth is set, the reads of all requests are issued as one batch instead.
+		* @param requests The files and voxel indices to load
+		* @return The collection holding the voxels of all requests in the order of the requests
+		*/
 		std::shared_ptr<VoxelCollection> access(const std::vector<VoxelCollectionRequest>& requests);
 	};
 }
\ No newline at end of file
@@ -0,0 +1,86 @@
+#pragma once
+#include "RadFiled3D/helpers/PositionalFile.hpp"
+#include <vector>
+#include <memory>
+#include <cstddef>
+
+
+namespace RadFiled3D {
+    /** A block of a file to read by a BatchReader */
+    struct BatchReadRequest {
+        /** The file to read from. Must stay open until the batch was read. */
+        const PositionalFile* file;
+        /** The offset of the block from the beginning of the file */
+        size_t offset;
+        /** The number of bytes to read */
+        size_t size;
+        /** The buffer to read the block into */
+        char* destination;
+    };
+
+
+    /** Reads large batches of small blocks, e.g. single voxels spread over many files, with many reads in flight at once.
+    * On Linux, all reads of a batch are submitted to an io_uring instance, which keeps up to the queue depth reads in flight and completes them directly into their destinations.
+    * Where io_uring is not available, e.g. on other platforms, on older kernels or when it is blocked by a seccomp profile, the reads are spread over worker threads issuing positional reads, which are started for each batch.
+    * A BatchReader must only be used by one thread at a time. Threads reading concurrently should use a reader each.
+    */
+    class BatchReader {
+    public:
+        enum class Backend {
+            /** The reads are submitted to an io_uring instance */
+            IoUring,
+            /** The reads are issued as positional reads by worker threads */
+            PositionalReads
+        };
+
+        /** Constructs a reader
+        * @param queue_depth The maximum number of reads in flight at once. At least 1.
+        * @param worker_count The number of threads issuing reads, if io_uring is not available. 0 uses the queue depth, but at most one thread per hardware thread.
+        * @param allow_io_uring If false, positional reads are used even if io_uring is available
+        */
+        BatchReader(size_t queue_depth = 64, size_t worker_count = 0, bool allow_io_uring = true);
+        ~BatchReader();
+
+        // Disable copying and moving
+        BatchReader(const BatchReader&) = delete;
+        BatchReader& operator=(const BatchReader&) = delete;
+        BatchReader(BatchReader&&) = delete;
+        BatchReader& operator=(BatchReader&&) = delete;
+
+        /** Reads all blocks of a batch and returns as soon as all of them were read
+        * @param requests The blocks to read. Their destinations must not overlap.
+        * @throws PositionalFileException if a block exceeds its file or could not be read completely. All reads in flight are completed before.
+        * If the io_uring instance fails, the reads in flight are awaited and the batch is read again by positional reads, which are used for all later batches.
+        */
+        void read(const std::vector<BatchReadRequest>& requests);
+
+        /** Returns the backend, which issues the reads */
+        inline Backend get_backend() const {
+            return (this->ring != nullptr) ? Backend::IoUring : Backend::PositionalReads;
+        }
+
+        /** Returns the maximum number of reads in flight at once */
+        inline size_t get_queue_depth() const {
+            return this->queue_depth;
+        }
+
+    protected:
+        struct Ring;
+
+        size_t queue_depth;
+        size_t worker_count;
+        std::unique_ptr<Ring> ring;
+
+        /** Reads a batch by the io_uring instance. If the ring fails, the reads in flight are awaited and the batch is read by positional reads instead. */
+        void read_ring(const std::vector<BatchReadRequest>& requests);
+
+        /** Awaits all reads in flight of a failed io_uring instance and releases it, so that later batches are read by positional reads
+        * @param in_flight The number of reads queued, including those not yet consumed by the kernel, which are withdrawn
+        * @return False, if the reads could not be awaited
+        */
+        bool drain_ring(size_t in_flight);
+
+        /** Reads a batch by a pool of threads issuing positional reads */
+        void read_threaded(const std::vector<BatchReadRequest>& requests) const;
+    };
+}
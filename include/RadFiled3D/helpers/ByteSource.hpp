@@ -0,0 +1,253 @@
+#pragma once
+#include "RadFiled3D/helpers/PositionalFile.hpp"
+#include "RadFiled3D/helpers/MappedFile.hpp"
+#include <string>
+#include <stdexcept>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <chrono>
+#include <streambuf>
+#include <istream>
+
+
+namespace RadFiled3D {
+    class ByteSourceException : public std::runtime_error {
+    public:
+        ByteSourceException(const std::string& message) : std::runtime_error("ByteSourceException: " + message) {}
+    };
+
+
+    /** A range of a ByteSource to read */
+    struct ByteRange {
+        /** The offset of the range from the beginning of the source */
+        size_t offset;
+        /** The number of bytes to read */
+        size_t size;
+        /** The buffer to read the range into */
+        char* destination;
+    };
+
+
+    /** A read-only sequence of bytes, which is read by ranges at explicit offsets, e.g. a local file, a memory mapping, a buffer in memory or an object of a remote store.
+    * Reading does not alter the state of a source, so any number of threads may read from the same source at the same time.
+    * Sources, whose requests are expensive, should override read_batch to issue all ranges of a batch at once.
+    */
+    class ByteSource {
+    public:
+        virtual ~ByteSource() = default;
+
+        /** Returns the number of bytes of the source */
+        virtual size_t size() const = 0;
+
+        /** Reads a range of the source. Safe to be called concurrently.
+        * @param offset The offset of the range from the beginning of the source
+        * @param destination The buffer to read the range into
+        * @param size The number of bytes to read
+        * @throws ByteSourceException if the range exceeds the source
+        */
+        virtual void read(size_t offset, char* destination, size_t size) const = 0;
+
+        /** Reads many ranges of the source. Reads the ranges one after another by default.
+        * @param ranges The ranges to read. Their destinations must not overlap.
+        * @throws ByteSourceException if a range exceeds the source
+        */
+        virtual void read_batch(const std::vector<ByteRange>& ranges) const;
+
+        /** Returns a pointer to a range, if the source holds it in memory, so that it can be used without being copied
+        * @param offset The offset of the range from the beginning of the source
+        * @param size The number of bytes of the range
+        * @return The pointer to the first byte of the range, which stays valid as long as the source exists, or nullptr if the range is not held in memory
+        * @throws ByteSourceException if the range exceeds the source
+        */
+        virtual const char* view(size_t offset, size_t size) const;
+
+    protected:
+        /** Checks that a range lies within the source
+        * @throws ByteSourceException if the range exceeds the source
+        */
+        void check_range(size_t offset, size_t size) const;
+    };
+
+
+    /** A local file read by positional reads. Batches are read by a BatchReader, if a queue depth is given. */
+    class FileByteSource : public ByteSource {
+    public:
+        /** Opens a file
+        * @param filename The path of the file to open
+        * @param queue_depth The number of reads of a batch in flight at once. 0 reads the ranges of a batch one after another.
+        * @throws PositionalFileException if the file could not be opened
+        */
+        FileByteSource(const std::string& filename, size_t queue_depth = 0);
+
+        /** Reads from an already opened file
+        * @param file The file to read from
+        * @param queue_depth The number of reads of a batch in flight at once. 0 reads the ranges of a batch one after another.
+        */
+        FileByteSource(std::shared_ptr<PositionalFile> file, size_t queue_depth = 0);
+
+        virtual size_t size() const override;
+        virtual void read(size_t offset, char* destination, size_t size) const override;
+        virtual void read_batch(const std::vector<ByteRange>& ranges) const override;
+
+        /** Returns the file read from */
+        inline const std::shared_ptr<PositionalFile>& get_file() const {
+            return this->file;
+        }
+
+    protected:
+        std::shared_ptr<PositionalFile> file;
+        size_t queue_depth;
+    };
+
+
+    /** A file mapped into memory. All ranges can be viewed without being copied. */
+    class MappedByteSource : public ByteSource {
+    public:
+        /** Maps a whole file into memory
+        * @param filename The path of the file to map
+        * @throws MappedFileException if the file could not be opened or mapped
+        */
+        MappedByteSource(const std::string& filename);
+
+        /** Reads from an already mapped file
+        * @param file The mapped file to read from
+        */
+        MappedByteSource(std::shared_ptr<MappedFile> file);
+
+        virtual size_t size() const override;
+        virtual void read(size_t offset, char* destination, size_t size) const override;
+        virtual const char* view(size_t offset, size_t size) const override;
+
+        /** Returns the mapped file read from */
+        inline const std::shared_ptr<MappedFile>& get_file() const {
+            return this->file;
+        }
+
+    protected:
+        std::shared_ptr<MappedFile> file;
+    };
+
+
+    /** A span of memory. All ranges can be viewed without being copied. */
+    class MemoryByteSource : public ByteSource {
+    public:
+        /** Reads from a span of memory, which is not owned by the source and must outlive it
+        * @param data The first byte of the span
+        * @param size The number of bytes of the span
+        */
+        MemoryByteSource(const char* data, size_t size);
+
+        /** Reads from a buffer owned by the source
+        * @param data The buffer
+        */
+        MemoryByteSource(std::vector<char> data);
+
+        /** Reads from a span of memory, which is kept alive by an owner shared with the source
+        * @param owner The object owning the span
+        * @param data The first byte of the span
+        * @param size The number of bytes of the span
+        */
+        MemoryByteSource(std::shared_ptr<const void> owner, const char* data, size_t size);
+
+        virtual size_t size() const override;
+        virtual void read(size_t offset, char* destination, size_t size) const override;
+        virtual const char* view(size_t offset, size_t size) const override;
+
+    protected:
+        std::shared_ptr<const void> owner;
+        const char* data;
+        size_t data_size;
+    };
+
+
+    /** Wraps another source and delays each request by a fixed latency and its transfer by a limited bandwidth, in order to mimic remote or object store like storage on a single machine.
+    * A call to read is one request and each range of a call to read_batch is a request of its own, so coalescing adjacent ranges saves latency as it would with a remote store.
+    * The ranges of a batch are issued in waves of up to the maximum number of concurrent requests, each wave being delayed by one latency and the transfer of its largest range.
+    * Concurrent calls are delayed independently of each other. Intended for tests and benchmarks of request coalescing and prefetching.
+    */
+    class ThrottledByteSource : public ByteSource {
+    public:
+        /** Wraps a source
+        * @param source The source to read from
+        * @param latency The delay of each request
+        * @param bandwidth The number of bytes transferred per second by a request. 0 does not limit the bandwidth.
+        * @param max_concurrent_requests The maximum number of requests of a batch in flight at once. Default is 1, which issues the ranges of a batch one after another. 0 issues all of them at once.
+        */
+        ThrottledByteSource(std::shared_ptr<ByteSource> source, std::chrono::microseconds latency, size_t bandwidth = 0, size_t max_concurrent_requests = 1);
+
+        virtual size_t size() const override;
+        virtual void read(size_t offset, char* destination, size_t size) const override;
+        virtual void read_batch(const std::vector<ByteRange>& ranges) const override;
+
+        /** Returns the number of requests issued so far */
+        inline size_t get_request_count() const {
+            return this->request_count;
+        }
+
+        /** Returns the number of bytes transferred so far */
+        inline size_t get_transferred_bytes() const {
+            return this->transferred_bytes;
+        }
+
+        /** Resets the number of requests and transferred bytes */
+        void reset_statistics();
+
+    protected:
+        std::shared_ptr<ByteSource> source;
+        std::chrono::microseconds latency;
+        size_t bandwidth;
+        size_t max_concurrent_requests;
+        mutable std::atomic<size_t> request_count;
+        mutable std::atomic<size_t> transferred_bytes;
+
+        /** Delays the calling thread by the latency of a wave of concurrent requests and the transfer of its largest request
+        * @param requests The number of requests in flight at once
+        * @param bytes The number of bytes transferred by all requests
+        * @param largest_request_bytes The number of bytes transferred by the largest request
+        */
+        void delay(size_t requests, size_t bytes, size_t largest_request_bytes) const;
+    };
+
+
+    /** A stream buffer reading from a ByteSource, so that a source can be passed to everything that reads from a std::istream.
+    * Small reads are served from a buffer filled by reads of the buffer size, large reads are passed to the source directly.
+    */
+    class ByteSourceStreamBuffer : public std::streambuf {
+    public:
+        /** Constructs a stream buffer
+        * @param source The source to read from
+        * @param buffer_size The number of bytes read at once for small reads
+        */
+        ByteSourceStreamBuffer(std::shared_ptr<ByteSource> source, size_t buffer_size = 64 * 1024);
+
+    protected:
+        std::shared_ptr<ByteSource> source;
+        std::vector<char> buffer;
+        /** The offset of the first byte of the buffer within the source */
+        size_t buffer_offset = 0;
+
+        virtual int_type underflow() override;
+        virtual std::streamsize xsgetn(char* destination, std::streamsize count) override;
+        virtual std::streamsize showmanyc() override;
+        virtual pos_type seekoff(off_type offset, std::ios_base::seekdir direction, std::ios_base::openmode which = std::ios_base::in) override;
+        virtual pos_type seekpos(pos_type position, std::ios_base::openmode which = std::ios_base::in) override;
+
+        /** Returns the offset of the next byte to read within the source */
+        size_t position() const;
+    };
+
+
+    /** An input stream reading from a ByteSource */
+    class ByteSourceStream : public std::istream {
+    public:
+        /** Constructs a stream
+        * @param source The source to read from
+        * @param buffer_size The number of bytes read at once for small reads
+        */
+        ByteSourceStream(std::shared_ptr<ByteSource> source, size_t buffer_size = 64 * 1024);
+
+    protected:
+        ByteSourceStreamBuffer stream_buffer;
+    };
+}
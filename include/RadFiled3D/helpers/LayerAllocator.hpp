@@ -0,0 +1,115 @@
+#pragma once
+#include <cstddef>
+#include <map>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <limits>
+
+
+namespace RadFiled3D {
+    /** Allocates the data and voxel buffers of voxel layers.
+    * All layers constructed by VoxelLayer::Construct*, VoxelBuffer::add_custom_layer* and VoxelBuffer::copy obtain their buffers from the default allocator.
+    * A layer keeps a reference to the allocator of its buffers and returns them to it, once it is freed, so the default allocator may be exchanged at any time.
+    * Implementations must be thread-safe.
+    */
+    class ILayerAllocator {
+    public:
+        virtual ~ILayerAllocator() = default;
+
+        /** Allocates an uninitialized buffer
+        * @param bytes The number of bytes to allocate
+        * @return The buffer, which is at least aligned to alignof(std::max_align_t). nullptr if bytes is 0.
+        * @throws std::bad_alloc if the buffer could not be allocated
+        */
+        virtual char* allocate(size_t bytes) = 0;
+
+        /** Returns a buffer to the allocator
+        * @param buffer The buffer, which was allocated by this allocator. May be nullptr.
+        * @param bytes The number of bytes the buffer was allocated with
+        */
+        virtual void deallocate(char* buffer, size_t bytes) noexcept = 0;
+
+        /** Returns the allocator, which is used for all layers constructed from now on.
+        * Default is an AlignedLayerAllocator with an alignment of 64 bytes.
+        * @return The default allocator
+        */
+        static std::shared_ptr<ILayerAllocator> get_default();
+
+        /** Sets the allocator, which is used for all layers constructed from now on
+        * @param allocator The new default allocator. nullptr resets to the initial AlignedLayerAllocator.
+        */
+        static void set_default(std::shared_ptr<ILayerAllocator> allocator);
+    };
+
+    /** Allocates buffers aligned to a fixed boundary, so that vectorized code can operate on the layer buffers with aligned loads */
+    class AlignedLayerAllocator : public ILayerAllocator {
+    public:
+        static constexpr size_t DEFAULT_ALIGNMENT = 64;
+
+        /** @param alignment The alignment of the buffers in bytes. Must be a power of two. */
+        AlignedLayerAllocator(size_t alignment = DEFAULT_ALIGNMENT);
+
+        virtual char* allocate(size_t bytes) override;
+        virtual void deallocate(char* buffer, size_t bytes) noexcept override;
+
+        inline size_t get_alignment() const {
+            return this->alignment;
+        }
+
+    protected:
+        const size_t alignment;
+    };
+
+    /** Allocates large buffers aligned to huge page boundaries and advises the kernel to back them by transparent huge pages.
+    * This reduces the number of page faults and TLB misses when touching large layers for the first time.
+    * Buffers smaller than HUGE_PAGE_BYTES are allocated like by an AlignedLayerAllocator.
+    * On platforms without transparent huge pages, the buffers are only aligned.
+    */
+    class HugePageLayerAllocator : public AlignedLayerAllocator {
+    public:
+        static constexpr size_t HUGE_PAGE_BYTES = 2 * 1024 * 1024;
+
+        HugePageLayerAllocator();
+
+        virtual char* allocate(size_t bytes) override;
+        virtual void deallocate(char* buffer, size_t bytes) noexcept override;
+    };
+
+    /** Keeps freed buffers and hands them out again for allocations of exactly the same size.
+    * Loading fields of the same shape repeatedly thereby reuses the already faulted in pages of the previously freed layers instead of requesting fresh memory from the system.
+    * Buffers are not cleared when reused.
+    */
+    class ArenaLayerAllocator : public ILayerAllocator {
+    public:
+        /** @param upstream The allocator to allocate new buffers from and to return buffers to, which are not kept
+        * @param max_cached_bytes The maximum number of bytes of freed buffers to keep for reuse. Unlimited by default.
+        */
+        ArenaLayerAllocator(std::shared_ptr<ILayerAllocator> upstream = std::make_shared<AlignedLayerAllocator>(), size_t max_cached_bytes = std::numeric_limits<size_t>::max());
+        ~ArenaLayerAllocator();
+
+        // Disable copying and moving
+        ArenaLayerAllocator(const ArenaLayerAllocator&) = delete;
+        ArenaLayerAllocator& operator=(const ArenaLayerAllocator&) = delete;
+
+        virtual char* allocate(size_t bytes) override;
+        virtual void deallocate(char* buffer, size_t bytes) noexcept override;
+
+        /** Returns all kept buffers to the upstream allocator */
+        void release();
+
+        /** Returns the number of bytes of freed buffers, which are kept for reuse */
+        size_t get_cached_bytes() const;
+
+        /** Returns the number of allocations, which were served by a kept buffer */
+        size_t get_reuse_count() const;
+
+    protected:
+        std::shared_ptr<ILayerAllocator> upstream;
+        const size_t max_cached_bytes;
+        mutable std::mutex mutex;
+        std::map<size_t, std::vector<char*>> free_buffers;
+        size_t cached_bytes = 0;
+        size_t reuse_count = 0;
+    };
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <string>
+#include <stdexcept>
+#include <memory>
+
+
+namespace RadFiled3D {
+    class MappedFileException : public std::runtime_error {
+    public:
+        MappedFileException(const std::string& message) : std::runtime_error("MappedFileException: " + message) {}
+    };
+
+
+    /** A read-only file mapped into the address space of the process.
+    * The mapping is private (copy-on-write), so views onto the mapping may be modified in memory without altering the file on disk.
+    * Objects handed out as views onto a mapping should hold a shared pointer to it in order to keep the mapping alive.
+    */
+    class MappedFile {
+    public:
+        /** Maps a whole file into memory
+        * @param filename The path of the file to map
+        * @throws MappedFileException if the file could not be opened or mapped
+        */
+        MappedFile(const std::string& filename);
+
+        /** Views a range of another mapping as a file of its own, e.g. a member stored uncompressed within an archive.
+        * The range is not mapped again, but shares the pages of the parent mapping, which is kept alive by the view.
+        * @param parent The mapping holding the range
+        * @param offset The offset of the range within the parent mapping
+        * @param size The number of bytes of the range
+        * @throws MappedFileException if the range exceeds the parent mapping
+        */
+        MappedFile(std::shared_ptr<MappedFile> parent, size_t offset, size_t size);
+        ~MappedFile();
+
+        // Disable copying and moving
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+        MappedFile(MappedFile&&) = delete;
+        MappedFile& operator=(MappedFile&&) = delete;
+
+        /** Returns the pointer to the first byte of the mapping */
+        inline char* data() const {
+            return this->mapped_data;
+        }
+
+        /** Returns the number of mapped bytes, which equals the file size */
+        inline size_t size() const {
+            return this->mapped_size;
+        }
+
+    private:
+        char* mapped_data = nullptr;
+        size_t mapped_size = 0;
+        /** The mapping viewed by this one, if it is a range of another mapping */
+        std::shared_ptr<MappedFile> parent;
+#if defined _WIN32 || defined _WIN64
+        void* hFile = (void*)-1;
+        void* hMapping = nullptr;
+#else
+        int fd = -1;
+#endif
+    };
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include <string>
+#include <stdexcept>
+#include <cstdint>
+
+
+namespace RadFiled3D {
+    class PositionalFileException : public std::runtime_error {
+    public:
+        PositionalFileException(const std::string& message) : std::runtime_error("PositionalFileException: " + message) {}
+    };
+
+
+    /** A file, which is read and written at explicit offsets (pread/pwrite on POSIX) instead of through a shared file position.
+    * Reading does not alter the state of the object, so any number of threads may read from the same PositionalFile at the same time.
+    * Files opened as writable may be written in place, but never grow.
+    */
+    class PositionalFile {
+    public:
+        /** Opens a file for reading
+        * @param filename The path of the file to open
+        * @param writable Opens the file for reading and writing
+        * @throws PositionalFileException if the file could not be opened
+        */
+        PositionalFile(const std::string& filename, bool writable = false);
+        ~PositionalFile();
+
+        // Disable copying and moving
+        PositionalFile(const PositionalFile&) = delete;
+        PositionalFile& operator=(const PositionalFile&) = delete;
+        PositionalFile(PositionalFile&&) = delete;
+        PositionalFile& operator=(PositionalFile&&) = delete;
+
+        /** Reads a block of the file. Safe to be called concurrently.
+        * @param offset The offset of the block from the beginning of the file
+        * @param destination The buffer to read the block into
+        * @param size The number of bytes to read
+        * @throws PositionalFileException if the block could not be read completely
+        */
+        void read(size_t offset, char* destination, size_t size) const;
+
+        /** Overwrites a block of the file. Safe to be called concurrently for disjoint blocks.
+        * @param offset The offset of the block from the beginning of the file
+        * @param source The data to write
+        * @param size The number of bytes to write
+        * @throws PositionalFileException if the file is not writable or the block could not be written completely
+        */
+        void write(size_t offset, const char* source, size_t size) const;
+
+        /** Returns the size of the file in bytes at the time it was opened */
+        inline size_t size() const {
+            return this->file_size;
+        }
+
+#if !(defined _WIN32 || defined _WIN64)
+        /** Returns the file descriptor, e.g. to submit reads of the file to an asynchronous I/O interface */
+        inline int get_descriptor() const {
+            return this->fd;
+        }
+#endif
+
+    private:
+        size_t file_size = 0;
+        bool writable = false;
+#if defined _WIN32 || defined _WIN64
+        void* hFile = (void*)-1;
+#else
+        int fd = -1;
+#endif
+    };
+}
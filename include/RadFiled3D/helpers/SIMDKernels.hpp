@@ -0,0 +1,69 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+
+namespace RadFiled3D {
+    /** Element-wise arithmetic kernels over the data buffers of voxel layers.
+    * The kernels are explicitly vectorized for SSE4.1, AVX2 and AVX-512 and the widest instruction set supported by the CPU is selected at runtime.
+    * All kernels produce exactly the same results as the scalar loops `dst[i] op= src[i]` and `dst[i] op= scalar`, independent of the selected instruction set.
+    * Multi component layers such as vec3 or histogram layers are processed as flat arrays of their components.
+    */
+    namespace Kernels {
+        enum class Operation {
+            Add,
+            Subtract,
+            Multiply,
+            Divide,
+            /** Divides like Divide, but yields 0 wherever the divisor is 0, as HistogramVoxel::operator/= does. Only for floating point buffers. */
+            DivideOrZero
+        };
+
+        enum class InstructionSet {
+            Scalar = 0,
+            SSE4 = 1,
+            AVX2 = 2,
+            AVX512 = 3
+        };
+
+        /** Returns the widest instruction set supported by the CPU and the operating system */
+        InstructionSet get_supported_instruction_set();
+
+        /** Returns the instruction set, which is currently used by the kernels */
+        InstructionSet get_instruction_set();
+
+        /** Limits the instruction set used by the kernels, e.g. for benchmarking or testing.
+        * @param instruction_set The widest instruction set to use. Clamped to the supported instruction set.
+        * @return The instruction set, which is used from now on
+        */
+        InstructionSet set_instruction_set(InstructionSet instruction_set);
+
+        /** Applies an operation element-wise: dst[i] = dst[i] op src[i]
+        * Operations without a vectorized implementation for the data type, such as integer divisions, run scalar.
+        * @param op The operation to apply
+        * @param dst The buffer to modify
+        * @param src The buffer of the second operands. May be equal to dst, but must not overlap it otherwise.
+        * @param count The number of elements
+        */
+        void apply(Operation op, float* dst, const float* src, size_t count);
+        void apply(Operation op, double* dst, const double* src, size_t count);
+        void apply(Operation op, int32_t* dst, const int32_t* src, size_t count);
+        void apply(Operation op, uint32_t* dst, const uint32_t* src, size_t count);
+        void apply(Operation op, uint64_t* dst, const uint64_t* src, size_t count);
+        void apply(Operation op, char* dst, const char* src, size_t count);
+
+        /** Applies an operation with a scalar element-wise: dst[i] = dst[i] op scalar
+        * Integer buffers are computed in single precision like the scalar expression `dst[i] op= scalar` and therefore run scalar.
+        * @param op The operation to apply. DivideOrZero is treated as Divide.
+        * @param dst The buffer to modify
+        * @param scalar The second operand
+        * @param count The number of elements
+        */
+        void apply(Operation op, float* dst, float scalar, size_t count);
+        void apply(Operation op, double* dst, float scalar, size_t count);
+        void apply(Operation op, int32_t* dst, float scalar, size_t count);
+        void apply(Operation op, uint32_t* dst, float scalar, size_t count);
+        void apply(Operation op, uint64_t* dst, float scalar, size_t count);
+        void apply(Operation op, char* dst, float scalar, size_t count);
+    }
+}
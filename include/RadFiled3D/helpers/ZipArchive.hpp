@@ -0,0 +1,121 @@
+#pragma once
+#include "RadFiled3D/helpers/MappedFile.hpp"
+#include "RadFiled3D/helpers/ByteSource.hpp"
+#include <string>
+#include <stdexcept>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <cstdint>
+
+
+namespace RadFiled3D {
+    class ZipArchiveException : public std::runtime_error {
+    public:
+        ZipArchiveException(const std::string& message) : std::runtime_error("ZipArchiveException: " + message) {}
+    };
+
+
+    /** A zip archive, whose members are read without extracting them, e.g. the radiation field files of a zipped dataset.
+    * The archive is mapped into memory and its central directory is parsed once into an index from member names to their entries, so opening a member costs the same for any size of the archive.
+    * Members stored uncompressed are views onto the mapping, so fields, layers and voxels are accessed from them without copies by the accessors taking a MappedFile.
+    * Views of a member share the mapping of the archive, so changes to the voxels of a viewed layer are seen by later views of the same member.
+    * Compressed (deflated) members are inflated into memory, if the library was built with zlib.
+    * Archives larger than 4 GiB or with more than 65535 members (ZIP64) are supported. Encrypted members are not.
+    * Opening members does not alter the state of the archive, so any number of threads may read from the same archive at the same time.
+    */
+    class ZipArchive {
+    public:
+        /** An entry of the central directory */
+        struct Member {
+            /** The path of the member within the archive */
+            std::string name;
+            /** The compression method, 0 for stored and 8 for deflated members */
+            uint16_t compression_method;
+            /** The general purpose flags of the member */
+            uint16_t flags;
+            /** The CRC-32 of the uncompressed data */
+            uint32_t crc32;
+            /** The number of bytes of the data within the archive */
+            size_t compressed_size;
+            /** The number of bytes of the uncompressed data */
+            size_t uncompressed_size;
+            /** The offset of the local header of the member from the beginning of the archive */
+            size_t local_header_offset;
+
+            /** Returns true, if the member is stored uncompressed and can therefore be viewed without a copy */
+            inline bool is_stored() const {
+                return this->compression_method == 0;
+            }
+        };
+
+        /** Opens an archive and indexes its members
+        * @param filename The path of the archive
+        * @throws MappedFileException if the archive could not be mapped
+        * @throws ZipArchiveException if the archive is not a valid zip archive
+        */
+        ZipArchive(const std::string& filename);
+
+        // Disable copying and moving
+        ZipArchive(const ZipArchive&) = delete;
+        ZipArchive& operator=(const ZipArchive&) = delete;
+        ZipArchive(ZipArchive&&) = delete;
+        ZipArchive& operator=(ZipArchive&&) = delete;
+
+        /** Returns the path of the archive */
+        inline const std::string& get_filename() const {
+            return this->filename;
+        }
+
+        /** Checks if the archive contains a member
+        * @param name The path of the member within the archive
+        */
+        bool contains(const std::string& name) const;
+
+        /** Returns the number of members of the archive */
+        inline size_t get_member_count() const {
+            return this->members.size();
+        }
+
+        /** Returns the paths of all members in the order of the central directory */
+        std::vector<std::string> get_member_names() const;
+
+        /** Returns the entry of a member
+        * @param name The path of the member within the archive
+        * @throws ZipArchiveException if the member does not exist
+        */
+        const Member& get_member(const std::string& name) const;
+
+        /** Maps a member stored uncompressed without copying it. The member keeps the mapping of the archive alive.
+        * @param name The path of the member within the archive
+        * @return The member as a file of its own, which can be passed to the accessors taking a MappedFile
+        * @throws ZipArchiveException if the member does not exist, is compressed or encrypted
+        */
+        std::shared_ptr<MappedFile> map_member(const std::string& name) const;
+
+        /** Opens a member as a byte source.
+        * Stored members are views onto the mapping, compressed members are inflated into memory and checked against their CRC-32.
+        * @param name The path of the member within the archive
+        * @return A MappedByteSource for stored members, a MemoryByteSource for inflated ones
+        * @throws ZipArchiveException if the member does not exist, is encrypted, corrupted or compressed by a method which is not supported
+        */
+        std::shared_ptr<ByteSource> open(const std::string& name) const;
+
+        /** Returns true, if deflated members can be opened, as the library was built with zlib */
+        static bool supports_compressed_members();
+
+    protected:
+        std::string filename;
+        std::shared_ptr<MappedFile> file;
+        std::vector<Member> members;
+        std::unordered_map<std::string, size_t> index;
+
+        /** Parses the central directory into the members and the index */
+        void parse_central_directory();
+
+        /** Returns the offset of the data of a member from the beginning of the archive by reading its local header
+        * @throws ZipArchiveException if the local header is corrupted or the data exceeds the archive
+        */
+        size_t get_data_offset(const Member& member) const;
+    };
+}
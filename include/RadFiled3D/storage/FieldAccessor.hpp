@@ -2,14 +2,23 @@
 #include <RadFiled3D/RadiationField.hpp>
 #include "RadFiled3D/storage/Types.hpp"
 #include "RadFiled3D/storage/FieldSerializer.hpp"
+#include "RadFiled3D/helpers/MappedFile.hpp"
+#include "RadFiled3D/helpers/PositionalFile.hpp"
+#include "RadFiled3D/helpers/BatchReader.hpp"
+#include "RadFiled3D/helpers/ByteSource.hpp"
 #include <stdexcept>
 #include <map>
+#include <mutex>
 
 
 namespace RadFiled3D {
 	namespace Storage {
 		class FieldAccessorBuilder;
 
+		namespace V2 {
+			struct FieldIndex;
+		}
+
 		namespace AccessorTypes {
 			typedef struct MemoryBlockDefinition {
 				size_t offset;
@@ -99,12 +108,23 @@ namespace RadFiled3D {
 				virtual void deserialize_additional_data(const std::vector<char>& data) { }
 			};
 #pragma pack(pop)
+
+			/** The positions of the channels and layers within a file being read, see resolveFileLayout */
+			struct FileLayout {
+				/** The offset from the beginning of the file to the start of the first channel block */
+				size_t field_data_offset = 0;
+				/** The channel and layer blocks of the file */
+				const std::map<std::string, AccessorTypes::ChannelStructure>* channels_layers_offsets = nullptr;
+				/** Owns the channel and layer blocks, if they were read from the file instead of being the ones of the accessor */
+				std::shared_ptr<const std::map<std::string, AccessorTypes::ChannelStructure>> file_channels_layers_offsets;
+			};
 		private:
 			const FieldType field_type;
 		protected:
 			size_t metadata_fileheader_size;
 			size_t voxel_count = 0;
 			StoreVersion store_version;
+			size_t voxel_read_gap_threshold = 4096;
 
 			/** Verify the buffer and set the read position to the beginning of the field.
 			* @param buffer The buffer to verify
@@ -133,6 +153,19 @@ namespace RadFiled3D {
 			*/
 			virtual std::shared_ptr<IRadiationField> accessField(std::istream& buffer) const = 0;
 
+			/** Access a field from a memory mapped file and return a shared pointer to it.
+			* The layers of the field are views onto the mapping instead of copies and keep the mapping alive.
+			* @param file The memory mapped file to access the field from
+			* @return A shared pointer to the field
+			*/
+			virtual std::shared_ptr<IRadiationField> accessField(const std::shared_ptr<MappedFile>& file) const = 0;
+
+			/** Access a field from a byte source and return a shared pointer to it
+			* @param source The source to access the field from
+			* @return A shared pointer to the field
+			*/
+			virtual std::shared_ptr<IRadiationField> accessField(const std::shared_ptr<ByteSource>& source) const = 0;
+
 			/** Get the version of the store that created a file
 			* @param file The file to get the store version from
 			* @return The store version of the file
@@ -157,6 +190,20 @@ namespace RadFiled3D {
 				return this->voxel_count;
 			}
 
+			/** Sets the maximum number of bytes between two requested voxels, which are read along instead of seeking past them, when accessing multiple voxels from a buffer.
+			* Larger values result in fewer but larger reads. The threshold is a runtime setting and is not serialized with the accessor.
+			* Default is 4096 bytes
+			* @param bytes The gap threshold in bytes
+			*/
+			inline void setVoxelReadGapThreshold(size_t bytes) {
+				this->voxel_read_gap_threshold = bytes;
+			}
+
+			/** Returns the maximum number of bytes between two requested voxels, which are read along when accessing multiple voxels from a buffer */
+			inline size_t getVoxelReadGapThreshold() const {
+				return this->voxel_read_gap_threshold;
+			}
+
 			/** Returns the offset from the beginning of a file to the start of the actual field data starting with the first channel block
 			* @return The offset from the beginning of the file to the start of the field data
 			*/
@@ -171,7 +218,8 @@ namespace RadFiled3D {
 			*/
 			virtual IVoxel* accessVoxelRawFlat(std::istream& buffer, const std::string& channel_name, const std::string& layer_name, size_t voxel_idx) const = 0;
 
-			/** Accesses a set of voxels from a buffer and returns a vector of pointers to them
+			/** Accesses a set of voxels from a buffer and returns a vector of pointers to them.
+			* Voxels close to each other are read at once, see setVoxelReadGapThreshold.
 			* @param buffer The buffer to access the voxels from
 			* @param channel_name The name of the channel the voxels are in
 			* @param layer_name The name of the layer the voxels are in
@@ -180,6 +228,169 @@ namespace RadFiled3D {
 			*/
 			virtual std::vector<IVoxel*> accessVoxelsRawFlat(std::istream& buffer, const std::string& channel_name, const std::string& layer_name, const std::vector<size_t>& voxel_indices) const = 0;
 
+			/** Accesses a voxel from a memory mapped file and returns a pointer to it
+			* @param file The memory mapped file to access the voxel from
+			* @param channel_name The name of the channel the voxel is in
+			* @param layer_name The name of the layer the voxel is in
+			* @param voxel_idx The index of the voxel in the layer
+			* @return A pointer to the voxel
+			*/
+			virtual IVoxel* accessVoxelRawFlat(const std::shared_ptr<MappedFile>& file, const std::string& channel_name, const std::string& layer_name, size_t voxel_idx) const = 0;
+
+			/** Accesses a set of voxels from a memory mapped file and returns a vector of pointers to them
+			* @param file The memory mapped file to access the voxels from
+			* @param channel_name The name of the channel the voxels are in
+			* @param layer_name The name of the layer the voxels are in
+			* @param voxel_indices The indices of the voxels in the layer
+			* @return A vector of pointers to the voxels
+			*/
+			virtual std::vector<IVoxel*> accessVoxelsRawFlat(const std::shared_ptr<MappedFile>& file, const std::string& channel_name, const std::string& layer_name, const std::vector<size_t>& voxel_indices) const = 0;
+
+			/** Accesses a set of voxels from a buffer and writes their data to a contiguous buffer without creating any voxel objects.
+			* The voxels are written in the order of voxel_indices, each taking elements_per_voxel elements of the data type of the layer, see getLayerDefinition.
+			* Voxels close to each other are read at once, see setVoxelReadGapThreshold.
+			* @param buffer The buffer to access the voxels from
+			* @param channel_name The name of the channel the voxels are in
+			* @param layer_name The name of the layer the voxels are in
+			* @param voxel_indices The indices of the voxels in the layer
+			* @param destination The buffer to write the voxel data to
+			* @param destination_size The size of the destination buffer in bytes
+			* @return The number of bytes written
+			* @throws RadiationFieldStoreException if a voxel index is out of bounds or the destination buffer is too small
+			*/
+			virtual size_t accessVoxelsDataFlat(std::istream& buffer, const std::string& channel_name, const std::string& layer_name, const std::vector<size_t>& voxel_indices, char* destination, size_t destination_size) const = 0;
+
+			/** Accesses a set of voxels from a memory mapped file and writes their data to a contiguous buffer without creating any voxel objects
+			* @param file The memory mapped file to access the voxels from
+			* @param channel_name The name of the channel the voxels are in
+			* @param layer_name The name of the layer the voxels are in
+			* @param voxel_indices The indices of the voxels in the layer
+			* @param destination The buffer to write the voxel data to
+			* @param destination_size The size of the destination buffer in bytes
+			* @return The number of bytes written
+			* @throws RadiationFieldStoreException if a voxel index is out of bounds or the destination buffer is too small
+			*/
+			virtual size_t accessVoxelsDataFlat(const std::shared_ptr<MappedFile>& file, const std::string& channel_name, const std::string& layer_name, const std::vector<size_t>& voxel_indices, char* destination, size_t destination_size) const = 0;
+
+			/** Accesses a voxel from a file read at explicit offsets and returns a pointer to it. Safe to be called from multiple threads sharing the file.
+			* @param file The file to access the voxel from
+			* @param channel_name The name of the channel the voxel is in
+			* @param layer_name The name of the layer the voxel is in
+			* @param voxel_idx The index of the voxel in the layer
+			* @return A pointer to the voxel
+			*/
+			virtual IVoxel* accessVoxelRawFlat(const std::shared_ptr<PositionalFile>& file, const std::string& channel_name, const std::string& layer_name, size_t voxel_idx) const = 0;
+
+			/** Accesses a set of voxels from a file read at explicit offsets and returns a vector of pointers to them. Safe to be called from multiple threads sharing the file.
+			* @param file The file to access the voxels from
+			* @param channel_name The name of the channel the voxels are in
+			* @param layer_name The name of the layer the voxels are in
+			* @param voxel_indices The indices of the voxels in the layer
+			* @return A vector of pointers to the voxels
+			*/
+			virtual std::vector<IVoxel*> accessVoxelsRawFlat(const std::shared_ptr<PositionalFile>& file, const std::string& channel_name, const std::string& layer_name, const std::vector<size_t>& voxel_indices) const = 0;
+
+			/** Accesses a set of voxels from a file read at explicit offsets and writes their data to a contiguous buffer. Safe to be called from multiple threads sharing the file.
+			* @param file The file to access the voxels from
+			* @param channel_name The name of the channel the voxels are in
+			* @param layer_name The name of the layer the voxels are in
+			* @param voxel_indices The indices of the voxels in the layer
+			* @param destination The buffer to write the voxel data to
+			* @param destination_size The size of the destination buffer in bytes
+			* @return The number of bytes written
+			* @throws RadiationFieldStoreException if a voxel index is out of bounds or the destination buffer is too small
+			*/
+			virtual size_t accessVoxelsDataFlat(const std::shared_ptr<PositionalFile>& file, const std::string& channel_name, const std::string& layer_name, const std::vector<size_t>& voxel_indices, char* destination, size_t destination_size) const = 0;
+
+			/** Queues the reads of a set of voxels to a batch instead of reading them, so that the reads of many files and layers can be issued at once by a BatchReader.
+			* The voxel data is written to the destination in the same layout as accessVoxelsDataFlat does, as soon as the batch was read.
+			* Layers, whose voxels can't be read directly from the file, as they are encoded, are read and decoded immediately.
+			* @param file The file to access the voxels from. Must stay open until the batch was read.
+			* @param channel_name The name of the channel the voxels are in
+			* @param layer_name The name of the layer the voxels are in
+			* @param voxel_indices The indices of the voxels in the layer
+			* @param destination The buffer to write the voxel data to
+			* @param destination_size The size of the destination buffer in bytes
+			* @param batch The batch to append the reads to
+			* @return The number of bytes written, once the batch was read
+			* @throws RadiationFieldStoreException if a voxel index is out of bounds or the destination buffer is too small
+			*/
+			virtual size_t queueVoxelsDataFlat(const std::shared_ptr<PositionalFile>& file, const std::string& channel_name, const std::string& layer_name, const std::vector<size_t>& voxel_indices, char* destination, size_t destination_size, std::vector<BatchReadRequest>& batch) const = 0;
+
+			/** Resolves the positions of the channels and layers of a file, so that many reads of the same file need to read its index only once.
+			* Version 2 files are indexed by a footer of their own, which is read by this call.
+			* @param file The file to resolve the layout of
+			* @return The layout of the file, which is only valid for this accessor
+			* @throws RadiationFieldStoreException if the file does not match the structure of the accessor
+			*/
+			virtual FileLayout resolveFileLayout(const std::shared_ptr<PositionalFile>& file) const = 0;
+
+			/** Queues the reads of a set of voxels to a batch like queueVoxelsDataFlat, but takes the layout of the file from a previous call to resolveFileLayout
+			* @param file The file to access the voxels from. Must stay open until the batch was read.
+			* @param layout The layout of the file, see resolveFileLayout
+			*/
+			virtual size_t queueVoxelsDataFlat(const std::shared_ptr<PositionalFile>& file, const FileLayout& layout, const std::string& channel_name, const std::string& layer_name, const std::vector<size_t>& voxel_indices, char* destination, size_t destination_size, std::vector<BatchReadRequest>& batch) const = 0;
+
+			/** Accesses a voxel from a byte source and returns a pointer to it. Safe to be called from multiple threads sharing the source.
+			* @param source The source to access the voxel from
+			* @param channel_name The name of the channel the voxel is in
+			* @param layer_name The name of the layer the voxel is in
+			* @param voxel_idx The index of the voxel in the layer
+			* @return A pointer to the voxel
+			*/
+			virtual IVoxel* accessVoxelRawFlat(const std::shared_ptr<ByteSource>& source, const std::string& channel_name, const std::string& layer_name, size_t voxel_idx) const = 0;
+
+			/** Accesses a set of voxels from a byte source and returns a vector of pointers to them. Safe to be called from multiple threads sharing the source.
+			* @param source The source to access the voxels from
+			* @param channel_name The name of the channel the voxels are in
+			* @param layer_name The name of the layer the voxels are in
+			* @param voxel_indices The indices of the voxels in the layer
+			* @return A vector of pointers to the voxels
+			*/
+			virtual std::vector<IVoxel*> accessVoxelsRawFlat(const std::shared_ptr<ByteSource>& source, const std::string& channel_name, const std::string& layer_name, const std::vector<size_t>& voxel_indices) const = 0;
+
+			/** Accesses a set of voxels from a byte source and writes their data to a contiguous buffer. Safe to be called from multiple threads sharing the source.
+			* The reads of all voxels are passed to the source as one batch by ByteSource::read_batch.
+			* @param source The source to access the voxels from
+			* @param channel_name The name of the channel the voxels are in
+			* @param layer_name The name of the layer the voxels are in
+			* @param voxel_indices The indices of the voxels in the layer
+			* @param destination The buffer to write the voxel data to
+			* @param destination_size The size of the destination buffer in bytes
+			* @return The number of bytes written
+			* @throws RadiationFieldStoreException if a voxel index is out of bounds or the destination buffer is too small
+			*/
+			virtual size_t accessVoxelsDataFlat(const std::shared_ptr<ByteSource>& source, const std::string& channel_name, const std::string& layer_name, const std::vector<size_t>& voxel_indices, char* destination, size_t destination_size) const = 0;
+
+			/** Returns the definition of a layer, which holds the data type, the number of elements and the header data of its voxels
+			* @param channel_name The name of the channel the layer is in
+			* @param layer_name The name of the layer
+			* @return The definition of the layer
+			* @throws RadiationFieldStoreException if the channel or layer does not exist
+			*/
+			virtual const AccessorTypes::TypedMemoryBlockDefinition& getLayerDefinition(const std::string& channel_name, const std::string& layer_name) const = 0;
+
+			/** Returns the names of all channels of the field
+			* @return The channel names
+			*/
+			virtual std::vector<std::string> getChannelNames() const = 0;
+
+			/** Returns the names of all layers of a channel
+			* @param channel_name The name of the channel
+			* @return The layer names
+			* @throws RadiationFieldStoreException if the channel does not exist
+			*/
+			virtual std::vector<std::string> getLayerNames(const std::string& channel_name) const = 0;
+
+			/** Returns the absolute position of a layer block from the beginning of the file the accessor was initialized from, which spans getLayerDefinition(channel_name, layer_name).size bytes.
+			* Encoded or bricked layers of other version 2 files may be placed elsewhere, as their size depends on their data.
+			* @param channel_name The name of the channel the layer is in
+			* @param layer_name The name of the layer
+			* @return The position of the layer block in bytes
+			* @throws RadiationFieldStoreException if the channel or layer does not exist
+			*/
+			virtual size_t getLayerPosition(const std::string& channel_name, const std::string& layer_name) const = 0;
+
 			/** Accesses a channel from a buffer and returns a shared pointer to it
 			* @param buffer The buffer to access the channel from
 			* @param channel_name The name of the channel to access
@@ -253,6 +464,89 @@ namespace RadFiled3D {
 			*/
 			virtual std::map<std::string, std::shared_ptr<VoxelGrid>> accessLayerAcrossChannels(std::istream& buffer, const std::string& layer_name) const = 0;
 
+			/** access a channel from a memory mapped file without copying its voxel data
+			* @param file The memory mapped file to access the channel from
+			* @param channel_name The name of the channel to access
+			* @return A shared pointer to the channel container, whose layers are views onto the mapping
+			*/
+			virtual std::shared_ptr<VoxelGridBuffer> accessChannel(const std::shared_ptr<MappedFile>& file, const std::string& channel_name) const = 0;
+
+			/** access a layer from a memory mapped file without copying its voxel data
+			* @param file The memory mapped file to access the layer from
+			* @param channel_name The name of the channel the layer is in
+			* @param layer_name The name of the layer to access
+			* @return A shared pointer to the layer, which is a view onto the mapping
+			*/
+			virtual std::shared_ptr<VoxelGrid> accessLayer(const std::shared_ptr<MappedFile>& file, const std::string& channel_name, const std::string& layer_name) const = 0;
+
+			/** access all channels of a layer from a memory mapped file without copying their voxel data
+			* @param file The memory mapped file to access the layer from
+			* @param layer_name The name of the layer to access
+			* @return A map containing all instances of the desired layer for each channel as views onto the mapping
+			*/
+			virtual std::map<std::string, std::shared_ptr<VoxelGrid>> accessLayerAcrossChannels(const std::shared_ptr<MappedFile>& file, const std::string& layer_name) const = 0;
+
+			/** access a layer from a file read at explicit offsets. Safe to be called from multiple threads sharing the file.
+			* @param file The file to access the layer from
+			* @param channel_name The name of the channel the layer is in
+			* @param layer_name The name of the layer to access
+			* @return A shared pointer to the layer
+			*/
+			virtual std::shared_ptr<VoxelGrid> accessLayer(const std::shared_ptr<PositionalFile>& file, const std::string& channel_name, const std::string& layer_name) const = 0;
+
+			/** access a layer from a byte source. Safe to be called from multiple threads sharing the source.
+			* @param source The source to access the layer from
+			* @param channel_name The name of the channel the layer is in
+			* @param layer_name The name of the layer to access
+			* @return A shared pointer to the layer
+			*/
+			virtual std::shared_ptr<VoxelGrid> accessLayer(const std::shared_ptr<ByteSource>& source, const std::string& channel_name, const std::string& layer_name) const = 0;
+
+			/** access a box shaped region of a layer from a buffer without reading the whole layer.
+			* Layers stored in bricks only need the bricks overlapping the region to be read.
+			* @param buffer The buffer to access the layer from
+			* @param channel_name The name of the channel the layer is in
+			* @param layer_name The name of the layer to access
+			* @param min_idx The first voxel of the region
+			* @param max_idx The voxel after the last voxel of the region in each dimension
+			* @return A shared pointer to a grid of max_idx - min_idx voxels, whose voxel (0, 0, 0) is the voxel min_idx of the layer
+			* @throws RadiationFieldStoreException if the region is empty or exceeds the layer
+			*/
+			virtual std::shared_ptr<VoxelGrid> accessSubvolume(std::istream& buffer, const std::string& channel_name, const std::string& layer_name, const glm::uvec3& min_idx, const glm::uvec3& max_idx) const = 0;
+
+			/** access a box shaped region of a layer from a memory mapped file. The voxels of the region are copied.
+			* @param file The memory mapped file to access the layer from
+			* @param channel_name The name of the channel the layer is in
+			* @param layer_name The name of the layer to access
+			* @param min_idx The first voxel of the region
+			* @param max_idx The voxel after the last voxel of the region in each dimension
+			* @return A shared pointer to a grid of max_idx - min_idx voxels, whose voxel (0, 0, 0) is the voxel min_idx of the layer
+			* @throws RadiationFieldStoreException if the region is empty or exceeds the layer
+			*/
+			virtual std::shared_ptr<VoxelGrid> accessSubvolume(const std::shared_ptr<MappedFile>& file, const std::string& channel_name, const std::string& layer_name, const glm::uvec3& min_idx, const glm::uvec3& max_idx) const = 0;
+
+			/** access a box shaped region of a layer from a file read at explicit offsets. Safe to be called from multiple threads sharing the file.
+			* @param file The file to access the layer from
+			* @param channel_name The name of the channel the layer is in
+			* @param layer_name The name of the layer to access
+			* @param min_idx The first voxel of the region
+			* @param max_idx The voxel after the last voxel of the region in each dimension
+			* @return A shared pointer to a grid of max_idx - min_idx voxels, whose voxel (0, 0, 0) is the voxel min_idx of the layer
+			* @throws RadiationFieldStoreException if the region is empty or exceeds the layer
+			*/
+			virtual std::shared_ptr<VoxelGrid> accessSubvolume(const std::shared_ptr<PositionalFile>& file, const std::string& channel_name, const std::string& layer_name, const glm::uvec3& min_idx, const glm::uvec3& max_idx) const = 0;
+
+			/** access a box shaped region of a layer from a byte source. Safe to be called from multiple threads sharing the source.
+			* @param source The source to access the layer from
+			* @param channel_name The name of the channel the layer is in
+			* @param layer_name The name of the layer to access
+			* @param min_idx The first voxel of the region
+			* @param max_idx The voxel after the last voxel of the region in each dimension
+			* @return A shared pointer to a grid of max_idx - min_idx voxels, whose voxel (0, 0, 0) is the voxel min_idx of the layer
+			* @throws RadiationFieldStoreException if the region is empty or exceeds the layer
+			*/
+			virtual std::shared_ptr<VoxelGrid> accessSubvolume(const std::shared_ptr<ByteSource>& source, const std::string& channel_name, const std::string& layer_name, const glm::uvec3& min_idx, const glm::uvec3& max_idx) const = 0;
+
 			template<typename dtype, typename VoxelT = ScalarVoxel<dtype>>
 			std::shared_ptr<VoxelT> accessVoxel(std::istream& buffer, const std::string& channel_name, const std::string& layer_name, const glm::uvec3& voxel_idx) const {
 				IVoxel* voxel = this->accessVoxelRaw(buffer, channel_name, layer_name, voxel_idx);
@@ -304,6 +598,30 @@ namespace RadFiled3D {
 			*/
 			virtual std::shared_ptr<PolarSegments> accessLayer(std::istream& buffer, const std::string& channel_name, const std::string& layer_name) const = 0;
 
+			/** access a layer from a memory mapped file without copying its voxel data
+			* @param file The memory mapped file to access the layer from
+			* @param channel_name The name of the channel the layer is in
+			* @param layer_name The name of the layer to access
+			* @return A shared pointer to the layer, which is a view onto the mapping
+			*/
+			virtual std::shared_ptr<PolarSegments> accessLayer(const std::shared_ptr<MappedFile>& file, const std::string& channel_name, const std::string& layer_name) const = 0;
+
+			/** access a layer from a file read at explicit offsets. Safe to be called from multiple threads sharing the file.
+			* @param file The file to access the layer from
+			* @param channel_name The name of the channel the layer is in
+			* @param layer_name The name of the layer to access
+			* @return A shared pointer to the layer
+			*/
+			virtual std::shared_ptr<PolarSegments> accessLayer(const std::shared_ptr<PositionalFile>& file, const std::string& channel_name, const std::string& layer_name) const = 0;
+
+			/** access a layer from a byte source. Safe to be called from multiple threads sharing the source.
+			* @param source The source to access the layer from
+			* @param channel_name The name of the channel the layer is in
+			* @param layer_name The name of the layer to access
+			* @return A shared pointer to the layer
+			*/
+			virtual std::shared_ptr<PolarSegments> accessLayer(const std::shared_ptr<ByteSource>& source, const std::string& channel_name, const std::string& layer_name) const = 0;
+
 			template<typename dtype, typename VoxelT = ScalarVoxel<dtype>>
 			std::shared_ptr<VoxelT> accessVoxel(std::istream& buffer, const std::string& channel_name, const std::string& layer_name, const glm::uvec2& voxel_idx) const {
 				IVoxel* voxel = this->accessVoxelRaw(buffer, channel_name, layer_name, voxel_idx);
@@ -323,6 +641,7 @@ namespace RadFiled3D {
 
 		namespace V1 {
 			class FileParser : virtual public RadFiled3D::Storage::FieldAccessor {
+				friend struct RadFiled3D::Storage::V2::FieldIndex;
 			public:
 				static std::vector<char> SerializeChannelsLayersOffsets(const std::map<std::string, AccessorTypes::ChannelStructure>& channels_layers_offsets);
 				static std::map<std::string, AccessorTypes::ChannelStructure> DeserializeChannelsLayersOffsets(const std::vector<char>& data);
@@ -339,9 +658,186 @@ namespace RadFiled3D {
 				virtual void initialize(std::istream& buffer) override;
 
 				std::map<std::string, AccessorTypes::ChannelStructure> channels_layers_offsets;
+
+				/** The layouts of the version 2 files read last, keyed by the identity and size of the file, so that repeated reads of a file read its index only once */
+				struct LayoutCache {
+					/** The maximum number of layouts kept */
+					static constexpr size_t CAPACITY = 16;
+
+					struct Entry {
+						/** Identifies the file without keeping it open */
+						std::weak_ptr<const void> source;
+						size_t size = 0;
+						FileLayout layout;
+					};
+
+					std::mutex mutex;
+					std::vector<Entry> entries;
+				};
+				std::shared_ptr<LayoutCache> layout_cache = std::make_shared<LayoutCache>();
+
+				/** Resolves a block of a memory mapped file
+				* @param file The memory mapped file
+				* @param position The absolute position of the block in the file
+				* @param size The size of the block in bytes
+				* @return A pointer to the first byte of the block within the mapping
+				* @throws RadiationFieldStoreException if the block exceeds the mapping
+				*/
+				char* getMappedBlock(const std::shared_ptr<MappedFile>& file, size_t position, size_t size) const;
+
+				/** Returns the offset of the first voxel relative to the beginning of a layer block
+				* @param layer_block The layer block
+				* @return The offset in bytes
+				*/
+				size_t getVoxelDataOffset(const AccessorTypes::TypedMemoryBlockDefinition& layer_block) const;
+
+				/** Reads a block of a file
+				* @param position The absolute position of the block in the file
+				* @param size The size of the block in bytes
+				* @param destination The buffer to read the block into
+				*/
+				typedef std::function<void(size_t position, size_t size, char* destination)> BlockReader;
+
+				/** Returns a BlockReader, which seeks and reads a buffer. Not thread safe, as the read position of the buffer is shared.
+				* @throws RadiationFieldStoreException on reading, if the buffer ends before the block
+				*/
+				static BlockReader StreamReader(std::istream& buffer);
+
+				/** Returns a BlockReader, which reads a file at explicit offsets. Safe to be used from multiple threads.
+				* @throws PositionalFileException on reading, if the file ends before the block
+				*/
+				static BlockReader FileReader(const std::shared_ptr<PositionalFile>& file);
+
+				/** Returns a BlockReader, which reads a byte source. Safe to be used from multiple threads.
+				* @throws ByteSourceException on reading, if the source ends before the block
+				*/
+				static BlockReader SourceReader(const std::shared_ptr<ByteSource>& source);
+
+				/** Returns a BlockReader, which copies from a memory mapped file. Safe to be used from multiple threads.
+				* @throws RadiationFieldStoreException on reading, if the mapping ends before the block
+				*/
+				static BlockReader MappedReader(const std::shared_ptr<MappedFile>& file);
+
+				/** Resolves the positions of the channels and layers of the file being read.
+				* Version 1 files share the layout of the file the accessor was initialized from.
+				* The layer blocks of version 2 files depend on their data, if they are encoded or bricked, so that the layout is read from the index of the file itself.
+				* @param read The reader of the buffer
+				* @param buffer_size The size of the buffer in bytes
+				* @return The layout of the file
+				* @throws RadiationFieldStoreException if the file does not contain a valid index or does not match the voxel count of the accessor
+				*/
+				FileLayout resolveLayout(const BlockReader& read, size_t buffer_size) const;
+
+				/** Resolves the positions of the channels and layers of a buffer, see resolveLayout */
+				FileLayout resolveLayout(std::istream& buffer) const;
+
+				/** Resolves the positions of the channels and layers of a file, which is shared between calls, see resolveLayout.
+				* The layouts of version 2 files are cached, so that only the first call per file reads its index.
+				* @param source The file, which identifies the layout in the cache as long as it exists
+				* @param read The reader of the file
+				* @param buffer_size The size of the file in bytes
+				*/
+				FileLayout resolveCachedLayout(const std::shared_ptr<const void>& source, const BlockReader& read, size_t buffer_size) const;
+
+				/** Resolves the positions of the channels and layers of a memory mapped file, see resolveCachedLayout */
+				FileLayout resolveLayout(const std::shared_ptr<MappedFile>& file) const;
+
+				/** Resolves the positions of the channels and layers of a file read at explicit offsets, see resolveCachedLayout */
+				FileLayout resolveLayout(const std::shared_ptr<PositionalFile>& file) const;
+
+				/** Resolves the positions of the channels and layers of a byte source, see resolveCachedLayout */
+				FileLayout resolveLayout(const std::shared_ptr<ByteSource>& source) const;
+
+				/** Finds a channel block within the layout of a file
+				* @throws RadiationFieldStoreException if the channel does not exist
+				*/
+				const AccessorTypes::ChannelStructure& findChannel(const FileLayout& layout, const std::string& channel_name) const;
+
+				/** Finds a layer block within the layout of a file and checks that its voxels are stored like the ones of the accessor
+				* @param layout The layout of the file
+				* @param channel_name The name of the channel the layer is in
+				* @param layer_name The name of the layer
+				* @param layer_position Receives the absolute position of the layer block in the file
+				* @return The layer block within the file
+				* @throws RadiationFieldStoreException if the channel or layer does not exist or stores its voxels differently than the accessor expects
+				*/
+				const AccessorTypes::TypedMemoryBlockDefinition& findLayer(const FileLayout& layout, const std::string& channel_name, const std::string& layer_name, size_t& layer_position) const;
+
+				/** Checks if the voxel data of a layer is encoded, so that single voxels can't be read from the buffer directly.
+				* Decided by the size of the layer block alone, as only raw layers are stored with exactly the size of their voxels, so that no header needs to be read.
+				* @param layer_block The layer block within the layout of the buffer
+				* @return True, if the whole layer needs to be decoded to access its voxels
+				*/
+				bool isLayerEncoded(const AccessorTypes::TypedMemoryBlockDefinition& layer_block) const;
+
+				/** Reads and deserializes a whole layer
+				* @param read The reader of the buffer to read the layer block from
+				* @param layout The layout of the buffer, see resolveLayout
+				* @param channel_name The name of the channel the layer is in
+				* @param layer_name The name of the layer
+				* @return The layer, which needs to be deleted by the caller
+				*/
+				VoxelLayer* readLayer(const BlockReader& read, const FileLayout& layout, const std::string& channel_name, const std::string& layer_name) const;
+
+				/** Reads the data of a set of voxels to a contiguous buffer, see accessVoxelsDataFlat
+				* @param read The reader of the buffer to read the voxels from
+				* @param layout The layout of the buffer, see resolveLayout
+				*/
+				size_t readVoxelsData(const BlockReader& read, const FileLayout& layout, const std::string& channel_name, const std::string& layer_name, const std::vector<size_t>& voxel_indices, char* destination, size_t destination_size) const;
+
+				/** Splits the reads of a set of voxels into blocks, which land directly in the destination, see queueVoxelsDataFlat
+				* @param read The reader of the buffer, which reads encoded layers immediately
+				* @param layout The layout of the buffer, see resolveLayout
+				* @param queue Called for each block to be read later
+				*/
+				size_t queueVoxelsData(const BlockReader& read, const FileLayout& layout, const BlockReader& queue, const std::string& channel_name, const std::string& layer_name, const std::vector<size_t>& voxel_indices, char* destination, size_t destination_size) const;
+
+				/** Creates voxels from the data of a decoded layer
+				* @param layer The decoded layer
+				* @param layer_block The layer block of the layer
+				* @param voxel_indices The flat indices of the voxels to create
+				* @return The voxels, which need to be deleted by the caller
+				*/
+				std::vector<IVoxel*> createVoxelsFromLayer(const VoxelLayer& layer, const AccessorTypes::TypedMemoryBlockDefinition& layer_block, const std::vector<size_t>& voxel_indices) const;
+
+				/** Copies the data of voxels from a decoded layer to a contiguous buffer
+				* @param layer The decoded layer
+				* @param layer_block The layer block of the layer
+				* @param voxel_indices The flat indices of the voxels to copy
+				* @param destination The buffer to copy the voxel data to
+				* @return The number of bytes written
+				*/
+				size_t copyVoxelsFromLayer(const VoxelLayer& layer, const AccessorTypes::TypedMemoryBlockDefinition& layer_block, const std::vector<size_t>& voxel_indices, char* destination) const;
+
+				/** Creates voxels from contiguous voxel data
+				* @param data The voxel data
+				* @param layer_block The layer block the voxels belong to
+				* @param voxel_count The number of voxels in data
+				* @return The voxels, which need to be deleted by the caller
+				*/
+				std::vector<IVoxel*> createVoxelsFromData(char* data, const AccessorTypes::TypedMemoryBlockDefinition& layer_block, size_t voxel_count) const;
 			public:
 				virtual IVoxel* accessVoxelRawFlat(std::istream& buffer, const std::string& channel_name, const std::string& layer_name, size_t voxel_idx) const override;
 				virtual std::vector<IVoxel*> accessVoxelsRawFlat(std::istream& buffer, const std::string& channel_name, const std::string& layer_name, const std::vector<size_t>& voxel_indices) const override;
+				virtual IVoxel* accessVoxelRawFlat(const std::shared_ptr<MappedFile>& file, const std::string& channel_name, const std::string& layer_name, size_t voxel_idx) const override;
+				virtual std::vector<IVoxel*> accessVoxelsRawFlat(const std::shared_ptr<MappedFile>& file, const std::string& channel_name, const std::string& layer_name, const std::vector<size_t>& voxel_indices) const override;
+				virtual size_t accessVoxelsDataFlat(std::istream& buffer, const std::string& channel_name, const std::string& layer_name, const std::vector<size_t>& voxel_indices, char* destination, size_t destination_size) const override;
+				virtual size_t accessVoxelsDataFlat(const std::shared_ptr<MappedFile>& file, const std::string& channel_name, const std::string& layer_name, const std::vector<size_t>& voxel_indices, char* destination, size_t destination_size) const override;
+				virtual const AccessorTypes::TypedMemoryBlockDefinition& getLayerDefinition(const std::string& channel_name, const std::string& layer_name) const override;
+				virtual std::vector<std::string> getChannelNames() const override;
+				virtual std::vector<std::string> getLayerNames(const std::string& channel_name) const override;
+				virtual size_t getLayerPosition(const std::string& channel_name, const std::string& layer_name) const override;
+				virtual IVoxel* accessVoxelRawFlat(const std::shared_ptr<PositionalFile>& file, const std::string& channel_name, const std::string& layer_name, size_t voxel_idx) const override;
+				virtual std::vector<IVoxel*> accessVoxelsRawFlat(const std::shared_ptr<PositionalFile>& file, const std::string& channel_name, const std::string& layer_name, const std::vector<size_t>& voxel_indices) const override;
+				virtual size_t accessVoxelsDataFlat(const std::shared_ptr<PositionalFile>& file, const std::string& channel_name, const std::string& layer_name, const std::vector<size_t>& voxel_indices, char* destination, size_t destination_size) const override;
+				virtual size_t queueVoxelsDataFlat(const std::shared_ptr<PositionalFile>& file, const std::string& channel_name, const std::string& layer_name, const std::vector<size_t>& voxel_indices, char* destination, size_t destination_size, std::vector<BatchReadRequest>& batch) const override;
+				virtual FileLayout resolveFileLayout(const std::shared_ptr<PositionalFile>& file) const override;
+				virtual size_t queueVoxelsDataFlat(const std::shared_ptr<PositionalFile>& file, const FileLayout& layout, const std::string& channel_name, const std::string& layer_name, const std::vector<size_t>& voxel_indices, char* destination, size_t destination_size, std::vector<BatchReadRequest>& batch) const override;
+				using RadFiled3D::Storage::FieldAccessor::accessField;
+				virtual std::shared_ptr<IRadiationField> accessField(const std::shared_ptr<ByteSource>& source) const override;
+				virtual IVoxel* accessVoxelRawFlat(const std::shared_ptr<ByteSource>& source, const std::string& channel_name, const std::string& layer_name, size_t voxel_idx) const override;
+				virtual std::vector<IVoxel*> accessVoxelsRawFlat(const std::shared_ptr<ByteSource>& source, const std::string& channel_name, const std::string& layer_name, const std::vector<size_t>& voxel_indices) const override;
+				virtual size_t accessVoxelsDataFlat(const std::shared_ptr<ByteSource>& source, const std::string& channel_name, const std::string& layer_name, const std::vector<size_t>& voxel_indices, char* destination, size_t destination_size) const override;
 
 				IVoxel* createVoxelFromBuffer(char* buffer, Typing::DType dtype, const char* voxel_header_data = nullptr) const;
 			};
@@ -371,6 +867,12 @@ namespace RadFiled3D {
 
 				CartesianFieldAccessor();
 				virtual void initialize(std::istream& buffer) override;
+
+				/** Reads a box shaped region of a layer, see accessSubvolume
+				* @param read The reader of the buffer to read the layer block from
+				* @param layout The layout of the buffer, see resolveLayout
+				*/
+				std::shared_ptr<VoxelGrid> readSubvolume(const BlockReader& read, const FileLayout& layout, const std::string& channel_name, const std::string& layer_name, const glm::uvec3& min_idx, const glm::uvec3& max_idx) const;
 			public:
 				CartesianFieldAccessor(const SerializationData& data);
 
@@ -382,6 +884,19 @@ namespace RadFiled3D {
 				virtual std::shared_ptr<VoxelGrid> accessLayer(std::istream& buffer, const std::string& channel_name, const std::string& layer_name) const override;
 				virtual std::map<std::string, std::shared_ptr<VoxelGrid>> accessLayerAcrossChannels(std::istream& buffer, const std::string& layer_name) const override;
 
+				virtual std::shared_ptr<IRadiationField> accessField(const std::shared_ptr<MappedFile>& file) const override;
+				virtual std::shared_ptr<VoxelGridBuffer> accessChannel(const std::shared_ptr<MappedFile>& file, const std::string& channel_name) const override;
+				virtual std::shared_ptr<VoxelGrid> accessLayer(const std::shared_ptr<MappedFile>& file, const std::string& channel_name, const std::string& layer_name) const override;
+				virtual std::map<std::string, std::shared_ptr<VoxelGrid>> accessLayerAcrossChannels(const std::shared_ptr<MappedFile>& file, const std::string& layer_name) const override;
+
+				virtual std::shared_ptr<VoxelGrid> accessLayer(const std::shared_ptr<PositionalFile>& file, const std::string& channel_name, const std::string& layer_name) const override;
+				virtual std::shared_ptr<VoxelGrid> accessLayer(const std::shared_ptr<ByteSource>& source, const std::string& channel_name, const std::string& layer_name) const override;
+
+				virtual std::shared_ptr<VoxelGrid> accessSubvolume(std::istream& buffer, const std::string& channel_name, const std::string& layer_name, const glm::uvec3& min_idx, const glm::uvec3& max_idx) const override;
+				virtual std::shared_ptr<VoxelGrid> accessSubvolume(const std::shared_ptr<MappedFile>& file, const std::string& channel_name, const std::string& layer_name, const glm::uvec3& min_idx, const glm::uvec3& max_idx) const override;
+				virtual std::shared_ptr<VoxelGrid> accessSubvolume(const std::shared_ptr<PositionalFile>& file, const std::string& channel_name, const std::string& layer_name, const glm::uvec3& min_idx, const glm::uvec3& max_idx) const override;
+				virtual std::shared_ptr<VoxelGrid> accessSubvolume(const std::shared_ptr<ByteSource>& source, const std::string& channel_name, const std::string& layer_name, const glm::uvec3& min_idx, const glm::uvec3& max_idx) const override;
+
 				virtual size_t getFieldDataOffset() const override;
 				virtual SerializationData* generateSerializationBuffer() const override {
 					return new SerializationData(this->store_version, this->getFieldType(), this->metadata_fileheader_size, this->voxel_count, this->field_dimensions, this->voxel_dimensions, this->channels_layers_offsets);
@@ -428,6 +943,12 @@ namespace RadFiled3D {
 				virtual std::shared_ptr<IRadiationField> accessField(std::istream& buffer) const override;
 				virtual std::shared_ptr<PolarSegments> accessLayer(std::istream& buffer, const std::string& channel_name, const std::string& layer_name) const override;
 
+				virtual std::shared_ptr<IRadiationField> accessField(const std::shared_ptr<MappedFile>& file) const override;
+				virtual std::shared_ptr<PolarSegments> accessLayer(const std::shared_ptr<MappedFile>& file, const std::string& channel_name, const std::string& layer_name) const override;
+
+				virtual std::shared_ptr<PolarSegments> accessLayer(const std::shared_ptr<PositionalFile>& file, const std::string& channel_name, const std::string& layer_name) const override;
+				virtual std::shared_ptr<PolarSegments> accessLayer(const std::shared_ptr<ByteSource>& source, const std::string& channel_name, const std::string& layer_name) const override;
+
 				virtual size_t getFieldDataOffset() const override;
 
 				virtual SerializationData* generateSerializationBuffer() const override {
@@ -438,6 +959,84 @@ namespace RadFiled3D {
 			};
 		};
 
+		namespace V2 {
+			/** The layer index table of version 2 files.
+			* Holds everything an accessor needs to know about a file, so that it can be initialized from the trailer and the index alone.
+			*/
+			struct FieldIndex {
+				size_t metadata_fileheader_size = 0;
+				FieldType field_type = FieldType::Cartesian;
+				FiledTypes::V1::CartesianHeader cartesian_header;
+				FiledTypes::V1::PolarHeader polar_header;
+				std::map<std::string, AccessorTypes::ChannelStructure> channels_layers_offsets;
+
+				/** Returns the offset from the beginning of a file to the start of the first channel block */
+				size_t getFieldDataOffset() const;
+
+				/** Returns the number of voxels per layer */
+				size_t getVoxelCount() const;
+
+				/** Reads the trailer of a version 2 file
+				* @param buffer The buffer to read the trailer from
+				* @return The trailer
+				* @throws RadiationFieldStoreException if the buffer does not end with a valid trailer
+				*/
+				static FiledTypes::V2::FieldIndexTrailer ReadTrailer(std::istream& buffer);
+
+				/** Reads the trailer of a version 2 file
+				* @param read Reads size bytes at an absolute position of the buffer to destination
+				* @param buffer_size The size of the buffer in bytes
+				* @return The trailer
+				* @throws RadiationFieldStoreException if the buffer does not end with a valid trailer
+				*/
+				static FiledTypes::V2::FieldIndexTrailer ReadTrailer(const std::function<void(size_t position, size_t size, char* destination)>& read, size_t buffer_size);
+
+				/** Reads the index of a version 2 file by reading the trailer and the index block
+				* @param buffer The buffer to read the index from
+				* @return The index
+				* @throws RadiationFieldStoreException if the buffer does not contain a valid index
+				*/
+				static FieldIndex Read(std::istream& buffer);
+
+				/** Reads the index of a version 2 file by reading the trailer and the index block
+				* @param read Reads size bytes at an absolute position of the buffer to destination
+				* @param buffer_size The size of the buffer in bytes
+				* @return The index
+				* @throws RadiationFieldStoreException if the buffer does not contain a valid index
+				*/
+				static FieldIndex Read(const std::function<void(size_t position, size_t size, char* destination)>& read, size_t buffer_size);
+
+				/** Writes the index block and the trailer at the current write position of a buffer
+				* @param buffer The buffer to write to
+				*/
+				void write(std::ostream& buffer) const;
+			};
+
+			class CartesianFieldAccessor : public V1::CartesianFieldAccessor {
+				friend class RadFiled3D::Storage::FieldAccessorBuilder;
+			protected:
+				CartesianFieldAccessor();
+				virtual void initialize(std::istream& buffer) override;
+				void initialize(const FieldIndex& index);
+			public:
+				CartesianFieldAccessor(const SerializationData& data);
+
+				virtual ~CartesianFieldAccessor() {};
+			};
+
+			class PolarFieldAccessor : public V1::PolarFieldAccessor {
+				friend class RadFiled3D::Storage::FieldAccessorBuilder;
+			protected:
+				PolarFieldAccessor();
+				virtual void initialize(std::istream& buffer) override;
+				void initialize(const FieldIndex& index);
+			public:
+				PolarFieldAccessor(const SerializationData& data);
+
+				virtual ~PolarFieldAccessor() {};
+			};
+		};
+
 		class FieldAccessorBuilder {
 		public:
 			/** Construct a field accessor from a buffer
@@ -1,6 +1,8 @@
 #pragma once
 #include <memory>
 #include <sstream>
+#include <functional>
+#include <vector>
 #include "RadFiled3D/storage/Types.hpp"
 
 namespace RadFiled3D {
@@ -9,6 +11,53 @@ namespace RadFiled3D {
 	class IRadiationField;
 
 	namespace Storage {
+		/** Writes the channel blocks of a field block one layer at a time, so that only a single layer has to be held in memory.
+		* Channels and layers are written in the order they shall appear in the buffer. A channel block is completed as soon as the next one is started or the writer is finished.
+		*/
+		class FieldBlockStreamWriter {
+		public:
+			virtual ~FieldBlockStreamWriter() = default;
+
+			/** Starts a new channel block and completes the previous one
+			* @param channel_name The name of the channel
+			*/
+			virtual void beginChannel(const std::string& channel_name) = 0;
+
+			/** Writes a layer of a voxel buffer as the next layer block of the current channel
+			* @param voxel_buffer The voxel buffer
+			* @param layer_name The name of the layer
+			* @throws RadiationFieldStoreException if no channel was started
+			*/
+			virtual void writeLayer(std::shared_ptr<VoxelBuffer> voxel_buffer, const std::string& layer_name) = 0;
+
+			/** Completes the last channel block and writes everything, which follows the channel blocks */
+			virtual void finish() = 0;
+		};
+
+		/** A layer block, which is ready to be written: its headers followed by either a view onto the voxel data of the layer or an encoded copy of it.
+		* The size of the block is known before anything is written, so that the size of a channel can be written ahead of its layers.
+		*/
+		struct LayerBlockWrite {
+			/** The codec header, the layer header and the voxel header block of the layer */
+			std::vector<char> headers;
+			/** The voxel data to write after the headers. Points into the layer or into encoded_data. */
+			const char* data = nullptr;
+			size_t data_bytes = 0;
+			/** Owns the encoded voxel data, if the layer is not stored raw */
+			std::vector<char> encoded_data;
+
+			/** Returns the size of the whole layer block in bytes */
+			size_t size() const { return this->headers.size() + this->data_bytes; }
+
+			/** Writes the layer block without copying the voxel data
+			* @param buffer The buffer to write to
+			*/
+			void write(std::ostream& buffer) const {
+				buffer.write(this->headers.data(), this->headers.size());
+				buffer.write(this->data, this->data_bytes);
+			}
+		};
+
 		class BinayFieldBlockHandler {
 		public:
 			/** Serializes a radiation field to a binary string
@@ -23,6 +72,20 @@ namespace RadFiled3D {
 			*/
 			virtual std::unique_ptr<std::ostringstream> serializeChannel(std::shared_ptr<VoxelBuffer> voxel_buffer) const = 0;
 
+			/** Serializes a single layer of a voxel buffer as a layer block of a channel
+			* @param voxel_buffer The voxel buffer
+			* @param layer_name The name of the layer
+			* @param buffer The buffer to write to
+			*/
+			virtual void serializeLayer(std::shared_ptr<VoxelBuffer> voxel_buffer, const std::string& layer_name, std::ostream& buffer) const = 0;
+
+			/** Starts to serialize a radiation field block by block instead of all at once
+			* @param field_shape A radiation field of the shape to write. Only its header is written, the channels are written by the returned writer.
+			* @param buffer The buffer to write to. Its write position is expected to be right after the metadata block. Must be seekable, as the channel headers are completed after their layers were written.
+			* @return The writer of the channel blocks. Must not outlive the buffer.
+			*/
+			virtual std::unique_ptr<FieldBlockStreamWriter> serializeFieldStreamed(std::shared_ptr<IRadiationField> field_shape, std::ostream& buffer) const = 0;
+
 			/** Deserializes a binary buffer of a channel to a voxel buffer
 			* @param destination The destination voxel buffer
 			* @param data The binary buffer
@@ -38,6 +101,25 @@ namespace RadFiled3D {
 			*/
 			virtual VoxelLayer* deserializeLayer(char* data, size_t size) const = 0;
 
+			/** Deserializes a binary buffer of a channel to a voxel buffer without copying the voxel data.
+			* The layers of the destination will be views onto the binary buffer.
+			* @param destination The destination voxel buffer
+			* @param data The binary buffer
+			* @param size The size of the binary buffer
+			* @param data_owner The owner of the binary buffer, which will be kept alive by the layers
+			* @return The destination voxel buffer
+			*/
+			virtual std::shared_ptr<VoxelBuffer> deserializeChannelView(std::shared_ptr<VoxelBuffer> destination, char* data, size_t size, std::shared_ptr<void> data_owner) const = 0;
+
+			/** Deserializes a binary buffer of a layer without copying the voxel data.
+			* The returned layer will be a view onto the binary buffer.
+			* @param data The binary buffer
+			* @param size The size of the binary buffer
+			* @param data_owner The owner of the binary buffer, which will be kept alive by the layer
+			* @return The layer
+			*/
+			virtual VoxelLayer* deserializeLayerView(char* data, size_t size, std::shared_ptr<void> data_owner) const = 0;
+
 			/** Deserializes a radiation field from a binary string
 			* @param buffer The binary string
 			* @return The radiation field
@@ -58,6 +140,36 @@ namespace RadFiled3D {
 				* @param unit The unit of the histogram
 				*/
 				static void add_hist_layer(std::shared_ptr<VoxelBuffer> field, const std::string& layer, size_t bytes_per_element, float max_energy_eV, const std::string& unit, void* header_data);
+
+				/** Describes a layer of a voxel buffer by a layer header
+				* @param voxel_buffer The voxel buffer
+				* @param layer_name The name of the layer
+				* @return The layer header
+				*/
+				static FiledTypes::V1::VoxelGridLayerHeader make_layer_header(std::shared_ptr<VoxelBuffer> voxel_buffer, const std::string& layer_name);
+
+				/** Writes the field type and the shape header of a radiation field
+				* @param field The radiation field
+				* @param buffer The buffer to write to
+				*/
+				void serializeFieldHeader(std::shared_ptr<IRadiationField> field, std::ostream& buffer) const;
+
+				/** Writes a channel block without staging it in memory.
+				* All layer blocks are prepared first, so that the size of the channel is known, when its header is written. The voxel data of raw layers is then written directly from the layers.
+				* @param channel_name The name of the channel
+				* @param voxel_buffer The voxel buffer of the channel
+				* @param buffer The buffer to write to
+				* @param on_layer Called with the name, the position relative to the channel data and the size of each layer block written
+				* @return The size of the channel data in bytes
+				*/
+				size_t serializeChannelBlock(const std::string& channel_name, std::shared_ptr<VoxelBuffer> voxel_buffer, std::ostream& buffer, const std::function<void(const std::string& layer_name, size_t layer_pos, size_t layer_size)>& on_layer = nullptr) const;
+
+				/** Deserializes a radiation field from a binary string, which ends at a known position
+				* @param buffer The binary string
+				* @param field_data_end The position in the buffer at which the channel blocks end
+				* @return The radiation field
+				*/
+				std::shared_ptr<IRadiationField> deserializeField(std::istream& buffer, size_t field_data_end) const;
 			public:
 				BinayFieldBlockHandler() = default;
 
@@ -69,6 +181,17 @@ namespace RadFiled3D {
 				*/
 				virtual std::unique_ptr<std::ostringstream> serializeChannel(std::shared_ptr<VoxelBuffer> voxel_buffer) const override;
 
+				virtual void serializeLayer(std::shared_ptr<VoxelBuffer> voxel_buffer, const std::string& layer_name, std::ostream& buffer) const override;
+
+				/** Prepares a layer of a voxel buffer to be written as a layer block
+				* @param voxel_buffer The voxel buffer. Must outlive the returned block, as the block may refer to its voxel data.
+				* @param layer_name The name of the layer
+				* @return The layer block
+				*/
+				virtual LayerBlockWrite prepareLayer(std::shared_ptr<VoxelBuffer> voxel_buffer, const std::string& layer_name) const;
+
+				virtual std::unique_ptr<FieldBlockStreamWriter> serializeFieldStreamed(std::shared_ptr<IRadiationField> field_shape, std::ostream& buffer) const override;
+
 				/** Deserializes a binary buffer of a channel to a voxel buffer
 				* @param destination The destination voxel buffer
 				* @param data The binary buffer
@@ -84,6 +207,24 @@ namespace RadFiled3D {
 				*/
 				virtual VoxelLayer* deserializeLayer(char* data, size_t size) const override;
 
+				/** Deserializes a binary buffer of a channel to a voxel buffer without copying the voxel data.
+				* @param destination The destination voxel buffer
+				* @param data The binary buffer
+				* @param size The size of the binary buffer
+				* @param data_owner The owner of the binary buffer, which will be kept alive by the layers
+				* @return The destination voxel buffer
+				*/
+				virtual std::shared_ptr<VoxelBuffer> deserializeChannelView(std::shared_ptr<VoxelBuffer> destination, char* data, size_t size, std::shared_ptr<void> data_owner) const override;
+
+				/** Deserializes a binary buffer of a layer without copying the voxel data.
+				* Falls back to a copy, if the voxel data is not aligned for its data type within the binary buffer.
+				* @param data The binary buffer
+				* @param size The size of the binary buffer
+				* @param data_owner The owner of the binary buffer, which will be kept alive by the layer
+				* @return The layer
+				*/
+				virtual VoxelLayer* deserializeLayerView(char* data, size_t size, std::shared_ptr<void> data_owner) const override;
+
 				/** Deserializes a radiation field from a binary string
 				* @param buffer The binary string
 				* @return The radiation field
@@ -91,6 +232,144 @@ namespace RadFiled3D {
 				virtual std::shared_ptr<IRadiationField> deserializeField(std::istream& buffer) const override;
 
 				virtual FieldType getFieldType(std::istream& buffer) const override;
+
+				/** Reads the field type and the shape header of a radiation field
+				* @param buffer The binary string
+				* @return An empty radiation field of the shape
+				* @throws RadiationFieldStoreException if the field type is not supported
+				*/
+				std::shared_ptr<IRadiationField> deserializeFieldShape(std::istream& buffer) const;
+
+				/** Determines the position at which the channel blocks of a field block end
+				* @param buffer The binary string. Its read position is undefined afterwards.
+				* @return The position in the buffer
+				*/
+				virtual size_t getFieldDataEnd(std::istream& buffer) const;
+
+				/** Determines the size of a layer block and validates it against the available data
+				* @param data The beginning of the layer block. Only the codec header and the layer header are read from it.
+				* @param size The number of bytes available from the beginning of the layer block
+				* @param voxel_count The number of voxels of the layer
+				* @return The size of the layer block in bytes
+				* @throws RadiationFieldStoreException if the layer block exceeds the available data
+				*/
+				virtual size_t getLayerBlockSize(const char* data, size_t size, size_t voxel_count) const;
+
+				/** Returns the number of bytes each layer block is prefixed with to describe the codec of its voxel data. Layers of version 1 files have no such prefix.
+				* @return The size of the codec header in bytes
+				*/
+				virtual size_t getLayerCodecHeaderSize() const { return 0; };
+
+				/** Checks if the voxel data of a layer block is stored raw and contiguous, so that single voxels can be read from it directly
+				* @param layer_data The beginning of the layer block
+				* @return True, if the voxel data directly follows the layer headers as is
+				*/
+				virtual bool isLayerRaw(const char* /*layer_data*/) const { return true; };
+
+				/** Deserializes a box shaped region of a cartesian layer by only reading the parts of the layer block, which are needed for it
+				* @param read Reads a number of bytes at an offset relative to the beginning of the layer block into a destination buffer
+				* @param size The size of the layer block
+				* @param voxel_counts The number of voxels of the layer in each dimension
+				* @param region_min The first voxel of the region
+				* @param region_max The voxel after the last voxel of the region in each dimension
+				* @return The layer holding the voxels of the region ordered x fastest
+				* @throws RadiationFieldStoreException if the region is empty or exceeds the layer
+				*/
+				virtual VoxelLayer* deserializeLayerRegion(const std::function<void(size_t offset, size_t size, char* destination)>& read, size_t size, const glm::uvec3& voxel_counts, const glm::uvec3& region_min, const glm::uvec3& region_max) const;
+			};
+		};
+
+		namespace V2 {
+			/** Handles the field block of version 2 files.
+			* The channel blocks are identical to version 1, but are followed by a layer index and a fixed size trailer at the end of the buffer.
+			*/
+			class BinayFieldBlockHandler : public RadFiled3D::Storage::V1::BinayFieldBlockHandler {
+			protected:
+				LayerCodec codec;
+				uint32_t brick_size;
+
+				/** Restores the version 1 layout of an encoded, but not bricked layer block
+				* @param data The beginning of the layer block
+				* @param size The size of the layer block
+				* @return The layer headers followed by the decoded voxel data
+				*/
+				std::vector<char> decodeLayerBlock(const char* data, size_t size) const;
+
+				/** Deserializes all layers of a channel block into a voxel buffer. Encoded layers are decoded in parallel.
+				* @param destination The destination voxel buffer
+				* @param data The binary buffer of the channel
+				* @param size The size of the binary buffer
+				* @param data_owner The owner of the binary buffer. If set, raw layers will be views onto the binary buffer, otherwise they are copied.
+				* @return The destination voxel buffer
+				*/
+				std::shared_ptr<VoxelBuffer> deserializeLayers(std::shared_ptr<VoxelBuffer> destination, char* data, size_t size, std::shared_ptr<void> data_owner) const;
+			public:
+				/** Constructs a handler
+				* @param codec The codec to encode the layers with when serializing. Layers, which would not become smaller by encoding, are always stored raw.
+				* @param brick_size The number of voxels along each edge of the bricks the layers of cartesian fields are split into when serializing. 0 stores all layers contiguous.
+				*/
+				BinayFieldBlockHandler(LayerCodec codec = LayerCodec::Raw, uint32_t brick_size = 0) : codec(codec), brick_size(brick_size) {};
+
+				/** Serializes a radiation field followed by its layer index
+				* @param field The radiation field
+				* @param buffer The buffer to write to. Its write position is expected to be right after the metadata block.
+				*/
+				virtual void serializeField(std::shared_ptr<IRadiationField> field, std::ostream& buffer) const override;
+
+				/** Deserializes a radiation field from a binary string and stops at the layer index
+				* @param buffer The binary string
+				* @return The radiation field
+				*/
+				virtual std::shared_ptr<IRadiationField> deserializeField(std::istream& buffer) const override;
+
+				/** Prepares a layer of a voxel buffer to be written as a layer block, encoding it with the codec of this handler and splitting layers of cartesian fields into bricks if a brick size was set
+				* @param voxel_buffer The voxel buffer. Must outlive the returned block, as the block may refer to its voxel data.
+				* @param layer_name The name of the layer
+				* @return The layer block
+				*/
+				virtual LayerBlockWrite prepareLayer(std::shared_ptr<VoxelBuffer> voxel_buffer, const std::string& layer_name) const override;
+
+				/** Starts to serialize a radiation field block by block. The layer index is written, when the returned writer is finished.
+				* @param field_shape A radiation field of the shape to write
+				* @param buffer The buffer to write to. Its write position is expected to be right after the metadata block.
+				* @return The writer of the channel blocks
+				*/
+				virtual std::unique_ptr<FieldBlockStreamWriter> serializeFieldStreamed(std::shared_ptr<IRadiationField> field_shape, std::ostream& buffer) const override;
+
+				virtual std::shared_ptr<VoxelBuffer> deserializeChannel(std::shared_ptr<VoxelBuffer> destination, char* data, size_t size) const override;
+
+				virtual VoxelLayer* deserializeLayer(char* data, size_t size) const override;
+
+				virtual std::shared_ptr<VoxelBuffer> deserializeChannelView(std::shared_ptr<VoxelBuffer> destination, char* data, size_t size, std::shared_ptr<void> data_owner) const override;
+
+				/** Deserializes a binary buffer of a layer without copying the voxel data.
+				* Encoded layers can not be viewed and are decoded into a copy instead.
+				* @param data The binary buffer
+				* @param size The size of the binary buffer
+				* @param data_owner The owner of the binary buffer, which will be kept alive by the layer
+				* @return The layer
+				*/
+				virtual VoxelLayer* deserializeLayerView(char* data, size_t size, std::shared_ptr<void> data_owner) const override;
+
+				virtual size_t getFieldDataEnd(std::istream& buffer) const override;
+
+				virtual size_t getLayerBlockSize(const char* data, size_t size, size_t voxel_count) const override;
+
+				virtual size_t getLayerCodecHeaderSize() const override;
+
+				virtual bool isLayerRaw(const char* layer_data) const override;
+
+				/** Deserializes a box shaped region of a cartesian layer.
+				* Of bricked layers only the bricks overlapping the region are read and decoded, other encoded layers are decoded as a whole.
+				* @param read Reads a number of bytes at an offset relative to the beginning of the layer block into a destination buffer
+				* @param size The size of the layer block
+				* @param voxel_counts The number of voxels of the layer in each dimension
+				* @param region_min The first voxel of the region
+				* @param region_max The voxel after the last voxel of the region in each dimension
+				* @return The layer holding the voxels of the region ordered x fastest
+				* @throws RadiationFieldStoreException if the region is empty or exceeds the layer
+				*/
+				virtual VoxelLayer* deserializeLayerRegion(const std::function<void(size_t offset, size_t size, char* destination)>& read, size_t size, const glm::uvec3& voxel_counts, const glm::uvec3& region_min, const glm::uvec3& region_max) const override;
 			};
 		};
 	};
@@ -0,0 +1,141 @@
+#pragma once
+#include "RadFiled3D/storage/Types.hpp"
+#include <vector>
+
+
+namespace RadFiled3D {
+	namespace Storage {
+		/** Describes how the voxels of a cartesian layer are split into cubic bricks.
+		* Bricks and the voxels within each brick are ordered x fastest. Bricks at the upper borders of the grid are clipped to the grid.
+		*/
+		class BrickLayout {
+		protected:
+			glm::uvec3 voxel_counts;
+			uint32_t brick_size;
+			glm::uvec3 bricks_counts;
+		public:
+			/** Constructs the layout of a grid
+			* @param voxel_counts The number of voxels of the grid in each dimension
+			* @param brick_size The number of voxels along each edge of a brick
+			* @throws RadiationFieldStoreException if the brick size is 0
+			*/
+			BrickLayout(const glm::uvec3& voxel_counts, uint32_t brick_size);
+
+			/** Returns the number of voxels of the grid in each dimension */
+			inline const glm::uvec3& get_voxel_counts() const {
+				return this->voxel_counts;
+			};
+
+			/** Returns the number of voxels along each edge of a brick */
+			inline uint32_t get_brick_size() const {
+				return this->brick_size;
+			};
+
+			/** Returns the number of bricks */
+			inline size_t get_brick_count() const {
+				return static_cast<size_t>(this->bricks_counts.x) * this->bricks_counts.y * this->bricks_counts.z;
+			};
+
+			/** Returns the number of bricks in each dimension */
+			inline const glm::uvec3& get_bricks_counts() const {
+				return this->bricks_counts;
+			};
+
+			/** Returns the first voxel of a brick */
+			glm::uvec3 get_brick_min(size_t brick_idx) const;
+
+			/** Returns the voxel after the last voxel of a brick in each dimension */
+			glm::uvec3 get_brick_max(size_t brick_idx) const;
+
+			/** Returns the number of voxels of a brick */
+			size_t get_brick_voxel_count(size_t brick_idx) const;
+
+			/** Returns the flat indices of all bricks overlapping a region
+			* @param region_min The first voxel of the region
+			* @param region_max The voxel after the last voxel of the region in each dimension
+			* @return The flat brick indices in ascending order
+			*/
+			std::vector<size_t> get_bricks_in_region(const glm::uvec3& region_min, const glm::uvec3& region_max) const;
+
+			/** Copies the voxels of a brick out of the voxel data of a whole layer
+			* @param layer_data The voxel data of the layer
+			* @param voxel_bytes The number of bytes of a single voxel
+			* @param brick_idx The flat index of the brick
+			* @param destination The buffer to copy the voxels of the brick to. Must hold get_brick_voxel_count(brick_idx) voxels.
+			*/
+			void gather(const char* layer_data, size_t voxel_bytes, size_t brick_idx, char* destination) const;
+
+			/** Copies the voxels of a brick, which lie within a region, to the voxel data of that region
+			* @param brick_data The voxels of the brick
+			* @param voxel_bytes The number of bytes of a single voxel
+			* @param brick_idx The flat index of the brick
+			* @param region_data The voxel data of the region, ordered x fastest
+			* @param region_min The first voxel of the region
+			* @param region_max The voxel after the last voxel of the region in each dimension
+			*/
+			void scatter(const char* brick_data, size_t voxel_bytes, size_t brick_idx, char* region_data, const glm::uvec3& region_min, const glm::uvec3& region_max) const;
+		};
+
+		/** Encodes and decodes the voxel data of single layers.
+		* All codecs are implemented in this library and do not depend on any external compression library.
+		*/
+		class LayerCodecs {
+		public:
+			/** Encodes a block of voxel data
+			* @param codec The codec to use
+			* @param data The voxel data
+			* @param size The number of bytes of the voxel data
+			* @param element_bytes The number of bytes of a single data element e.g. 4 for float. Used to group the bytes by significance.
+			* @return The encoded data
+			* @throws RadiationFieldStoreException if the codec is unknown
+			*/
+			static std::vector<char> Encode(LayerCodec codec, const char* data, size_t size, size_t element_bytes);
+
+			/** Decodes a block of voxel data
+			* @param codec The codec the data was encoded with
+			* @param data The encoded data
+			* @param size The number of bytes of the encoded data
+			* @param destination The buffer to decode into
+			* @param destination_size The number of bytes the decoded data is expected to have
+			* @param element_bytes The number of bytes of a single data element, which was used during encoding
+			* @throws RadiationFieldStoreException if the codec is unknown or the encoded data is corrupted
+			*/
+			static void Decode(LayerCodec codec, const char* data, size_t size, char* destination, size_t destination_size, size_t element_bytes);
+
+			/** Splits the voxel data of a cartesian layer into bricks and encodes each of them on its own
+			* @param codec The codec to use. Bricks, which would not become smaller, are stored raw.
+			* @param data The voxel data of the layer
+			* @param voxel_bytes The number of bytes of a single voxel
+			* @param element_bytes The number of bytes of a single data element
+			* @param layout The brick layout of the layer
+			* @return The brick table header and the brick offsets followed by the encoded bricks
+			*/
+			static std::vector<char> EncodeBricks(LayerCodec codec, const char* data, size_t voxel_bytes, size_t element_bytes, const BrickLayout& layout);
+
+			/** Decodes a single brick, which was encoded by EncodeBricks
+			* @param codec The codec the brick was encoded with
+			* @param data The encoded brick
+			* @param size The number of bytes of the encoded brick
+			* @param destination The buffer to decode into
+			* @param destination_size The number of bytes of the decoded brick
+			* @param element_bytes The number of bytes of a single data element
+			*/
+			static void DecodeBrick(LayerCodec codec, const char* data, size_t size, char* destination, size_t destination_size, size_t element_bytes);
+
+		protected:
+			/** Groups the bytes of all data elements by their significance, so that e.g. all exponents of floats end up next to each other */
+			static void Shuffle(const char* data, size_t size, size_t element_bytes, char* destination);
+
+			/** Reverts Shuffle */
+			static void Unshuffle(const char* data, size_t size, size_t element_bytes, char* destination);
+
+			/** Run length encodes a byte buffer.
+			* The result is a sequence of tokens, each starting with a variable length integer. Odd values introduce a run of a single byte, even values a sequence of literal bytes.
+			*/
+			static std::vector<char> EncodeRLE(const char* data, size_t size);
+
+			/** Reverts EncodeRLE */
+			static void DecodeRLE(const char* data, size_t size, char* destination, size_t destination_size);
+		};
+	};
+}
@@ -7,6 +7,8 @@
 #include "RadFiled3D/RadiationField.hpp"
 #include "RadFiled3D/storage/Types.hpp"
 #include <utility>
+#include <mutex>
+#include <map>
 #include <RadFiled3D/storage/FieldAccessor.hpp>
 #include <RadFiled3D/storage/MetadataSerializer.hpp>
 #include <RadFiled3D/storage/MetadataAccessor.hpp>
@@ -22,6 +24,7 @@ namespace RadFiled3D {
 		* Subtract: Subtract the values of the additional source field from the target field
 		* Devide: Devide the values of the target field by the values of the additional source field
 		* Multiply: Multiply the values of the target field by the values of the additional source field
+		* Welford: Accumulate the mean and the variance of the values of all joined fields, see ExporterHelpers::join_layer_welford. Layers, which are not floating point, are added.
 		*/
 		enum class FieldJoinMode {
 			/* Use the value of the target field */
@@ -37,7 +40,9 @@ namespace RadFiled3D {
 			/* Multiply the values of the target field by the values of the additional source field */
 			Multiply = 5,
 			/* Add the values of the target and the additional source field with a weighting ratio based on the primary particles */
-			AddWeighted = 6
+			AddWeighted = 6,
+			/* Keep the mean of the values of all joined fields and track their variance in auxiliary layers. Layers, which are not floating point, are added. */
+			Welford = 7
 		};
 
 		/** The mode to join the fields.
@@ -70,6 +75,78 @@ namespace RadFiled3D {
 
 		class ExporterHelpers {
 		public:
+			/** Joins a layer of an additional source buffer into the layer of the same name of a target buffer.
+			* The join mode and data type are dispatched once per layer to a kernel specialized for both at compile time, which processes the layer chunk-wise.
+			* The results equal those of merging with get_join_function, except that the additional source is never modified.
+			* @param target The buffer to join into
+			* @param additional_source The buffer to join from
+			* @param layer_name The name of the layer
+			* @param dtype The data type of the layer in both buffers
+			* @param mode The mode to join the layers
+			* @param ratio The ratio to use for the weighted join mode
+			* @throws RadiationFieldStoreException if the data type can't be joined or the join mode is unknown
+			*/
+			static void join_layer(VoxelBuffer& target, const VoxelBuffer& additional_source, const std::string& layer_name, Typing::DType dtype, FieldJoinMode mode, float ratio = 0.f);
+
+			/** Joins the raw data of a layer into the raw data of another one, like join_layer does for the layers of buffers, but on the calling thread only
+			* @param target The data to join into
+			* @param additional_source The data to join from. Must not overlap the target.
+			* @param bytes The size of both data blocks in bytes. Must be a multiple of the size of the element type of the data type.
+			* @param layer_name The name of the layer, used for error messages
+			* @param dtype The data type of the layer
+			* @param mode The mode to join the data
+			* @param ratio The ratio to use for the weighted join mode
+			* @throws RadiationFieldStoreException if the data type can't be joined or the join mode is unknown
+			*/
+			static void join_layer_data(char* target, const char* additional_source, size_t bytes, const std::string& layer_name, Typing::DType dtype, FieldJoinMode mode, float ratio = 0.f);
+
+			/** Suffix of the auxiliary layer, which holds the number of samples per voxel of a layer joined by FieldJoinMode::Welford */
+			static constexpr const char* WELFORD_COUNT_SUFFIX = "#count";
+			/** Suffix of the auxiliary layer, which holds the sum of squared deviations from the mean of a layer joined by FieldJoinMode::Welford */
+			static constexpr const char* WELFORD_M2_SUFFIX = "#m2";
+
+			/** Joins a layer by the parallel variant of Welford's algorithm (Chan et al.), which merges the mean and the sum of squared deviations of two sets of samples.
+			* The layer itself holds the mean of all samples. The number of samples per voxel and the sum of squared deviations of each element are kept in the auxiliary layers
+			* layer_name + WELFORD_COUNT_SUFFIX and layer_name + WELFORD_M2_SUFFIX, which are added to the target, if missing. A layer without auxiliary layers counts as a single sample.
+			* As the combination is associative, joining the same fields in any order or along any tree yields the same mean and variance up to floating point rounding.
+			* The statistical error of the target layer is set to the mean relative standard error of the mean of all elements with a non-zero mean and at least two samples.
+			* @param target The buffer to join into
+			* @param additional_source The buffer to join from
+			* @param layer_name The name of the layer
+			* @param dtype The data type of the layer in both buffers
+			* @throws RadiationFieldStoreException if the data type is not a floating point type or the layers differ in size
+			*/
+			static void join_layer_welford(VoxelBuffer& target, const VoxelBuffer& additional_source, const std::string& layer_name, Typing::DType dtype);
+
+			/** Tests if layers of a data type are joined by join_layer_welford in FieldJoinMode::Welford.
+			* Only floating point layers hold a mean. All other layers, e.g. counters, are joined by FieldJoinMode::Add instead and get no auxiliary layers.
+			* @param dtype The data type of the layer
+			* @return True, if the data type is a floating point type
+			*/
+			static bool is_welford_dtype(Typing::DType dtype);
+
+			/** Adds the auxiliary layers of FieldJoinMode::Welford to a layer, if missing
+			* @param buffer The buffer, which holds the layer
+			* @param layer_name The name of the layer
+			* @param samples The number of samples, the current values of the layer represent. Use 0 for a layer without data yet.
+			*/
+			static void ensure_welford_layers(VoxelBuffer& buffer, const std::string& layer_name, uint32_t samples);
+
+			/** Returns the name of the layer, whose auxiliary layer of FieldJoinMode::Welford a layer is
+			* @param layer_name The name of the layer
+			* @return The name of the layer of the mean or an empty string, if layer_name is not an auxiliary layer
+			*/
+			static std::string get_welford_value_layer(const std::string& layer_name);
+
+			/** Writes the standard error of the mean of a layer joined by FieldJoinMode::Welford to a layer of the same type, sqrt(m2 / (n * (n - 1))) per element.
+			* Elements with less than two samples get an uncertainty of 0.
+			* @param buffer The buffer, which holds the layer and its auxiliary layers
+			* @param layer_name The name of the layer
+			* @param uncertainty_layer_name The name of the layer to write the uncertainty to. Added, if missing.
+			* @throws RadiationFieldStoreException if the layer has no auxiliary layers or is not of a floating point type
+			*/
+			static void write_welford_uncertainty(VoxelBuffer& buffer, const std::string& layer_name, const std::string& uncertainty_layer_name);
+
 			/** Perform the actual merge of the fields
 			* @param target The target field
 			* @param additional_source The additional source field
@@ -113,6 +190,13 @@ namespace RadFiled3D {
 					throw RadiationFieldStoreException("Unknown join mode");
 				}
 			}
+
+		protected:
+			template<typename T>
+			static void join_layer_welford_as(VoxelBuffer& target, const VoxelBuffer& additional_source, const std::string& layer_name);
+
+			template<typename T>
+			static void write_welford_uncertainty_as(VoxelBuffer& buffer, const std::string& layer_name, const std::string& uncertainty_layer_name);
 		};
 
 		class IRadiationFieldExporter {
@@ -140,6 +224,34 @@ namespace RadFiled3D {
 			* @param ratio The ratio to use for the weighted join mode. Default is 0.f meaning only the data of the target field is used.
 			*/
 			virtual void join(std::shared_ptr<IRadiationField> target, std::shared_ptr<IRadiationField> additional_source, FieldJoinMode join_mode, FieldJoinCheckMode check_mode, float ratio = 0.f) const = 0;
+
+			/** Merge the radiation field to the one stored in a file without loading the stored field as a whole.
+			* The stored field is read, joined and written to a temporary file next to it one layer at a time, so that only a single layer of it has to be held in memory.
+			* The temporary file replaces the stored one after all layers were written. If joining fails, the stored file is left untouched.
+			* @param file The file of the radiation field to join to
+			* @param additional_source The radiation field to join from
+			* @param metadata The metadata to store with the joined radiation field
+			* @param join_mode The mode to join the fields
+			* @param check_mode The mode to check the fields
+			* @param ratio The ratio to use for the weighted join mode. Default is 0.f meaning only the data of the target field is used.
+			* @throw RadiationFieldStoreException If the file is corrupted or the fields can't be joined
+			*/
+			virtual void join_file(const std::string& file, std::shared_ptr<IRadiationField> additional_source, std::shared_ptr<RadFiled3D::Storage::RadiationFieldMetadata> metadata, FieldJoinMode join_mode, FieldJoinCheckMode check_mode, float ratio = 0.f) const = 0;
+
+			/** Merge the radiation field into the one stored in a file by overwriting the layers of the file in place.
+			* Only applies, if the stored field is structurally identical to the additional source: each layer of the additional source needs to be stored raw in the file with the same data type, unit and size and the serialized metadata needs to be as large as the stored one.
+			* The layers are read, joined and written back in small blocks, so neither field is copied and the size of the file does not change. The metadata is written last.
+			* As the file is modified in place, a failure during writing leaves a partially joined file behind.
+			* @param file The file of the radiation field to join to
+			* @param additional_source The radiation field to join from
+			* @param metadata The metadata to store with the joined radiation field
+			* @param join_mode The mode to join the fields
+			* @param check_mode The mode to check the fields
+			* @param ratio The ratio to use for the weighted join mode. Default is 0.f meaning only the data of the target field is used.
+			* @return True, if the field was joined. False, if the fields are not structurally identical, in which case the file was not modified and join_file needs to be used instead.
+			* @throw RadiationFieldStoreException If the file is corrupted
+			*/
+			virtual bool join_in_place(const std::string& file, std::shared_ptr<IRadiationField> additional_source, std::shared_ptr<RadFiled3D::Storage::RadiationFieldMetadata> metadata, FieldJoinMode join_mode, FieldJoinCheckMode check_mode, float ratio = 0.f) const = 0;
 		};
 
 		class IRadiationFieldImporter {
@@ -174,6 +286,15 @@ namespace RadFiled3D {
 			*/
 			virtual std::shared_ptr<IRadiationField> load(std::istream& buffer) const = 0;
 
+			/** Load the radiation field from a file by reading, validating and copying its layers on multiple threads at once.
+			* The loaded field is identical to the one loaded by load(std::istream&).
+			* @param file The file to load the radiation field from
+			* @param worker_count The number of threads to use
+			* @return The radiation field
+			* @throw RadiationFieldStoreException If the file does not exist or the file is corrupted
+			*/
+			virtual std::shared_ptr<IRadiationField> load_parallel(const std::string& file, size_t worker_count) const = 0;
+
 			/** Fully retrieves the metadata of the radiation field from a buffer
 			* @param buffer The buffer to get the metadata from
 			* @return The metadata of the radiation field
@@ -240,6 +361,12 @@ namespace RadFiled3D {
 				return *this->field_serializer;
 			}
 
+			/** Writes the version header and the metadata block, which precede the field block
+			* @param stream The stream to write to
+			* @param metadata The metadata of the radiation field
+			*/
+			void serialize_file_header(std::ostream& stream, std::shared_ptr<RadFiled3D::Storage::RadiationFieldMetadata> metadata) const;
+
 		public:
 			/** Serialize the radiation field to a stream
 			* @param stream The stream to serialize the radiation field to
@@ -278,6 +405,37 @@ namespace RadFiled3D {
 					new V1::MetadataAccessor()
 				) {}
 
+			protected:
+				/** Constructs a store, which shares the metadata block and the join logic of version 1 files
+				* @param file_version The version string written to the file header
+				* @param field_serializer The handler of the field block
+				*/
+				FieldStore(const std::string& file_version, RadFiled3D::Storage::BinayFieldBlockHandler* field_serializer) : BasicFieldStore(
+					file_version,
+					new V1::MetadataSerializer(),
+					field_serializer,
+					new V1::MetadataAccessor()
+				) {}
+
+				/** Location and type of a layer block within a file */
+				struct LayerBlockLocation {
+					size_t offset;
+					size_t size;
+					Typing::DType dtype;
+					std::string unit;
+				};
+
+				/** Locates all layer blocks of a field block by reading their headers only
+				* @param stream The stream of the file. Its read position is expected to be at the first channel block and is undefined afterwards.
+				* @param voxel_count The number of voxels of each layer
+				* @param field_data_end The position in the stream at which the channel blocks end
+				* @param file The name of the file, which is reported on errors
+				* @return The layer blocks of each channel by the names of the channels and layers
+				* @throw RadiationFieldStoreException If a channel or layer block is incomplete
+				*/
+				std::map<std::string, std::map<std::string, LayerBlockLocation>> locate_layer_blocks(std::istream& stream, size_t voxel_count, size_t field_data_end, const std::string& file) const;
+
+			public:
 				/** Merge the radiation field to the one of an existing
 				* @param target The radiation field to join to
 				* @param additional_source The radiation field to join from
@@ -286,24 +444,88 @@ namespace RadFiled3D {
 				*/
 				virtual void join(std::shared_ptr<IRadiationField> target, std::shared_ptr<IRadiationField> additional_source, FieldJoinMode join_mode, FieldJoinCheckMode check_mode, float ratio = 0.f) const override;
 
+				virtual void join_file(const std::string& file, std::shared_ptr<IRadiationField> additional_source, std::shared_ptr<RadFiled3D::Storage::RadiationFieldMetadata> metadata, FieldJoinMode join_mode, FieldJoinCheckMode check_mode, float ratio = 0.f) const override;
+
+				virtual bool join_in_place(const std::string& file, std::shared_ptr<IRadiationField> additional_source, std::shared_ptr<RadFiled3D::Storage::RadiationFieldMetadata> metadata, FieldJoinMode join_mode, FieldJoinCheckMode check_mode, float ratio = 0.f) const override;
+
 				/** Load a single layer from a buffer without loding the entire radiation field
 				* @param buffer The buffer to load the radiation field from
 				* @return The radiation field
 				* @throw RadiationFieldStoreException If the buffer is corrupted
 				*/
 				virtual std::shared_ptr<VoxelLayer> load_single_layer(std::istream& buffer, const std::string& channel, const std::string& layer) const override;
+
+				/** Load the radiation field from a file by reading and deserializing each layer block on a worker of its own.
+				* The layer blocks are located by their headers, read by positional reads and deserialized by the same handler as load(std::istream&) uses.
+				* @param file The file to load the radiation field from
+				* @param worker_count The number of threads to use
+				* @return The radiation field
+				* @throw RadiationFieldStoreException If the file does not exist or the file is corrupted
+				*/
+				virtual std::shared_ptr<IRadiationField> load_parallel(const std::string& file, size_t worker_count) const override;
+			};
+		};
+
+		namespace V2 {
+			/** Store of version 2 files.
+			* Version 2 files extend version 1 files by a layer index at the end of the file, which allows to locate every channel and layer without scanning the field data.
+			*/
+			class FieldStore : public V1::FieldStore {
+			public:
+				/** Constructs a store
+				* @param codec The codec to encode the layers with when storing fields
+				* @param brick_size The number of voxels along each edge of the bricks the layers of cartesian fields are split into when storing fields. 0 stores all layers contiguous.
+				*/
+				FieldStore(LayerCodec codec = LayerCodec::Raw, uint32_t brick_size = 0) : V1::FieldStore(
+					"2.0",
+					(RadFiled3D::Storage::BinayFieldBlockHandler*)new RadFiled3D::Storage::V2::BinayFieldBlockHandler(codec, brick_size)
+				) {}
+
+				/** Load a single layer from a buffer by looking it up in the layer index
+				* @param buffer The buffer to load the radiation field from
+				* @return The radiation field
+				* @throw RadiationFieldStoreException If the buffer is corrupted
+				*/
+				virtual std::shared_ptr<VoxelLayer> load_single_layer(std::istream& buffer, const std::string& channel, const std::string& layer) const override;
 			};
 		};
 
 		/** This class should be used to accutally store and load radiation fields.
 		* It will automatically detect the version of the file and use the correct store to load the radiation field.
 		* When using the same versions multiple times, the class will cache the store to avoid unnecessary reinitialization.
+		* Loading, storing and joining may be called from multiple threads at once, as long as no two threads write the same file.
 		*/
 		class FieldStore {
 		protected:
 			static std::shared_ptr<BasicFieldStore> store_instance;
 			static StoreVersion store_version;
 			static bool file_lock_syncronization;
+			static bool in_place_join;
+			static LayerCodec layer_codec;
+			static uint32_t layer_brick_size;
+			/** Guards the cached store and its configuration */
+			static std::mutex store_instance_mutex;
+
+			/** Creates a new store of a version with the current configuration
+			* @param version The version of the store
+			* @return The store
+			*/
+			static std::shared_ptr<BasicFieldStore> create_store_instance(StoreVersion version);
+
+			/** Returns the cached store of a version and replaces it, if it has another version.
+			* The returned store stays valid, even if another thread replaces the cached one afterwards.
+			* @param version The version of the store
+			* @return The store
+			*/
+			static std::shared_ptr<BasicFieldStore> get_store_instance(StoreVersion version);
+
+			/** Checks the metadata of a field to join against the metadata of the field to join to
+			* @param target_metadata The metadata of the field to join to
+			* @param source_metadata The metadata of the field to join
+			* @param check_mode The mode to check the metadata
+			* @throws RadiationFieldStoreException if the metadata does not match
+			*/
+			static void check_metadata(const FiledTypes::V1::RadiationFieldMetadataHeader& target_metadata, const FiledTypes::V1::RadiationFieldMetadataHeader& source_metadata, FieldJoinCheckMode check_mode);
 		public:
 			/** Enable or disable file transaction synchronization. This will make sure, that only one process can perform transactions such as joining on a file at a time and that other processes are queued.
 			* Default is disabled
@@ -314,6 +536,44 @@ namespace RadFiled3D {
 				FieldStore::file_lock_syncronization = enable;
 			}
 
+			/** Enable or disable joining fields into files in place. If enabled, join overwrites the layers of a stored field in place, whenever it is structurally identical to the joined field, instead of rewriting the whole file.
+			* Joining in place is not crash-safe: a crash or an exception during the join leaves a partially joined file with a stale header behind, while rewriting only replaces the file once the joined field was written completely.
+			* It also alters the file under other processes, which mapped it, e.g. by load_mapped: pages of the mapping not yet accessed show the joined data.
+			* Default is disabled
+			* @param enable Enable or disable joining in place
+			*/
+			static void enable_in_place_join(bool enable) {
+				FieldStore::in_place_join = enable;
+			}
+
+			/** Set the codec to encode the layers with when storing fields. Loading detects the codec of each layer on its own.
+			* Only stores of version 2 and above support codecs, version 1 files are always written raw.
+			* Default is LayerCodec::Raw
+			* @param codec The codec to use
+			*/
+			static void set_layer_codec(LayerCodec codec);
+
+			/** Get the codec layers are encoded with when storing fields
+			* @return The codec
+			*/
+			static LayerCodec get_layer_codec() {
+				return FieldStore::layer_codec;
+			}
+
+			/** Set the number of voxels along each edge of the cubic bricks the layers of cartesian fields are split into when storing fields.
+			* Bricked layers allow CartesianFieldAccessor::accessSubvolume to only read the bricks overlapping a region. Each brick is encoded with the layer codec on its own.
+			* Only stores of version 2 and above support bricks. Default is 0, which stores all layers contiguous.
+			* @param brick_size The brick edge length in voxels, e.g. 16 or 32
+			*/
+			static void set_layer_brick_size(uint32_t brick_size);
+
+			/** Get the number of voxels along each edge of the bricks layers are split into when storing fields
+			* @return The brick edge length in voxels, 0 if layers are stored contiguous
+			*/
+			static uint32_t get_layer_brick_size() {
+				return FieldStore::layer_brick_size;
+			}
+
 			/** Initialize the store instance. Optional: Will be called on load and store operations if not called manually.
 			* @param version The version of the store to use
 			*/
@@ -343,7 +603,8 @@ namespace RadFiled3D {
 			*/
 			static void serialize(std::ostream& stream, std::shared_ptr<IRadiationField> field, std::shared_ptr<RadFiled3D::Storage::RadiationFieldMetadata> metadata, StoreVersion version = StoreVersion::V1);
 
-			/** Load the radiation field from a file
+			/** Load the radiation field from a file.
+			* If VoxelBuffer::get_worker_count() is greater than 1, the layers are read and deserialized on that many threads, see IRadiationFieldImporter::load_parallel.
 			* @param file The file to load the radiation field from
 			* @return The radiation field
 			*/
@@ -355,6 +616,20 @@ namespace RadFiled3D {
 			*/
 			static std::shared_ptr<IRadiationField> load(std::istream& buffer);
 
+			/** Load the radiation field from a byte source, e.g. a member of an archive or an object of a remote store
+			* @param source The source to load the radiation field from
+			* @return The radiation field
+			*/
+			static std::shared_ptr<IRadiationField> load(const std::shared_ptr<ByteSource>& source);
+
+			/** Load the radiation field from a file by mapping it into memory instead of reading it.
+			* The layers of the returned field are views onto the mapping, which stays alive as long as any of them exists.
+			* Modifying the layers does not alter the file, as the mapping is copy-on-write.
+			* @param file The file to load the radiation field from
+			* @return The radiation field
+			*/
+			static std::shared_ptr<IRadiationField> load_mapped(const std::string& file);
+
 			/** Fully retrieves the metadata of the radiation field from a file
 			* @param file The file to get the metadata from
 			* @return The metadata of the radiation field
@@ -367,6 +642,12 @@ namespace RadFiled3D {
 			*/
 			static std::shared_ptr<RadFiled3D::Storage::RadiationFieldMetadata> load_metadata(std::istream& buffer);
 
+			/** Fully retrieves the metadata of the radiation field from a byte source
+			* @param source The source to get the metadata from
+			* @return The metadata of the radiation field
+			*/
+			static std::shared_ptr<RadFiled3D::Storage::RadiationFieldMetadata> load_metadata(const std::shared_ptr<ByteSource>& source);
+
 			/** Quickly peeks at the mandatory metadata header of the radiation field from a file
 			* @param file The file to get the metadata from
 			* @return The metadata header of the radiation field
@@ -394,6 +675,9 @@ namespace RadFiled3D {
 
 			/** Merge the radiation field to the one of an existing file
 			* Creates a new stored radiation field if no radiation field was present at the file path.
+			* If joining in place is enabled and the existing field is structurally identical to the joined one and stored raw, its layers are joined in place within the file.
+			* This is not crash-safe and alters the file under processes, which mapped it, see enable_in_place_join.
+			* Otherwise the existing field is joined layer by layer through a temporary file, which atomically replaces the existing file, so memory stays bounded by the largest layer of the existing field.
 			* @param field The radiation field to join
 			* @param metadata The metadata of the radiation field
 			* @param file The file to join the radiation field to
@@ -402,6 +686,21 @@ namespace RadFiled3D {
 			* @param fallback_version The version of the store to use if the file does not exist
 			*/
 			static void join(std::shared_ptr<IRadiationField> field, std::shared_ptr<RadiationFieldMetadata> metadata, const std::string& file, FieldJoinMode join_mode, FieldJoinCheckMode check_mode = FieldJoinCheckMode::MetadataSimulationSimilar, StoreVersion fallback_version = StoreVersion::V1);
+
+			/** Merges many stored radiation fields into a single new file by a parallel tree reduction.
+			* The files are joined pairwise along a balanced binary tree over their order, which is independent of the number of threads, so the result is reproducible.
+			* Each file is read exactly once and partial results are kept in memory. The primary particle counts are summed up and each AddWeighted join is weighted by the primary particles of both partial results,
+			* so the result equals joining all files one after another into the first one up to floating point rounding.
+			* The metadata of each file is checked against the one of the first file, which is stored with the result.
+			* @param files The files to merge. The first file determines the store version and the metadata of the result.
+			* @param output_file The file to store the merged radiation field to
+			* @param join_mode The mode to join the fields. Only modes, whose result does not depend on the order of joining, are supported: Identity, Add, Multiply, AddWeighted and Welford
+			* @param check_mode The mode to check the fields
+			* @param thread_count The maximum number of threads to reduce subtrees on. 0 uses all hardware threads.
+			* @param memory_budget The approximate number of bytes the fields held in memory at the same time may take. Limits the number of threads, so that each holds up to log2(files) + 2 fields. 0 does not limit the memory.
+			* @throws RadiationFieldStoreException if no files are given, the join mode is not supported or the fields can't be joined
+			*/
+			static void merge(const std::vector<std::string>& files, const std::string& output_file, FieldJoinMode join_mode, FieldJoinCheckMode check_mode = FieldJoinCheckMode::MetadataSimulationSimilar, size_t thread_count = 0, size_t memory_budget = 0);
 		
 			/** Construct a field accessor from a file, that can be used for all files that share the same structure (metadata-size and field structure)
 			* This is useful when parsing large datasets.
@@ -416,6 +715,12 @@ namespace RadFiled3D {
 			* @return The field accessor
 			*/
 			static std::shared_ptr<FieldAccessor> construct_accessor(std::istream& buffer);
+
+			/** Construct a field accessor from a byte source, that can be used for all files that share the same structure (metadata-size and field structure)
+			* @param source The source to construct the accessor from
+			* @return The field accessor
+			*/
+			static std::shared_ptr<FieldAccessor> construct_accessor(const std::shared_ptr<ByteSource>& source);
 		};
 	};
 }
\ No newline at end of file
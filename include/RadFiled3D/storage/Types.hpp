@@ -4,6 +4,7 @@
 #include "RadFiled3D/VoxelBuffer.hpp"
 #include <memory>
 #include <stdexcept>
+#include <cstdint>
 
 #ifdef __linux__
 #define strncpy_s(dest, src, count) strncpy(dest, src, count)
@@ -24,7 +25,20 @@ namespace RadFiled3D {
 		class FieldStore;
 
 		enum class StoreVersion {
-			V1 = 0
+			V1 = 0,
+			V2 = 1
+		};
+
+		/** The codec the voxel data of a layer is stored with.
+		* Raw: The voxel data is stored as is
+		* ShuffleRLE: The bytes of the data elements are grouped by significance and then run length encoded. Works best on sparse layers like histograms.
+		* Codecs are only applied by stores of version 2 and above.
+		*/
+		enum class LayerCodec : uint32_t {
+			/* Store the voxel data as is */
+			Raw = 0,
+			/* Byte shuffle the voxel data and run length encode it */
+			ShuffleRLE = 1
 		};
 
 		namespace FiledTypes {
@@ -119,6 +133,48 @@ namespace RadFiled3D {
 				struct RadiationFieldMetadataHeaderBlock {
 					size_t dynamic_metadata_size = 0;
 				};
+#pragma pack(pop)
+			};
+
+			/** Version 2 files share the layout of version 1 files and append a layer index table followed by a fixed size trailer.
+			* This allows to locate every channel and layer by reading the trailer and the index instead of walking all headers.
+			* Each layer block is prefixed by a LayerCodecHeader, which tells how the voxel data following the version 1 layer header is encoded.
+			* Layers of cartesian fields may be split into cubic bricks. Their voxel data then starts with a BrickTableHeader, followed by the offsets of all bricks plus the end offset of the last brick and the bricks themselves.
+			* Bricks are ordered x fastest, the same as voxels within a brick. Each brick is encoded on its own and stored raw if it would not become smaller.
+			* Only raw layers, which are not bricked, have a block exactly as large as their headers and voxels, so that the index alone tells if a layer is encoded.
+			*/
+			namespace V2 {
+#pragma pack(push, 4)
+				struct LayerCodecHeader {
+					uint32_t codec = 0;
+					uint32_t brick_size = 0;
+					size_t encoded_bytes = 0;
+					size_t decoded_bytes = 0;
+				};
+#pragma pack(pop)
+
+#pragma pack(push, 4)
+				struct BrickTableHeader {
+					glm::uvec3 voxel_counts = glm::uvec3(0);
+				};
+#pragma pack(pop)
+
+#pragma pack(push, 4)
+				struct FieldIndexHeader {
+					size_t metadata_fileheader_size = 0;
+					uint32_t field_type = 0;
+					V1::CartesianHeader cartesian_header;
+					V1::PolarHeader polar_header;
+					size_t channels_layers_bytes = 0;
+				};
+#pragma pack(pop)
+
+#pragma pack(push, 4)
+				struct FieldIndexTrailer {
+					char magic[8] = { 'R', 'F', '3', 'I', 'D', 'X', '2', 0 };
+					size_t index_offset = 0;
+					size_t index_bytes = 0;
+				};
 #pragma pack(pop)
 			};
 		};
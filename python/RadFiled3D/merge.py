@@ -0,0 +1,73 @@
+"""
+Merges partial result files into a single radiation field file.
+
+Usage:
+    python -m RadFiled3D.merge -o merged.rf3 --mode add_weighted --threads 8 --memory-budget 16G part_*.rf3
+"""
+from RadFiled3D.RadFiled3D import FieldStore, FieldJoinMode, FieldJoinCheckMode
+from typing import List, Optional
+import argparse
+import glob
+import sys
+
+
+JOIN_MODES = {
+    "identity": FieldJoinMode.IDENTITY,
+    "add": FieldJoinMode.ADD,
+    "multiply": FieldJoinMode.MULTIPLY,
+    "add_weighted": FieldJoinMode.ADD_WEIGHTED,
+    "welford": FieldJoinMode.WELFORD
+}
+
+CHECK_MODES = {
+    "strict": FieldJoinCheckMode.STRICT,
+    "metadata_simulation_similar": FieldJoinCheckMode.METADATA_SIMULATION_SIMILAR,
+    "metadata_software_equal": FieldJoinCheckMode.METADATA_SOFTWARE_EQUAL,
+    "metadata_software_similar": FieldJoinCheckMode.METADATA_SOFTWARE_SIMILAR,
+    "field_structure_only": FieldJoinCheckMode.FIELD_STRUCTURE_ONLY,
+    "field_units_only": FieldJoinCheckMode.FIELD_UNITS_ONLY,
+    "no_checks": FieldJoinCheckMode.NO_CHECKS
+}
+
+
+def parse_size(size: str) -> int:
+    """
+    Parse a number of bytes with an optional K, M, G or T suffix, e.g. 512M.
+    :param size: The size to parse.
+    :return: The number of bytes.
+    """
+    units = {"K": 1 << 10, "M": 1 << 20, "G": 1 << 30, "T": 1 << 40}
+    size = size.strip().upper().rstrip("B")
+    if len(size) > 0 and size[-1] in units:
+        return int(float(size[:-1]) * units[size[-1]])
+    return int(size)
+
+
+def main(argv: Optional[List[str]] = None) -> int:
+    parser = argparse.ArgumentParser(prog="python -m RadFiled3D.merge", description="Merge partial radiation field files into a single file by a parallel tree reduction.")
+    parser.add_argument("files", nargs="*", help="The files to merge. Glob patterns are expanded. The first file determines the metadata and store version of the result.")
+    parser.add_argument("-o", "--output", required=True, help="The file to store the merged radiation field to.")
+    parser.add_argument("-l", "--file-list", help="A text file listing further files to merge, one per line.")
+    parser.add_argument("-m", "--mode", choices=JOIN_MODES.keys(), default="add", help="The mode to join the fields with.")
+    parser.add_argument("-c", "--check", choices=CHECK_MODES.keys(), default="metadata_simulation_similar", help="The mode to check the fields with.")
+    parser.add_argument("-t", "--threads", type=int, default=0, help="The maximum number of threads. 0 uses all hardware threads.")
+    parser.add_argument("--memory-budget", type=parse_size, default=0, help="The approximate memory the fields may take at the same time, e.g. 16G. 0 does not limit the memory.")
+    args = parser.parse_args(argv)
+
+    files: List[str] = []
+    for pattern in args.files:
+        matches = sorted(glob.glob(pattern))
+        files.extend(matches if len(matches) > 0 else [pattern])
+    if args.file_list is not None:
+        with open(args.file_list, "r") as file_list:
+            files.extend(line.strip() for line in file_list if len(line.strip()) > 0)
+    if len(files) == 0:
+        parser.error("no files to merge")
+
+    FieldStore.merge(files, args.output, JOIN_MODES[args.mode], CHECK_MODES[args.check], args.threads, args.memory_budget)
+    print(f"Merged {len(files)} files into {args.output}")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
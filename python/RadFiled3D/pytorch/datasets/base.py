@@ -1,5 +1,4 @@
-from RadFiled3D.RadFiled3D import FieldStore, RadiationField as RawRadiationField, PolarRadiationField, CartesianRadiationField, RadiationFieldMetadata, VoxelGrid, PolarSegments, FieldAccessor, CartesianFieldAccessor, PolarFieldAccessor, Voxel
-import zipfile
+from RadFiled3D.RadFiled3D import FieldStore, RadiationField as RawRadiationField, PolarRadiationField, CartesianRadiationField, RadiationFieldMetadata, VoxelGrid, PolarSegments, FieldAccessor, CartesianFieldAccessor, PolarFieldAccessor, Voxel, ZipArchive, ByteSource
 from enum import Enum
 from torch import Tensor
 from torch.utils.data import Dataset
@@ -23,6 +22,7 @@ class RadiationFieldDataset(Dataset):
     A dataset that loads radiation field files and returns them as (field, metadata)-tuples.
     The dataset can be initialized with either a list of file paths in the file system (uncompressed) or a path to a zip file containing radiation field files.
     In the latter case, the file paths are either extracted from the zip file or can be provided as a list of relative paths. This is encouraged, as the splitting of the dataset in train, validation and test should be random an therefore all file paths should be known at the time of initialization.
+    Zip files are indexed once per process by a ZipArchive, so that loading an element does not reopen or search the zip file. Files stored uncompressed in the zip file are read without copies.
 
     The dataset can be created by using the DatasetBuilder class. This allows the Builder to parse the zip or folder structure correctly and link the metadata to the radiation field files.
 
@@ -45,20 +45,27 @@ class RadiationFieldDataset(Dataset):
         self.file_paths = file_paths
         
         self.zip_file = zip_file
+        self._zip_archive: ZipArchive = None
         self.metadata_load_mode = metadata_load_mode
         if self.file_paths is None and self.zip_file is not None:
-            with zipfile.ZipFile(self.zip_file, 'r') as zip_ref:
-                self.file_paths = [f for f in zip_ref.namelist() if f.endswith(".rf3")]
+            self.file_paths = [f for f in self.zip_archive.get_member_names() if f.endswith(".rf3")]
         elif self.file_paths is None and self.zip_file is None:
             raise ValueError("Either file_paths or zip_file must be provided.")
         
         self._field_accessor: FieldAccessor = None
-        self.file_paths = manager.list(file_paths) if file_paths is not None else None
+        self.file_paths = manager.list(self.file_paths) if self.file_paths is not None else None
+
+    def _get_zip_archive(self) -> Union[ZipArchive, None]:
+        if self._zip_archive is None and self.zip_file is not None:
+            self._zip_archive = ZipArchive(self.zip_file)
+        return self._zip_archive
+
+    zip_archive: Union[ZipArchive, None] = property(_get_zip_archive)
 
     def _get_field_accessor(self) -> Union[FieldAccessor, CartesianFieldAccessor, PolarFieldAccessor]:
         if self._field_accessor is None:
             if self.is_dataset_zipped:
-                self._field_accessor = FieldStore.construct_field_accessor_from_buffer(self.load_file_buffer(0))
+                self._field_accessor = FieldStore.construct_field_accessor_from_source(self.load_file_source(0))
             else:
                 self._field_accessor = FieldStore.construct_field_accessor(self.file_paths[0])
         return self._field_accessor
@@ -79,11 +86,29 @@ class RadiationFieldDataset(Dataset):
         
     def load_file_buffer_by_path(self, file_path: str) -> bytes:
         if self.zip_file is not None:
-            with zipfile.ZipFile(self.zip_file, 'r') as zip_ref:
-                with zip_ref.open(file_path) as file:
-                    return file.read()
+            source = self.load_file_source_by_path(file_path)
+            return source.read(0, source.size())
         else:
             return open(file_path, 'rb').read()
+
+    def load_file_source(self, idx: int) -> ByteSource:
+        """
+        Opens a file of a zipped dataset as a byte source given a file index.
+        :param idx: The index of the file in the dataset.
+        :return: The byte source of the file.
+        """
+        return self.load_file_source_by_path(self.file_paths[idx])
+
+    def load_file_source_by_path(self, file_path: str) -> ByteSource:
+        """
+        Opens a file of a zipped dataset as a byte source given a file path.
+        Files stored uncompressed are views onto the mapped zip file, compressed files are inflated into memory.
+        :param file_path: The path to the file in the zip file.
+        :return: The byte source of the file.
+        """
+        if self.zip_file is None:
+            raise ValueError("Byte sources are only provided for zipped datasets.")
+        return self.zip_archive.open(file_path)
     
     def _get_field(self, idx: int) -> Union[RawRadiationField, CartesianRadiationField, PolarRadiationField]:
         """
@@ -100,7 +125,7 @@ class RadiationFieldDataset(Dataset):
         :return: The radiation field.
         """
         if self.is_dataset_zipped:
-            return self.field_accessor.access_field_from_buffer(self.load_file_buffer_by_path(file_path))
+            return self.field_accessor.access_field_from_source(self.load_file_source_by_path(file_path))
         else:
             return self.field_accessor.access_field(file_path)
 
@@ -151,11 +176,10 @@ class RadiationFieldDataset(Dataset):
         :return: The metadata of the radiation field.
         """
         if self.is_dataset_zipped:
-            file_buffer = self.load_file_buffer_by_path(file_path)
             if self.metadata_load_mode == MetadataLoadMode.FULL:
-                metadata: RadiationFieldMetadata = FieldStore.peek_metadata_from_buffer(file_buffer)
+                metadata: RadiationFieldMetadata = FieldStore.peek_metadata_from_source(self.load_file_source_by_path(file_path))
             elif self.metadata_load_mode == MetadataLoadMode.HEADER:
-                metadata: RadiationFieldMetadata = FieldStore.peek_metadata_from_buffer(file_buffer)
+                metadata: RadiationFieldMetadata = FieldStore.peek_metadata_from_source(self.load_file_source_by_path(file_path))
             else:
                 metadata = None
         else:
@@ -177,7 +201,7 @@ class RadiationFieldDataset(Dataset):
         :return: The voxel.
         """
         if self.is_dataset_zipped:
-            return self.field_accessor.access_voxel_flat_from_buffer(self.load_file_buffer(file_idx), channel_name, layer_name, vx_idx)
+            return self.field_accessor.access_voxel_flat_from_source(self.load_file_source(file_idx), channel_name, layer_name, vx_idx)
         else:
             return self.field_accessor.access_voxel_flat(self.file_paths[file_idx], channel_name, layer_name, vx_idx)
 
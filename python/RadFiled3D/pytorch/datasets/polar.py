@@ -27,7 +27,7 @@ class PolarFieldDataset(RadiationFieldDataset):
         :return: The radiation layer.
         """
         if self.is_dataset_zipped:
-            return self.field_accessor.access_layer_from_buffer(self.load_file_buffer(idx), channel_name, layer_name)
+            return self.field_accessor.access_layer_from_source(self.load_file_source(idx), channel_name, layer_name)
         else:
             return self.field_accessor.access_layer(self.file_paths[idx], channel_name, layer_name)
     
@@ -14,13 +14,17 @@
 #include <stdexcept>
 #include "RadFiled3D/storage/FieldSerializer.hpp"
 #include "RadFiled3D/GridTracer.hpp"
+#include "RadFiled3D/LayerExpression.hpp"
+#include "RadFiled3D/helpers/ZipArchive.hpp"
 #include <fstream>
 #include <atomic>
 #include <map>
 #include <memory>
 #include <string>
 #include <tuple>
+#include <type_traits>
 #include <iostream>
+#include <limits>
 #include <RadFiled3D/dataset/helpers.hpp>
 
 
@@ -201,6 +205,39 @@ py::array create_py_array_generic(const T* data, size_t len, size_t element_size
 	)));
 }
 
+template<typename T>
+py::array create_py_array_generic(const T* data, size_t len, size_t element_size, std::shared_ptr<void> ptr) {
+    auto memory_safe_struct = shared_ptrs.find((void*)data);
+    if (memory_safe_struct != shared_ptrs.end()) {
+        memory_safe_struct->second.first++;
+    }
+    else {
+        shared_ptrs[(void*)data] = std::make_pair(1, ptr);
+    }
+
+    const size_t components = static_cast<size_t>(element_size / sizeof(T));
+    auto capsule = py::capsule(data, [](void* data) {
+        auto memory_safe_struct = shared_ptrs.find((void*)data);
+        if (memory_safe_struct != shared_ptrs.end()) {
+            memory_safe_struct->second.first--;
+            if (memory_safe_struct->second.first == 0) {
+                shared_ptrs.erase(memory_safe_struct);
+            }
+        }
+    });
+    return (components > 1) ? static_cast<py::array>(py::array_t<T>(
+        { len, components },  // shape
+        { element_size, sizeof(T) },  // strides
+        data,
+        capsule
+    )) : static_cast<py::array>(py::array_t<T>(
+        { len },  // shape
+        { sizeof(T) },  // strides
+        data,
+        capsule
+    ));
+}
+
 template<typename T>
 py::array create_py_array_generic(const T* data, const glm::uvec2& shape, size_t element_size, std::shared_ptr<void> ptr) {
     auto memory_safe_struct = shared_ptrs.find((void*)data);
@@ -1109,7 +1146,8 @@ PYBIND11_MODULE(RadFiled3D, m) {
         .value("SUBTRACT", FieldJoinMode::Subtract)
         .value("DIVIDE", FieldJoinMode::Divide)
         .value("MULTIPLY", FieldJoinMode::Multiply)
-        .value("ADD_WEIGHTED", FieldJoinMode::AddWeighted);
+        .value("ADD_WEIGHTED", FieldJoinMode::AddWeighted)
+        .value("WELFORD", FieldJoinMode::Welford);
 
     py::enum_<FieldType>(m, "FieldType")
         .value("CARTESIAN", FieldType::Cartesian)
@@ -1126,11 +1164,17 @@ PYBIND11_MODULE(RadFiled3D, m) {
 
     py::class_<VoxelBuffer, std::shared_ptr<VoxelBuffer>>(m, "VoxelBuffer")
         .def("get_voxel_count", &VoxelBuffer::get_voxel_count)
+        .def("compact_layers", &VoxelBuffer::compact_layers)
+        .def_static("set_worker_count", &VoxelBuffer::set_worker_count, py::arg("worker_count"))
+        .def_static("get_worker_count", &VoxelBuffer::get_worker_count)
         .def("get_layers", &VoxelBuffer::get_layers)
 		.def("has_layer", &VoxelBuffer::has_layer)
         .def("get_layer_unit", &VoxelBuffer::get_layer_unit)
         .def("get_statistical_error", &VoxelBuffer::get_statistical_error)
 		.def("set_statistical_error", &VoxelBuffer::set_statistical_error)
+        .def("write_welford_uncertainty", [](VoxelBuffer& self, const std::string& layer_name, const std::string& uncertainty_layer_name) {
+            RadFiled3D::Storage::ExporterHelpers::write_welford_uncertainty(self, layer_name, uncertainty_layer_name);
+            }, py::arg("layer_name"), py::arg("uncertainty_layer_name"))
         .def("get_layer_voxel_type", [](VoxelBuffer& self, const std::string& layer_name) {
             return self.get_voxel_flat<IVoxel>(layer_name, 0).get_type();
             })
@@ -1171,6 +1215,34 @@ PYBIND11_MODULE(RadFiled3D, m) {
                 self.add_custom_layer<HistogramVoxel>(name, HistogramVoxel(bins, bin_width, nullptr), 0.f, unit);
             }, py::arg("name"), py::arg("bins"), py::arg("bin_width"), py::arg("unit"));
 
+        // expressions only reference their operand buffers, so each expression keeps the python objects of its operands alive
+        py::class_<LayerExpression>(m, "LayerExpression")
+            .def(py::init<double>(), py::arg("value"))
+            .def_static("layer", &LayerExpression::layer, py::arg("buffer"), py::arg("layer_name"), py::keep_alive<0, 1>())
+            .def_static("buffer", &LayerExpression::buffer, py::arg("buffer"), py::keep_alive<0, 1>())
+            .def_static("constant", &LayerExpression::constant, py::arg("value"))
+            .def_static("divide_or_zero", &LayerExpression::divide_or_zero, py::arg("dividend"), py::arg("divisor"), py::keep_alive<0, 1>(), py::keep_alive<0, 2>())
+            .def("evaluate", py::overload_cast<VoxelBuffer&, const std::string&>(&LayerExpression::evaluate, py::const_), py::arg("target"), py::arg("layer_name"), py::call_guard<py::gil_scoped_release>())
+            .def("evaluate", py::overload_cast<VoxelBuffer&>(&LayerExpression::evaluate, py::const_), py::arg("target"), py::call_guard<py::gil_scoped_release>())
+            .def("to_string", &LayerExpression::to_string)
+            .def("__repr__", [](const LayerExpression& self) {
+                return "<LayerExpression " + self.to_string() + ">";
+            })
+            .def("__add__", [](const LayerExpression& a, const LayerExpression& b) { return a + b; }, py::is_operator(), py::keep_alive<0, 1>(), py::keep_alive<0, 2>())
+            .def("__sub__", [](const LayerExpression& a, const LayerExpression& b) { return a - b; }, py::is_operator(), py::keep_alive<0, 1>(), py::keep_alive<0, 2>())
+            .def("__mul__", [](const LayerExpression& a, const LayerExpression& b) { return a * b; }, py::is_operator(), py::keep_alive<0, 1>(), py::keep_alive<0, 2>())
+            .def("__truediv__", [](const LayerExpression& a, const LayerExpression& b) { return a / b; }, py::is_operator(), py::keep_alive<0, 1>(), py::keep_alive<0, 2>())
+            .def("__add__", [](const LayerExpression& a, double b) { return a + b; }, py::is_operator(), py::keep_alive<0, 1>())
+            .def("__sub__", [](const LayerExpression& a, double b) { return a - b; }, py::is_operator(), py::keep_alive<0, 1>())
+            .def("__mul__", [](const LayerExpression& a, double b) { return a * b; }, py::is_operator(), py::keep_alive<0, 1>())
+            .def("__truediv__", [](const LayerExpression& a, double b) { return a / b; }, py::is_operator(), py::keep_alive<0, 1>())
+            .def("__radd__", [](const LayerExpression& a, double b) { return b + a; }, py::is_operator(), py::keep_alive<0, 1>())
+            .def("__rsub__", [](const LayerExpression& a, double b) { return b - a; }, py::is_operator(), py::keep_alive<0, 1>())
+            .def("__rmul__", [](const LayerExpression& a, double b) { return b * a; }, py::is_operator(), py::keep_alive<0, 1>())
+            .def("__rtruediv__", [](const LayerExpression& a, double b) { return b / a; }, py::is_operator(), py::keep_alive<0, 1>())
+            .def("__neg__", [](const LayerExpression& a) { return -a; }, py::is_operator(), py::keep_alive<0, 1>());
+        py::implicitly_convertible<double, LayerExpression>();
+
         py::class_<VoxelGridBuffer, std::shared_ptr<VoxelGridBuffer>, VoxelBuffer>(m, "VoxelGridBuffer")
             .def("get_voxel_counts", &VoxelGridBuffer::get_voxel_counts)
             .def("get_voxel_dimensions", &VoxelGridBuffer::get_voxel_dimensions)
@@ -1317,7 +1389,32 @@ PYBIND11_MODULE(RadFiled3D, m) {
                 }, py::return_value_policy::reference)
                 .def("get_unit", &VoxelLayer::get_unit)
                 .def("get_statistical_error", &VoxelLayer::get_statistical_error)
-                .def("get_voxel_count", &VoxelLayer::get_voxel_count);
+                .def("get_voxel_count", &VoxelLayer::get_voxel_count)
+                .def("is_compact", &VoxelLayer::is_compact)
+                .def("compact", &VoxelLayer::compact)
+                .def_static("set_compact_by_default", &VoxelLayer::set_compact_by_default, py::arg("compact"))
+                .def_static("is_compact_by_default", &VoxelLayer::is_compact_by_default);
+
+            py::class_<ILayerAllocator, std::shared_ptr<ILayerAllocator>>(m, "LayerAllocator")
+                .def_static("get_default", &ILayerAllocator::get_default)
+                .def_static("set_default", &ILayerAllocator::set_default, py::arg("allocator"));
+
+            py::class_<AlignedLayerAllocator, std::shared_ptr<AlignedLayerAllocator>, ILayerAllocator>(m, "AlignedLayerAllocator")
+                .def(py::init<size_t>(), py::arg("alignment") = AlignedLayerAllocator::DEFAULT_ALIGNMENT)
+                .def("get_alignment", &AlignedLayerAllocator::get_alignment);
+
+            py::class_<HugePageLayerAllocator, std::shared_ptr<HugePageLayerAllocator>, AlignedLayerAllocator>(m, "HugePageLayerAllocator")
+                .def(py::init<>());
+
+            py::class_<ArenaLayerAllocator, std::shared_ptr<ArenaLayerAllocator>, ILayerAllocator>(m, "ArenaLayerAllocator")
+                .def(py::init([](std::shared_ptr<ILayerAllocator> upstream, size_t max_cached_bytes) {
+                    if (upstream == nullptr)
+                        upstream = std::make_shared<AlignedLayerAllocator>();
+                    return std::make_shared<ArenaLayerAllocator>(upstream, max_cached_bytes);
+                }), py::arg("upstream") = std::shared_ptr<ILayerAllocator>(nullptr), py::arg("max_cached_bytes") = std::numeric_limits<size_t>::max())
+                .def("release", &ArenaLayerAllocator::release)
+                .def("get_cached_bytes", &ArenaLayerAllocator::get_cached_bytes)
+                .def("get_reuse_count", &ArenaLayerAllocator::get_reuse_count);
 
             py::class_<VoxelGrid, std::shared_ptr<VoxelGrid>>(m, "VoxelGrid")
                 .def(py::init([](const glm::vec3& field_dimensions, const glm::vec3& voxel_dimensions, std::shared_ptr<VoxelLayer> layer) {
@@ -1726,7 +1823,12 @@ PYBIND11_MODULE(RadFiled3D, m) {
             );
 
         py::enum_<Storage::StoreVersion>(m, "StoreVersion")
-            .value("V1", Storage::StoreVersion::V1);
+            .value("V1", Storage::StoreVersion::V1)
+            .value("V2", Storage::StoreVersion::V2);
+
+        py::enum_<Storage::LayerCodec>(m, "LayerCodec")
+            .value("RAW", Storage::LayerCodec::Raw)
+            .value("SHUFFLE_RLE", Storage::LayerCodec::ShuffleRLE);
 
         py::class_<RadFiled3D::Storage::FieldAccessor, std::shared_ptr<FieldAccessor>>(m, "FieldAccessor")
 			.def(py::pickle(    // general fallback for all FieldAccessor types. No explicit testing if the type python is expecting matches the unpickle procedure loaded, but should be fine for future accessors.
@@ -1747,12 +1849,19 @@ PYBIND11_MODULE(RadFiled3D, m) {
             })
             .def("access_field_from_buffer", [](const FieldAccessor& self, const py::bytes& bytes) {
                 std::istringstream stream(static_cast<std::string>(bytes));
+                py::gil_scoped_release release;
                 return self.accessField(stream);
             })
             .def("access_field", [](const FieldAccessor& self, const std::string& file) {
 			    std::ifstream stream(file, std::ios::binary);
                 return self.accessField(stream);
-            })
+            }, py::call_guard<py::gil_scoped_release>())
+            .def("access_field_mapped", [](const FieldAccessor& self, const std::string& file) {
+                return self.accessField(std::make_shared<MappedFile>(file));
+            }, py::call_guard<py::gil_scoped_release>())
+            .def("access_field_from_source", [](const FieldAccessor& self, const std::shared_ptr<ByteSource>& source) {
+                return self.accessField(source);
+            }, py::arg("source"), py::call_guard<py::gil_scoped_release>())
 			.def_static("get_store_version", [](const py::bytes& bytes) {
                 std::istringstream stream(static_cast<std::string>(bytes));
 			    return FieldAccessor::getStoreVersion(stream);
@@ -1760,6 +1869,8 @@ PYBIND11_MODULE(RadFiled3D, m) {
             .def("get_voxel_count", [](const FieldAccessor& self) {
                 return self.getVoxelCount();
             })
+            .def("set_voxel_read_gap_threshold", &FieldAccessor::setVoxelReadGapThreshold, py::arg("bytes"))
+            .def("get_voxel_read_gap_threshold", &FieldAccessor::getVoxelReadGapThreshold)
 			.def("__repr__", [](const FieldAccessor& a) {
                 std::string field_type = "";
 				switch (a.getFieldType()) {
@@ -1778,18 +1889,22 @@ PYBIND11_MODULE(RadFiled3D, m) {
             .def("access_voxel_flat", [](const FieldAccessor& self, const std::string& file, const std::string& channel_name, const std::string& layer_name, size_t idx) {
                 std::ifstream stream(file, std::ios::binary);
                 return encapsulate_voxel(self.accessVoxelRawFlat(stream, channel_name, layer_name, idx));
-            })
+            }, py::call_guard<py::gil_scoped_release>())
             .def("access_voxel_flat_from_buffer", [](const FieldAccessor& self, const py::bytes& bytes, const std::string& channel_name, const std::string& layer_name, size_t idx) {
                 std::istringstream stream(static_cast<std::string>(bytes));
+                py::gil_scoped_release release;
                 return encapsulate_voxel(self.accessVoxelRawFlat(stream, channel_name, layer_name, idx));
-            });
+            })
+            .def("access_voxel_flat_from_source", [](const FieldAccessor& self, const std::shared_ptr<ByteSource>& source, const std::string& channel_name, const std::string& layer_name, size_t idx) {
+                return encapsulate_voxel(self.accessVoxelRawFlat(source, channel_name, layer_name, idx));
+            }, py::arg("source"), py::arg("channel_name"), py::arg("layer_name"), py::arg("idx"), py::call_guard<py::gil_scoped_release>());
 
         py::class_<Storage::CartesianFieldAccessor, std::shared_ptr<CartesianFieldAccessor>, RadFiled3D::Storage::FieldAccessor>(m, "CartesianFieldAccessor")
 			.def(py::init([](const std::shared_ptr<FieldAccessor>& base) { return std::dynamic_pointer_cast<Storage::CartesianFieldAccessor>(base); }))
             .def("access_voxel_flat", [](const Storage::CartesianFieldAccessor& self, const std::string& file, const std::string& channel_name, const std::string& layer_name, size_t idx) {
 			    std::ifstream stream(file, std::ios::binary);
 			    return encapsulate_voxel(self.accessVoxelRawFlat(stream, channel_name, layer_name, idx));
-			})
+			}, py::call_guard<py::gil_scoped_release>())
             .def("get_field_type", [](const CartesianFieldAccessor& self) {
                 return self.getFieldType();
             })
@@ -1798,46 +1913,73 @@ PYBIND11_MODULE(RadFiled3D, m) {
             })
 			.def("access_voxel_flat_from_buffer", [](const Storage::CartesianFieldAccessor& self, const py::bytes& bytes, const std::string& channel_name, const std::string& layer_name, size_t idx) {
 			    std::istringstream stream(static_cast<std::string>(bytes));
+                py::gil_scoped_release release;
                 return encapsulate_voxel(self.accessVoxelRawFlat(stream, channel_name, layer_name, idx));
 			})
             .def("access_field", [](const Storage::CartesianFieldAccessor& self, const std::string& file) {
 			    std::ifstream stream(file, std::ios::binary);
 			    return self.accessField(stream);
-		    })
+		    }, py::call_guard<py::gil_scoped_release>())
 			.def("access_field_from_buffer", [](const Storage::CartesianFieldAccessor& self, const py::bytes& bytes) {
 			    std::istringstream stream(static_cast<std::string>(bytes));
+			    py::gil_scoped_release release;
 			    return self.accessField(stream);
 			})
             .def("access_layer_from_buffer", [](const Storage::CartesianFieldAccessor& self, const py::bytes& bytes, const std::string& channel_name, const std::string& layer_name) {
                 std::istringstream stream(static_cast<std::string>(bytes));
+			    py::gil_scoped_release release;
 			    return self.accessLayer(stream, channel_name, layer_name);
 			})
 			.def("access_layer", [](const Storage::CartesianFieldAccessor& self, const std::string& file, const std::string& channel_name, const std::string& layer_name) {
 			    std::ifstream stream(file, std::ios::binary);
 			    return self.accessLayer(stream, channel_name, layer_name);
-		    })
+		    }, py::call_guard<py::gil_scoped_release>())
+            .def("access_layer_mapped", [](const Storage::CartesianFieldAccessor& self, const std::string& file, const std::string& channel_name, const std::string& layer_name) {
+                return self.accessLayer(std::make_shared<MappedFile>(file), channel_name, layer_name);
+            }, py::call_guard<py::gil_scoped_release>())
+            .def("access_layer_from_source", [](const Storage::CartesianFieldAccessor& self, const std::shared_ptr<ByteSource>& source, const std::string& channel_name, const std::string& layer_name) {
+                return self.accessLayer(source, channel_name, layer_name);
+            }, py::arg("source"), py::arg("channel_name"), py::arg("layer_name"), py::call_guard<py::gil_scoped_release>())
+            .def("access_subvolume", [](const Storage::CartesianFieldAccessor& self, const std::string& file, const std::string& channel_name, const std::string& layer_name, const glm::uvec3& min_idx, const glm::uvec3& max_idx) {
+                std::ifstream stream(file, std::ios::binary);
+                return self.accessSubvolume(stream, channel_name, layer_name, min_idx, max_idx);
+            }, py::arg("file"), py::arg("channel_name"), py::arg("layer_name"), py::arg("min_idx"), py::arg("max_idx"), py::call_guard<py::gil_scoped_release>())
+            .def("access_subvolume_from_buffer", [](const Storage::CartesianFieldAccessor& self, const py::bytes& bytes, const std::string& channel_name, const std::string& layer_name, const glm::uvec3& min_idx, const glm::uvec3& max_idx) {
+                std::istringstream stream(static_cast<std::string>(bytes));
+                py::gil_scoped_release release;
+                return self.accessSubvolume(stream, channel_name, layer_name, min_idx, max_idx);
+            }, py::arg("buffer"), py::arg("channel_name"), py::arg("layer_name"), py::arg("min_idx"), py::arg("max_idx"))
+            .def("access_subvolume_mapped", [](const Storage::CartesianFieldAccessor& self, const std::string& file, const std::string& channel_name, const std::string& layer_name, const glm::uvec3& min_idx, const glm::uvec3& max_idx) {
+                return self.accessSubvolume(std::make_shared<MappedFile>(file), channel_name, layer_name, min_idx, max_idx);
+            }, py::arg("file"), py::arg("channel_name"), py::arg("layer_name"), py::arg("min_idx"), py::arg("max_idx"), py::call_guard<py::gil_scoped_release>())
             .def("access_layer_across_channels", [](const Storage::CartesianFieldAccessor& self, const std::string& file, const std::string& layer_name) {
 			    std::ifstream stream(file, std::ios::binary);
 			    return self.accessLayerAcrossChannels(stream, layer_name);
-			})
+			}, py::call_guard<py::gil_scoped_release>())
             .def("access_layer_across_channels_from_buffer", [](const Storage::CartesianFieldAccessor& self, const py::bytes& bytes, const std::string& layer_name) {
 			    std::istringstream stream(static_cast<std::string>(bytes));
+			    py::gil_scoped_release release;
 			    return self.accessLayerAcrossChannels(stream, layer_name);
 			})
 			.def("access_channel", [](const Storage::CartesianFieldAccessor& self, const std::string& file, const std::string& channel_name) {
 			    std::ifstream stream(file, std::ios::binary);
 			    return self.accessChannel(stream, channel_name);
-			})
+			}, py::call_guard<py::gil_scoped_release>())
             .def("access_channel_from_buffer", [](const Storage::CartesianFieldAccessor& self, const py::bytes& bytes, const std::string& channel_name) {
                 std::istringstream stream(static_cast<std::string>(bytes));
+                py::gil_scoped_release release;
                 return self.accessChannel(stream, channel_name);
             })
+            .def("access_channel_mapped", [](const Storage::CartesianFieldAccessor& self, const std::string& file, const std::string& channel_name) {
+                return self.accessChannel(std::make_shared<MappedFile>(file), channel_name);
+            }, py::call_guard<py::gil_scoped_release>())
 			.def("access_voxel", [](const Storage::CartesianFieldAccessor& self, const std::string& file, const std::string& channel_name, const std::string& layer_name, const glm::uvec3& coord) {
 			    std::ifstream stream(static_cast<std::string>(file), std::ios::binary);
 			    return encapsulate_voxel(self.accessVoxelRaw(stream, channel_name, layer_name, coord));
-			})
+			}, py::call_guard<py::gil_scoped_release>())
             .def("access_voxel_from_buffer", [](const Storage::CartesianFieldAccessor& self, const py::bytes& bytes, const std::string& channel_name, const std::string& layer_name, const glm::uvec3& coord) {
                 std::istringstream stream(static_cast<std::string>(bytes));
+                py::gil_scoped_release release;
                 return encapsulate_voxel(self.accessVoxelRaw(stream, channel_name, layer_name, coord));
             })
 			.def("__repr__", [](const Storage::CartesianFieldAccessor& self) {
@@ -1846,12 +1988,13 @@ PYBIND11_MODULE(RadFiled3D, m) {
 			})
 			.def("access_voxel_by_coord_from_buffer", [](const Storage::CartesianFieldAccessor& self, const py::bytes& bytes, const std::string& channel_name, const std::string& layer_name, const glm::vec3& coord) {
                 std::istringstream stream(static_cast<std::string>(bytes));
+			    py::gil_scoped_release release;
 			    return encapsulate_voxel(self.accessVoxelRawByCoord(stream, channel_name, layer_name, coord));
 			})
             .def("access_voxel_by_coord", [](const Storage::CartesianFieldAccessor& self, const std::string& file, const std::string& channel_name, const std::string& layer_name, const glm::vec3& coord) {
 			    std::ifstream stream(file, std::ios::binary);
                 return encapsulate_voxel(self.accessVoxelRawByCoord(stream, channel_name, layer_name, coord));
-            });
+            }, py::call_guard<py::gil_scoped_release>());
         
 		py::class_<Storage::V1::CartesianFieldAccessor, std::shared_ptr<Storage::V1::CartesianFieldAccessor>, Storage::CartesianFieldAccessor>(m, "CartesianFieldAccessorV1")
             .def(py::pickle(
@@ -1882,6 +2025,28 @@ PYBIND11_MODULE(RadFiled3D, m) {
 				return std::string("<RadFiled3D.CartesianFieldAccessorV1 (voxels: ") + std::to_string(voxels) + std::string(")>");
 			});
 
+		py::class_<Storage::V2::CartesianFieldAccessor, std::shared_ptr<Storage::V2::CartesianFieldAccessor>, Storage::V1::CartesianFieldAccessor>(m, "CartesianFieldAccessorV2")
+            .def(py::pickle(
+                [](const Storage::V2::CartesianFieldAccessor& self) {
+                    auto data = FieldAccessor::Serialize(&self);
+                    return FieldAccessorPickleTuple(self.getFieldType(), data);
+                },
+                [](const FieldAccessorPickleTuple& t) {
+                    FieldType type = std::get<0>(t);
+                    if (type != FieldType::Cartesian) {
+                        throw std::runtime_error("Unsupported field type: " + std::to_string(static_cast<int>(type)));
+                    }
+                    if (std::get<1>(t).size() == 0) {
+                        throw std::runtime_error("Empty data");
+                    }
+                    return std::dynamic_pointer_cast<Storage::V2::CartesianFieldAccessor>(FieldAccessor::Deserialize(std::get<1>(t)));
+                }
+            ))
+			.def("__repr__", [](const V2::CartesianFieldAccessor& self) {
+			    auto voxels = self.getVoxelCount();
+				return std::string("<RadFiled3D.CartesianFieldAccessorV2 (voxels: ") + std::to_string(voxels) + std::string(")>");
+			});
+
 		py::class_<Storage::PolarFieldAccessor, std::shared_ptr<PolarFieldAccessor>, Storage::FieldAccessor>(m, "PolarFieldAccessor")
             .def("get_voxel_count", [](const PolarFieldAccessor& self) {
                 return self.getVoxelCount();
@@ -1891,10 +2056,15 @@ PYBIND11_MODULE(RadFiled3D, m) {
             })
             .def("access_layer", [](const PolarFieldAccessor& self, const py::bytes& bytes, const std::string& channel_name, const std::string& layer_name) {
                 std::istringstream stream(static_cast<std::string>(bytes));
+                py::gil_scoped_release release;
                 return self.accessLayer(stream, channel_name, layer_name);
             })
+            .def("access_layer_from_source", [](const PolarFieldAccessor& self, const std::shared_ptr<ByteSource>& source, const std::string& channel_name, const std::string& layer_name) {
+                return self.accessLayer(source, channel_name, layer_name);
+            }, py::arg("source"), py::arg("channel_name"), py::arg("layer_name"), py::call_guard<py::gil_scoped_release>())
 			.def("access_voxel", [](const PolarFieldAccessor& self, const py::bytes& bytes, const std::string& channel_name, const std::string& layer_name, const glm::uvec2& coord) {
                 std::istringstream stream(static_cast<std::string>(bytes));
+			    py::gil_scoped_release release;
 			    return encapsulate_voxel(self.accessVoxelRaw(stream, channel_name, layer_name, coord));
 		    })
 			.def("__repr__", [](const PolarFieldAccessor& a) {
@@ -1903,6 +2073,7 @@ PYBIND11_MODULE(RadFiled3D, m) {
 		    })
 			.def("access_voxel_by_coord", [](const PolarFieldAccessor& self, const py::bytes& bytes, const std::string& channel_name, const std::string& layer_name, const glm::vec2& coord) {
                 std::istringstream stream(static_cast<std::string>(bytes));
+			    py::gil_scoped_release release;
 			    return encapsulate_voxel(self.accessVoxelRawByCoord(stream, channel_name, layer_name, coord));
 			});
 
@@ -1934,34 +2105,128 @@ PYBIND11_MODULE(RadFiled3D, m) {
 			    return std::string("<RadFiled3D.PolarFieldAccessorV1 (voxels: ") + std::to_string(voxels) + std::string(")>");
 			});
 
+		py::class_<V2::PolarFieldAccessor, std::shared_ptr<V2::PolarFieldAccessor>, V1::PolarFieldAccessor>(m, "PolarFieldAccessorV2")
+            .def(py::pickle(
+                [](const Storage::V2::PolarFieldAccessor& self) {
+                    auto data = FieldAccessor::Serialize(&self);
+                    return FieldAccessorPickleTuple(self.getFieldType(), data);
+                },
+                [](const FieldAccessorPickleTuple& t) {
+                    FieldType type = std::get<0>(t);
+                    if (type != FieldType::Polar) {
+                        throw std::runtime_error("Unsupported field type: " + std::to_string(static_cast<int>(type)));
+                    }
+                    if (std::get<1>(t).size() == 0) {
+                        throw std::runtime_error("Empty data");
+                    }
+                    return std::dynamic_pointer_cast<Storage::V2::PolarFieldAccessor>(FieldAccessor::Deserialize(std::get<1>(t)));
+                }
+            ))
+			.def("__repr__", [](const V2::PolarFieldAccessor& a) {
+			    auto voxels = a.getVoxelCount();
+			    return std::string("<RadFiled3D.PolarFieldAccessorV2 (voxels: ") + std::to_string(voxels) + std::string(")>");
+			});
+
+        py::class_<ByteSource, std::shared_ptr<ByteSource>>(m, "ByteSource")
+            .def("size", &ByteSource::size)
+            .def("read", [](const ByteSource& self, size_t offset, size_t size) {
+                std::string data(size, '\0');
+                {
+                    py::gil_scoped_release release;
+                    self.read(offset, data.data(), size);
+                }
+                return py::bytes(data);
+            }, py::arg("offset"), py::arg("size"));
+
+        py::class_<FileByteSource, std::shared_ptr<FileByteSource>, ByteSource>(m, "FileByteSource")
+            .def(py::init<const std::string&, size_t>(), py::arg("file"), py::arg("queue_depth") = 0);
+
+        py::class_<MappedByteSource, std::shared_ptr<MappedByteSource>, ByteSource>(m, "MappedByteSource")
+            .def(py::init<const std::string&>(), py::arg("file"));
+
+        py::class_<MemoryByteSource, std::shared_ptr<MemoryByteSource>, ByteSource>(m, "MemoryByteSource")
+            .def(py::init([](const py::bytes& bytes) {
+                const std::string data = static_cast<std::string>(bytes);
+                return std::make_shared<MemoryByteSource>(std::vector<char>(data.begin(), data.end()));
+            }), py::arg("data"));
+
+        py::class_<ThrottledByteSource, std::shared_ptr<ThrottledByteSource>, ByteSource>(m, "ThrottledByteSource")
+            .def(py::init([](std::shared_ptr<ByteSource> source, double latency_us, size_t bandwidth, size_t max_concurrent_requests) {
+                return std::make_shared<ThrottledByteSource>(source, std::chrono::microseconds(static_cast<long long>(latency_us)), bandwidth, max_concurrent_requests);
+            }), py::arg("source"), py::arg("latency_us"), py::arg("bandwidth") = 0, py::arg("max_concurrent_requests") = 1)
+            .def("get_request_count", &ThrottledByteSource::get_request_count)
+            .def("get_transferred_bytes", &ThrottledByteSource::get_transferred_bytes)
+            .def("reset_statistics", &ThrottledByteSource::reset_statistics);
+
+        py::class_<ZipArchive, std::shared_ptr<ZipArchive>>(m, "ZipArchive")
+            .def(py::init<const std::string&>(), py::arg("file"), py::call_guard<py::gil_scoped_release>())
+            .def("get_filename", &ZipArchive::get_filename)
+            .def("contains", &ZipArchive::contains, py::arg("name"))
+            .def("__contains__", &ZipArchive::contains, py::arg("name"))
+            .def("__len__", &ZipArchive::get_member_count)
+            .def("get_member_names", &ZipArchive::get_member_names)
+            .def("is_stored", [](const ZipArchive& self, const std::string& name) {
+                return self.get_member(name).is_stored();
+            }, py::arg("name"))
+            .def("open", &ZipArchive::open, py::arg("name"), py::call_guard<py::gil_scoped_release>())
+            .def_static("supports_compressed_members", &ZipArchive::supports_compressed_members)
+            .def(py::pickle(    // the archive is reopened by its path, so that it can be passed to the workers of a DataLoader
+                [](const ZipArchive& self) {
+                    return py::make_tuple(self.get_filename());
+                },
+                [](const py::tuple& t) {
+                    if (t.size() != 1)
+                        throw std::runtime_error("Invalid state of ZipArchive");
+                    return std::make_shared<ZipArchive>(t[0].cast<std::string>());
+                }
+            ))
+            .def("__repr__", [](const ZipArchive& self) {
+                return std::string("<RadFiled3D.ZipArchive (") + self.get_filename() + std::string(", members: ") + std::to_string(self.get_member_count()) + std::string(")>");
+            });
+
         py::class_<Storage::FieldStore>(m, "FieldStore")
             .def_static("init_store_instance", &Storage::FieldStore::init_store_instance)
             .def_static("enable_file_lock_syncronization", &Storage::FieldStore::enable_file_lock_syncronization)
+            .def_static("enable_in_place_join", &Storage::FieldStore::enable_in_place_join, py::arg("enable"))
+            .def_static("set_layer_codec", &Storage::FieldStore::set_layer_codec, py::arg("codec"))
+            .def_static("get_layer_codec", &Storage::FieldStore::get_layer_codec)
+            .def_static("set_layer_brick_size", &Storage::FieldStore::set_layer_brick_size, py::arg("brick_size"))
+            .def_static("get_layer_brick_size", &Storage::FieldStore::get_layer_brick_size)
             .def_static("get_store_version", static_cast<Storage::StoreVersion(*)(const std::string&)>(&Storage::FieldStore::get_store_version))
-            .def_static("load", static_cast<std::shared_ptr<IRadiationField>(*)(const std::string&)>(&FieldStore::load))
+            .def_static("load", static_cast<std::shared_ptr<IRadiationField>(*)(const std::string&)>(&FieldStore::load), py::call_guard<py::gil_scoped_release>())
+            .def_static("load_mapped", &FieldStore::load_mapped, py::arg("file"), py::call_guard<py::gil_scoped_release>())
             .def_static("load_from_buffer", [](const std::string& bytes) {
                 std::istringstream stream(bytes);
                 return FieldStore::load(stream);
-            })
-            .def_static("load_metadata", static_cast<std::shared_ptr<Storage::RadiationFieldMetadata>(*)(const std::string&)>(&FieldStore::load_metadata))
-            .def_static("peek_metadata", static_cast<std::shared_ptr<Storage::RadiationFieldMetadata>(*)(const std::string&)>(&FieldStore::peek_metadata))
+            }, py::call_guard<py::gil_scoped_release>())
+            .def_static("load_from_source", static_cast<std::shared_ptr<IRadiationField>(*)(const std::shared_ptr<ByteSource>&)>(&FieldStore::load), py::arg("source"), py::call_guard<py::gil_scoped_release>())
+            .def_static("load_metadata", static_cast<std::shared_ptr<Storage::RadiationFieldMetadata>(*)(const std::string&)>(&FieldStore::load_metadata), py::call_guard<py::gil_scoped_release>())
+            .def_static("load_metadata_from_source", static_cast<std::shared_ptr<Storage::RadiationFieldMetadata>(*)(const std::shared_ptr<ByteSource>&)>(&FieldStore::load_metadata), py::arg("source"), py::call_guard<py::gil_scoped_release>())
+            .def_static("peek_metadata", static_cast<std::shared_ptr<Storage::RadiationFieldMetadata>(*)(const std::string&)>(&FieldStore::peek_metadata), py::call_guard<py::gil_scoped_release>())
             .def_static("load_metadata_from_buffer", [](const std::string& bytes) {
                 std::istringstream stream(bytes);
                 return FieldStore::load_metadata(stream);
-            })
+            }, py::call_guard<py::gil_scoped_release>())
             .def_static("peek_metadata_from_buffer", [](const std::string& bytes) {
                 std::istringstream stream(bytes);
                 return FieldStore::peek_metadata(stream);
-            })
-            .def_static("store", &FieldStore::store, py::arg("field"), py::arg("metadata"), py::arg("file"), py::arg("version") = StoreVersion::V1)
-            .def_static("join", &FieldStore::join, py::arg("field"), py::arg("metadata"), py::arg("file"), py::arg("join_mode") = FieldJoinMode::Add, py::arg("check_mode") = FieldJoinCheckMode::MetadataSimulationSimilar, py::arg("fallback_version") = StoreVersion::V1)
+            }, py::call_guard<py::gil_scoped_release>())
+            .def_static("peek_metadata_from_source", [](const std::shared_ptr<ByteSource>& source) {
+                ByteSourceStream stream(source);
+                return FieldStore::peek_metadata(stream);
+            }, py::arg("source"), py::call_guard<py::gil_scoped_release>())
+            .def_static("store", &FieldStore::store, py::arg("field"), py::arg("metadata"), py::arg("file"), py::arg("version") = StoreVersion::V1, py::call_guard<py::gil_scoped_release>())
+            .def_static("join", &FieldStore::join, py::arg("field"), py::arg("metadata"), py::arg("file"), py::arg("join_mode") = FieldJoinMode::Add, py::arg("check_mode") = FieldJoinCheckMode::MetadataSimulationSimilar, py::arg("fallback_version") = StoreVersion::V1, py::call_guard<py::gil_scoped_release>())
+            .def_static("merge", &FieldStore::merge, py::arg("files"), py::arg("output_file"), py::arg("join_mode") = FieldJoinMode::Add, py::arg("check_mode") = FieldJoinCheckMode::MetadataSimulationSimilar, py::arg("thread_count") = 0, py::arg("memory_budget") = 0, py::call_guard<py::gil_scoped_release>())
             .def_static("peek_field_type", &FieldStore::peek_field_type)
             .def_static("construct_field_accessor", [](const std::string& file) {
 			    std::ifstream stream(file, std::ios::binary);
                 return FieldStore::construct_accessor(stream);
-            })
+            }, py::call_guard<py::gil_scoped_release>())
+            .def_static("construct_field_accessor_from_source", static_cast<std::shared_ptr<FieldAccessor>(*)(const std::shared_ptr<ByteSource>&)>(&FieldStore::construct_accessor), py::arg("source"), py::call_guard<py::gil_scoped_release>())
             .def_static("construct_field_accessor_from_buffer", [](const py::bytes& bytes) {
 			    std::istringstream stream(static_cast<std::string>(bytes));
+                py::gil_scoped_release release;
                 return FieldStore::construct_accessor(stream);
             })
             .def_static("load_single_grid_layer", [](const std::string& file, const std::string& channel_name, const std::string& layer_name) -> std::shared_ptr<VoxelGrid> {
@@ -1973,7 +2238,7 @@ PYBIND11_MODULE(RadFiled3D, m) {
 				}
 
 				return std::dynamic_pointer_cast<CartesianFieldAccessor>(accessor)->accessLayer(buffer, channel_name, layer_name);
-            })
+            }, py::call_guard<py::gil_scoped_release>())
 			.def_static("load_single_grid_layer_from_buffer", [](const std::string& bytes, const std::string& channel_name, const std::string& layer_name) -> std::shared_ptr<VoxelGrid> {
 			    std::istringstream stream(bytes);
 				auto accessor = FieldStore::construct_accessor(stream);
@@ -1983,7 +2248,7 @@ PYBIND11_MODULE(RadFiled3D, m) {
 				}
 
 				return std::dynamic_pointer_cast<CartesianFieldAccessor>(accessor)->accessLayer(stream, channel_name, layer_name);
-		    })
+		    }, py::call_guard<py::gil_scoped_release>())
             .def_static("load_single_polar_layer", [](const std::string& file, const std::string& channel_name, const std::string& layer_name) -> std::shared_ptr<PolarSegments> {
 			    std::ifstream buffer(file, std::ios::binary);
 			    auto accessor = FieldStore::construct_accessor(buffer);
@@ -1993,7 +2258,7 @@ PYBIND11_MODULE(RadFiled3D, m) {
 				}
 
 			    return std::dynamic_pointer_cast<PolarFieldAccessor>(accessor)->accessLayer(buffer, channel_name, layer_name);
-            })
+            }, py::call_guard<py::gil_scoped_release>())
             .def_static("load_single_polar_layer_from_buffer", [](const std::string& bytes, const std::string& channel_name, const std::string& layer_name) -> std::shared_ptr<PolarSegments> {
 			    std::istringstream stream(bytes);
 			    auto accessor = FieldStore::construct_accessor(stream);
@@ -2003,7 +2268,7 @@ PYBIND11_MODULE(RadFiled3D, m) {
 				}
 
 			    return std::dynamic_pointer_cast<PolarFieldAccessor>(accessor)->accessLayer(stream, channel_name, layer_name);
-			}, py::arg("bytes"), py::arg("channel_name"), py::arg("layer_name"));
+			}, py::arg("bytes"), py::arg("channel_name"), py::arg("layer_name"), py::call_guard<py::gil_scoped_release>());
 
 
         // Datasets helper bindings
@@ -2021,45 +2286,49 @@ PYBIND11_MODULE(RadFiled3D, m) {
 				if (layer_it == channel_it->second.layers.end())
 					throw std::runtime_error("Layer '" + layer + "' not found in channel '" + channel + "'");
 
-                const Typing::DType type = Typing::Helper::get_dtype(layer_it->second.voxels[0]->get_type());
-                char* data_buffer = self->extract_data_buffer_from(channel, layer);
-                size_t voxel_count = self->channels.begin()->second.layers.begin()->second.voxels.size();
+                // the array is a view onto the buffer of the layer, which is kept alive by the array
+                const VoxelCollection::Layer& layer_data = layer_it->second;
+                const std::shared_ptr<void> keep_alive = layer_data.data;
+                const size_t voxel_count = layer_data.voxel_count;
 
-                switch (type) {
+                switch (layer_data.dtype) {
                     case Typing::DType::Float:
-                        return create_py_array_generic<float>((float*)data_buffer, voxel_count);
+                        return create_py_array_generic<float>(layer_data.get_data<float>(), voxel_count, sizeof(float), keep_alive);
                     case Typing::DType::Double:
-                        return create_py_array_generic<double>((double*)data_buffer, voxel_count);
+                        return create_py_array_generic<double>(layer_data.get_data<double>(), voxel_count, sizeof(double), keep_alive);
                     case Typing::DType::Int:
-                        return create_py_array_generic<int>((int*)data_buffer, voxel_count);
+                        return create_py_array_generic<int>(layer_data.get_data<int>(), voxel_count, sizeof(int), keep_alive);
                     case Typing::DType::Char:
-                        return create_py_array_generic<char>(data_buffer, voxel_count);
+                        return create_py_array_generic<char>(layer_data.get_data<char>(), voxel_count, sizeof(char), keep_alive);
                     case Typing::DType::UInt64:
-                        return create_py_array_generic<uint64_t>((uint64_t*)data_buffer, voxel_count);
+                        return create_py_array_generic<uint64_t>(layer_data.get_data<uint64_t>(), voxel_count, sizeof(uint64_t), keep_alive);
                     case Typing::DType::UInt32:
-                        return create_py_array_generic<unsigned long>((unsigned long*)data_buffer, voxel_count);
+                        return create_py_array_generic<uint32_t>(layer_data.get_data<uint32_t>(), voxel_count, sizeof(uint32_t), keep_alive);
                 }
 
-                const size_t element_size = layer_it->second.voxels[0]->get_bytes();
-                return create_py_array_generic<float>((float*)data_buffer, voxel_count, element_size);
-            }, py::arg("channel"), py::arg("layer"), py::return_value_policy::take_ownership);
+                return create_py_array_generic<float>(layer_data.get_data<float>(), voxel_count, layer_data.voxel_bytes, keep_alive);
+            }, py::arg("channel"), py::arg("layer"));
 
         py::class_<VoxelCollectionAccessor>(m, "VoxelCollectionAccessor")
-            .def(py::init<std::shared_ptr<Storage::FieldAccessor>, const std::vector<std::string>&, const std::vector<std::string>&>(), py::arg("accessor"), py::arg("channels"), py::arg("layers"))
-            .def("access", &VoxelCollectionAccessor::access, py::arg("requests"));
+            .def(py::init<std::shared_ptr<Storage::FieldAccessor>, const std::vector<std::string>&, const std::vector<std::string>&, size_t>(), py::arg("accessor"), py::arg("channels"), py::arg("layers"), py::arg("worker_count") = 1)
+            .def("set_worker_count", &VoxelCollectionAccessor::set_worker_count, py::arg("worker_count"))
+            .def("get_worker_count", &VoxelCollectionAccessor::get_worker_count)
+            .def("set_io_queue_depth", &VoxelCollectionAccessor::set_io_queue_depth, py::arg("io_queue_depth"))
+            .def("get_io_queue_depth", &VoxelCollectionAccessor::get_io_queue_depth)
+            .def("access", &VoxelCollectionAccessor::access, py::arg("requests"), py::call_guard<py::gil_scoped_release>());
 
 
         py::class_<GridTracer, std::shared_ptr<GridTracer>>(m, "GridTracer")
-            .def("trace", &GridTracer::trace, py::arg("p1"), py::arg("p2"));
+            .def("trace", &GridTracer::trace, py::arg("p1"), py::arg("p2"), py::call_guard<py::gil_scoped_release>());
 
 		py::class_<SamplingGridTracer, std::shared_ptr<SamplingGridTracer>, GridTracer>(m, "SamplingGridTracer")
-			.def("trace", &SamplingGridTracer::trace, py::arg("p1"), py::arg("p2"));
+			.def("trace", &SamplingGridTracer::trace, py::arg("p1"), py::arg("p2"), py::call_guard<py::gil_scoped_release>());
 
 		py::class_<BresenhamGridTracer, std::shared_ptr<BresenhamGridTracer>, GridTracer>(m, "BresenhamGridTracer")
-			.def("trace", &BresenhamGridTracer::trace, py::arg("p1"), py::arg("p2"));
+			.def("trace", &BresenhamGridTracer::trace, py::arg("p1"), py::arg("p2"), py::call_guard<py::gil_scoped_release>());
 
 		py::class_<LinetracingGridTracer, std::shared_ptr<LinetracingGridTracer>, GridTracer>(m, "LinetracingGridTracer")
-			.def("trace", &LinetracingGridTracer::trace, py::arg("p1"), py::arg("p2"));
+			.def("trace", &LinetracingGridTracer::trace, py::arg("p1"), py::arg("p2"), py::call_guard<py::gil_scoped_release>());
 
 		py::class_<PyGridTracerFactory>(m, "GridTracerFactory")
 			.def_static("construct", &PyGridTracerFactory::construct, py::arg("field"), py::arg("algorithm") = GridTracerAlgorithm::SAMPLING);
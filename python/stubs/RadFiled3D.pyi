@@ -47,6 +47,9 @@ class FieldJoinMode(Enum):
     ADD_WEIGHTED = 6
     "Add the values of the target and the additional source field with a weighting ratio based on the primary particles"
 
+    WELFORD = 7
+    "Accumulate the mean and the variance of the values of all joined fields. The sample count and the sum of squared deviations are kept in the layers '<layer>#count' and '<layer>#m2'. Layers, which are not floating point, are added."
+
 
 class FieldJoinCheckMode(Enum):
     """
@@ -86,6 +89,12 @@ class GridTracerAlgorithm(Enum):
 
 class StoreVersion(Enum):
     V1 = 0
+    V2 = 1
+
+
+class LayerCodec(Enum):
+    RAW = 0
+    SHUFFLE_RLE = 1
 
 
 class vec4:
@@ -373,6 +382,31 @@ class VoxelBuffer(object):
         """
         ...
 
+    def compact_layers(self) -> None:
+        """
+        Drop the voxel objects of all layers of the buffer. Voxel objects are only created again for pages of voxels, which are accessed.
+        """
+        ...
+
+    @staticmethod
+    def set_worker_count(worker_count: int) -> None:
+        """
+        Set the number of threads the arithmetic operators, layer fills and merges of all buffers run on.
+        Results are identical for every number of threads. Merge functions must be thread-safe if more than one thread is used.
+
+        :param worker_count: The number of threads. 0 uses one thread per hardware thread, 1 runs on the calling thread. Default is 1.
+        """
+        ...
+
+    @staticmethod
+    def get_worker_count() -> int:
+        """
+        Get the number of threads the arithmetic operators, layer fills and merges run on.
+
+        :return: The number of threads.
+        """
+        ...
+
     def has_layer(self, layer_name: str) -> bool:
         """
         Check if a layer exists in the buffer.
@@ -415,6 +449,15 @@ class VoxelBuffer(object):
         """
         ...
 
+    def write_welford_uncertainty(self, layer_name: str, uncertainty_layer_name: str) -> None:
+        """
+        Write the standard error of the mean of a layer joined by FieldJoinMode.WELFORD to a layer. The layer is created, if it does not exist.
+
+        :param layer_name: The name of the layer joined by FieldJoinMode.WELFORD.
+        :param uncertainty_layer_name: The name of the layer to write the standard error of the mean to.
+        """
+        ...
+
     def get_layer_voxel_type(self, layer_name: str) -> str:
         """
         Returns the type of the voxels in a layer.
@@ -461,6 +504,83 @@ class VoxelBuffer(object):
         ...
 
 
+class LayerExpression(object):
+    """
+    A lazily evaluated element-wise expression over voxel layers, e.g. (a * w1 + b * w2) / n.
+    Combining expressions with +, -, * and / or with numbers only builds the expression. Evaluating it into a destination layer computes the whole expression in a single pass over the operand layers, without temporary buffers.
+    The expression is computed in double precision, if the destination or any operand layer stores doubles or 32-bit or 64-bit integers, and in single precision otherwise.
+    Operand layers must either have as many components per voxel as the destination layer or a single one, which is then used for all components.
+    """
+
+    def __init__(self, value: float) -> None:
+        """
+        Create a constant expression.
+
+        :param value: The value of the constant.
+        """
+        ...
+
+    @staticmethod
+    def layer(buffer: VoxelBuffer, layer_name: str) -> LayerExpression:
+        """
+        Create an expression of a single layer of a buffer.
+
+        :param buffer: The buffer holding the layer.
+        :param layer_name: The name of the layer.
+        """
+        ...
+
+    @staticmethod
+    def buffer(buffer: VoxelBuffer) -> LayerExpression:
+        """
+        Create an expression of all layers of a buffer. It resolves to the layer of the same name as the destination layer during evaluation.
+
+        :param buffer: The buffer.
+        """
+        ...
+
+    @staticmethod
+    def constant(value: float) -> LayerExpression:
+        """
+        Create a constant expression.
+
+        :param value: The value of the constant.
+        """
+        ...
+
+    @staticmethod
+    def divide_or_zero(dividend: Union[LayerExpression, float], divisor: Union[LayerExpression, float]) -> LayerExpression:
+        """
+        Divide like /, but yield 0 wherever the divisor is 0, as the division of histogram layers does.
+        """
+        ...
+
+    def evaluate(self, target: VoxelBuffer, layer_name: str = None) -> None:
+        """
+        Evaluate the expression into a layer. The target may be an operand of the expression as well.
+
+        :param target: The buffer holding the destination layer.
+        :param layer_name: The name of the destination layer. If None, the expression is evaluated into all layers of the target one after another, after all of them were validated.
+        """
+        ...
+
+    def to_string(self) -> str:
+        """
+        Returns a readable representation of the expression.
+        """
+        ...
+
+    def __add__(self, other: Union[LayerExpression, float]) -> LayerExpression: ...
+    def __sub__(self, other: Union[LayerExpression, float]) -> LayerExpression: ...
+    def __mul__(self, other: Union[LayerExpression, float]) -> LayerExpression: ...
+    def __truediv__(self, other: Union[LayerExpression, float]) -> LayerExpression: ...
+    def __radd__(self, other: float) -> LayerExpression: ...
+    def __rsub__(self, other: float) -> LayerExpression: ...
+    def __rmul__(self, other: float) -> LayerExpression: ...
+    def __rtruediv__(self, other: float) -> LayerExpression: ...
+    def __neg__(self) -> LayerExpression: ...
+
+
 class VoxelLayer(object):
     """
     Interface for voxel layers.
@@ -477,6 +597,106 @@ class VoxelLayer(object):
     
     def get_voxel_count(self) -> int: ...
 
+    def is_compact(self) -> bool:
+        """
+        Check if the layer is compact. Compact layers only keep the voxel data and create voxel objects page by page, when voxels of a page are first accessed, instead of holding a voxel object per voxel.
+        """
+        ...
+
+    def compact(self) -> None:
+        """
+        Drop the voxel objects of the layer. Voxel objects are only created again for pages of voxels, which are accessed.
+        """
+        ...
+
+    @staticmethod
+    def set_compact_by_default(compact: bool) -> None:
+        """
+        Set if layers, which are created from now on, are compact. Saves the memory of one voxel object per voxel, which is multiple times the size of the data of scalar layers.
+        Layers of a single voxel always keep their voxel object. Default is False.
+
+        :param compact: True to create compact layers.
+        """
+        ...
+
+    @staticmethod
+    def is_compact_by_default() -> bool:
+        """
+        Check if layers, which are created from now on, are compact.
+        """
+        ...
+
+
+class LayerAllocator(object):
+    """
+    Allocates the data and voxel buffers of voxel layers. Layers keep a reference to the allocator of their buffers, so the default allocator may be exchanged at any time.
+    """
+    @staticmethod
+    def get_default() -> LayerAllocator:
+        """
+        Returns the allocator, which is used for all layers constructed from now on. Default is an AlignedLayerAllocator with an alignment of 64 bytes.
+        """
+        ...
+
+    @staticmethod
+    def set_default(allocator: LayerAllocator) -> None:
+        """
+        Sets the allocator, which is used for all layers constructed from now on.
+
+        :param allocator: The new default allocator. None resets to the initial AlignedLayerAllocator.
+        """
+        ...
+
+
+class AlignedLayerAllocator(LayerAllocator):
+    """
+    Allocates buffers aligned to a fixed boundary.
+    """
+    def __init__(self, alignment: int = 64) -> None:
+        """
+        :param alignment: The alignment of the buffers in bytes. Must be a power of two.
+        """
+        ...
+
+    def get_alignment(self) -> int: ...
+
+
+class HugePageLayerAllocator(AlignedLayerAllocator):
+    """
+    Allocates buffers of at least 2 MiB aligned to huge pages and advises the kernel to back them by transparent huge pages. Smaller buffers are aligned to 64 bytes.
+    """
+    def __init__(self) -> None: ...
+
+
+class ArenaLayerAllocator(LayerAllocator):
+    """
+    Keeps freed buffers and hands them out again for allocations of exactly the same size. Repeatedly loading fields of the same shape thereby reuses the memory of previously freed layers.
+    """
+    def __init__(self, upstream: LayerAllocator = None, max_cached_bytes: int = 2**64 - 1) -> None:
+        """
+        :param upstream: The allocator to allocate new buffers from. Defaults to an AlignedLayerAllocator.
+        :param max_cached_bytes: The maximum number of bytes of freed buffers to keep for reuse. Unlimited by default.
+        """
+        ...
+
+    def release(self) -> None:
+        """
+        Returns all kept buffers to the upstream allocator.
+        """
+        ...
+
+    def get_cached_bytes(self) -> int:
+        """
+        Returns the number of bytes of freed buffers, which are kept for reuse.
+        """
+        ...
+
+    def get_reuse_count(self) -> int:
+        """
+        Returns the number of allocations, which were served by a kept buffer.
+        """
+        ...
+
 
 class VoxelGrid(object):
     """
@@ -867,6 +1087,149 @@ class PolarRadiationField(RadiationField):
 
 
 
+class ByteSource(object):
+    """
+    A read-only sequence of bytes, which is read by ranges, e.g. a local file, a memory mapping, a buffer or an object of a remote store.
+    """
+    def size(self) -> int:
+        """
+        Get the number of bytes of the source.
+        """
+        ...
+
+    def read(self, offset: int, size: int) -> bytes:
+        """
+        Read a range of the source.
+
+        :param offset: The offset of the range.
+        :param size: The number of bytes to read.
+        :return: The bytes of the range.
+        """
+        ...
+
+
+class FileByteSource(ByteSource):
+    def __init__(self, file: str, queue_depth: int = 0) -> None:
+        """
+        Read a local file by positional reads.
+
+        :param file: The path of the file.
+        :param queue_depth: The number of reads of a batch in flight at once. 0 reads the ranges of a batch one after another.
+        """
+        ...
+
+
+class MappedByteSource(ByteSource):
+    def __init__(self, file: str) -> None:
+        """
+        Read a file mapped into memory.
+
+        :param file: The path of the file.
+        """
+        ...
+
+
+class MemoryByteSource(ByteSource):
+    def __init__(self, data: bytes) -> None:
+        """
+        Read a copy of a buffer held in memory.
+
+        :param data: The buffer.
+        """
+        ...
+
+
+class ThrottledByteSource(ByteSource):
+    def __init__(self, source: ByteSource, latency_us: float, bandwidth: int = 0, max_concurrent_requests: int = 1) -> None:
+        """
+        Wrap a source and delay each request by a latency and a limited bandwidth, in order to mimic remote storage in tests and benchmarks.
+        Each range of a batched read is a request of its own.
+
+        :param source: The source to read from.
+        :param latency_us: The delay of each request in microseconds.
+        :param bandwidth: The number of bytes transferred per second by a request. 0 does not limit the bandwidth.
+        :param max_concurrent_requests: The maximum number of requests of a batch in flight at once. 1 issues them one after another, 0 issues all of them at once.
+        """
+        ...
+
+    def get_request_count(self) -> int:
+        """
+        Get the number of requests issued so far.
+        """
+        ...
+
+    def get_transferred_bytes(self) -> int:
+        """
+        Get the number of bytes transferred so far.
+        """
+        ...
+
+    def reset_statistics(self) -> None:
+        """
+        Reset the number of requests and transferred bytes.
+        """
+        ...
+
+
+class ZipArchive:
+    def __init__(self, file: str) -> None:
+        """
+        Open a zip archive and index its members by the central directory, so that members are opened without extracting or searching the archive.
+        Members stored uncompressed are viewed without copies, deflated members are inflated into memory, if supported.
+        The archive can be pickled, which reopens it by its path.
+
+        :param file: The path of the archive.
+        """
+        ...
+
+    def get_filename(self) -> str:
+        """
+        Get the path of the archive.
+        """
+        ...
+
+    def contains(self, name: str) -> bool:
+        """
+        Check if the archive contains a member.
+
+        :param name: The path of the member within the archive.
+        """
+        ...
+
+    def __contains__(self, name: str) -> bool: ...
+
+    def __len__(self) -> int: ...
+
+    def get_member_names(self) -> list[str]:
+        """
+        Get the paths of all members in the order of the central directory.
+        """
+        ...
+
+    def is_stored(self, name: str) -> bool:
+        """
+        Check if a member is stored uncompressed and can therefore be viewed without a copy.
+
+        :param name: The path of the member within the archive.
+        """
+        ...
+
+    def open(self, name: str) -> ByteSource:
+        """
+        Open a member as a byte source, which can be passed to all methods taking a source.
+
+        :param name: The path of the member within the archive.
+        """
+        ...
+
+    @staticmethod
+    def supports_compressed_members() -> bool:
+        """
+        Check if deflated members can be opened, as the library was built with zlib.
+        """
+        ...
+
+
 class FieldAccessor:
     def get_field_type(self) -> FieldType:
         """
@@ -879,6 +1242,21 @@ class FieldAccessor:
         Returns the linear number of voxels in the buffer.
         """
         ...
+
+    def set_voxel_read_gap_threshold(self, bytes: int) -> None:
+        """
+        Sets the maximum number of bytes between two requested voxels, which are read along instead of seeking past them, when accessing multiple voxels at once.
+        Larger values result in fewer but larger reads. The threshold is not pickled with the accessor. Default is 4096 bytes.
+
+        :param bytes: The gap threshold in bytes.
+        """
+        ...
+
+    def get_voxel_read_gap_threshold(self) -> int:
+        """
+        Returns the maximum number of bytes between two requested voxels, which are read along when accessing multiple voxels at once.
+        """
+        ...
     
     @staticmethod
     def get_store_version(data: bytes) -> StoreVersion:
@@ -899,6 +1277,18 @@ class FieldAccessor:
         """
         ...
 
+    def access_voxel_flat_from_source(self, source: ByteSource, channel_name: str, layer_name: str, idx: int) -> Voxel:
+        """
+        Get a voxel at a specific linear index from a byte source.
+
+        :param source: The source to load the radiation field from.
+        :param channel_name: The name of the channel.
+        :param layer_name: The name of the layer.
+        :param idx: The index of the voxel.
+        :return: The voxel at the specified index.
+        """
+        ...
+
     def access_voxel_flat(self, file: str, channel_name: str, layer_name: str, idx: int) -> Voxel:
         """
         Get a voxel at a specific linear index from a file.
@@ -929,6 +1319,25 @@ class FieldAccessor:
         """
         ...
 
+    def access_field_mapped(self, file: str) -> RadiationField:
+        """
+        Get a radiation field from a memory mapped file.
+        The layers of the field are views onto the mapping instead of copies.
+
+        :param file: The file path to the stored radiation field.
+        :return: The radiation field.
+        """
+        ...
+
+    def access_field_from_source(self, source: ByteSource) -> RadiationField:
+        """
+        Get a radiation field from a byte source.
+
+        :param source: The source to read the stored radiation field from.
+        :return: The radiation field.
+        """
+        ...
+
 
 class CartesianFieldAccessor(FieldAccessor):
     def access_channel_from_buffer(self, buffer: bytes, channel_name: str) -> VoxelGridBuffer:
@@ -951,6 +1360,16 @@ class CartesianFieldAccessor(FieldAccessor):
         """
         ...
 
+    def access_channel_mapped(self, file: str, channel_name: str) -> VoxelGridBuffer:
+        """
+        Get a channel by name from a memory mapped file without copying its voxel data.
+
+        :param file: The file path to the stored radiation field.
+        :param channel_name: The name of the channel.
+        :return: The channel.
+        """
+        ...
+
     def access_layer_from_buffer(self, buffer: bytes, channel_name: str, layer_name: str) -> VoxelGrid:
         """
         Get a layer by name from a data buffer.
@@ -973,6 +1392,68 @@ class CartesianFieldAccessor(FieldAccessor):
         """
         ...
 
+    def access_layer_mapped(self, file: str, channel_name: str, layer_name: str) -> VoxelGrid:
+        """
+        Get a layer by name from a memory mapped file without copying its voxel data.
+
+        :param file: The file path to the stored radiation field.
+        :param channel_name: The name of the channel.
+        :param layer_name: The name of the layer.
+        :return: The layer.
+        """
+        ...
+
+    def access_layer_from_source(self, source: ByteSource, channel_name: str, layer_name: str) -> VoxelGrid:
+        """
+        Get a layer by name from a byte source. Layers of mapped sources are views without copies.
+
+        :param source: The source to load the radiation field from.
+        :param channel_name: The name of the channel.
+        :param layer_name: The name of the layer.
+        :return: The layer.
+        """
+        ...
+
+    def access_subvolume(self, file: str, channel_name: str, layer_name: str, min_idx: uvec3, max_idx: uvec3) -> VoxelGrid:
+        """
+        Get a box shaped region of a layer without reading the whole layer.
+        Layers stored in bricks (see FieldStore.set_layer_brick_size) only need the bricks overlapping the region to be read.
+
+        :param file: The file path to the stored radiation field.
+        :param channel_name: The name of the channel.
+        :param layer_name: The name of the layer.
+        :param min_idx: The first voxel of the region.
+        :param max_idx: The voxel after the last voxel of the region in each dimension.
+        :return: A grid of max_idx - min_idx voxels, whose voxel (0, 0, 0) is the voxel min_idx of the layer.
+        """
+        ...
+
+    def access_subvolume_from_buffer(self, buffer: bytes, channel_name: str, layer_name: str, min_idx: uvec3, max_idx: uvec3) -> VoxelGrid:
+        """
+        Get a box shaped region of a layer from a data buffer.
+
+        :param buffer: The data buffer.
+        :param channel_name: The name of the channel.
+        :param layer_name: The name of the layer.
+        :param min_idx: The first voxel of the region.
+        :param max_idx: The voxel after the last voxel of the region in each dimension.
+        :return: A grid of max_idx - min_idx voxels, whose voxel (0, 0, 0) is the voxel min_idx of the layer.
+        """
+        ...
+
+    def access_subvolume_mapped(self, file: str, channel_name: str, layer_name: str, min_idx: uvec3, max_idx: uvec3) -> VoxelGrid:
+        """
+        Get a box shaped region of a layer from a memory mapped file. The voxels of the region are copied.
+
+        :param file: The file path to the stored radiation field.
+        :param channel_name: The name of the channel.
+        :param layer_name: The name of the layer.
+        :param min_idx: The first voxel of the region.
+        :param max_idx: The voxel after the last voxel of the region in each dimension.
+        :return: A grid of max_idx - min_idx voxels, whose voxel (0, 0, 0) is the voxel min_idx of the layer.
+        """
+        ...
+
     def access_layer_across_channels_from_buffer(self, buffer: bytes, layer_name: str) -> dict[str, VoxelGrid]:
         """
         Get a layer by name from a data buffer across all channels.
@@ -1054,6 +1535,17 @@ class PolarFieldAccessor(FieldAccessor):
         """
         ...
 
+    def access_layer_from_source(self, source: ByteSource, channel_name: str, layer_name: str) -> PolarSegments:
+        """
+        Get a layer by name from a byte source. Layers of mapped sources are views without copies.
+
+        :param source: The source to load the radiation field from.
+        :param channel_name: The name of the channel.
+        :param layer_name: The name of the layer.
+        :return: The layer.
+        """
+        ...
+
     def access_layer(self, file: str, channel_name: str, layer_name: str) -> PolarSegments:
         """
         Get a layer by name from a file.
@@ -1125,6 +1617,52 @@ class FieldStore:
         ...
     
 
+    @staticmethod
+    def enable_in_place_join(enable: bool) -> None:
+        """
+        Enable or disable joining fields into files in place. If enabled, join overwrites the layers of a stored field within the file, whenever the stored field is structurally identical to the joined one and its layers are stored raw.
+        Otherwise the whole file is rewritten. Joining in place is not crash-safe: a crash during the join leaves a partially joined file with a stale header behind.
+        It also alters the file under other processes, which mapped it, e.g. by load_mapped. Default is disabled.
+
+        :param enable: Enable or disable joining in place.
+        """
+        ...
+
+
+    @staticmethod
+    def set_layer_codec(codec: LayerCodec) -> None:
+        """
+        Set the codec used to encode the voxel data of each layer when storing with StoreVersion.V2.
+        Layers which would not become smaller are always stored raw. StoreVersion.V1 files are never encoded.
+
+        :param codec: The codec to use.
+        """
+        ...
+
+    @staticmethod
+    def get_layer_codec() -> LayerCodec:
+        """
+        Get the codec used to encode the voxel data of each layer when storing with StoreVersion.V2.
+        """
+        ...
+
+    @staticmethod
+    def set_layer_brick_size(brick_size: int) -> None:
+        """
+        Set the number of voxels along each edge of the cubic bricks the layers of cartesian fields are split into when storing with StoreVersion.V2.
+        Bricked layers allow CartesianFieldAccessor.access_subvolume to only read the bricks overlapping a region.
+
+        :param brick_size: The brick edge length in voxels, e.g. 16 or 32. 0 stores all layers contiguous, which is the default.
+        """
+        ...
+
+    @staticmethod
+    def get_layer_brick_size() -> int:
+        """
+        Get the number of voxels along each edge of the bricks layers are split into when storing with StoreVersion.V2.
+        """
+        ...
+
     @staticmethod
     def init_store_instance(version: StoreVersion) -> None:
         """
@@ -1170,6 +1708,15 @@ class FieldStore:
         """
         ...
 
+    @staticmethod
+    def peek_metadata_from_source(source: ByteSource) -> RadiationFieldMetadataHeaderV1:
+        """
+        Quickly peeks at the mandatory metadata header of the radiation field from a byte source
+
+        :param source: The source to load the metadata from.
+        """
+        ...
+
     @staticmethod
     def load(file: str) -> RadiationField:
         """
@@ -1179,6 +1726,17 @@ class FieldStore:
         """
         ...
 
+    @staticmethod
+    def load_mapped(file: str) -> RadiationField:
+        """
+        Load a stored radiation field by mapping the file into memory.
+        The layers of the field are views onto the mapping, which stays alive as long as the field is used.
+        Modifying the field does not alter the file.
+
+        :param file: The file path to the stored radiation field.
+        """
+        ...
+
     @staticmethod
     def load_from_buffer(buffer: bytes) -> RadiationField:
         """
@@ -1188,6 +1746,24 @@ class FieldStore:
         """
         ...
 
+    @staticmethod
+    def load_from_source(source: ByteSource) -> RadiationField:
+        """
+        Load a stored radiation field from a byte source.
+
+        :param source: The source to load the radiation field from.
+        """
+        ...
+
+    @staticmethod
+    def load_metadata_from_source(source: ByteSource) -> RadiationFieldMetadata:
+        """
+        Get the metadata of a stored radiation field from a byte source.
+
+        :param source: The source to load the metadata from.
+        """
+        ...
+
     @staticmethod
     def load_single_grid_layer_from_buffer(buffer: bytes, channel_name: str, layer_name: str) -> VoxelGrid:
         """
@@ -1248,6 +1824,23 @@ class FieldStore:
         """
         ...
 
+    @staticmethod
+    def merge(files: list[str], output_file: str, join_mode: FieldJoinMode = FieldJoinMode.ADD, check_mode: FieldJoinCheckMode = FieldJoinCheckMode.METADATA_SIMULATION_SIMILAR, thread_count: int = 0, memory_budget: int = 0) -> None:
+        """
+        Merge many stored radiation fields into a single new file by a parallel tree reduction.
+        The files are joined pairwise along a balanced binary tree over their order, so the result does not depend on the number of threads.
+        Primary particle counts are summed up and ADD_WEIGHTED joins are weighted by the primary particles of both partial results.
+        The metadata of each file is checked against the first file, whose metadata is stored with the result.
+
+        :param files: The files to merge. The first file determines the store version of the result.
+        :param output_file: The file path to store the merged radiation field to.
+        :param join_mode: The mode to join the radiation fields with. Only IDENTITY, ADD, MULTIPLY and ADD_WEIGHTED are supported.
+        :param check_mode: The mode to check the radiation fields with.
+        :param thread_count: The maximum number of threads to use. 0 uses all hardware threads.
+        :param memory_budget: The approximate number of bytes the fields held in memory at the same time may take. 0 does not limit the memory.
+        """
+        ...
+
     @staticmethod
     def load_single_grid_layer(file: str, channel_name: str, layer_name: str) -> VoxelGrid:
         """
@@ -1303,6 +1896,16 @@ class FieldStore:
         """
         ...
 
+    @staticmethod
+    def construct_field_accessor_from_source(source: ByteSource) -> FieldAccessor:
+        """
+        Construct a radiation field accessor from a byte source for a set of radiation fields that share the same metadata size and overall field structure.
+
+        :param source: The source to load the radiation field from.
+        :return: The radiation field accessor.
+        """
+        ...
+
 
 class GridTracer:
     def trace(self, p1: vec3, p2: vec3) -> list[int]:
@@ -1347,28 +1950,64 @@ class VoxelCollection(object):
     def get_as_ndarray(self, channel: str, layer: str) -> np.ndarray:
         """
         Get the collected voxels as a numpy ndarray.
+        The array is a view onto the buffer of the layer and does not copy the voxels.
 
         :param channel: The name of the channel.
         :param layer: The name of the layer.
-        :return: The collected voxels as a numpy ndarray.
+        :return: The collected voxels as a numpy ndarray. Shape is (voxel_count,) for scalar layers and (voxel_count, elements_per_voxel) for all others.
         """
         ...
 
 
 class VoxelCollectionAccessor(object):
-    def __init__(self, accessor: FieldAccessor, channels: list[str], layers: list[str]) -> None:
+    def __init__(self, accessor: FieldAccessor, channels: list[str], layers: list[str], worker_count: int = 1) -> None:
         """
         Initialize a voxel collection accessor.
 
         :param accessor: The field accessor to use for accessing the radiation field.
         :param channels: The names of the channels to collect.
         :param layers: The names of the layers to collect.
+        :param worker_count: The number of threads loading requests in parallel. 0 uses one thread per hardware thread. Default is 1.
+        """
+        ...
+
+    def set_worker_count(self, worker_count: int) -> None:
+        """
+        Set the number of threads loading requests in parallel.
+
+        :param worker_count: The number of threads. 0 uses one thread per hardware thread, 1 loads all requests on the calling thread.
+        """
+        ...
+
+    def get_worker_count(self) -> int:
+        """
+        Get the number of threads loading requests in parallel.
+
+        :return: The number of threads.
+        """
+        ...
+
+    def set_io_queue_depth(self, io_queue_depth: int) -> None:
+        """
+        Set the number of reads in flight at once, if all reads of a call to access are issued as one batch.
+        On Linux, the batch is submitted to io_uring, otherwise it is read by the worker threads issuing positional reads.
+
+        :param io_queue_depth: The maximum number of reads in flight. 0 disables batching, which is the default.
+        """
+        ...
+
+    def get_io_queue_depth(self) -> int:
+        """
+        Get the number of reads in flight at once, if the reads are batched.
+
+        :return: The queue depth or 0, if batching is disabled.
         """
         ...
 
     def access(self, requests: list[VoxelCollectionRequest]) -> VoxelCollection:
         """
         Load the voxels from the radiation field based on the requests.
+        The requests are spread over the worker threads and the GIL is released while loading.
 
         :param requests: The requests for voxel collections.
         :return: The collected voxels as a VoxelCollection.
@@ -0,0 +1,338 @@
+#include "RadFiled3D/helpers/BatchReader.hpp"
+#include "RadFiled3D/VoxelBuffer.hpp"
+#include <algorithm>
+#include <thread>
+#if defined(__linux__) && defined(__has_include)
+    #if __has_include(<linux/io_uring.h>)
+        #define RADFILED3D_IO_URING
+    #endif
+#endif
+#ifdef RADFILED3D_IO_URING
+    #include <linux/io_uring.h>
+    #include <sys/mman.h>
+    #include <sys/syscall.h>
+    #include <unistd.h>
+    #include <sys/uio.h>
+    #include <cerrno>
+    #include <cstring>
+#endif
+
+
+using namespace RadFiled3D;
+
+
+namespace {
+    void validate_request(const BatchReadRequest& request) {
+        if (request.offset > request.file->size() || request.size > request.file->size() - request.offset) {
+            throw PositionalFileException("Block exceeds the file");
+        }
+    }
+}
+
+#ifdef RADFILED3D_IO_URING
+/** The rings of an io_uring instance mapped into the process. The rings are used without liburing by the raw system calls. */
+struct BatchReader::Ring {
+    int ring_fd = -1;
+    unsigned entries = 0;
+
+    void* sq_ptr = nullptr;
+    size_t sq_ring_size = 0;
+    void* cq_ptr = nullptr;
+    size_t cq_ring_size = 0;
+    io_uring_sqe* sqes = nullptr;
+    size_t sqes_size = 0;
+
+    unsigned* sq_head = nullptr;
+    unsigned* sq_tail = nullptr;
+    unsigned* sq_mask = nullptr;
+    unsigned* sq_array = nullptr;
+    unsigned* cq_head = nullptr;
+    unsigned* cq_tail = nullptr;
+    unsigned* cq_mask = nullptr;
+    io_uring_cqe* cqes = nullptr;
+
+    /** Sets up an io_uring instance
+    * @param depth The number of submission queue entries
+    * @return False, if io_uring is not available
+    */
+    bool setup(unsigned depth) {
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(io_uring_params));
+        this->ring_fd = static_cast<int>(syscall(__NR_io_uring_setup, depth, &params));
+        if (this->ring_fd < 0) {
+            return false;
+        }
+        this->entries = params.sq_entries;
+
+        this->sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        this->cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        const bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (single_mmap) {
+            this->sq_ring_size = this->cq_ring_size = std::max(this->sq_ring_size, this->cq_ring_size);
+        }
+
+        this->sq_ptr = mmap(nullptr, this->sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, this->ring_fd, IORING_OFF_SQ_RING);
+        if (this->sq_ptr == MAP_FAILED) {
+            this->sq_ptr = nullptr;
+            return false;
+        }
+        if (single_mmap) {
+            this->cq_ptr = this->sq_ptr;
+        }
+        else {
+            this->cq_ptr = mmap(nullptr, this->cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, this->ring_fd, IORING_OFF_CQ_RING);
+            if (this->cq_ptr == MAP_FAILED) {
+                this->cq_ptr = nullptr;
+                return false;
+            }
+        }
+        this->sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+        void* sqes_ptr = mmap(nullptr, this->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, this->ring_fd, IORING_OFF_SQES);
+        if (sqes_ptr == MAP_FAILED) {
+            return false;
+        }
+        this->sqes = static_cast<io_uring_sqe*>(sqes_ptr);
+
+        char* sq = static_cast<char*>(this->sq_ptr);
+        this->sq_head = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+        this->sq_tail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        this->sq_mask = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        this->sq_array = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        char* cq = static_cast<char*>(this->cq_ptr);
+        this->cq_head = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        this->cq_tail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        this->cq_mask = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        this->cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+        return true;
+    }
+
+    ~Ring() {
+        if (this->sqes != nullptr) {
+            munmap(this->sqes, this->sqes_size);
+        }
+        if (this->cq_ptr != nullptr && this->cq_ptr != this->sq_ptr) {
+            munmap(this->cq_ptr, this->cq_ring_size);
+        }
+        if (this->sq_ptr != nullptr) {
+            munmap(this->sq_ptr, this->sq_ring_size);
+        }
+        if (this->ring_fd >= 0) {
+            close(this->ring_fd);
+        }
+    }
+
+    /** Submits the queued entries and waits for a number of completions
+    * @param to_submit The number of queued entries
+    * @param min_complete The number of completions to wait for
+    * @return The number of entries consumed by the kernel, or a negative errno
+    */
+    int enter(unsigned to_submit, unsigned min_complete) const {
+        const int result = static_cast<int>(syscall(__NR_io_uring_enter, this->ring_fd, to_submit, min_complete, (min_complete > 0) ? IORING_ENTER_GETEVENTS : 0u, nullptr, 0));
+        return (result < 0) ? -errno : result;
+    }
+};
+#else
+struct BatchReader::Ring {};
+#endif
+
+BatchReader::BatchReader(size_t queue_depth, size_t worker_count, bool allow_io_uring)
+    : queue_depth(std::max<size_t>(1, queue_depth)), worker_count(worker_count)
+{
+#ifdef RADFILED3D_IO_URING
+    if (allow_io_uring) {
+        std::unique_ptr<Ring> io_ring = std::make_unique<Ring>();
+        // the kernel rounds the number of entries up to a power of two
+        if (io_ring->setup(static_cast<unsigned>(std::min<size_t>(this->queue_depth, 4096)))) {
+            this->ring = std::move(io_ring);
+        }
+    }
+#endif
+}
+
+BatchReader::~BatchReader() = default;
+
+void BatchReader::read(const std::vector<BatchReadRequest>& requests)
+{
+    for (const BatchReadRequest& request : requests) {
+        validate_request(request);
+    }
+
+    if (this->ring != nullptr) {
+        this->read_ring(requests);
+    }
+    else {
+        this->read_threaded(requests);
+    }
+}
+
+bool BatchReader::drain_ring(size_t in_flight)
+{
+#ifdef RADFILED3D_IO_URING
+    Ring& io_ring = *this->ring;
+
+    // entries, which were queued but not consumed by the kernel, are withdrawn, as they will never complete
+    const unsigned sq_head = __atomic_load_n(io_ring.sq_head, __ATOMIC_ACQUIRE);
+    const unsigned sq_tail = *io_ring.sq_tail;
+    in_flight -= std::min<size_t>(in_flight, sq_tail - sq_head);
+    __atomic_store_n(io_ring.sq_tail, sq_head, __ATOMIC_RELEASE);
+
+    bool drained = true;
+    while (in_flight > 0) {
+        const int result = io_ring.enter(0, 1);
+        if (result < 0 && result != -EINTR && result != -EAGAIN && result != -EBUSY) {
+            drained = false;
+            break;
+        }
+        const unsigned cq_head = *io_ring.cq_head;
+        const unsigned cq_tail = __atomic_load_n(io_ring.cq_tail, __ATOMIC_ACQUIRE);
+        in_flight -= std::min<size_t>(in_flight, cq_tail - cq_head);
+        __atomic_store_n(io_ring.cq_head, cq_tail, __ATOMIC_RELEASE);
+    }
+
+    // the failed ring is not used again. Closing it cancels reads, which could not be awaited
+    this->ring.reset();
+    return drained;
+#else
+    (void)in_flight;
+    return true;
+#endif
+}
+
+void BatchReader::read_ring(const std::vector<BatchReadRequest>& requests)
+{
+#ifdef RADFILED3D_IO_URING
+    Ring& io_ring = *this->ring;
+
+    // each read in flight occupies a slot, which remembers the remainder of its block in case the read completes short
+    struct Slot {
+        int fd;
+        size_t offset;
+        char* destination;
+        size_t remaining;
+        iovec vector;
+    };
+    const size_t slot_count = std::min<size_t>(this->queue_depth, io_ring.entries);
+    std::vector<Slot> slots(slot_count);
+    std::vector<size_t> free_slots;
+    std::vector<size_t> resubmit_slots;
+    free_slots.reserve(slot_count);
+    for (size_t i = slot_count; i > 0; i--) {
+        free_slots.push_back(i - 1);
+    }
+
+    size_t next_request = 0;
+    size_t in_flight = 0;
+    unsigned unconsumed = 0;
+    bool failed = false;
+    std::string error;
+
+    auto queue_slot = [&](size_t slot_idx) {
+        Slot& slot = slots[slot_idx];
+        slot.vector.iov_base = slot.destination;
+        slot.vector.iov_len = slot.remaining;
+
+        const unsigned tail = *io_ring.sq_tail;
+        const unsigned index = tail & *io_ring.sq_mask;
+        io_uring_sqe& sqe = io_ring.sqes[index];
+        std::memset(&sqe, 0, sizeof(io_uring_sqe));
+        sqe.opcode = IORING_OP_READV;
+        sqe.fd = slot.fd;
+        sqe.off = static_cast<uint64_t>(slot.offset);
+        sqe.addr = reinterpret_cast<uint64_t>(&slot.vector);
+        sqe.len = 1;
+        sqe.user_data = static_cast<uint64_t>(slot_idx);
+        io_ring.sq_array[index] = index;
+        __atomic_store_n(io_ring.sq_tail, tail + 1, __ATOMIC_RELEASE);
+        unconsumed++;
+        in_flight++;
+    };
+
+    while (true) {
+        // keep the queue filled with the remainders of short reads first and the next requests afterwards
+        while (!resubmit_slots.empty()) {
+            queue_slot(resubmit_slots.back());
+            resubmit_slots.pop_back();
+        }
+        while (!failed && next_request < requests.size() && !free_slots.empty()) {
+            const BatchReadRequest& request = requests[next_request++];
+            if (request.size == 0) {
+                continue;
+            }
+            const size_t slot_idx = free_slots.back();
+            free_slots.pop_back();
+            slots[slot_idx] = Slot{ request.file->get_descriptor(), request.offset, request.destination, request.size, iovec() };
+            queue_slot(slot_idx);
+        }
+        if (in_flight == 0) {
+            break;
+        }
+
+        const int consumed = io_ring.enter(unconsumed, 1);
+        if (consumed < 0) {
+            if (consumed == -EINTR || consumed == -EAGAIN || consumed == -EBUSY) {
+                continue;
+            }
+            // the ring itself failed, but the reads the kernel consumed may still complete into their destinations and slots, so they are awaited before the batch is read again by positional reads
+            if (!this->drain_ring(in_flight)) {
+                throw PositionalFileException("Unable to complete reads: " + std::string(std::strerror(-consumed)));
+            }
+            this->read_threaded(requests);
+            return;
+        }
+        unconsumed -= std::min<unsigned>(unconsumed, static_cast<unsigned>(consumed));
+
+        unsigned head = *io_ring.cq_head;
+        const unsigned tail = __atomic_load_n(io_ring.cq_tail, __ATOMIC_ACQUIRE);
+        while (head != tail) {
+            const io_uring_cqe& cqe = io_ring.cqes[head & *io_ring.cq_mask];
+            const size_t slot_idx = static_cast<size_t>(cqe.user_data);
+            const int result = cqe.res;
+            head++;
+            in_flight--;
+
+            Slot& slot = slots[slot_idx];
+            if (result == -EINTR || result == -EAGAIN) {
+                resubmit_slots.push_back(slot_idx);
+                continue;
+            }
+            if (result <= 0) {
+                if (!failed) {
+                    error = (result < 0) ? "Unable to read from the file: " + std::string(std::strerror(-result)) : "Unable to read from the file";
+                }
+                failed = true;
+                free_slots.push_back(slot_idx);
+                continue;
+            }
+            slot.offset += static_cast<size_t>(result);
+            slot.destination += result;
+            slot.remaining -= static_cast<size_t>(result);
+            if (slot.remaining > 0 && !failed) {
+                resubmit_slots.push_back(slot_idx);
+            }
+            else {
+                free_slots.push_back(slot_idx);
+            }
+        }
+        __atomic_store_n(io_ring.cq_head, head, __ATOMIC_RELEASE);
+    }
+
+    if (failed) {
+        throw PositionalFileException(error);
+    }
+#else
+    this->read_threaded(requests);
+#endif
+}
+
+void BatchReader::read_threaded(const std::vector<BatchReadRequest>& requests) const
+{
+    size_t workers = this->worker_count;
+    if (workers == 0) {
+        const size_t hardware_threads = std::thread::hardware_concurrency();
+        workers = std::min(this->queue_depth, (hardware_threads > 0) ? hardware_threads : static_cast<size_t>(1));
+    }
+    // each worker takes the next block that is not yet read, the first error is rethrown after all workers finished
+    VoxelBuffer::parallel_for(requests.size(), workers, [&requests](size_t i) {
+        requests[i].file->read(requests[i].offset, requests[i].destination, requests[i].size);
+    });
+}
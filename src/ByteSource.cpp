@@ -0,0 +1,298 @@
+#include "RadFiled3D/helpers/ByteSource.hpp"
+#include "RadFiled3D/helpers/BatchReader.hpp"
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+
+using namespace RadFiled3D;
+
+
+void ByteSource::read_batch(const std::vector<ByteRange>& ranges) const
+{
+    for (const ByteRange& range : ranges) {
+        this->read(range.offset, range.destination, range.size);
+    }
+}
+
+const char* ByteSource::view(size_t offset, size_t size) const
+{
+    this->check_range(offset, size);
+    return nullptr;
+}
+
+void ByteSource::check_range(size_t offset, size_t size) const
+{
+    const size_t source_size = this->size();
+    if (offset > source_size || size > source_size - offset) {
+        throw ByteSourceException("Range exceeds the source");
+    }
+}
+
+
+FileByteSource::FileByteSource(const std::string& filename, size_t queue_depth)
+    : file(std::make_shared<PositionalFile>(filename)), queue_depth(queue_depth)
+{
+}
+
+FileByteSource::FileByteSource(std::shared_ptr<PositionalFile> file, size_t queue_depth)
+    : file(file), queue_depth(queue_depth)
+{
+}
+
+size_t FileByteSource::size() const
+{
+    return this->file->size();
+}
+
+void FileByteSource::read(size_t offset, char* destination, size_t size) const
+{
+    this->check_range(offset, size);
+    this->file->read(offset, destination, size);
+}
+
+void FileByteSource::read_batch(const std::vector<ByteRange>& ranges) const
+{
+    if (this->queue_depth == 0) {
+        ByteSource::read_batch(ranges);
+        return;
+    }
+
+    std::vector<BatchReadRequest> requests;
+    requests.reserve(ranges.size());
+    for (const ByteRange& range : ranges) {
+        this->check_range(range.offset, range.size);
+        requests.push_back({ this->file.get(), range.offset, range.size, range.destination });
+    }
+    BatchReader(this->queue_depth).read(requests);
+}
+
+
+MappedByteSource::MappedByteSource(const std::string& filename)
+    : file(std::make_shared<MappedFile>(filename))
+{
+}
+
+MappedByteSource::MappedByteSource(std::shared_ptr<MappedFile> file)
+    : file(file)
+{
+}
+
+size_t MappedByteSource::size() const
+{
+    return this->file->size();
+}
+
+void MappedByteSource::read(size_t offset, char* destination, size_t size) const
+{
+    std::memcpy(destination, this->view(offset, size), size);
+}
+
+const char* MappedByteSource::view(size_t offset, size_t size) const
+{
+    this->check_range(offset, size);
+    return this->file->data() + offset;
+}
+
+
+MemoryByteSource::MemoryByteSource(const char* data, size_t size)
+    : data(data), data_size(size)
+{
+}
+
+MemoryByteSource::MemoryByteSource(std::vector<char> data)
+{
+    std::shared_ptr<std::vector<char>> buffer = std::make_shared<std::vector<char>>(std::move(data));
+    this->data = buffer->data();
+    this->data_size = buffer->size();
+    this->owner = buffer;
+}
+
+MemoryByteSource::MemoryByteSource(std::shared_ptr<const void> owner, const char* data, size_t size)
+    : owner(owner), data(data), data_size(size)
+{
+}
+
+size_t MemoryByteSource::size() const
+{
+    return this->data_size;
+}
+
+void MemoryByteSource::read(size_t offset, char* destination, size_t size) const
+{
+    std::memcpy(destination, this->view(offset, size), size);
+}
+
+const char* MemoryByteSource::view(size_t offset, size_t size) const
+{
+    this->check_range(offset, size);
+    return this->data + offset;
+}
+
+
+ThrottledByteSource::ThrottledByteSource(std::shared_ptr<ByteSource> source, std::chrono::microseconds latency, size_t bandwidth, size_t max_concurrent_requests)
+    : source(source), latency(latency), bandwidth(bandwidth), max_concurrent_requests(max_concurrent_requests), request_count(0), transferred_bytes(0)
+{
+}
+
+size_t ThrottledByteSource::size() const
+{
+    return this->source->size();
+}
+
+void ThrottledByteSource::read(size_t offset, char* destination, size_t size) const
+{
+    this->check_range(offset, size);
+    this->delay(1, size, size);
+    this->source->read(offset, destination, size);
+}
+
+void ThrottledByteSource::read_batch(const std::vector<ByteRange>& ranges) const
+{
+    for (const ByteRange& range : ranges) {
+        this->check_range(range.offset, range.size);
+    }
+
+    // each range is a request of its own, which are issued in waves of up to the maximum number of concurrent requests
+    const size_t wave_size = (this->max_concurrent_requests > 0) ? this->max_concurrent_requests : std::max<size_t>(ranges.size(), 1);
+    for (size_t first = 0; first < ranges.size(); first += wave_size) {
+        const size_t end = std::min(first + wave_size, ranges.size());
+        size_t bytes = 0;
+        size_t largest_request_bytes = 0;
+        for (size_t i = first; i < end; i++) {
+            bytes += ranges[i].size;
+            largest_request_bytes = std::max(largest_request_bytes, ranges[i].size);
+        }
+        this->delay(end - first, bytes, largest_request_bytes);
+    }
+    this->source->read_batch(ranges);
+}
+
+void ThrottledByteSource::reset_statistics()
+{
+    this->request_count = 0;
+    this->transferred_bytes = 0;
+}
+
+void ThrottledByteSource::delay(size_t requests, size_t bytes, size_t largest_request_bytes) const
+{
+    this->request_count += requests;
+    this->transferred_bytes += bytes;
+
+    std::chrono::microseconds duration = this->latency;
+    if (this->bandwidth > 0) {
+        duration += std::chrono::microseconds(static_cast<long long>(static_cast<double>(largest_request_bytes) / static_cast<double>(this->bandwidth) * 1e6));
+    }
+    if (duration.count() > 0) {
+        std::this_thread::sleep_for(duration);
+    }
+}
+
+
+ByteSourceStreamBuffer::ByteSourceStreamBuffer(std::shared_ptr<ByteSource> source, size_t buffer_size)
+    : source(source), buffer(std::max<size_t>(1, buffer_size))
+{
+    this->setg(this->buffer.data(), this->buffer.data(), this->buffer.data());
+}
+
+size_t ByteSourceStreamBuffer::position() const
+{
+    return this->buffer_offset + static_cast<size_t>(this->gptr() - this->eback());
+}
+
+ByteSourceStreamBuffer::int_type ByteSourceStreamBuffer::underflow()
+{
+    if (this->gptr() < this->egptr()) {
+        return traits_type::to_int_type(*this->gptr());
+    }
+
+    const size_t offset = this->position();
+    const size_t source_size = this->source->size();
+    if (offset >= source_size) {
+        return traits_type::eof();
+    }
+
+    const size_t count = std::min(this->buffer.size(), source_size - offset);
+    this->source->read(offset, this->buffer.data(), count);
+    this->buffer_offset = offset;
+    this->setg(this->buffer.data(), this->buffer.data(), this->buffer.data() + count);
+    return traits_type::to_int_type(*this->gptr());
+}
+
+std::streamsize ByteSourceStreamBuffer::xsgetn(char* destination, std::streamsize count)
+{
+    // serve as much as possible from the buffer and read the rest directly, if it does not fit into the buffer
+    std::streamsize copied = std::min<std::streamsize>(count, this->egptr() - this->gptr());
+    if (copied > 0) {
+        std::memcpy(destination, this->gptr(), static_cast<size_t>(copied));
+        this->gbump(static_cast<int>(copied));
+    }
+    if (copied == count) {
+        return copied;
+    }
+
+    const size_t remaining = static_cast<size_t>(count - copied);
+    if (remaining < this->buffer.size()) {
+        return copied + std::streambuf::xsgetn(destination + copied, count - copied);
+    }
+
+    const size_t offset = this->position();
+    const size_t source_size = this->source->size();
+    const size_t available = (offset < source_size) ? std::min(remaining, source_size - offset) : 0;
+    if (available > 0) {
+        this->source->read(offset, destination + copied, available);
+    }
+    this->buffer_offset = offset + available;
+    this->setg(this->buffer.data(), this->buffer.data(), this->buffer.data());
+    return copied + static_cast<std::streamsize>(available);
+}
+
+std::streamsize ByteSourceStreamBuffer::showmanyc()
+{
+    const size_t offset = this->position();
+    const size_t source_size = this->source->size();
+    return (offset < source_size) ? static_cast<std::streamsize>(source_size - offset) : -1;
+}
+
+ByteSourceStreamBuffer::pos_type ByteSourceStreamBuffer::seekoff(off_type offset, std::ios_base::seekdir direction, std::ios_base::openmode which)
+{
+    if ((which & std::ios_base::in) == 0) {
+        return pos_type(off_type(-1));
+    }
+
+    off_type base = 0;
+    if (direction == std::ios_base::cur) {
+        base = static_cast<off_type>(this->position());
+    }
+    else if (direction == std::ios_base::end) {
+        base = static_cast<off_type>(this->source->size());
+    }
+    return this->seekpos(pos_type(base + offset), which);
+}
+
+ByteSourceStreamBuffer::pos_type ByteSourceStreamBuffer::seekpos(pos_type position, std::ios_base::openmode which)
+{
+    const off_type target = off_type(position);
+    if ((which & std::ios_base::in) == 0 || target < 0 || static_cast<size_t>(target) > this->source->size()) {
+        return pos_type(off_type(-1));
+    }
+
+    // keep the buffer, if the position lies within it
+    const size_t offset = static_cast<size_t>(target);
+    const size_t buffered = static_cast<size_t>(this->egptr() - this->eback());
+    if (offset >= this->buffer_offset && offset < this->buffer_offset + buffered) {
+        this->setg(this->eback(), this->eback() + (offset - this->buffer_offset), this->egptr());
+    }
+    else {
+        this->buffer_offset = offset;
+        this->setg(this->buffer.data(), this->buffer.data(), this->buffer.data());
+    }
+    return position;
+}
+
+
+ByteSourceStream::ByteSourceStream(std::shared_ptr<ByteSource> source, size_t buffer_size)
+    : std::istream(nullptr), stream_buffer(source, buffer_size)
+{
+    this->rdbuf(&this->stream_buffer);
+}
@@ -8,6 +8,8 @@
 #include <istream>
 #include <fstream>
 #include <memory>
+#include <algorithm>
+#include <cstring>
 
 
 using namespace RadFiled3D;
@@ -47,12 +49,13 @@ std::vector<char> RadFiled3D::Storage::V1::FileParser::SerializeChannelsLayersOf
 std::map<std::string, AccessorTypes::ChannelStructure> RadFiled3D::Storage::V1::FileParser::DeserializeChannelsLayersOffsets(const std::vector<char>& data) {
 	std::map<std::string, AccessorTypes::ChannelStructure> channels_layers_offsets = std::map<std::string, AccessorTypes::ChannelStructure>();
 	size_t offset = 0;
-	const size_t min_bytes_per_channel = sizeof(size_t) * 3 + sizeof(char);
-	const size_t min_remaining_size = (data.size() >= min_bytes_per_channel) ? data.size() - min_bytes_per_channel : 0;
-	while (offset < min_remaining_size) {
-		std::string channel_name = std::string(data.data() + offset);
-		if (offset + channel_name.size() + 1 + sizeof(size_t) * 3 > min_remaining_size)
+	const size_t channel_fields_size = sizeof(size_t) * 3;
+	const size_t layer_fields_size = sizeof(size_t) * 4 + sizeof(Typing::DType);
+	while (offset < data.size()) {
+		const size_t channel_name_length = strnlen(data.data() + offset, data.size() - offset);
+		if (offset + channel_name_length + 1 + channel_fields_size > data.size())
 			break;
+		std::string channel_name = std::string(data.data() + offset, channel_name_length);
 		offset += channel_name.size() + 1;
 		size_t channel_offset = *(size_t*)(data.data() + offset);
 		offset += sizeof(size_t);
@@ -63,7 +66,10 @@ std::map<std::string, AccessorTypes::ChannelStructure> RadFiled3D::Storage::V1::
 
 		std::map<std::string, AccessorTypes::TypedMemoryBlockDefinition> layers;
 		while (offset < data.size() && layers.size() < layer_count) {
-			std::string layer_name = std::string(data.data() + offset);
+			const size_t layer_name_length = strnlen(data.data() + offset, data.size() - offset);
+			if (offset + layer_name_length + 1 + layer_fields_size > data.size())
+				throw RadiationFieldStoreException("Corrupted channel and layer offsets");
+			std::string layer_name = std::string(data.data() + offset, layer_name_length);
 			offset += layer_name.size() + 1;
 			size_t layer_offset = *(size_t*)(data.data() + offset);
 			offset += sizeof(size_t);
@@ -76,6 +82,9 @@ std::map<std::string, AccessorTypes::ChannelStructure> RadFiled3D::Storage::V1::
 			size_t voxel_header_data_size = *(size_t*)(data.data() + offset);
 			offset += sizeof(size_t);
 
+			if (offset + voxel_header_data_size > data.size())
+				throw RadiationFieldStoreException("Corrupted channel and layer offsets");
+
 			AccessorTypes::TypedMemoryBlockDefinition layer_block(layer_offset, layer_size, dtype, elements_per_voxel);
 			if (voxel_header_data_size > 0)
 				layer_block.set_voxel_header_data((char*)(data.data() + offset), voxel_header_data_size);
@@ -128,7 +137,7 @@ std::shared_ptr<FieldAccessor> RadFiled3D::Storage::FieldAccessor::Deserialize(c
 	FieldAccessor::SerializationData sdata_header;
 	memcpy((char*)&sdata_header, buffer.data(), sizeof(FieldAccessor::SerializationData));
 	std::shared_ptr<FieldAccessor> accessor;
-	if (sdata_header.store_version == StoreVersion::V1) {
+	if (sdata_header.store_version == StoreVersion::V1 || sdata_header.store_version == StoreVersion::V2) {
 		if (sdata_header.field_type == FieldType::Cartesian) {
 			V1::CartesianFieldAccessor::SerializationData sdata;
 			memcpy(((char*)&sdata), buffer.data(), sizeof(V1::CartesianFieldAccessor::SerializationData) - sizeof(std::map<std::string, AccessorTypes::ChannelStructure>));
@@ -137,6 +146,8 @@ std::shared_ptr<FieldAccessor> RadFiled3D::Storage::FieldAccessor::Deserialize(c
 			std::vector<char> additional_data(remaining_size);
 			memcpy(additional_data.data(), buffer.data() + sizeof(V1::CartesianFieldAccessor::SerializationData), remaining_size);
 			sdata.deserialize_additional_data(additional_data);
+			if (sdata.store_version == StoreVersion::V2)
+				return std::static_pointer_cast<FieldAccessor>(std::make_shared<V2::CartesianFieldAccessor>(sdata));
 			return std::static_pointer_cast<FieldAccessor>(std::make_shared<V1::CartesianFieldAccessor>(sdata));
 		}
 		else if (sdata_header.field_type == FieldType::Polar) {
@@ -147,6 +158,8 @@ std::shared_ptr<FieldAccessor> RadFiled3D::Storage::FieldAccessor::Deserialize(c
 			std::vector<char> additional_data(remaining_size);
 			memcpy(additional_data.data(), buffer.data() + sizeof(V1::PolarFieldAccessor::SerializationData), remaining_size);
 			sdata.deserialize_additional_data(additional_data);
+			if (sdata.store_version == StoreVersion::V2)
+				return std::static_pointer_cast<FieldAccessor>(std::make_shared<V2::PolarFieldAccessor>(sdata));
 			return std::static_pointer_cast<FieldAccessor>(std::make_shared<V1::PolarFieldAccessor>(sdata));
 		}
 		else {
@@ -169,6 +182,8 @@ StoreVersion RadFiled3D::Storage::FieldAccessor::getStoreVersion(std::istream& b
 
 	if (strcmp(version.version, "1.0") == 0)
 		return StoreVersion::V1;
+	if (strcmp(version.version, "2.0") == 0)
+		return StoreVersion::V2;
 
 	throw RadiationFieldStoreException(std::string("Unsupported file version: ") + std::string(version.version));
 }
@@ -303,6 +318,413 @@ IVoxel* RadFiled3D::Storage::V1::FileParser::createVoxelFromBuffer(char* data_bu
 }
 
 IVoxel* RadFiled3D::Storage::V1::FileParser::accessVoxelRawFlat(std::istream& buffer, const std::string& channel_name, const std::string& layer_name, size_t voxel_idx) const
+{
+	return this->accessVoxelsRawFlat(buffer, channel_name, layer_name, { voxel_idx })[0];
+}
+
+std::vector<IVoxel*> RadFiled3D::Storage::V1::FileParser::accessVoxelsRawFlat(std::istream& buffer, const std::string& channel_name, const std::string& layer_name, const std::vector<size_t>& voxel_indices) const
+{
+	const auto& layer_block = this->getLayerDefinition(channel_name, layer_name);
+	const size_t voxel_bytes = layer_block.elements_per_voxel * Typing::Helper::get_bytes_of_dtype(layer_block.dtype);
+
+	std::vector<char> data_buffer(voxel_indices.size() * voxel_bytes);
+	this->accessVoxelsDataFlat(buffer, channel_name, layer_name, voxel_indices, data_buffer.data(), data_buffer.size());
+	return this->createVoxelsFromData(data_buffer.data(), layer_block, voxel_indices.size());
+}
+
+size_t RadFiled3D::Storage::V1::FileParser::accessVoxelsDataFlat(std::istream& buffer, const std::string& channel_name, const std::string& layer_name, const std::vector<size_t>& voxel_indices, char* destination, size_t destination_size) const
+{
+	const FileLayout layout = this->resolveLayout(buffer);
+	return this->readVoxelsData(FileParser::StreamReader(buffer), layout, channel_name, layer_name, voxel_indices, destination, destination_size);
+}
+
+IVoxel* RadFiled3D::Storage::V1::FileParser::accessVoxelRawFlat(const std::shared_ptr<PositionalFile>& file, const std::string& channel_name, const std::string& layer_name, size_t voxel_idx) const
+{
+	return this->accessVoxelsRawFlat(file, channel_name, layer_name, { voxel_idx })[0];
+}
+
+std::vector<IVoxel*> RadFiled3D::Storage::V1::FileParser::accessVoxelsRawFlat(const std::shared_ptr<PositionalFile>& file, const std::string& channel_name, const std::string& layer_name, const std::vector<size_t>& voxel_indices) const
+{
+	const auto& layer_block = this->getLayerDefinition(channel_name, layer_name);
+	const size_t voxel_bytes = layer_block.elements_per_voxel * Typing::Helper::get_bytes_of_dtype(layer_block.dtype);
+
+	std::vector<char> data_buffer(voxel_indices.size() * voxel_bytes);
+	this->accessVoxelsDataFlat(file, channel_name, layer_name, voxel_indices, data_buffer.data(), data_buffer.size());
+	return this->createVoxelsFromData(data_buffer.data(), layer_block, voxel_indices.size());
+}
+
+size_t RadFiled3D::Storage::V1::FileParser::accessVoxelsDataFlat(const std::shared_ptr<PositionalFile>& file, const std::string& channel_name, const std::string& layer_name, const std::vector<size_t>& voxel_indices, char* destination, size_t destination_size) const
+{
+	const BlockReader read = FileParser::FileReader(file);
+	return this->readVoxelsData(read, this->resolveLayout(file), channel_name, layer_name, voxel_indices, destination, destination_size);
+}
+
+size_t RadFiled3D::Storage::V1::FileParser::queueVoxelsDataFlat(const std::shared_ptr<PositionalFile>& file, const std::string& channel_name, const std::string& layer_name, const std::vector<size_t>& voxel_indices, char* destination, size_t destination_size, std::vector<BatchReadRequest>& batch) const
+{
+	return this->queueVoxelsDataFlat(file, this->resolveFileLayout(file), channel_name, layer_name, voxel_indices, destination, destination_size, batch);
+}
+
+RadFiled3D::Storage::FieldAccessor::FileLayout RadFiled3D::Storage::V1::FileParser::resolveFileLayout(const std::shared_ptr<PositionalFile>& file) const
+{
+	return this->resolveLayout(file);
+}
+
+size_t RadFiled3D::Storage::V1::FileParser::queueVoxelsDataFlat(const std::shared_ptr<PositionalFile>& file, const FileLayout& layout, const std::string& channel_name, const std::string& layer_name, const std::vector<size_t>& voxel_indices, char* destination, size_t destination_size, std::vector<BatchReadRequest>& batch) const
+{
+	const PositionalFile* batch_file = file.get();
+	return this->queueVoxelsData(FileParser::FileReader(file), layout, [&batch, batch_file](size_t position, size_t size, char* block_destination) {
+		batch.push_back({ batch_file, position, size, block_destination });
+	}, channel_name, layer_name, voxel_indices, destination, destination_size);
+}
+
+std::shared_ptr<IRadiationField> RadFiled3D::Storage::V1::FileParser::accessField(const std::shared_ptr<ByteSource>& source) const
+{
+	// mapped sources, e.g. stored members of a ZipArchive, are viewed without copies
+	if (auto mapped = std::dynamic_pointer_cast<MappedByteSource>(source))
+		return this->accessField(mapped->get_file());
+
+	ByteSourceStream buffer(source);
+	return this->accessField(buffer);
+}
+
+IVoxel* RadFiled3D::Storage::V1::FileParser::accessVoxelRawFlat(const std::shared_ptr<ByteSource>& source, const std::string& channel_name, const std::string& layer_name, size_t voxel_idx) const
+{
+	return this->accessVoxelsRawFlat(source, channel_name, layer_name, { voxel_idx })[0];
+}
+
+std::vector<IVoxel*> RadFiled3D::Storage::V1::FileParser::accessVoxelsRawFlat(const std::shared_ptr<ByteSource>& source, const std::string& channel_name, const std::string& layer_name, const std::vector<size_t>& voxel_indices) const
+{
+	const auto& layer_block = this->getLayerDefinition(channel_name, layer_name);
+	const size_t voxel_bytes = layer_block.elements_per_voxel * Typing::Helper::get_bytes_of_dtype(layer_block.dtype);
+
+	std::vector<char> data_buffer(voxel_indices.size() * voxel_bytes);
+	this->accessVoxelsDataFlat(source, channel_name, layer_name, voxel_indices, data_buffer.data(), data_buffer.size());
+	return this->createVoxelsFromData(data_buffer.data(), layer_block, voxel_indices.size());
+}
+
+size_t RadFiled3D::Storage::V1::FileParser::accessVoxelsDataFlat(const std::shared_ptr<ByteSource>& source, const std::string& channel_name, const std::string& layer_name, const std::vector<size_t>& voxel_indices, char* destination, size_t destination_size) const
+{
+	if (auto mapped = std::dynamic_pointer_cast<MappedByteSource>(source))
+		return this->accessVoxelsDataFlat(mapped->get_file(), channel_name, layer_name, voxel_indices, destination, destination_size);
+
+	// all blocks are passed to the source at once, so that sources with expensive requests can coalesce or parallelize them
+	std::vector<ByteRange> ranges;
+	const BlockReader read = FileParser::SourceReader(source);
+	const size_t bytes = this->queueVoxelsData(read, this->resolveLayout(source), [&ranges](size_t position, size_t size, char* block_destination) {
+		ranges.push_back({ position, size, block_destination });
+	}, channel_name, layer_name, voxel_indices, destination, destination_size);
+	source->read_batch(ranges);
+	return bytes;
+}
+
+size_t RadFiled3D::Storage::V1::FileParser::queueVoxelsData(const BlockReader& read, const FileLayout& layout, const BlockReader& queue, const std::string& channel_name, const std::string& layer_name, const std::vector<size_t>& voxel_indices, char* destination, size_t destination_size) const
+{
+	size_t layer_position = 0;
+	const auto& layer_block = this->findLayer(layout, channel_name, layer_name, layer_position);
+
+	const size_t voxel_bytes = layer_block.elements_per_voxel * Typing::Helper::get_bytes_of_dtype(layer_block.dtype);
+	if (destination_size < voxel_indices.size() * voxel_bytes)
+		throw RadiationFieldStoreException("Destination buffer is too small");
+
+	if (this->isLayerEncoded(layer_block))
+		return this->readVoxelsData(read, layout, channel_name, layer_name, voxel_indices, destination, destination_size);
+
+	for (size_t voxel_idx : voxel_indices) {
+		if (voxel_idx >= this->voxel_count)
+			throw RadiationFieldStoreException("Voxel index out of bounds");
+	}
+
+	// each read lands directly in the destination, so only voxels adjacent in the file and in the destination are read at once
+	const size_t voxel_data_position = layer_position + this->getVoxelDataOffset(layer_block);
+	size_t run_start = 0;
+	while (run_start < voxel_indices.size()) {
+		size_t run_end = run_start + 1;
+		while (run_end < voxel_indices.size() && voxel_indices[run_end] == voxel_indices[run_end - 1] + 1)
+			run_end++;
+
+		queue(voxel_data_position + voxel_indices[run_start] * voxel_bytes, (run_end - run_start) * voxel_bytes, destination + run_start * voxel_bytes);
+		run_start = run_end;
+	}
+
+	return voxel_indices.size() * voxel_bytes;
+}
+
+RadFiled3D::Storage::V1::FileParser::BlockReader RadFiled3D::Storage::V1::FileParser::StreamReader(std::istream& buffer)
+{
+	return [&buffer](size_t position, size_t size, char* destination) {
+		buffer.seekg(position, std::ios::beg);
+		buffer.read(destination, size);
+		if (static_cast<size_t>(buffer.gcount()) != size)
+			throw RadiationFieldStoreException("Unexpected end of buffer");
+	};
+}
+
+RadFiled3D::Storage::V1::FileParser::BlockReader RadFiled3D::Storage::V1::FileParser::FileReader(const std::shared_ptr<PositionalFile>& file)
+{
+	return [file](size_t position, size_t size, char* destination) {
+		file->read(position, destination, size);
+	};
+}
+
+RadFiled3D::Storage::V1::FileParser::BlockReader RadFiled3D::Storage::V1::FileParser::SourceReader(const std::shared_ptr<ByteSource>& source)
+{
+	return [source](size_t position, size_t size, char* destination) {
+		source->read(position, destination, size);
+	};
+}
+
+RadFiled3D::Storage::V1::FileParser::BlockReader RadFiled3D::Storage::V1::FileParser::MappedReader(const std::shared_ptr<MappedFile>& file)
+{
+	return [file](size_t position, size_t size, char* destination) {
+		if (position + size > file->size())
+			throw RadiationFieldStoreException("Memory block exceeds the mapped file");
+		memcpy(destination, file->data() + position, size);
+	};
+}
+
+RadFiled3D::Storage::V1::FileParser::FileLayout RadFiled3D::Storage::V1::FileParser::resolveLayout(const BlockReader& read, size_t buffer_size) const
+{
+	FileLayout layout;
+	if (this->store_version != StoreVersion::V2) {
+		layout.field_data_offset = this->getFieldDataOffset();
+		layout.channels_layers_offsets = &this->channels_layers_offsets;
+		return layout;
+	}
+
+	V2::FieldIndex index = V2::FieldIndex::Read(read, buffer_size);
+	if (index.field_type != this->getFieldType() || index.getVoxelCount() != this->voxel_count)
+		throw RadiationFieldStoreException("Field of the buffer does not match the structure of the accessor");
+
+	auto file_offsets = std::make_shared<const std::map<std::string, AccessorTypes::ChannelStructure>>(std::move(index.channels_layers_offsets));
+	layout.field_data_offset = index.getFieldDataOffset();
+	layout.channels_layers_offsets = file_offsets.get();
+	layout.file_channels_layers_offsets = file_offsets;
+	return layout;
+}
+
+RadFiled3D::Storage::V1::FileParser::FileLayout RadFiled3D::Storage::V1::FileParser::resolveLayout(std::istream& buffer) const
+{
+	if (this->store_version != StoreVersion::V2)
+		return this->resolveLayout(FileParser::StreamReader(buffer), 0);
+
+	buffer.clear();
+	buffer.seekg(0, std::ios::end);
+	const size_t buffer_size = buffer.tellg();
+	return this->resolveLayout(FileParser::StreamReader(buffer), buffer_size);
+}
+
+RadFiled3D::Storage::V1::FileParser::FileLayout RadFiled3D::Storage::V1::FileParser::resolveCachedLayout(const std::shared_ptr<const void>& source, const BlockReader& read, size_t buffer_size) const
+{
+	if (this->store_version != StoreVersion::V2)
+		return this->resolveLayout(read, buffer_size);
+
+	// an expired entry still holds the control block of its file, so that no other file can be mistaken for it
+	auto is_source = [&source, buffer_size](const LayoutCache::Entry& entry) {
+		return !entry.source.owner_before(source) && !source.owner_before(entry.source) && entry.size == buffer_size;
+	};
+	{
+		std::lock_guard<std::mutex> lock(this->layout_cache->mutex);
+		auto entry_itr = std::find_if(this->layout_cache->entries.begin(), this->layout_cache->entries.end(), is_source);
+		if (entry_itr != this->layout_cache->entries.end())
+			return entry_itr->layout;
+	}
+
+	// the index is read without holding the lock, so that reads of other files are not blocked
+	FileLayout layout = this->resolveLayout(read, buffer_size);
+
+	std::lock_guard<std::mutex> lock(this->layout_cache->mutex);
+	std::vector<LayoutCache::Entry>& entries = this->layout_cache->entries;
+	entries.erase(std::remove_if(entries.begin(), entries.end(), [](const LayoutCache::Entry& entry) { return entry.source.expired(); }), entries.end());
+	if (std::find_if(entries.begin(), entries.end(), is_source) == entries.end()) {
+		if (entries.size() >= LayoutCache::CAPACITY)
+			entries.erase(entries.begin());
+		entries.push_back({ source, buffer_size, layout });
+	}
+	return layout;
+}
+
+RadFiled3D::Storage::V1::FileParser::FileLayout RadFiled3D::Storage::V1::FileParser::resolveLayout(const std::shared_ptr<MappedFile>& file) const
+{
+	return this->resolveCachedLayout(file, FileParser::MappedReader(file), file->size());
+}
+
+RadFiled3D::Storage::V1::FileParser::FileLayout RadFiled3D::Storage::V1::FileParser::resolveLayout(const std::shared_ptr<PositionalFile>& file) const
+{
+	return this->resolveCachedLayout(file, FileParser::FileReader(file), file->size());
+}
+
+RadFiled3D::Storage::V1::FileParser::FileLayout RadFiled3D::Storage::V1::FileParser::resolveLayout(const std::shared_ptr<ByteSource>& source) const
+{
+	return this->resolveCachedLayout(source, FileParser::SourceReader(source), source->size());
+}
+
+const RadFiled3D::Storage::AccessorTypes::ChannelStructure& RadFiled3D::Storage::V1::FileParser::findChannel(const FileLayout& layout, const std::string& channel_name) const
+{
+	auto channel_block_itr = layout.channels_layers_offsets->find(channel_name);
+	if (channel_block_itr == layout.channels_layers_offsets->end())
+		throw RadiationFieldStoreException("Channel not found");
+
+	return channel_block_itr->second;
+}
+
+const RadFiled3D::Storage::AccessorTypes::TypedMemoryBlockDefinition& RadFiled3D::Storage::V1::FileParser::findLayer(const FileLayout& layout, const std::string& channel_name, const std::string& layer_name, size_t& layer_position) const
+{
+	const AccessorTypes::ChannelStructure& channel = this->findChannel(layout, channel_name);
+	auto layer_block_itr = channel.layers.find(layer_name);
+	if (layer_block_itr == channel.layers.end())
+		throw RadiationFieldStoreException("Layer not found");
+
+	const AccessorTypes::TypedMemoryBlockDefinition& layer_block = layer_block_itr->second;
+	if (layout.channels_layers_offsets != &this->channels_layers_offsets) {
+		// voxels are created and sized by the layer definitions of the accessor, so that the layer of the buffer needs to store them alike
+		const AccessorTypes::TypedMemoryBlockDefinition& expected_block = this->getLayerDefinition(channel_name, layer_name);
+		if (layer_block.dtype != expected_block.dtype || layer_block.elements_per_voxel != expected_block.elements_per_voxel ||
+			layer_block.get_voxel_header_data_size() != expected_block.get_voxel_header_data_size() ||
+			memcmp(layer_block.get_voxel_header_data(), expected_block.get_voxel_header_data(), layer_block.get_voxel_header_data_size()) != 0)
+			throw RadiationFieldStoreException("Layer: '" + layer_name + "' of the buffer does not match the layer definition of the accessor");
+	}
+
+	layer_position = layout.field_data_offset + channel.channel_block.offset + layer_block.offset + sizeof(FiledTypes::V1::ChannelHeader);
+	return layer_block;
+}
+
+VoxelLayer* RadFiled3D::Storage::V1::FileParser::readLayer(const BlockReader& read, const FileLayout& layout, const std::string& channel_name, const std::string& layer_name) const
+{
+	size_t layer_position = 0;
+	const auto& layer_block = this->findLayer(layout, channel_name, layer_name, layer_position);
+
+	std::vector<char> layer_data(layer_block.size);
+	read(layer_position, layer_block.size, layer_data.data());
+	return this->serializer->deserializeLayer(layer_data.data(), layer_block.size);
+}
+
+size_t RadFiled3D::Storage::V1::FileParser::readVoxelsData(const BlockReader& read, const FileLayout& layout, const std::string& channel_name, const std::string& layer_name, const std::vector<size_t>& voxel_indices, char* destination, size_t destination_size) const
+{
+	size_t layer_position = 0;
+	const auto& layer_block = this->findLayer(layout, channel_name, layer_name, layer_position);
+
+	const size_t element_size = Typing::Helper::get_bytes_of_dtype(layer_block.dtype);
+	const size_t voxel_bytes = layer_block.elements_per_voxel * element_size;
+	if (destination_size < voxel_indices.size() * voxel_bytes)
+		throw RadiationFieldStoreException("Destination buffer is too small");
+
+	if (this->isLayerEncoded(layer_block)) {
+		std::vector<char> layer_data(layer_block.size);
+		read(layer_position, layer_block.size, layer_data.data());
+		std::unique_ptr<VoxelLayer> layer(this->serializer->deserializeLayer(layer_data.data(), layer_block.size));
+		return this->copyVoxelsFromLayer(*layer, layer_block, voxel_indices, destination);
+	}
+
+	for (size_t voxel_idx : voxel_indices) {
+		if (voxel_idx >= this->voxel_count)
+			throw RadiationFieldStoreException("Voxel index out of bounds");
+	}
+
+	// visit the voxels in file order, so that voxels close to each other can be read at once
+	std::vector<size_t> read_order(voxel_indices.size());
+	for (size_t i = 0; i < read_order.size(); i++)
+		read_order[i] = i;
+	std::sort(read_order.begin(), read_order.end(), [&voxel_indices](size_t a, size_t b) { return voxel_indices[a] < voxel_indices[b]; });
+
+	const size_t voxel_data_position = layer_position + this->getVoxelDataOffset(layer_block);
+	std::vector<char> data_buffer;
+	size_t run_start = 0;
+	while (run_start < read_order.size()) {
+		const size_t first_voxel = voxel_indices[read_order[run_start]];
+		size_t last_voxel = first_voxel;
+		size_t run_end = run_start + 1;
+		while (run_end < read_order.size()) {
+			const size_t next_voxel = voxel_indices[read_order[run_end]];
+			if ((next_voxel - last_voxel) * voxel_bytes > this->voxel_read_gap_threshold + voxel_bytes)
+				break;
+			last_voxel = next_voxel;
+			run_end++;
+		}
+
+		data_buffer.resize((last_voxel - first_voxel + 1) * voxel_bytes);
+		read(voxel_data_position + first_voxel * voxel_bytes, data_buffer.size(), data_buffer.data());
+
+		// scatter the voxels of the run back into the requested order
+		for (size_t i = run_start; i < run_end; i++)
+			memcpy(destination + read_order[i] * voxel_bytes, data_buffer.data() + (voxel_indices[read_order[i]] - first_voxel) * voxel_bytes, voxel_bytes);
+		run_start = run_end;
+	}
+
+	return voxel_indices.size() * voxel_bytes;
+}
+
+char* RadFiled3D::Storage::V1::FileParser::getMappedBlock(const std::shared_ptr<MappedFile>& file, size_t position, size_t size) const
+{
+	if (position + size > file->size())
+		throw RadiationFieldStoreException("Memory block exceeds the mapped file");
+
+	return file->data() + position;
+}
+
+size_t RadFiled3D::Storage::V1::FileParser::getVoxelDataOffset(const AccessorTypes::TypedMemoryBlockDefinition& layer_block) const
+{
+	return this->serializer->getLayerCodecHeaderSize() + sizeof(FiledTypes::V1::VoxelGridLayerHeader) + layer_block.get_voxel_header_data_size();
+}
+
+bool RadFiled3D::Storage::V1::FileParser::isLayerEncoded(const AccessorTypes::TypedMemoryBlockDefinition& layer_block) const
+{
+	if (this->serializer->getLayerCodecHeaderSize() == 0)
+		return false;
+
+	// encoded layers are only kept if they are smaller and bricked layers never end up with the size of the raw layer, see V2::BinayFieldBlockHandler::prepareLayer
+	const size_t voxel_bytes = layer_block.elements_per_voxel * Typing::Helper::get_bytes_of_dtype(layer_block.dtype);
+	return layer_block.size != this->getVoxelDataOffset(layer_block) + this->voxel_count * voxel_bytes;
+}
+
+std::vector<IVoxel*> RadFiled3D::Storage::V1::FileParser::createVoxelsFromLayer(const VoxelLayer& layer, const AccessorTypes::TypedMemoryBlockDefinition& layer_block, const std::vector<size_t>& voxel_indices) const
+{
+	const size_t voxel_bytes = layer_block.elements_per_voxel * Typing::Helper::get_bytes_of_dtype(layer_block.dtype);
+	const char* voxel_header_data = (layer_block.get_voxel_header_data_size() > 0) ? layer_block.get_voxel_header_data() : nullptr;
+
+	// validate all indices first, so that no voxel was created when throwing
+	for (size_t voxel_idx : voxel_indices) {
+		if (voxel_idx >= layer.get_voxel_count())
+			throw RadiationFieldStoreException("Voxel index out of bounds");
+	}
+
+	std::vector<IVoxel*> voxels;
+	voxels.reserve(voxel_indices.size());
+	for (size_t voxel_idx : voxel_indices)
+		voxels.push_back(this->createVoxelFromBuffer((char*)layer.get_raw_data() + voxel_idx * voxel_bytes, layer_block.dtype, voxel_header_data));
+
+	return voxels;
+}
+
+size_t RadFiled3D::Storage::V1::FileParser::copyVoxelsFromLayer(const VoxelLayer& layer, const AccessorTypes::TypedMemoryBlockDefinition& layer_block, const std::vector<size_t>& voxel_indices, char* destination) const
+{
+	const size_t voxel_bytes = layer_block.elements_per_voxel * Typing::Helper::get_bytes_of_dtype(layer_block.dtype);
+	const char* layer_data = (const char*)layer.get_raw_data();
+
+	for (size_t voxel_idx : voxel_indices) {
+		if (voxel_idx >= layer.get_voxel_count())
+			throw RadiationFieldStoreException("Voxel index out of bounds");
+	}
+	for (size_t i = 0; i < voxel_indices.size(); i++)
+		memcpy(destination + i * voxel_bytes, layer_data + voxel_indices[i] * voxel_bytes, voxel_bytes);
+
+	return voxel_indices.size() * voxel_bytes;
+}
+
+std::vector<IVoxel*> RadFiled3D::Storage::V1::FileParser::createVoxelsFromData(char* data, const AccessorTypes::TypedMemoryBlockDefinition& layer_block, size_t voxel_count) const
+{
+	const size_t voxel_bytes = layer_block.elements_per_voxel * Typing::Helper::get_bytes_of_dtype(layer_block.dtype);
+	const char* voxel_header_data = (layer_block.get_voxel_header_data_size() > 0) ? layer_block.get_voxel_header_data() : nullptr;
+
+	std::vector<IVoxel*> voxels;
+	voxels.reserve(voxel_count);
+	// creating a voxel only fails for data types, which are not supported on this platform, so it throws at the first voxel before any voxel was created
+	for (size_t i = 0; i < voxel_count; i++)
+		voxels.push_back(this->createVoxelFromBuffer(data + i * voxel_bytes, layer_block.dtype, voxel_header_data));
+
+	return voxels;
+}
+
+const RadFiled3D::Storage::AccessorTypes::TypedMemoryBlockDefinition& RadFiled3D::Storage::V1::FileParser::getLayerDefinition(const std::string& channel_name, const std::string& layer_name) const
 {
 	auto channel_block_itr = this->channels_layers_offsets.find(channel_name);
 	if (channel_block_itr == this->channels_layers_offsets.end())
@@ -312,28 +734,35 @@ IVoxel* RadFiled3D::Storage::V1::FileParser::accessVoxelRawFlat(std::istream& bu
 	if (layer_block_itr == channel_block_itr->second.layers.end())
 		throw RadiationFieldStoreException("Layer not found");
 
-	auto& channel_block = channel_block_itr->second.channel_block;
-	auto& layer_block = layer_block_itr->second;
+	return layer_block_itr->second;
+}
 
-	const size_t element_size = Typing::Helper::get_bytes_of_dtype(layer_block.dtype);
+std::vector<std::string> RadFiled3D::Storage::V1::FileParser::getChannelNames() const
+{
+	std::vector<std::string> channel_names;
+	channel_names.reserve(this->channels_layers_offsets.size());
+	for (auto& channel : this->channels_layers_offsets)
+		channel_names.push_back(channel.first);
 
-	if (voxel_idx >= this->voxel_count)
-		throw RadiationFieldStoreException("Voxel index out of bounds");
+	return channel_names;
+}
 
-	// Add layer_block.get_voxel_header_data_size() to read position as the creation of the voxel does not revist the header data
-	buffer.seekg(this->getFieldDataOffset() + channel_block.offset + layer_block.offset + layer_block.get_voxel_header_data_size() + sizeof(FiledTypes::V1::VoxelGridLayerHeader) + sizeof(FiledTypes::V1::ChannelHeader) + voxel_idx * layer_block.elements_per_voxel * element_size, std::ios::beg);
-	char* data_buffer = new char[layer_block.elements_per_voxel * element_size];
-	buffer.read(data_buffer, layer_block.elements_per_voxel * element_size);
+std::vector<std::string> RadFiled3D::Storage::V1::FileParser::getLayerNames(const std::string& channel_name) const
+{
+	auto channel_block_itr = this->channels_layers_offsets.find(channel_name);
+	if (channel_block_itr == this->channels_layers_offsets.end())
+		throw RadiationFieldStoreException("Channel not found");
 
-	IVoxel* voxel = this->createVoxelFromBuffer(data_buffer, layer_block.dtype, (layer_block.get_voxel_header_data_size() > 0) ? layer_block.get_voxel_header_data() : nullptr);
-	delete[] data_buffer;
-	return voxel;
+	std::vector<std::string> layer_names;
+	layer_names.reserve(channel_block_itr->second.layers.size());
+	for (auto& layer : channel_block_itr->second.layers)
+		layer_names.push_back(layer.first);
+
+	return layer_names;
 }
 
-std::vector<IVoxel*> RadFiled3D::Storage::V1::FileParser::accessVoxelsRawFlat(std::istream& buffer, const std::string& channel_name, const std::string& layer_name, const std::vector<size_t>& voxel_indices) const
+size_t RadFiled3D::Storage::V1::FileParser::getLayerPosition(const std::string& channel_name, const std::string& layer_name) const
 {
-	auto voxels = std::vector<IVoxel*>(voxel_indices.size());
-
 	auto channel_block_itr = this->channels_layers_offsets.find(channel_name);
 	if (channel_block_itr == this->channels_layers_offsets.end())
 		throw RadiationFieldStoreException("Channel not found");
@@ -342,25 +771,70 @@ std::vector<IVoxel*> RadFiled3D::Storage::V1::FileParser::accessVoxelsRawFlat(st
 	if (layer_block_itr == channel_block_itr->second.layers.end())
 		throw RadiationFieldStoreException("Layer not found");
 
-	auto& channel_block = channel_block_itr->second.channel_block;
-	auto& layer_block = layer_block_itr->second;
+	return this->getFieldDataOffset() + channel_block_itr->second.channel_block.offset + layer_block_itr->second.offset + sizeof(FiledTypes::V1::ChannelHeader);
+}
+
+IVoxel* RadFiled3D::Storage::V1::FileParser::accessVoxelRawFlat(const std::shared_ptr<MappedFile>& file, const std::string& channel_name, const std::string& layer_name, size_t voxel_idx) const
+{
+	size_t layer_position = 0;
+	const FileLayout layout = this->resolveLayout(file);
+	const auto& layer_block = this->findLayer(layout, channel_name, layer_name, layer_position);
 
 	const size_t element_size = Typing::Helper::get_bytes_of_dtype(layer_block.dtype);
+	const size_t voxel_bytes = layer_block.elements_per_voxel * element_size;
+
+	if (voxel_idx >= this->voxel_count)
+		throw RadiationFieldStoreException("Voxel index out of bounds");
+
+	char* layer_data = this->getMappedBlock(file, layer_position, layer_block.size);
+	if (!this->serializer->isLayerRaw(layer_data)) {
+		std::unique_ptr<VoxelLayer> layer(this->serializer->deserializeLayer(layer_data, layer_block.size));
+		return this->createVoxelsFromLayer(*layer, layer_block, { voxel_idx })[0];
+	}
+
+	char* data_buffer = layer_data + this->getVoxelDataOffset(layer_block) + voxel_idx * voxel_bytes;
+	return this->createVoxelFromBuffer(data_buffer, layer_block.dtype, (layer_block.get_voxel_header_data_size() > 0) ? layer_block.get_voxel_header_data() : nullptr);
+}
+
+std::vector<IVoxel*> RadFiled3D::Storage::V1::FileParser::accessVoxelsRawFlat(const std::shared_ptr<MappedFile>& file, const std::string& channel_name, const std::string& layer_name, const std::vector<size_t>& voxel_indices) const
+{
+	const auto& layer_block = this->getLayerDefinition(channel_name, layer_name);
+	const size_t voxel_bytes = layer_block.elements_per_voxel * Typing::Helper::get_bytes_of_dtype(layer_block.dtype);
+
+	std::vector<char> data_buffer(voxel_indices.size() * voxel_bytes);
+	this->accessVoxelsDataFlat(file, channel_name, layer_name, voxel_indices, data_buffer.data(), data_buffer.size());
+	return this->createVoxelsFromData(data_buffer.data(), layer_block, voxel_indices.size());
+}
+
+size_t RadFiled3D::Storage::V1::FileParser::accessVoxelsDataFlat(const std::shared_ptr<MappedFile>& file, const std::string& channel_name, const std::string& layer_name, const std::vector<size_t>& voxel_indices, char* destination, size_t destination_size) const
+{
+	size_t layer_position = 0;
+	const FileLayout layout = this->resolveLayout(file);
+	const auto& layer_block = this->findLayer(layout, channel_name, layer_name, layer_position);
+
+	const size_t element_size = Typing::Helper::get_bytes_of_dtype(layer_block.dtype);
+	const size_t voxel_bytes = layer_block.elements_per_voxel * element_size;
+	if (destination_size < voxel_indices.size() * voxel_bytes)
+		throw RadiationFieldStoreException("Destination buffer is too small");
+
+	// Resolve the whole layer block once, all voxels are then copied from it directly
+	char* layer_block_data = this->getMappedBlock(file, layer_position, layer_block.size);
+	if (!this->serializer->isLayerRaw(layer_block_data)) {
+		std::unique_ptr<VoxelLayer> layer(this->serializer->deserializeLayer(layer_block_data, layer_block.size));
+		return this->copyVoxelsFromLayer(*layer, layer_block, voxel_indices, destination);
+	}
+	if (this->getVoxelDataOffset(layer_block) + this->voxel_count * voxel_bytes > layer_block.size)
+		throw RadiationFieldStoreException("Memory block exceeds the layer");
+	const char* layer_data = layer_block_data + this->getVoxelDataOffset(layer_block);
 
-	size_t vx_parsed = 0;
 	for (size_t voxel_idx : voxel_indices) {
 		if (voxel_idx >= this->voxel_count)
 			throw RadiationFieldStoreException("Voxel index out of bounds");
-
-		// Add layer_block.get_voxel_header_data_size() to read position as the creation of the voxel does not revist the header data
-		buffer.seekg(this->getFieldDataOffset() + channel_block.offset + layer_block.offset + layer_block.get_voxel_header_data_size() + sizeof(FiledTypes::V1::VoxelGridLayerHeader) + sizeof(FiledTypes::V1::ChannelHeader) + voxel_idx * layer_block.elements_per_voxel * element_size, std::ios::beg);
-		char* data_buffer = new char[layer_block.elements_per_voxel * element_size];
-		buffer.read(data_buffer, layer_block.elements_per_voxel * element_size);
-		voxels[vx_parsed++] = this->createVoxelFromBuffer(data_buffer, layer_block.dtype, (layer_block.get_voxel_header_data_size() > 0) ? layer_block.get_voxel_header_data() : nullptr);
-		delete[] data_buffer;
 	}
+	for (size_t i = 0; i < voxel_indices.size(); i++)
+		memcpy(destination + i * voxel_bytes, layer_data + voxel_indices[i] * voxel_bytes, voxel_bytes);
 
-	return voxels;
+	return voxel_indices.size() * voxel_bytes;
 }
 
 size_t RadFiled3D::Storage::V1::CartesianFieldAccessor::getFieldDataOffset() const
@@ -430,15 +904,16 @@ std::shared_ptr<VoxelGridBuffer> RadFiled3D::Storage::V1::CartesianFieldAccessor
 	std::ofstream out("access_channel_accessor.log", std::ios::app);
 	out << "From CartesianFieldAccessorV1" << std::endl;
 	out << "Accessing channel '" << channel_name << "'" << std::endl;
-	auto channel_block_itr = this->channels_layers_offsets.find(channel_name);
-	if (channel_block_itr == this->channels_layers_offsets.end()) {
+	const FileLayout layout = this->resolveLayout(buffer);
+	auto channel_block_itr = layout.channels_layers_offsets->find(channel_name);
+	if (channel_block_itr == layout.channels_layers_offsets->end()) {
 		out << "Channel not found" << std::endl;
 		throw RadiationFieldStoreException("Channel not found");
 	}
 
 	auto& channel_block = channel_block_itr->second.channel_block;
 
-	buffer.seekg(this->getFieldDataOffset() + channel_block.offset + sizeof(FiledTypes::V1::ChannelHeader), std::ios::beg);
+	buffer.seekg(layout.field_data_offset + channel_block.offset + sizeof(FiledTypes::V1::ChannelHeader), std::ios::beg);
 
 	auto grid_buffer = std::make_shared<VoxelGridBuffer>(this->field_dimensions, this->voxel_dimensions);
 	char* data_buffer = new char[channel_block.size];
@@ -453,24 +928,24 @@ std::shared_ptr<VoxelGridBuffer> RadFiled3D::Storage::V1::CartesianFieldAccessor
 
 std::shared_ptr<VoxelGrid> RadFiled3D::Storage::V1::CartesianFieldAccessor::accessLayer(std::istream& buffer, const std::string& channel_name, const std::string& layer_name) const
 {
-	auto channel_block_itr = this->channels_layers_offsets.find(channel_name);
-	if (channel_block_itr == this->channels_layers_offsets.end())
-		throw RadiationFieldStoreException("Channel not found");
-
-	auto layer_block_itr = channel_block_itr->second.layers.find(layer_name);
-	if (layer_block_itr == channel_block_itr->second.layers.end())
-		throw RadiationFieldStoreException("Layer not found");
-
-	auto& channel_block = channel_block_itr->second.channel_block;
-	auto& layer_block = layer_block_itr->second;
+	VoxelLayer* layer = this->readLayer(FileParser::StreamReader(buffer), this->resolveLayout(buffer), channel_name, layer_name);
+	return std::make_shared<VoxelGrid>(this->field_dimensions, this->voxel_dimensions, std::shared_ptr<VoxelLayer>(layer));
+}
 
-	buffer.seekg(this->getFieldDataOffset() + channel_block.offset + layer_block.offset + sizeof(FiledTypes::V1::ChannelHeader), std::ios::beg);
+std::shared_ptr<VoxelGrid> RadFiled3D::Storage::V1::CartesianFieldAccessor::accessLayer(const std::shared_ptr<PositionalFile>& file, const std::string& channel_name, const std::string& layer_name) const
+{
+	const BlockReader read = FileParser::FileReader(file);
+	VoxelLayer* layer = this->readLayer(read, this->resolveLayout(file), channel_name, layer_name);
+	return std::make_shared<VoxelGrid>(this->field_dimensions, this->voxel_dimensions, std::shared_ptr<VoxelLayer>(layer));
+}
 
-	char* data_buffer = new char[layer_block.size];
-	buffer.read(data_buffer, layer_block.size);
-	VoxelLayer* layer = this->serializer->deserializeLayer(data_buffer, layer_block.size);
-	delete[] data_buffer;
+std::shared_ptr<VoxelGrid> RadFiled3D::Storage::V1::CartesianFieldAccessor::accessLayer(const std::shared_ptr<ByteSource>& source, const std::string& channel_name, const std::string& layer_name) const
+{
+	if (auto mapped = std::dynamic_pointer_cast<MappedByteSource>(source))
+		return this->accessLayer(mapped->get_file(), channel_name, layer_name);
 
+	const BlockReader read = FileParser::SourceReader(source);
+	VoxelLayer* layer = this->readLayer(read, this->resolveLayout(source), channel_name, layer_name);
 	return std::make_shared<VoxelGrid>(this->field_dimensions, this->voxel_dimensions, std::shared_ptr<VoxelLayer>(layer));
 }
 
@@ -478,13 +953,14 @@ std::map<std::string, std::shared_ptr<VoxelGrid>> RadFiled3D::Storage::V1::Carte
 {
 	std::map<std::string, std::shared_ptr<VoxelGrid>> layers = std::map<std::string, std::shared_ptr<VoxelGrid>>();
 
-	for (auto& channel : this->channels_layers_offsets) {
+	const FileLayout layout = this->resolveLayout(buffer);
+	for (auto& channel : *layout.channels_layers_offsets) {
 		auto layer_block_itr = channel.second.layers.find(layer_name);
 		if (layer_block_itr == channel.second.layers.end())
 			continue;
 		auto& channel_block = channel.second.channel_block;
 		auto& layer_block = layer_block_itr->second;
-		buffer.seekg(this->getFieldDataOffset() + channel_block.offset + layer_block.offset + sizeof(FiledTypes::V1::ChannelHeader), std::ios::beg);
+		buffer.seekg(layout.field_data_offset + channel_block.offset + layer_block.offset + sizeof(FiledTypes::V1::ChannelHeader), std::ios::beg);
 		char* data_buffer = new char[layer_block.size];
 		buffer.read(data_buffer, layer_block.size);
 		VoxelLayer* layer = this->serializer->deserializeLayer(data_buffer, layer_block.size);
@@ -495,6 +971,109 @@ std::map<std::string, std::shared_ptr<VoxelGrid>> RadFiled3D::Storage::V1::Carte
 	return layers;
 }
 
+std::shared_ptr<IRadiationField> RadFiled3D::Storage::V1::CartesianFieldAccessor::accessField(const std::shared_ptr<MappedFile>& file) const
+{
+	auto field = std::make_shared<CartesianRadiationField>(this->field_dimensions, this->voxel_dimensions);
+
+	const FileLayout layout = this->resolveLayout(file);
+	for (auto& channel : *layout.channels_layers_offsets) {
+		auto& channel_block = channel.second.channel_block;
+		char* channel_data = this->getMappedBlock(file, layout.field_data_offset + channel_block.offset + sizeof(FiledTypes::V1::ChannelHeader), channel_block.size);
+		this->serializer->deserializeChannelView(field->add_channel(channel.first), channel_data, channel_block.size, file);
+	}
+
+	return field;
+}
+
+std::shared_ptr<VoxelGridBuffer> RadFiled3D::Storage::V1::CartesianFieldAccessor::accessChannel(const std::shared_ptr<MappedFile>& file, const std::string& channel_name) const
+{
+	const FileLayout layout = this->resolveLayout(file);
+	auto& channel_block = this->findChannel(layout, channel_name).channel_block;
+	char* channel_data = this->getMappedBlock(file, layout.field_data_offset + channel_block.offset + sizeof(FiledTypes::V1::ChannelHeader), channel_block.size);
+
+	auto grid_buffer = std::make_shared<VoxelGridBuffer>(this->field_dimensions, this->voxel_dimensions);
+	this->serializer->deserializeChannelView(grid_buffer, channel_data, channel_block.size, file);
+
+	return grid_buffer;
+}
+
+std::shared_ptr<VoxelGrid> RadFiled3D::Storage::V1::CartesianFieldAccessor::accessLayer(const std::shared_ptr<MappedFile>& file, const std::string& channel_name, const std::string& layer_name) const
+{
+	size_t layer_position = 0;
+	const FileLayout layout = this->resolveLayout(file);
+	const auto& layer_block = this->findLayer(layout, channel_name, layer_name, layer_position);
+
+	char* layer_data = this->getMappedBlock(file, layer_position, layer_block.size);
+	VoxelLayer* layer = this->serializer->deserializeLayerView(layer_data, layer_block.size, file);
+
+	return std::make_shared<VoxelGrid>(this->field_dimensions, this->voxel_dimensions, std::shared_ptr<VoxelLayer>(layer));
+}
+
+std::map<std::string, std::shared_ptr<VoxelGrid>> RadFiled3D::Storage::V1::CartesianFieldAccessor::accessLayerAcrossChannels(const std::shared_ptr<MappedFile>& file, const std::string& layer_name) const
+{
+	std::map<std::string, std::shared_ptr<VoxelGrid>> layers = std::map<std::string, std::shared_ptr<VoxelGrid>>();
+
+	const FileLayout layout = this->resolveLayout(file);
+	for (auto& channel : *layout.channels_layers_offsets) {
+		auto layer_block_itr = channel.second.layers.find(layer_name);
+		if (layer_block_itr == channel.second.layers.end())
+			continue;
+		auto& channel_block = channel.second.channel_block;
+		auto& layer_block = layer_block_itr->second;
+		char* layer_data = this->getMappedBlock(file, layout.field_data_offset + channel_block.offset + layer_block.offset + sizeof(FiledTypes::V1::ChannelHeader), layer_block.size);
+		VoxelLayer* layer = this->serializer->deserializeLayerView(layer_data, layer_block.size, file);
+		layers.insert(std::make_pair(channel.first, std::make_shared<VoxelGrid>(this->field_dimensions, this->voxel_dimensions, std::shared_ptr<VoxelLayer>(layer))));
+	}
+
+	return layers;
+}
+
+std::shared_ptr<VoxelGrid> RadFiled3D::Storage::V1::CartesianFieldAccessor::accessSubvolume(std::istream& buffer, const std::string& channel_name, const std::string& layer_name, const glm::uvec3& min_idx, const glm::uvec3& max_idx) const
+{
+	return this->readSubvolume(FileParser::StreamReader(buffer), this->resolveLayout(buffer), channel_name, layer_name, min_idx, max_idx);
+}
+
+std::shared_ptr<VoxelGrid> RadFiled3D::Storage::V1::CartesianFieldAccessor::accessSubvolume(const std::shared_ptr<PositionalFile>& file, const std::string& channel_name, const std::string& layer_name, const glm::uvec3& min_idx, const glm::uvec3& max_idx) const
+{
+	const BlockReader read = FileParser::FileReader(file);
+	return this->readSubvolume(read, this->resolveLayout(file), channel_name, layer_name, min_idx, max_idx);
+}
+
+std::shared_ptr<VoxelGrid> RadFiled3D::Storage::V1::CartesianFieldAccessor::accessSubvolume(const std::shared_ptr<ByteSource>& source, const std::string& channel_name, const std::string& layer_name, const glm::uvec3& min_idx, const glm::uvec3& max_idx) const
+{
+	const BlockReader read = FileParser::SourceReader(source);
+	return this->readSubvolume(read, this->resolveLayout(source), channel_name, layer_name, min_idx, max_idx);
+}
+
+std::shared_ptr<VoxelGrid> RadFiled3D::Storage::V1::CartesianFieldAccessor::readSubvolume(const BlockReader& read, const FileLayout& layout, const std::string& channel_name, const std::string& layer_name, const glm::uvec3& min_idx, const glm::uvec3& max_idx) const
+{
+	size_t layer_position = 0;
+	const auto& layer_block = this->findLayer(layout, channel_name, layer_name, layer_position);
+	VoxelLayer* layer = this->serializer->deserializeLayerRegion([&read, &layer_block, layer_position](size_t offset, size_t size, char* destination) {
+		if (offset + size > layer_block.size)
+			throw RadiationFieldStoreException("Memory block exceeds the layer");
+		read(layer_position + offset, size, destination);
+	}, layer_block.size, this->default_grid->get_voxel_counts(), min_idx, max_idx);
+
+	return std::make_shared<VoxelGrid>(max_idx - min_idx, this->voxel_dimensions, std::shared_ptr<VoxelLayer>(layer));
+}
+
+std::shared_ptr<VoxelGrid> RadFiled3D::Storage::V1::CartesianFieldAccessor::accessSubvolume(const std::shared_ptr<MappedFile>& file, const std::string& channel_name, const std::string& layer_name, const glm::uvec3& min_idx, const glm::uvec3& max_idx) const
+{
+	size_t layer_position = 0;
+	const FileLayout layout = this->resolveLayout(file);
+	const auto& layer_block = this->findLayer(layout, channel_name, layer_name, layer_position);
+
+	const char* layer_data = this->getMappedBlock(file, layer_position, layer_block.size);
+	VoxelLayer* layer = this->serializer->deserializeLayerRegion([layer_data, &layer_block](size_t offset, size_t size, char* destination) {
+		if (offset + size > layer_block.size)
+			throw RadiationFieldStoreException("Memory block exceeds the layer");
+		memcpy(destination, layer_data + offset, size);
+	}, layer_block.size, this->default_grid->get_voxel_counts(), min_idx, max_idx);
+
+	return std::make_shared<VoxelGrid>(max_idx - min_idx, this->voxel_dimensions, std::shared_ptr<VoxelLayer>(layer));
+}
+
 IVoxel* RadFiled3D::Storage::V1::CartesianFieldAccessor::accessVoxelRaw(std::istream& buffer, const std::string& channel_name, const std::string& layer_name, const glm::uvec3& voxel_idx) const
 {
 	const size_t idx = this->default_grid->get_voxel_idx(voxel_idx.x, voxel_idx.y, voxel_idx.z);
@@ -569,25 +1148,243 @@ std::shared_ptr<IRadiationField> RadFiled3D::Storage::V1::PolarFieldAccessor::ac
 
 std::shared_ptr<PolarSegments> RadFiled3D::Storage::V1::PolarFieldAccessor::accessLayer(std::istream& buffer, const std::string& channel_name, const std::string& layer_name) const
 {
-	auto channel_block_itr = this->channels_layers_offsets.find(channel_name);
-	if (channel_block_itr == this->channels_layers_offsets.end())
-		throw RadiationFieldStoreException("Channel not found");
+	VoxelLayer* layer = this->readLayer(FileParser::StreamReader(buffer), this->resolveLayout(buffer), channel_name, layer_name);
+	return std::make_shared<PolarSegments>(this->segments_counts, std::shared_ptr<VoxelLayer>(layer));
+}
 
-	auto layer_block_itr = channel_block_itr->second.layers.find(layer_name);
-	if (layer_block_itr == channel_block_itr->second.layers.end())
-		throw RadiationFieldStoreException("Layer not found");
+std::shared_ptr<PolarSegments> RadFiled3D::Storage::V1::PolarFieldAccessor::accessLayer(const std::shared_ptr<PositionalFile>& file, const std::string& channel_name, const std::string& layer_name) const
+{
+	const BlockReader read = FileParser::FileReader(file);
+	VoxelLayer* layer = this->readLayer(read, this->resolveLayout(file), channel_name, layer_name);
+	return std::make_shared<PolarSegments>(this->segments_counts, std::shared_ptr<VoxelLayer>(layer));
+}
 
-	auto& channel_block = channel_block_itr->second.channel_block;
-	auto& layer_block = layer_block_itr->second;
+std::shared_ptr<PolarSegments> RadFiled3D::Storage::V1::PolarFieldAccessor::accessLayer(const std::shared_ptr<ByteSource>& source, const std::string& channel_name, const std::string& layer_name) const
+{
+	if (auto mapped = std::dynamic_pointer_cast<MappedByteSource>(source))
+		return this->accessLayer(mapped->get_file(), channel_name, layer_name);
 
-	buffer.seekg(this->getFieldDataOffset() + channel_block.offset + layer_block.offset + sizeof(FiledTypes::V1::ChannelHeader), std::ios::beg);
+	const BlockReader read = FileParser::SourceReader(source);
+	VoxelLayer* layer = this->readLayer(read, this->resolveLayout(source), channel_name, layer_name);
+	return std::make_shared<PolarSegments>(this->segments_counts, std::shared_ptr<VoxelLayer>(layer));
+}
 
-	char* data_buffer = new char[layer_block.size];
-	buffer.read(data_buffer, layer_block.size);
-	PolarSegments* layer = (PolarSegments*)this->serializer->deserializeLayer(data_buffer, layer_block.size);
-	delete[] data_buffer;
+std::shared_ptr<IRadiationField> RadFiled3D::Storage::V1::PolarFieldAccessor::accessField(const std::shared_ptr<MappedFile>& file) const
+{
+	auto field = std::make_shared<PolarRadiationField>(this->segments_counts);
 
-	return std::shared_ptr<PolarSegments>(layer);
+	const FileLayout layout = this->resolveLayout(file);
+	for (auto& channel : *layout.channels_layers_offsets) {
+		auto& channel_block = channel.second.channel_block;
+		char* channel_data = this->getMappedBlock(file, layout.field_data_offset + channel_block.offset + sizeof(FiledTypes::V1::ChannelHeader), channel_block.size);
+		this->serializer->deserializeChannelView(field->add_channel(channel.first), channel_data, channel_block.size, file);
+	}
+
+	return field;
+}
+
+std::shared_ptr<PolarSegments> RadFiled3D::Storage::V1::PolarFieldAccessor::accessLayer(const std::shared_ptr<MappedFile>& file, const std::string& channel_name, const std::string& layer_name) const
+{
+	size_t layer_position = 0;
+	const FileLayout layout = this->resolveLayout(file);
+	const auto& layer_block = this->findLayer(layout, channel_name, layer_name, layer_position);
+
+	char* layer_data = this->getMappedBlock(file, layer_position, layer_block.size);
+	VoxelLayer* layer = this->serializer->deserializeLayerView(layer_data, layer_block.size, file);
+
+	return std::make_shared<PolarSegments>(this->segments_counts, std::shared_ptr<VoxelLayer>(layer));
+}
+
+size_t RadFiled3D::Storage::V2::FieldIndex::getFieldDataOffset() const
+{
+	const size_t shape_header_size = (this->field_type == FieldType::Cartesian) ? sizeof(FiledTypes::V1::CartesianHeader) : sizeof(FiledTypes::V1::PolarHeader);
+	return this->metadata_fileheader_size + sizeof(FiledTypes::V1::RadiationFieldHeader) + shape_header_size;
+}
+
+size_t RadFiled3D::Storage::V2::FieldIndex::getVoxelCount() const
+{
+	if (this->field_type == FieldType::Cartesian)
+		return static_cast<size_t>(this->cartesian_header.voxel_counts.x) * this->cartesian_header.voxel_counts.y * this->cartesian_header.voxel_counts.z;
+	return static_cast<size_t>(this->polar_header.segments_counts.x) * this->polar_header.segments_counts.y;
+}
+
+FiledTypes::V2::FieldIndexTrailer RadFiled3D::Storage::V2::FieldIndex::ReadTrailer(std::istream& buffer)
+{
+	buffer.clear();
+	buffer.seekg(0, std::ios::end);
+	const size_t file_size = buffer.tellg();
+	return FieldIndex::ReadTrailer(V1::FileParser::StreamReader(buffer), file_size);
+}
+
+FiledTypes::V2::FieldIndexTrailer RadFiled3D::Storage::V2::FieldIndex::ReadTrailer(const std::function<void(size_t position, size_t size, char* destination)>& read, size_t buffer_size)
+{
+	if (buffer_size < sizeof(VersionHeader) + sizeof(FiledTypes::V2::FieldIndexHeader) + sizeof(FiledTypes::V2::FieldIndexTrailer))
+		throw RadiationFieldStoreException("Buffer is too small to contain a field index");
+
+	FiledTypes::V2::FieldIndexTrailer trailer;
+	const FiledTypes::V2::FieldIndexTrailer expected_trailer;
+	read(buffer_size - sizeof(FiledTypes::V2::FieldIndexTrailer), sizeof(FiledTypes::V2::FieldIndexTrailer), (char*)&trailer);
+
+	if (memcmp(trailer.magic, expected_trailer.magic, sizeof(trailer.magic)) != 0)
+		throw RadiationFieldStoreException("Field index trailer is missing or corrupted");
+	if (trailer.index_offset + sizeof(FiledTypes::V2::FieldIndexHeader) + trailer.index_bytes + sizeof(FiledTypes::V2::FieldIndexTrailer) != buffer_size)
+		throw RadiationFieldStoreException("Field index trailer does not match the buffer size");
+
+	return trailer;
+}
+
+RadFiled3D::Storage::V2::FieldIndex RadFiled3D::Storage::V2::FieldIndex::Read(std::istream& buffer)
+{
+	buffer.clear();
+	buffer.seekg(0, std::ios::end);
+	const size_t file_size = buffer.tellg();
+	return FieldIndex::Read(V1::FileParser::StreamReader(buffer), file_size);
+}
+
+RadFiled3D::Storage::V2::FieldIndex RadFiled3D::Storage::V2::FieldIndex::Read(const std::function<void(size_t position, size_t size, char* destination)>& read, size_t buffer_size)
+{
+	// indices are small, so that the end of the buffer usually holds the index and the trailer and both are taken from a single read
+	std::vector<char> tail(std::min<size_t>(buffer_size, 4096));
+	const size_t tail_position = buffer_size - tail.size();
+	read(tail_position, tail.size(), tail.data());
+	auto read_tail = [&read, &tail, tail_position](size_t position, size_t size, char* destination) {
+		if (position >= tail_position && position + size <= tail_position + tail.size())
+			memcpy(destination, tail.data() + (position - tail_position), size);
+		else
+			read(position, size, destination);
+	};
+
+	FiledTypes::V2::FieldIndexTrailer trailer = FieldIndex::ReadTrailer(read_tail, buffer_size);
+
+	// the header and the channel and layer blocks follow each other, so that they are read at once
+	std::vector<char> index_data(sizeof(FiledTypes::V2::FieldIndexHeader) + trailer.index_bytes);
+	read_tail(trailer.index_offset, index_data.size(), index_data.data());
+
+	FiledTypes::V2::FieldIndexHeader header;
+	memcpy((char*)&header, index_data.data(), sizeof(FiledTypes::V2::FieldIndexHeader));
+	if (header.channels_layers_bytes != trailer.index_bytes)
+		throw RadiationFieldStoreException("Field index header does not match its trailer");
+
+	FieldIndex index;
+	index.metadata_fileheader_size = header.metadata_fileheader_size;
+	index.field_type = static_cast<FieldType>(header.field_type);
+	index.cartesian_header = header.cartesian_header;
+	index.polar_header = header.polar_header;
+
+	std::vector<char> channels_layers_data(index_data.begin() + sizeof(FiledTypes::V2::FieldIndexHeader), index_data.end());
+	index.channels_layers_offsets = V1::FileParser::DeserializeChannelsLayersOffsets(channels_layers_data);
+
+	if (index.getVoxelCount() == 0)
+		throw RadiationFieldStoreException("Invalid voxel count");
+
+	return index;
+}
+
+void RadFiled3D::Storage::V2::FieldIndex::write(std::ostream& buffer) const
+{
+	std::vector<char> channels_layers_data = V1::FileParser::SerializeChannelsLayersOffsets(this->channels_layers_offsets);
+
+	FiledTypes::V2::FieldIndexHeader header;
+	header.metadata_fileheader_size = this->metadata_fileheader_size;
+	header.field_type = static_cast<uint32_t>(this->field_type);
+	header.cartesian_header = this->cartesian_header;
+	header.polar_header = this->polar_header;
+	header.channels_layers_bytes = channels_layers_data.size();
+
+	FiledTypes::V2::FieldIndexTrailer trailer;
+	trailer.index_offset = buffer.tellp();
+	trailer.index_bytes = channels_layers_data.size();
+
+	buffer.write((const char*)&header, sizeof(FiledTypes::V2::FieldIndexHeader));
+	buffer.write(channels_layers_data.data(), channels_layers_data.size());
+	buffer.write((const char*)&trailer, sizeof(FiledTypes::V2::FieldIndexTrailer));
+}
+
+RadFiled3D::Storage::V2::CartesianFieldAccessor::CartesianFieldAccessor()
+	: RadFiled3D::Storage::FieldAccessor(FieldType::Cartesian),
+	  RadFiled3D::Storage::V1::CartesianFieldAccessor()
+{
+	this->store_version = StoreVersion::V2;
+}
+
+RadFiled3D::Storage::V2::CartesianFieldAccessor::CartesianFieldAccessor(const SerializationData& data)
+	: RadFiled3D::Storage::FieldAccessor(FieldType::Cartesian),
+	  RadFiled3D::Storage::V1::CartesianFieldAccessor()
+{
+	if (data.store_version != StoreVersion::V2)
+		throw RadiationFieldStoreException("Invalid store version");
+
+	this->metadata_fileheader_size = data.metadata_fileheader_size;
+	this->voxel_count = data.voxel_count;
+
+	this->field_dimensions = data.field_dimensions;
+	this->voxel_dimensions = data.voxel_dimensions;
+	this->store_version = StoreVersion::V2;
+	this->channels_layers_offsets = data.channels_layers_offsets;
+	this->default_grid = std::make_unique<VoxelGrid>(this->field_dimensions, this->voxel_dimensions);
+	this->serializer = std::make_unique<V2::BinayFieldBlockHandler>();
+}
+
+void RadFiled3D::Storage::V2::CartesianFieldAccessor::initialize(std::istream& buffer)
+{
+	this->initialize(FieldIndex::Read(buffer));
+}
+
+void RadFiled3D::Storage::V2::CartesianFieldAccessor::initialize(const FieldIndex& index)
+{
+	if (index.field_type != FieldType::Cartesian)
+		throw RadiationFieldStoreException("Field index does not describe a cartesian field");
+
+	const FiledTypes::V1::CartesianHeader& ch = index.cartesian_header;
+	this->metadata_fileheader_size = index.metadata_fileheader_size;
+	this->field_dimensions = glm::vec3(ch.voxel_counts) * ch.voxel_dimensions;
+	this->voxel_dimensions = ch.voxel_dimensions;
+	this->voxel_count = index.getVoxelCount();
+	this->default_grid = std::make_unique<VoxelGrid>(this->field_dimensions, ch.voxel_dimensions);
+	this->channels_layers_offsets = index.channels_layers_offsets;
+	this->serializer = std::make_unique<V2::BinayFieldBlockHandler>();
+}
+
+RadFiled3D::Storage::V2::PolarFieldAccessor::PolarFieldAccessor()
+	: RadFiled3D::Storage::FieldAccessor(FieldType::Polar),
+	  RadFiled3D::Storage::V1::PolarFieldAccessor()
+{
+	this->store_version = StoreVersion::V2;
+}
+
+RadFiled3D::Storage::V2::PolarFieldAccessor::PolarFieldAccessor(const SerializationData& data)
+	: RadFiled3D::Storage::FieldAccessor(FieldType::Polar),
+	  RadFiled3D::Storage::V1::PolarFieldAccessor()
+{
+	if (data.store_version != StoreVersion::V2)
+		throw RadiationFieldStoreException("Invalid store version");
+
+	this->metadata_fileheader_size = data.metadata_fileheader_size;
+	this->voxel_count = data.voxel_count;
+
+	this->segments_counts = data.segments_counts;
+	this->store_version = StoreVersion::V2;
+	this->channels_layers_offsets = data.channels_layers_offsets;
+	this->default_segments = std::make_unique<PolarSegments>(this->segments_counts);
+	this->serializer = std::make_unique<V2::BinayFieldBlockHandler>();
+}
+
+void RadFiled3D::Storage::V2::PolarFieldAccessor::initialize(std::istream& buffer)
+{
+	this->initialize(FieldIndex::Read(buffer));
+}
+
+void RadFiled3D::Storage::V2::PolarFieldAccessor::initialize(const FieldIndex& index)
+{
+	if (index.field_type != FieldType::Polar)
+		throw RadiationFieldStoreException("Field index does not describe a polar field");
+
+	this->metadata_fileheader_size = index.metadata_fileheader_size;
+	this->segments_counts = index.polar_header.segments_counts;
+	this->voxel_count = index.getVoxelCount();
+	this->default_segments = std::make_unique<PolarSegments>(this->segments_counts);
+	this->channels_layers_offsets = index.channels_layers_offsets;
+	this->serializer = std::make_unique<V2::BinayFieldBlockHandler>();
 }
 
 std::shared_ptr<FieldAccessor> FieldAccessorBuilder::Construct(std::istream& buffer)
@@ -611,6 +1408,27 @@ std::shared_ptr<FieldAccessor> FieldAccessorBuilder::Construct(std::istream& buf
 			throw RadiationFieldStoreException("Unsupported field type");
 		}
 		break;
+	case StoreVersion::V2:
+	{
+		// The index describes the whole file, so the accessor can be initialized without parsing the field data.
+		Storage::V2::FieldIndex index = Storage::V2::FieldIndex::Read(buffer);
+		switch (index.field_type) {
+		case FieldType::Cartesian:
+		{
+			auto cartesian_accessor = std::shared_ptr<Storage::V2::CartesianFieldAccessor>(new Storage::V2::CartesianFieldAccessor());
+			cartesian_accessor->initialize(index);
+			return std::static_pointer_cast<FieldAccessor>(cartesian_accessor);
+		}
+		case FieldType::Polar:
+		{
+			auto polar_accessor = std::shared_ptr<Storage::V2::PolarFieldAccessor>(new Storage::V2::PolarFieldAccessor());
+			polar_accessor->initialize(index);
+			return std::static_pointer_cast<FieldAccessor>(polar_accessor);
+		}
+		default:
+			throw RadiationFieldStoreException("Unsupported field type");
+		}
+	}
 	default:
 		throw RadiationFieldStoreException("Unsupported file version");
 	}
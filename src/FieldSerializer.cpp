@@ -5,15 +5,184 @@
 #include <glm/vec3.hpp>
 #include <glm/vec4.hpp>
 #include <string.h>
+#include <cstdint>
 #include <RadFiled3D/helpers/Typing.hpp>
 #include <RadFiled3D/RadiationField.hpp>
+#include <RadFiled3D/storage/FieldAccessor.hpp>
+#include <limits>
+#include <RadFiled3D/storage/LayerCodecs.hpp>
 
 
 using namespace RadFiled3D;
 using namespace RadFiled3D::Storage;
 using namespace RadFiled3D::Storage::FiledTypes;
 
+namespace {
+	/** Describes a written layer block for the layer index of version 2 files
+	* @param voxel_buffer The voxel buffer, which holds the layer
+	* @param layer_name The name of the layer
+	* @param layer_pos The position of the layer block relative to the channel data
+	* @param layer_size The size of the layer block
+	* @return The definition of the layer block
+	*/
+	AccessorTypes::TypedMemoryBlockDefinition MakeLayerBlockDefinition(std::shared_ptr<VoxelBuffer> voxel_buffer, const std::string& layer_name, size_t layer_pos, size_t layer_size) {
+		const IVoxel& voxel = voxel_buffer->get_voxel_flat(layer_name, 0);
+		const Typing::DType dtype = Typing::Helper::get_dtype(voxel.get_type());
+		AccessorTypes::TypedMemoryBlockDefinition layer_block(layer_pos, layer_size, dtype, voxel.get_bytes() / Typing::Helper::get_bytes_of_dtype(dtype));
+		if (voxel.get_header().header_bytes > 0)
+			layer_block.set_voxel_header_data((char*)voxel.get_header().header, voxel.get_header().header_bytes);
+		return layer_block;
+	}
+
+	/** Writes channel blocks layer by layer and completes each channel header as soon as the size of the channel is known */
+	class ChannelBlockStreamWriter : public FieldBlockStreamWriter {
+	protected:
+		const Storage::BinayFieldBlockHandler& handler;
+		std::ostream& buffer;
+		FiledTypes::V1::ChannelHeader channel_header;
+		std::string channel_name;
+		std::streamoff channel_start = -1;
+
+		/** Writes the final channel header of the current channel, if any */
+		virtual void endChannel() {
+			if (this->channel_start < 0)
+				return;
+
+			const std::streamoff channel_end = this->buffer.tellp();
+			this->channel_header.channel_bytes = static_cast<size_t>(channel_end - this->channel_start) - sizeof(FiledTypes::V1::ChannelHeader);
+			this->buffer.seekp(this->channel_start, std::ios::beg);
+			this->buffer.write((const char*)&this->channel_header, sizeof(FiledTypes::V1::ChannelHeader));
+			this->buffer.seekp(channel_end, std::ios::beg);
+			this->channel_start = -1;
+		}
+
+	public:
+		ChannelBlockStreamWriter(const Storage::BinayFieldBlockHandler& handler, std::ostream& buffer) : handler(handler), buffer(buffer) {}
+
+		virtual void beginChannel(const std::string& channel_name) override {
+			this->endChannel();
+
+			this->channel_header = FiledTypes::V1::ChannelHeader();
+			this->channel_name = channel_name;
+			std::strncpy(this->channel_header.name, channel_name.c_str(), std::min<size_t>(64, channel_name.length()));
+			this->channel_start = this->buffer.tellp();
+			// the size of the channel is written as soon as its last layer was written
+			this->buffer.write((const char*)&this->channel_header, sizeof(FiledTypes::V1::ChannelHeader));
+		}
+
+		virtual void writeLayer(std::shared_ptr<VoxelBuffer> voxel_buffer, const std::string& layer_name) override {
+			if (this->channel_start < 0)
+				throw RadiationFieldStoreException("No channel was started to write layer: '" + layer_name + "' to");
+			this->handler.serializeLayer(voxel_buffer, layer_name, this->buffer);
+		}
+
+		virtual void finish() override {
+			this->endChannel();
+		}
+	};
+
+	/** Writes channel blocks layer by layer like ChannelBlockStreamWriter and builds the layer index of version 2 files along the way */
+	class IndexedChannelBlockStreamWriter : public ChannelBlockStreamWriter {
+	protected:
+		Storage::V2::FieldIndex index;
+		std::streamoff field_data_start;
+		std::map<std::string, AccessorTypes::TypedMemoryBlockDefinition> layers_blocks;
+
+		virtual void endChannel() override {
+			if (this->channel_start < 0)
+				return;
+
+			const std::streamoff channel_start = this->channel_start;
+			ChannelBlockStreamWriter::endChannel();
+			this->index.channels_layers_offsets[this->channel_name] = AccessorTypes::ChannelStructure(
+				AccessorTypes::MemoryBlockDefinition(static_cast<size_t>(channel_start - this->field_data_start), this->channel_header.channel_bytes),
+				this->layers_blocks
+			);
+			this->layers_blocks.clear();
+		}
+
+	public:
+		IndexedChannelBlockStreamWriter(const Storage::BinayFieldBlockHandler& handler, std::ostream& buffer, Storage::V2::FieldIndex&& index)
+			: ChannelBlockStreamWriter(handler, buffer), index(std::move(index)), field_data_start(buffer.tellp()) {}
+
+		virtual void writeLayer(std::shared_ptr<VoxelBuffer> voxel_buffer, const std::string& layer_name) override {
+			const std::streamoff layer_start = this->buffer.tellp();
+			ChannelBlockStreamWriter::writeLayer(voxel_buffer, layer_name);
+			const size_t layer_size = static_cast<size_t>(static_cast<std::streamoff>(this->buffer.tellp()) - layer_start);
+
+			const size_t layer_pos = static_cast<size_t>(layer_start - this->channel_start) - sizeof(FiledTypes::V1::ChannelHeader);
+			this->layers_blocks[layer_name] = MakeLayerBlockDefinition(voxel_buffer, layer_name, layer_pos, layer_size);
+		}
+
+		virtual void finish() override {
+			this->endChannel();
+			this->index.write(this->buffer);
+		}
+	};
+
+	/** Describes the shape of a field by the header of a layer index, which does not list any channels yet
+	* @param field The radiation field
+	* @param metadata_fileheader_size The position of the field block in the buffer
+	* @return The layer index
+	*/
+	Storage::V2::FieldIndex MakeFieldIndex(std::shared_ptr<IRadiationField> field, size_t metadata_fileheader_size) {
+		Storage::V2::FieldIndex index;
+		index.metadata_fileheader_size = metadata_fileheader_size;
+
+		if (field->get_typename() == "CartesianRadiationField") {
+			auto field_cartesian = std::dynamic_pointer_cast<CartesianRadiationField>(field);
+			index.field_type = FieldType::Cartesian;
+			index.cartesian_header.voxel_counts = field_cartesian->get_voxel_counts();
+			index.cartesian_header.voxel_dimensions = field_cartesian->get_voxel_dimensions();
+		}
+		else {
+			auto field_polar = std::dynamic_pointer_cast<PolarRadiationField>(field);
+			index.field_type = FieldType::Polar;
+			index.polar_header.segments_counts = field_polar->get_segments_count();
+		}
+		return index;
+	}
+}
+
 void Storage::V1::BinayFieldBlockHandler::serializeField(std::shared_ptr<IRadiationField> field, std::ostream& buffer) const
+{
+	this->serializeFieldHeader(field, buffer);
+
+	for (auto& channel : field->get_channels())
+		this->serializeChannelBlock(channel.first, channel.second, buffer);
+}
+
+size_t Storage::V1::BinayFieldBlockHandler::serializeChannelBlock(const std::string& channel_name, std::shared_ptr<VoxelBuffer> voxel_buffer, std::ostream& buffer, const std::function<void(const std::string& layer_name, size_t layer_pos, size_t layer_size)>& on_layer) const
+{
+	FiledTypes::V1::ChannelHeader ch;
+	std::strncpy(ch.name, channel_name.c_str(), std::min<size_t>(64, channel_name.length()));
+
+	// raw layers are only referenced, so preparing all of them costs nothing but their headers
+	const std::vector<std::string> layer_names = voxel_buffer->get_layers();
+	std::vector<LayerBlockWrite> layer_blocks(layer_names.size());
+	// encoding is the expensive part of preparing a layer, so the layers are prepared on multiple threads
+	VoxelBuffer::parallel_for(layer_names.size(), VoxelBuffer::get_worker_count(), [&](size_t i) {
+		layer_blocks[i] = this->prepareLayer(voxel_buffer, layer_names[i]);
+	});
+	ch.channel_bytes = 0;
+	for (auto& layer_block : layer_blocks)
+		ch.channel_bytes += layer_block.size();
+
+	buffer.write((const char*)&ch, sizeof(FiledTypes::V1::ChannelHeader));
+	size_t layer_pos = 0;
+	for (size_t i = 0; i < layer_blocks.size(); i++) {
+		const size_t layer_size = layer_blocks[i].size();
+		layer_blocks[i].write(buffer);
+		// release encoded data as soon as it was written
+		layer_blocks[i] = LayerBlockWrite();
+		if (on_layer)
+			on_layer(layer_names[i], layer_pos, layer_size);
+		layer_pos += layer_size;
+	}
+	return ch.channel_bytes;
+}
+
+void Storage::V1::BinayFieldBlockHandler::serializeFieldHeader(std::shared_ptr<IRadiationField> field, std::ostream& buffer) const
 {
 	FiledTypes::V1::RadiationFieldHeader desc;
 
@@ -38,16 +207,21 @@ void Storage::V1::BinayFieldBlockHandler::serializeField(std::shared_ptr<IRadiat
 		std::string msg = "Field type " + field_type + " is not supported!";
 		throw RadiationFieldStoreException(msg.c_str());
 	}
+}
 
-	auto channels = field->get_channels();
-	for (auto& channel : channels) {
-		FiledTypes::V1::ChannelHeader ch;
-		std::strncpy(ch.name, channel.first.c_str(), std::min<size_t>(64, channel.first.length()));
-		auto serialized_field = this->serializeChannel(channel.second);
-		ch.channel_bytes = serialized_field->str().length();
-		buffer.write((const char*)&ch, sizeof(FiledTypes::V1::ChannelHeader));
-		buffer.write(serialized_field->str().c_str(), ch.channel_bytes);
-	}
+FiledTypes::V1::VoxelGridLayerHeader Storage::V1::BinayFieldBlockHandler::make_layer_header(std::shared_ptr<VoxelBuffer> voxel_buffer, const std::string& layer_name)
+{
+	FiledTypes::V1::VoxelGridLayerHeader layer_desc;
+	const IVoxel& voxel = voxel_buffer->get_voxel_flat(layer_name, 0);
+	layer_desc.bytes_per_element = voxel.get_bytes();
+	std::strncpy(layer_desc.dtype, voxel.get_type().c_str(), std::min<size_t>(32, voxel.get_type().length()));
+	std::strncpy(layer_desc.name, layer_name.c_str(), std::min<size_t>(64, layer_name.length()));
+	const std::string layer_unit = voxel_buffer->get_layer_unit(layer_name);
+	std::strncpy(layer_desc.unit, layer_unit.c_str(), std::min<size_t>(32, layer_unit.length()));
+	layer_desc.statistical_error = voxel_buffer->get_statistical_error(layer_name);
+	if (voxel.get_header().header_bytes > 0)
+		layer_desc.header_block_size = voxel.get_header().header_bytes;
+	return layer_desc;
 }
 
 std::unique_ptr<std::ostringstream> Storage::V1::BinayFieldBlockHandler::serializeChannel(std::shared_ptr<VoxelBuffer> voxel_buffer) const
@@ -55,28 +229,36 @@ std::unique_ptr<std::ostringstream> Storage::V1::BinayFieldBlockHandler::seriali
 	auto layers = voxel_buffer->get_layers();
 
 	std::unique_ptr<std::ostringstream> oss = std::make_unique<std::ostringstream>();
-	for (auto& layer_name : layers) {
-		FiledTypes::V1::VoxelGridLayerHeader layer_desc;
-		const IVoxel& voxel = voxel_buffer->get_voxel_flat(layer_name, 0);
-		layer_desc.bytes_per_element = voxel.get_bytes();
-		std::strncpy(layer_desc.dtype, voxel.get_type().c_str(), std::min<size_t>(32, voxel.get_type().length()));
-		std::strncpy(layer_desc.name, layer_name.c_str(), std::min<size_t>(64, layer_name.length()));
-		const std::string layer_unit = voxel_buffer->get_layer_unit(layer_name);
-		std::strncpy(layer_desc.unit, layer_unit.c_str(), std::min<size_t>(32, layer_unit.length()));
-		layer_desc.statistical_error = voxel_buffer->get_statistical_error(layer_name);
-		if (voxel.get_header().header_bytes > 0)
-			layer_desc.header_block_size = voxel.get_header().header_bytes;
-		oss->write((const char*)&layer_desc, sizeof(FiledTypes::V1::VoxelGridLayerHeader));
-		if (layer_desc.header_block_size > 0) {
-			const char* header_data = (char*)voxel.get_header().header;
-			oss->write(header_data, layer_desc.header_block_size);
-		}
-		const char* data_buffer = voxel_buffer->get_layer<char>(layer_name);
-		oss->write(data_buffer, voxel_buffer->get_voxel_count() * layer_desc.bytes_per_element);
-	}
+	for (auto& layer_name : layers)
+		this->serializeLayer(voxel_buffer, layer_name, *oss);
 	return oss;
 }
 
+void Storage::V1::BinayFieldBlockHandler::serializeLayer(std::shared_ptr<VoxelBuffer> voxel_buffer, const std::string& layer_name, std::ostream& buffer) const
+{
+	this->prepareLayer(voxel_buffer, layer_name).write(buffer);
+}
+
+LayerBlockWrite Storage::V1::BinayFieldBlockHandler::prepareLayer(std::shared_ptr<VoxelBuffer> voxel_buffer, const std::string& layer_name) const
+{
+	const FiledTypes::V1::VoxelGridLayerHeader layer_desc = BinayFieldBlockHandler::make_layer_header(voxel_buffer, layer_name);
+
+	LayerBlockWrite block;
+	block.headers.resize(sizeof(FiledTypes::V1::VoxelGridLayerHeader) + layer_desc.header_block_size);
+	std::memcpy(block.headers.data(), &layer_desc, sizeof(FiledTypes::V1::VoxelGridLayerHeader));
+	if (layer_desc.header_block_size > 0)
+		std::memcpy(block.headers.data() + sizeof(FiledTypes::V1::VoxelGridLayerHeader), voxel_buffer->get_voxel_flat(layer_name, 0).get_header().header, layer_desc.header_block_size);
+	block.data = voxel_buffer->get_layer<char>(layer_name);
+	block.data_bytes = voxel_buffer->get_voxel_count() * layer_desc.bytes_per_element;
+	return block;
+}
+
+std::unique_ptr<FieldBlockStreamWriter> Storage::V1::BinayFieldBlockHandler::serializeFieldStreamed(std::shared_ptr<IRadiationField> field_shape, std::ostream& buffer) const
+{
+	this->serializeFieldHeader(field_shape, buffer);
+	return std::make_unique<ChannelBlockStreamWriter>(*this, buffer);
+}
+
 VoxelLayer* Storage::V1::BinayFieldBlockHandler::deserializeLayer(char* data, size_t size) const
 {
 	if (size < sizeof(FiledTypes::V1::VoxelGridLayerHeader))
@@ -150,6 +332,159 @@ VoxelLayer* Storage::V1::BinayFieldBlockHandler::deserializeLayer(char* data, si
 	return layer;
 }
 
+VoxelLayer* Storage::V1::BinayFieldBlockHandler::deserializeLayerView(char* data, size_t size, std::shared_ptr<void> data_owner) const
+{
+	if (size < sizeof(FiledTypes::V1::VoxelGridLayerHeader))
+		throw std::runtime_error("Data is too small to contain a valid layer header");
+
+	size_t mem_pos = 0;
+	FiledTypes::V1::VoxelGridLayerHeader layer_desc = *(FiledTypes::V1::VoxelGridLayerHeader*)(data);
+	mem_pos += sizeof(FiledTypes::V1::VoxelGridLayerHeader);
+	void* header_data = nullptr;
+
+	if (layer_desc.header_block_size > 0) {
+		header_data = (void*)(data + mem_pos);
+		mem_pos += layer_desc.header_block_size;
+	}
+
+	if (mem_pos >= size)
+		throw std::runtime_error("Data is too small to contain a valid layer data");
+
+	size_t remaining_bytes = size - mem_pos;
+	size_t voxel_count = remaining_bytes / layer_desc.bytes_per_element;
+
+	Typing::DType dtype = Typing::Helper::get_dtype(std::string(layer_desc.dtype));
+
+	// The position of the voxel data depends on the size of the dynamic metadata, so it is not guaranteed to be aligned
+	size_t alignment = sizeof(float);
+	switch (dtype) {
+	case Typing::DType::Char:
+		alignment = sizeof(char);
+		break;
+	case Typing::DType::Double:
+	case Typing::DType::UInt64:
+		alignment = sizeof(uint64_t);
+		break;
+	default:
+		break;
+	}
+	if (reinterpret_cast<uintptr_t>(data + mem_pos) % alignment != 0)
+		return this->deserializeLayer(data, size);
+
+	VoxelLayer* layer = nullptr;
+	HistogramVoxel hist_template;
+
+	switch (dtype)
+	{
+	case Typing::DType::Float:
+		layer = VoxelLayer::ConstructView<float>(std::string(layer_desc.unit), voxel_count, layer_desc.statistical_error, data + mem_pos, data_owner, true);
+		break;
+	case Typing::DType::Double:
+#if defined(__x86_64__) || defined(_M_X64)
+		layer = VoxelLayer::ConstructView<double>(std::string(layer_desc.unit), voxel_count, layer_desc.statistical_error, data + mem_pos, data_owner, true);
+#else
+		throw std::runtime_error("Can't load 64-bit file in 32-bit system!");
+#endif
+		break;
+	case Typing::DType::Int:
+		layer = VoxelLayer::ConstructView<int>(std::string(layer_desc.unit), voxel_count, layer_desc.statistical_error, data + mem_pos, data_owner, true);
+		break;
+	case Typing::DType::Char:
+		layer = VoxelLayer::ConstructView<char>(std::string(layer_desc.unit), voxel_count, layer_desc.statistical_error, data + mem_pos, data_owner, true);
+		break;
+	case Typing::DType::Vec2:
+		layer = VoxelLayer::ConstructView<glm::vec2>(std::string(layer_desc.unit), voxel_count, layer_desc.statistical_error, data + mem_pos, data_owner, true);
+		break;
+	case Typing::DType::Vec3:
+		layer = VoxelLayer::ConstructView<glm::vec3>(std::string(layer_desc.unit), voxel_count, layer_desc.statistical_error, data + mem_pos, data_owner, true);
+		break;
+	case Typing::DType::Vec4:
+		layer = VoxelLayer::ConstructView<glm::vec4>(std::string(layer_desc.unit), voxel_count, layer_desc.statistical_error, data + mem_pos, data_owner, true);
+		break;
+	case Typing::DType::Hist:
+		if (header_data != nullptr)
+			hist_template.init_from_header(header_data);
+		layer = VoxelLayer::ConstructView<float, HistogramVoxel>(std::string(layer_desc.unit), voxel_count, layer_desc.statistical_error, data + mem_pos, data_owner, true, hist_template);
+		break;
+	case Typing::DType::UInt64:
+#if defined(__x86_64__) || defined(_M_X64)
+		layer = VoxelLayer::ConstructView<uint64_t>(std::string(layer_desc.unit), voxel_count, layer_desc.statistical_error, data + mem_pos, data_owner, true);
+#else
+		throw std::runtime_error("Can't load 64-bit file in 32-bit system!");
+#endif
+		break;
+	case Typing::DType::UInt32:
+		layer = VoxelLayer::ConstructView<uint32_t>(std::string(layer_desc.unit), voxel_count, layer_desc.statistical_error, data + mem_pos, data_owner, true);
+		break;
+	default:
+		throw std::runtime_error("Failed to find data-type for layer! Data-type was: " + std::string(layer_desc.dtype));
+	}
+	return layer;
+}
+
+VoxelLayer* Storage::V1::BinayFieldBlockHandler::deserializeLayerRegion(const std::function<void(size_t offset, size_t size, char* destination)>& read, size_t size, const glm::uvec3& voxel_counts, const glm::uvec3& region_min, const glm::uvec3& region_max) const
+{
+	if (glm::any(glm::greaterThanEqual(region_min, region_max)) || glm::any(glm::greaterThan(region_max, voxel_counts)))
+		throw RadiationFieldStoreException("Region is empty or exceeds the layer");
+	if (size < sizeof(FiledTypes::V1::VoxelGridLayerHeader))
+		throw RadiationFieldStoreException("Data is too small to contain a valid layer header");
+
+	FiledTypes::V1::VoxelGridLayerHeader layer_desc;
+	read(0, sizeof(FiledTypes::V1::VoxelGridLayerHeader), (char*)&layer_desc);
+
+	const size_t headers_size = sizeof(FiledTypes::V1::VoxelGridLayerHeader) + layer_desc.header_block_size;
+	const size_t voxel_bytes = layer_desc.bytes_per_element;
+	const size_t voxel_count = static_cast<size_t>(voxel_counts.x) * voxel_counts.y * voxel_counts.z;
+	if (headers_size + voxel_count * voxel_bytes > size)
+		throw RadiationFieldStoreException("Data is too small to contain layer: '" + std::string(layer_desc.name) + "'");
+
+	const glm::uvec3 region_extent = region_max - region_min;
+	std::vector<char> region_block(headers_size + static_cast<size_t>(region_extent.x) * region_extent.y * region_extent.z * voxel_bytes);
+	memcpy(region_block.data(), &layer_desc, sizeof(FiledTypes::V1::VoxelGridLayerHeader));
+	if (layer_desc.header_block_size > 0)
+		read(sizeof(FiledTypes::V1::VoxelGridLayerHeader), layer_desc.header_block_size, region_block.data() + sizeof(FiledTypes::V1::VoxelGridLayerHeader));
+
+	// read the region row by row, rows which follow each other in the layer block are read at once
+	const size_t row_bytes = region_extent.x * voxel_bytes;
+	char* destination = region_block.data() + headers_size;
+	size_t pending_offset = 0;
+	size_t pending_size = 0;
+	for (size_t z = region_min.z; z < region_max.z; z++) {
+		for (size_t y = region_min.y; y < region_max.y; y++) {
+			const size_t row_offset = headers_size + ((z * voxel_counts.y + y) * voxel_counts.x + region_min.x) * voxel_bytes;
+			if (pending_size > 0 && pending_offset + pending_size == row_offset) {
+				pending_size += row_bytes;
+				continue;
+			}
+			if (pending_size > 0) {
+				read(pending_offset, pending_size, destination);
+				destination += pending_size;
+			}
+			pending_offset = row_offset;
+			pending_size = row_bytes;
+		}
+	}
+	read(pending_offset, pending_size, destination);
+
+	return V1::BinayFieldBlockHandler::deserializeLayer(region_block.data(), region_block.size());
+}
+
+std::shared_ptr<VoxelBuffer> Storage::V1::BinayFieldBlockHandler::deserializeChannelView(std::shared_ptr<VoxelBuffer> destination, char* data, size_t size, std::shared_ptr<void> data_owner) const
+{
+	size_t mem_pos = 0;
+	while (mem_pos + sizeof(FiledTypes::V1::VoxelGridLayerHeader) <= size) {
+		const FiledTypes::V1::VoxelGridLayerHeader& layer_desc = *(FiledTypes::V1::VoxelGridLayerHeader*)(data + mem_pos);
+		const size_t layer_size = sizeof(FiledTypes::V1::VoxelGridLayerHeader) + layer_desc.header_block_size + destination->get_voxel_count() * layer_desc.bytes_per_element;
+		if (mem_pos + layer_size > size)
+			throw std::runtime_error("Data is too small to contain layer: '" + std::string(layer_desc.name) + "'");
+
+		destination->insert_layer(std::string(layer_desc.name), this->deserializeLayerView(data + mem_pos, layer_size, data_owner));
+		mem_pos += layer_size;
+	}
+
+	return destination;
+}
+
 std::shared_ptr<VoxelBuffer> Storage::V1::BinayFieldBlockHandler::deserializeChannel(std::shared_ptr<VoxelBuffer> destination, char* data, size_t size) const
 {
 	size_t mem_pos = 0;
@@ -231,42 +566,80 @@ void Storage::V1::BinayFieldBlockHandler::add_hist_layer(std::shared_ptr<VoxelBu
 }
 
 std::shared_ptr<IRadiationField> RadFiled3D::Storage::V1::BinayFieldBlockHandler::deserializeField(std::istream& buffer) const
+{
+	return this->deserializeField(buffer, std::numeric_limits<size_t>::max());
+}
+
+std::shared_ptr<IRadiationField> RadFiled3D::Storage::V1::BinayFieldBlockHandler::deserializeField(std::istream& buffer, size_t field_data_end) const
+{
+	std::shared_ptr<IRadiationField> field = this->deserializeFieldShape(buffer);
+
+	while (!buffer.eof() && static_cast<size_t>(buffer.tellg()) < field_data_end) {
+		FiledTypes::V1::ChannelHeader ch;
+		buffer.read((char*)&ch, sizeof(FiledTypes::V1::ChannelHeader));
+
+		if (buffer.eof())
+			break;
+
+		// the staging buffer is of the same size for each field of the same shape, so it is taken from the layer allocator to be recycled as well
+		std::shared_ptr<ILayerAllocator> allocator = ILayerAllocator::get_default();
+		const size_t channel_bytes = ch.channel_bytes;
+		std::shared_ptr<char> channel_data(
+			allocator->allocate(channel_bytes),
+			[allocator, channel_bytes](char* data) { allocator->deallocate(data, channel_bytes); }
+		);
+		buffer.read(channel_data.get(), ch.channel_bytes);
+
+		this->deserializeChannel(field->add_channel(std::string(ch.name)), channel_data.get(), ch.channel_bytes);
+	}
+
+	return field;
+}
+
+std::shared_ptr<IRadiationField> RadFiled3D::Storage::V1::BinayFieldBlockHandler::deserializeFieldShape(std::istream& buffer) const
 {
 	FiledTypes::V1::RadiationFieldHeader desc;
 
 	buffer.read((char*)&desc, sizeof(FiledTypes::V1::RadiationFieldHeader));
 
-	std::shared_ptr<IRadiationField> field;
 	if (strcmp(desc.field_type, "CartesianRadiationField") == 0) {
 		FiledTypes::V1::CartesianHeader ch;
 		buffer.read((char*)&ch, sizeof(FiledTypes::V1::CartesianHeader));
-		field = std::make_shared<CartesianRadiationField>(glm::vec3(ch.voxel_counts) * ch.voxel_dimensions, ch.voxel_dimensions);
+		return std::make_shared<CartesianRadiationField>(glm::vec3(ch.voxel_counts) * ch.voxel_dimensions, ch.voxel_dimensions);
 	}
 	else if (strcmp(desc.field_type, "PolarRadiationField") == 0) {
 		FiledTypes::V1::PolarHeader ph;
 		buffer.read((char*)&ph, sizeof(FiledTypes::V1::PolarHeader));
-		field = std::make_shared<PolarRadiationField>(ph.segments_counts);
+		return std::make_shared<PolarRadiationField>(ph.segments_counts);
 	}
 	else {
 		std::string msg = "Field type " + std::string(desc.field_type) + " is not supported!";
 		throw RadiationFieldStoreException(msg.c_str());
 	}
+}
 
-	while (!buffer.eof()) {
-		FiledTypes::V1::ChannelHeader ch;
-		buffer.read((char*)&ch, sizeof(FiledTypes::V1::ChannelHeader));
+size_t RadFiled3D::Storage::V1::BinayFieldBlockHandler::getFieldDataEnd(std::istream& buffer) const
+{
+	// version 1 fields end with the buffer
+	buffer.clear();
+	buffer.seekg(0, std::ios::end);
+	return buffer.tellg();
+}
 
-		if (buffer.eof())
-			break;
+size_t RadFiled3D::Storage::V1::BinayFieldBlockHandler::getLayerBlockSize(const char* data, size_t size, size_t voxel_count) const
+{
+	if (size < sizeof(FiledTypes::V1::VoxelGridLayerHeader))
+		throw RadiationFieldStoreException("Data is too small to contain a valid layer header");
 
-		char* channel_data = new char[ch.channel_bytes];
-		buffer.read(channel_data, ch.channel_bytes);
+	const FiledTypes::V1::VoxelGridLayerHeader& layer_desc = *(const FiledTypes::V1::VoxelGridLayerHeader*)(data);
+	if (layer_desc.bytes_per_element == 0)
+		throw RadiationFieldStoreException("Layer: '" + std::string(layer_desc.name) + "' is incomplete");
 
-		BinayFieldBlockHandler::deserializeChannel(field->add_channel(std::string(ch.name)), channel_data, ch.channel_bytes);
-		delete[] channel_data;
-	}
+	const size_t layer_size = sizeof(FiledTypes::V1::VoxelGridLayerHeader) + layer_desc.header_block_size + voxel_count * layer_desc.bytes_per_element;
+	if (layer_size > size)
+		throw RadiationFieldStoreException("Data is too small to contain layer: '" + std::string(layer_desc.name) + "'");
 
-	return field;
+	return layer_size;
 }
 
 RadFiled3D::FieldType RadFiled3D::Storage::V1::BinayFieldBlockHandler::getFieldType(std::istream& buffer) const
@@ -284,4 +657,335 @@ RadFiled3D::FieldType RadFiled3D::Storage::V1::BinayFieldBlockHandler::getFieldT
 		std::string msg = "Field type " + std::string(desc.field_type) + " is not supported!";
 		throw RadiationFieldStoreException(msg.c_str());
 	}
-}
\ No newline at end of file
+}
+void RadFiled3D::Storage::V2::BinayFieldBlockHandler::serializeField(std::shared_ptr<IRadiationField> field, std::ostream& buffer) const
+{
+	V2::FieldIndex index = MakeFieldIndex(field, buffer.tellp());
+
+	this->serializeFieldHeader(field, buffer);
+
+	size_t channel_pos = 0;
+	for (auto& channel : field->get_channels()) {
+		// index the layers as they are written, as the size of encoded layers is only known once they were encoded
+		std::map<std::string, AccessorTypes::TypedMemoryBlockDefinition> layers_blocks;
+		const size_t channel_bytes = this->serializeChannelBlock(channel.first, channel.second, buffer, [&](const std::string& layer_name, size_t layer_pos, size_t layer_size) {
+			layers_blocks[layer_name] = MakeLayerBlockDefinition(channel.second, layer_name, layer_pos, layer_size);
+		});
+		index.channels_layers_offsets[channel.first] = AccessorTypes::ChannelStructure(AccessorTypes::MemoryBlockDefinition(channel_pos, channel_bytes), layers_blocks);
+		channel_pos += sizeof(FiledTypes::V1::ChannelHeader) + channel_bytes;
+	}
+
+	index.write(buffer);
+}
+
+std::shared_ptr<IRadiationField> RadFiled3D::Storage::V2::BinayFieldBlockHandler::deserializeField(std::istream& buffer) const
+{
+	const size_t field_start = buffer.tellg();
+	FiledTypes::V2::FieldIndexTrailer trailer = V2::FieldIndex::ReadTrailer(buffer);
+	buffer.seekg(field_start, std::ios::beg);
+
+	return V1::BinayFieldBlockHandler::deserializeField(buffer, trailer.index_offset);
+}
+
+LayerBlockWrite RadFiled3D::Storage::V2::BinayFieldBlockHandler::prepareLayer(std::shared_ptr<VoxelBuffer> voxel_buffer, const std::string& layer_name) const
+{
+	// only layers of cartesian fields can be split into bricks
+	std::shared_ptr<VoxelGridBuffer> grid_buffer = std::dynamic_pointer_cast<VoxelGridBuffer>(voxel_buffer);
+
+	FiledTypes::V1::VoxelGridLayerHeader layer_desc = V1::BinayFieldBlockHandler::make_layer_header(voxel_buffer, layer_name);
+	const char* data_buffer = voxel_buffer->get_layer<char>(layer_name);
+	const size_t data_bytes = voxel_buffer->get_voxel_count() * layer_desc.bytes_per_element;
+
+	LayerBlockWrite block;
+	FiledTypes::V2::LayerCodecHeader codec_desc;
+	const size_t element_bytes = Typing::Helper::get_bytes_of_dtype(Typing::Helper::get_dtype(std::string(layer_desc.dtype)));
+	if (grid_buffer != nullptr && this->brick_size > 0) {
+		// bricked layers are kept bricked regardless of their size, as they are meant for reading regions
+		block.encoded_data = LayerCodecs::EncodeBricks(this->codec, data_buffer, layer_desc.bytes_per_element, element_bytes, BrickLayout(grid_buffer->get_voxel_counts(), this->brick_size));
+		codec_desc.codec = static_cast<uint32_t>(this->codec);
+		// accessors identify raw layers by their size in the index, so bricks shrinking by exactly the brick table are stored raw instead
+		if (block.encoded_data.size() == data_bytes) {
+			block.encoded_data = LayerCodecs::EncodeBricks(LayerCodec::Raw, data_buffer, layer_desc.bytes_per_element, element_bytes, BrickLayout(grid_buffer->get_voxel_counts(), this->brick_size));
+			codec_desc.codec = static_cast<uint32_t>(LayerCodec::Raw);
+		}
+		codec_desc.brick_size = this->brick_size;
+		codec_desc.encoded_bytes = block.encoded_data.size();
+	}
+	else if (this->codec != LayerCodec::Raw) {
+		block.encoded_data = LayerCodecs::Encode(this->codec, data_buffer, data_bytes, element_bytes);
+		// only keep the encoded data if it actually saves space
+		if (block.encoded_data.size() < data_bytes) {
+			codec_desc.codec = static_cast<uint32_t>(this->codec);
+			codec_desc.encoded_bytes = block.encoded_data.size();
+		}
+		else {
+			block.encoded_data = std::vector<char>();
+		}
+	}
+	if (codec_desc.codec == static_cast<uint32_t>(LayerCodec::Raw) && codec_desc.brick_size == 0)
+		codec_desc.encoded_bytes = data_bytes;
+	codec_desc.decoded_bytes = data_bytes;
+
+	block.headers.resize(sizeof(FiledTypes::V2::LayerCodecHeader) + sizeof(FiledTypes::V1::VoxelGridLayerHeader) + layer_desc.header_block_size);
+	std::memcpy(block.headers.data(), &codec_desc, sizeof(FiledTypes::V2::LayerCodecHeader));
+	std::memcpy(block.headers.data() + sizeof(FiledTypes::V2::LayerCodecHeader), &layer_desc, sizeof(FiledTypes::V1::VoxelGridLayerHeader));
+	if (layer_desc.header_block_size > 0)
+		std::memcpy(block.headers.data() + sizeof(FiledTypes::V2::LayerCodecHeader) + sizeof(FiledTypes::V1::VoxelGridLayerHeader), voxel_buffer->get_voxel_flat(layer_name, 0).get_header().header, layer_desc.header_block_size);
+	if (codec_desc.codec == static_cast<uint32_t>(LayerCodec::Raw) && codec_desc.brick_size == 0) {
+		block.data = data_buffer;
+		block.data_bytes = data_bytes;
+	}
+	else {
+		block.data = block.encoded_data.data();
+		block.data_bytes = block.encoded_data.size();
+	}
+	return block;
+}
+
+std::unique_ptr<FieldBlockStreamWriter> RadFiled3D::Storage::V2::BinayFieldBlockHandler::serializeFieldStreamed(std::shared_ptr<IRadiationField> field_shape, std::ostream& buffer) const
+{
+	V2::FieldIndex index = MakeFieldIndex(field_shape, buffer.tellp());
+
+	this->serializeFieldHeader(field_shape, buffer);
+	return std::make_unique<IndexedChannelBlockStreamWriter>(*this, buffer, std::move(index));
+}
+
+size_t RadFiled3D::Storage::V2::BinayFieldBlockHandler::getFieldDataEnd(std::istream& buffer) const
+{
+	return V2::FieldIndex::ReadTrailer(buffer).index_offset;
+}
+
+size_t RadFiled3D::Storage::V2::BinayFieldBlockHandler::getLayerBlockSize(const char* data, size_t size, size_t voxel_count) const
+{
+	const size_t headers_size = sizeof(FiledTypes::V2::LayerCodecHeader) + sizeof(FiledTypes::V1::VoxelGridLayerHeader);
+	if (size < headers_size)
+		throw RadiationFieldStoreException("Data is too small to contain a valid layer header");
+
+	const FiledTypes::V2::LayerCodecHeader& codec_desc = *(const FiledTypes::V2::LayerCodecHeader*)(data);
+	const FiledTypes::V1::VoxelGridLayerHeader& layer_desc = *(const FiledTypes::V1::VoxelGridLayerHeader*)(data + sizeof(FiledTypes::V2::LayerCodecHeader));
+
+	if (codec_desc.decoded_bytes != voxel_count * layer_desc.bytes_per_element)
+		throw RadiationFieldStoreException("Size of layer: '" + std::string(layer_desc.name) + "' does not match the voxel count");
+	if (static_cast<LayerCodec>(codec_desc.codec) == LayerCodec::Raw && codec_desc.brick_size == 0 && codec_desc.encoded_bytes != codec_desc.decoded_bytes)
+		throw RadiationFieldStoreException("Size of raw layer: '" + std::string(layer_desc.name) + "' does not match the voxel count");
+
+	const size_t layer_size = headers_size + layer_desc.header_block_size + codec_desc.encoded_bytes;
+	if (layer_size > size)
+		throw RadiationFieldStoreException("Data is too small to contain layer: '" + std::string(layer_desc.name) + "'");
+
+	return layer_size;
+}
+
+VoxelLayer* RadFiled3D::Storage::V2::BinayFieldBlockHandler::deserializeLayer(char* data, size_t size) const
+{
+	if (size < sizeof(FiledTypes::V2::LayerCodecHeader) + sizeof(FiledTypes::V1::VoxelGridLayerHeader))
+		throw std::runtime_error("Data is too small to contain a valid layer header");
+
+	const FiledTypes::V2::LayerCodecHeader& codec_desc = *(const FiledTypes::V2::LayerCodecHeader*)(data);
+	if (this->isLayerRaw(data))
+		return V1::BinayFieldBlockHandler::deserializeLayer(data + sizeof(FiledTypes::V2::LayerCodecHeader), size - sizeof(FiledTypes::V2::LayerCodecHeader));
+
+	if (codec_desc.brick_size > 0) {
+		// a bricked layer is read as a region covering the whole layer
+		const FiledTypes::V1::VoxelGridLayerHeader& layer_desc = *(const FiledTypes::V1::VoxelGridLayerHeader*)(data + sizeof(FiledTypes::V2::LayerCodecHeader));
+		const size_t table_position = sizeof(FiledTypes::V2::LayerCodecHeader) + sizeof(FiledTypes::V1::VoxelGridLayerHeader) + layer_desc.header_block_size;
+		if (table_position + sizeof(FiledTypes::V2::BrickTableHeader) > size)
+			throw RadiationFieldStoreException("Data is too small to contain the brick table of layer: '" + std::string(layer_desc.name) + "'");
+		const glm::uvec3 voxel_counts = ((const FiledTypes::V2::BrickTableHeader*)(data + table_position))->voxel_counts;
+
+		return this->deserializeLayerRegion([data, size](size_t offset, size_t bytes, char* destination) {
+			if (offset + bytes > size)
+				throw RadiationFieldStoreException("Memory block exceeds the layer");
+			memcpy(destination, data + offset, bytes);
+		}, size, voxel_counts, glm::uvec3(0), voxel_counts);
+	}
+
+	std::vector<char> decoded_block = this->decodeLayerBlock(data, size);
+	return V1::BinayFieldBlockHandler::deserializeLayer(decoded_block.data(), decoded_block.size());
+}
+
+std::vector<char> RadFiled3D::Storage::V2::BinayFieldBlockHandler::decodeLayerBlock(const char* data, size_t size) const
+{
+	const FiledTypes::V2::LayerCodecHeader& codec_desc = *(const FiledTypes::V2::LayerCodecHeader*)(data);
+	const char* layer_data = data + sizeof(FiledTypes::V2::LayerCodecHeader);
+	const size_t layer_size = size - sizeof(FiledTypes::V2::LayerCodecHeader);
+
+	// restore the version 1 layout of the layer block, so that the version 1 handler can construct the layer from it
+	const FiledTypes::V1::VoxelGridLayerHeader& layer_desc = *(const FiledTypes::V1::VoxelGridLayerHeader*)(layer_data);
+	const size_t headers_size = sizeof(FiledTypes::V1::VoxelGridLayerHeader) + layer_desc.header_block_size;
+	if (headers_size + codec_desc.encoded_bytes > layer_size)
+		throw std::runtime_error("Data is too small to contain layer: '" + std::string(layer_desc.name) + "'");
+
+	const Typing::DType dtype = Typing::Helper::get_dtype(std::string(layer_desc.dtype));
+	const size_t element_bytes = Typing::Helper::get_bytes_of_dtype(dtype);
+	std::vector<char> decoded_block(headers_size + codec_desc.decoded_bytes);
+	memcpy(decoded_block.data(), layer_data, headers_size);
+	LayerCodecs::Decode(static_cast<LayerCodec>(codec_desc.codec), layer_data + headers_size, codec_desc.encoded_bytes, decoded_block.data() + headers_size, decoded_block.size() - headers_size, element_bytes);
+
+	return decoded_block;
+}
+
+VoxelLayer* RadFiled3D::Storage::V2::BinayFieldBlockHandler::deserializeLayerRegion(const std::function<void(size_t offset, size_t size, char* destination)>& read, size_t size, const glm::uvec3& voxel_counts, const glm::uvec3& region_min, const glm::uvec3& region_max) const
+{
+	const size_t codec_header_size = sizeof(FiledTypes::V2::LayerCodecHeader);
+	if (size < codec_header_size + sizeof(FiledTypes::V1::VoxelGridLayerHeader))
+		throw RadiationFieldStoreException("Data is too small to contain a valid layer header");
+
+	char codec_header_data[sizeof(FiledTypes::V2::LayerCodecHeader)];
+	read(0, codec_header_size, codec_header_data);
+	const FiledTypes::V2::LayerCodecHeader& codec_desc = *(const FiledTypes::V2::LayerCodecHeader*)(codec_header_data);
+
+	if (this->isLayerRaw(codec_header_data)) {
+		return V1::BinayFieldBlockHandler::deserializeLayerRegion([&read, codec_header_size](size_t offset, size_t bytes, char* destination) {
+			read(codec_header_size + offset, bytes, destination);
+		}, size - codec_header_size, voxel_counts, region_min, region_max);
+	}
+
+	if (codec_desc.brick_size == 0) {
+		// a contiguous encoded layer can only be decoded as a whole
+		std::vector<char> layer_data(size);
+		read(0, size, layer_data.data());
+		std::vector<char> decoded_block = this->decodeLayerBlock(layer_data.data(), size);
+		return V1::BinayFieldBlockHandler::deserializeLayerRegion([&decoded_block](size_t offset, size_t bytes, char* destination) {
+			memcpy(destination, decoded_block.data() + offset, bytes);
+		}, decoded_block.size(), voxel_counts, region_min, region_max);
+	}
+
+	if (glm::any(glm::greaterThanEqual(region_min, region_max)) || glm::any(glm::greaterThan(region_max, voxel_counts)))
+		throw RadiationFieldStoreException("Region is empty or exceeds the layer");
+
+	FiledTypes::V1::VoxelGridLayerHeader layer_desc;
+	read(codec_header_size, sizeof(FiledTypes::V1::VoxelGridLayerHeader), (char*)&layer_desc);
+	const size_t headers_size = sizeof(FiledTypes::V1::VoxelGridLayerHeader) + layer_desc.header_block_size;
+	const size_t voxel_bytes = layer_desc.bytes_per_element;
+	const size_t element_bytes = Typing::Helper::get_bytes_of_dtype(Typing::Helper::get_dtype(std::string(layer_desc.dtype)));
+
+	const glm::uvec3 region_extent = region_max - region_min;
+	std::vector<char> region_block(headers_size + static_cast<size_t>(region_extent.x) * region_extent.y * region_extent.z * voxel_bytes);
+	memcpy(region_block.data(), &layer_desc, sizeof(FiledTypes::V1::VoxelGridLayerHeader));
+	if (layer_desc.header_block_size > 0)
+		read(codec_header_size + sizeof(FiledTypes::V1::VoxelGridLayerHeader), layer_desc.header_block_size, region_block.data() + sizeof(FiledTypes::V1::VoxelGridLayerHeader));
+
+	const size_t table_position = codec_header_size + headers_size;
+	FiledTypes::V2::BrickTableHeader table_desc;
+	read(table_position, sizeof(FiledTypes::V2::BrickTableHeader), (char*)&table_desc);
+	if (table_desc.voxel_counts != voxel_counts)
+		throw RadiationFieldStoreException("Brick table of layer: '" + std::string(layer_desc.name) + "' does not match the voxel counts");
+
+	const BrickLayout layout(voxel_counts, codec_desc.brick_size);
+	const size_t brick_count = layout.get_brick_count();
+	const size_t table_bytes = sizeof(FiledTypes::V2::BrickTableHeader) + (brick_count + 1) * sizeof(size_t);
+	if (table_bytes > codec_desc.encoded_bytes || codec_header_size + headers_size + codec_desc.encoded_bytes > size)
+		throw RadiationFieldStoreException("Data is too small to contain layer: '" + std::string(layer_desc.name) + "'");
+
+	std::vector<size_t> offsets(brick_count + 1);
+	read(table_position + sizeof(FiledTypes::V2::BrickTableHeader), offsets.size() * sizeof(size_t), (char*)offsets.data());
+	const size_t bricks_position = table_position + table_bytes;
+	if (offsets[brick_count] != codec_desc.encoded_bytes - table_bytes)
+		throw RadiationFieldStoreException("Brick table of layer: '" + std::string(layer_desc.name) + "' is corrupted");
+
+	// bricks next to each other along x are stored next to each other as well and are read at once
+	const std::vector<size_t> bricks = layout.get_bricks_in_region(region_min, region_max);
+	std::vector<char> encoded_bricks;
+	std::vector<char> brick;
+	char* region_data = region_block.data() + headers_size;
+	for (size_t i = 0; i < bricks.size();) {
+		size_t j = i + 1;
+		while (j < bricks.size() && bricks[j] == bricks[j - 1] + 1)
+			j++;
+
+		const size_t first_brick = bricks[i];
+		const size_t end_brick = bricks[j - 1] + 1;
+		if (offsets[first_brick] > offsets[end_brick] || offsets[end_brick] > offsets[brick_count])
+			throw RadiationFieldStoreException("Brick table of layer: '" + std::string(layer_desc.name) + "' is corrupted");
+		encoded_bricks.resize(offsets[end_brick] - offsets[first_brick]);
+		read(bricks_position + offsets[first_brick], encoded_bricks.size(), encoded_bricks.data());
+
+		for (size_t brick_idx = first_brick; brick_idx < end_brick; brick_idx++) {
+			if (offsets[brick_idx] > offsets[brick_idx + 1])
+				throw RadiationFieldStoreException("Brick table of layer: '" + std::string(layer_desc.name) + "' is corrupted");
+			brick.resize(layout.get_brick_voxel_count(brick_idx) * voxel_bytes);
+			LayerCodecs::DecodeBrick(static_cast<LayerCodec>(codec_desc.codec), encoded_bricks.data() + offsets[brick_idx] - offsets[first_brick], offsets[brick_idx + 1] - offsets[brick_idx], brick.data(), brick.size(), element_bytes);
+			layout.scatter(brick.data(), voxel_bytes, brick_idx, region_data, region_min, region_max);
+		}
+		i = j;
+	}
+
+	return V1::BinayFieldBlockHandler::deserializeLayer(region_block.data(), region_block.size());
+}
+
+VoxelLayer* RadFiled3D::Storage::V2::BinayFieldBlockHandler::deserializeLayerView(char* data, size_t size, std::shared_ptr<void> data_owner) const
+{
+	if (size < sizeof(FiledTypes::V2::LayerCodecHeader))
+		throw std::runtime_error("Data is too small to contain a valid layer header");
+
+	if (!this->isLayerRaw(data))
+		return this->deserializeLayer(data, size);
+
+	return V1::BinayFieldBlockHandler::deserializeLayerView(data + sizeof(FiledTypes::V2::LayerCodecHeader), size - sizeof(FiledTypes::V2::LayerCodecHeader), data_owner);
+}
+
+std::shared_ptr<VoxelBuffer> RadFiled3D::Storage::V2::BinayFieldBlockHandler::deserializeLayers(std::shared_ptr<VoxelBuffer> destination, char* data, size_t size, std::shared_ptr<void> data_owner) const
+{
+	std::vector<std::pair<std::string, size_t>> layer_blocks;
+	size_t mem_pos = 0;
+	while (mem_pos < size) {
+		const size_t layer_size = this->getLayerBlockSize(data + mem_pos, size - mem_pos, destination->get_voxel_count());
+		const FiledTypes::V1::VoxelGridLayerHeader& layer_desc = *(const FiledTypes::V1::VoxelGridLayerHeader*)(data + mem_pos + sizeof(FiledTypes::V2::LayerCodecHeader));
+		layer_blocks.push_back(std::make_pair(std::string(layer_desc.name), mem_pos));
+		mem_pos += layer_size;
+	}
+
+	std::vector<VoxelLayer*> layers(layer_blocks.size(), nullptr);
+
+	// decoding is the expensive part, so the layers are deserialized on multiple threads
+	try {
+		VoxelBuffer::parallel_for(layer_blocks.size(), VoxelBuffer::get_worker_count(), [&](size_t i) {
+			char* layer_data = data + layer_blocks[i].second;
+			const size_t layer_size = ((i + 1 < layer_blocks.size()) ? layer_blocks[i + 1].second : mem_pos) - layer_blocks[i].second;
+			if (data_owner != nullptr && this->isLayerRaw(layer_data))
+				layers[i] = this->deserializeLayerView(layer_data, layer_size, data_owner);
+			else
+				layers[i] = this->deserializeLayer(layer_data, layer_size);
+		});
+	}
+	catch (...) {
+		for (VoxelLayer* layer : layers)
+			delete layer;
+		throw;
+	}
+
+	for (size_t i = 0; i < layer_blocks.size(); i++) {
+		try {
+			destination->insert_layer(layer_blocks[i].first, layers[i]);
+		}
+		catch (...) {
+			for (size_t j = i + 1; j < layers.size(); j++)
+				delete layers[j];
+			throw;
+		}
+	}
+
+	return destination;
+}
+
+std::shared_ptr<VoxelBuffer> RadFiled3D::Storage::V2::BinayFieldBlockHandler::deserializeChannel(std::shared_ptr<VoxelBuffer> destination, char* data, size_t size) const
+{
+	return this->deserializeLayers(destination, data, size, nullptr);
+}
+
+std::shared_ptr<VoxelBuffer> RadFiled3D::Storage::V2::BinayFieldBlockHandler::deserializeChannelView(std::shared_ptr<VoxelBuffer> destination, char* data, size_t size, std::shared_ptr<void> data_owner) const
+{
+	return this->deserializeLayers(destination, data, size, data_owner);
+}
+
+size_t RadFiled3D::Storage::V2::BinayFieldBlockHandler::getLayerCodecHeaderSize() const
+{
+	return sizeof(FiledTypes::V2::LayerCodecHeader);
+}
+
+bool RadFiled3D::Storage::V2::BinayFieldBlockHandler::isLayerRaw(const char* layer_data) const
+{
+	const FiledTypes::V2::LayerCodecHeader& codec_desc = *(const FiledTypes::V2::LayerCodecHeader*)(layer_data);
+	return static_cast<LayerCodec>(codec_desc.codec) == LayerCodec::Raw && codec_desc.brick_size == 0;
+}
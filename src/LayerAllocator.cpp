@@ -0,0 +1,164 @@
+#include "RadFiled3D/helpers/LayerAllocator.hpp"
+#include <new>
+#include <stdexcept>
+#include <string>
+#if defined __linux__
+    #include <sys/mman.h>
+#endif
+
+
+using namespace RadFiled3D;
+
+
+namespace {
+    std::mutex default_allocator_mutex;
+
+    std::shared_ptr<ILayerAllocator>& default_allocator() {
+        static std::shared_ptr<ILayerAllocator> allocator = std::make_shared<AlignedLayerAllocator>();
+        return allocator;
+    }
+}
+
+std::shared_ptr<ILayerAllocator> ILayerAllocator::get_default()
+{
+    std::lock_guard<std::mutex> lock(default_allocator_mutex);
+    return default_allocator();
+}
+
+void ILayerAllocator::set_default(std::shared_ptr<ILayerAllocator> allocator)
+{
+    if (allocator == nullptr)
+        allocator = std::make_shared<AlignedLayerAllocator>();
+    std::lock_guard<std::mutex> lock(default_allocator_mutex);
+    default_allocator() = allocator;
+}
+
+AlignedLayerAllocator::AlignedLayerAllocator(size_t alignment)
+    : alignment(alignment)
+{
+    if (alignment == 0 || (alignment & (alignment - 1)) != 0)
+        throw std::invalid_argument("Alignment must be a power of two, but was " + std::to_string(alignment));
+}
+
+char* AlignedLayerAllocator::allocate(size_t bytes)
+{
+    if (bytes == 0)
+        return nullptr;
+    return static_cast<char*>(::operator new[](bytes, std::align_val_t(this->alignment)));
+}
+
+void AlignedLayerAllocator::deallocate(char* buffer, size_t /*bytes*/) noexcept
+{
+    if (buffer != nullptr)
+        ::operator delete[](buffer, std::align_val_t(this->alignment));
+}
+
+HugePageLayerAllocator::HugePageLayerAllocator()
+    : AlignedLayerAllocator(AlignedLayerAllocator::DEFAULT_ALIGNMENT)
+{
+}
+
+char* HugePageLayerAllocator::allocate(size_t bytes)
+{
+    if (bytes < HUGE_PAGE_BYTES)
+        return AlignedLayerAllocator::allocate(bytes);
+
+    // whole huge pages only, so that the tail of the buffer can be backed by a huge page as well
+    const size_t huge_bytes = (bytes + HUGE_PAGE_BYTES - 1) / HUGE_PAGE_BYTES * HUGE_PAGE_BYTES;
+    char* buffer = static_cast<char*>(::operator new[](huge_bytes, std::align_val_t(HUGE_PAGE_BYTES)));
+#if defined __linux__ && defined MADV_HUGEPAGE
+    // only a hint, the buffer is usable regardless of the kernel configuration
+    madvise(buffer, huge_bytes, MADV_HUGEPAGE);
+#endif
+    return buffer;
+}
+
+void HugePageLayerAllocator::deallocate(char* buffer, size_t bytes) noexcept
+{
+    if (bytes < HUGE_PAGE_BYTES) {
+        AlignedLayerAllocator::deallocate(buffer, bytes);
+        return;
+    }
+    if (buffer != nullptr)
+        ::operator delete[](buffer, std::align_val_t(HUGE_PAGE_BYTES));
+}
+
+ArenaLayerAllocator::ArenaLayerAllocator(std::shared_ptr<ILayerAllocator> upstream, size_t max_cached_bytes)
+    : upstream(upstream), max_cached_bytes(max_cached_bytes)
+{
+    if (this->upstream == nullptr)
+        throw std::invalid_argument("The upstream allocator of an arena must not be null");
+}
+
+ArenaLayerAllocator::~ArenaLayerAllocator()
+{
+    this->release();
+}
+
+char* ArenaLayerAllocator::allocate(size_t bytes)
+{
+    if (bytes == 0)
+        return nullptr;
+
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        auto found = this->free_buffers.find(bytes);
+        if (found != this->free_buffers.end() && !found->second.empty()) {
+            char* buffer = found->second.back();
+            found->second.pop_back();
+            this->cached_bytes -= bytes;
+            this->reuse_count++;
+            return buffer;
+        }
+    }
+
+    return this->upstream->allocate(bytes);
+}
+
+void ArenaLayerAllocator::deallocate(char* buffer, size_t bytes) noexcept
+{
+    if (buffer == nullptr)
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        if (bytes <= this->max_cached_bytes - this->cached_bytes) {
+            try {
+                this->free_buffers[bytes].push_back(buffer);
+                this->cached_bytes += bytes;
+                return;
+            }
+            catch (const std::bad_alloc&) {
+                // not enough memory to keep track of the buffer, so it is returned instead
+            }
+        }
+    }
+
+    this->upstream->deallocate(buffer, bytes);
+}
+
+void ArenaLayerAllocator::release()
+{
+    std::map<size_t, std::vector<char*>> buffers;
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        buffers.swap(this->free_buffers);
+        this->cached_bytes = 0;
+    }
+
+    for (auto& sized_buffers : buffers)
+        for (char* buffer : sized_buffers.second)
+            this->upstream->deallocate(buffer, sized_buffers.first);
+}
+
+size_t ArenaLayerAllocator::get_cached_bytes() const
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->cached_bytes;
+}
+
+size_t ArenaLayerAllocator::get_reuse_count() const
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->reuse_count;
+}
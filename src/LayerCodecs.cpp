@@ -0,0 +1,286 @@
+#include "RadFiled3D/storage/LayerCodecs.hpp"
+#include <cstring>
+
+
+using namespace RadFiled3D;
+using namespace RadFiled3D::Storage;
+
+namespace {
+	// Runs shorter than this are cheaper to store as literals
+	constexpr size_t MIN_RUN_LENGTH = 3;
+
+	void write_varint(std::vector<char>& out, size_t value) {
+		while (value >= 0x80) {
+			out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+			value >>= 7;
+		}
+		out.push_back(static_cast<char>(value));
+	}
+
+	size_t read_varint(const char* data, size_t size, size_t& pos) {
+		size_t value = 0;
+		size_t shift = 0;
+		while (pos < size && shift < sizeof(size_t) * 8) {
+			const uint8_t byte = static_cast<uint8_t>(data[pos++]);
+			value |= static_cast<size_t>(byte & 0x7F) << shift;
+			if ((byte & 0x80) == 0)
+				return value;
+			shift += 7;
+		}
+		throw RadiationFieldStoreException("Corrupted run length encoded data");
+	}
+
+	void write_literals(std::vector<char>& out, const char* data, size_t count) {
+		if (count == 0)
+			return;
+		write_varint(out, (count - 1) << 1);
+		out.insert(out.end(), data, data + count);
+	}
+}
+
+BrickLayout::BrickLayout(const glm::uvec3& voxel_counts, uint32_t brick_size)
+	: voxel_counts(voxel_counts),
+	  brick_size(brick_size)
+{
+	if (brick_size == 0)
+		throw RadiationFieldStoreException("Brick size must be greater than 0");
+	this->bricks_counts = (voxel_counts + glm::uvec3(brick_size - 1)) / glm::uvec3(brick_size);
+}
+
+glm::uvec3 BrickLayout::get_brick_min(size_t brick_idx) const
+{
+	const size_t bricks_per_slice = static_cast<size_t>(this->bricks_counts.x) * this->bricks_counts.y;
+	const size_t z = brick_idx / bricks_per_slice;
+	const size_t y = (brick_idx - z * bricks_per_slice) / this->bricks_counts.x;
+	const size_t x = brick_idx - z * bricks_per_slice - y * this->bricks_counts.x;
+	return glm::uvec3(x, y, z) * this->brick_size;
+}
+
+glm::uvec3 BrickLayout::get_brick_max(size_t brick_idx) const
+{
+	return glm::min(this->get_brick_min(brick_idx) + glm::uvec3(this->brick_size), this->voxel_counts);
+}
+
+size_t BrickLayout::get_brick_voxel_count(size_t brick_idx) const
+{
+	const glm::uvec3 extent = this->get_brick_max(brick_idx) - this->get_brick_min(brick_idx);
+	return static_cast<size_t>(extent.x) * extent.y * extent.z;
+}
+
+std::vector<size_t> BrickLayout::get_bricks_in_region(const glm::uvec3& region_min, const glm::uvec3& region_max) const
+{
+	std::vector<size_t> bricks;
+	if (glm::any(glm::greaterThanEqual(region_min, region_max)))
+		return bricks;
+
+	const glm::uvec3 first = region_min / this->brick_size;
+	const glm::uvec3 last = (region_max - glm::uvec3(1)) / this->brick_size;
+	for (size_t z = first.z; z <= last.z; z++)
+		for (size_t y = first.y; y <= last.y; y++)
+			for (size_t x = first.x; x <= last.x; x++)
+				bricks.push_back((z * this->bricks_counts.y + y) * this->bricks_counts.x + x);
+
+	return bricks;
+}
+
+void BrickLayout::gather(const char* layer_data, size_t voxel_bytes, size_t brick_idx, char* destination) const
+{
+	const glm::uvec3 brick_min = this->get_brick_min(brick_idx);
+	const glm::uvec3 brick_max = this->get_brick_max(brick_idx);
+	const size_t row_bytes = (brick_max.x - brick_min.x) * voxel_bytes;
+
+	for (size_t z = brick_min.z; z < brick_max.z; z++) {
+		for (size_t y = brick_min.y; y < brick_max.y; y++) {
+			const size_t layer_idx = (z * this->voxel_counts.y + y) * this->voxel_counts.x + brick_min.x;
+			memcpy(destination, layer_data + layer_idx * voxel_bytes, row_bytes);
+			destination += row_bytes;
+		}
+	}
+}
+
+void BrickLayout::scatter(const char* brick_data, size_t voxel_bytes, size_t brick_idx, char* region_data, const glm::uvec3& region_min, const glm::uvec3& region_max) const
+{
+	const glm::uvec3 brick_min = this->get_brick_min(brick_idx);
+	const glm::uvec3 brick_max = this->get_brick_max(brick_idx);
+	const glm::uvec3 copy_min = glm::max(brick_min, region_min);
+	const glm::uvec3 copy_max = glm::min(brick_max, region_max);
+	if (glm::any(glm::greaterThanEqual(copy_min, copy_max)))
+		return;
+
+	const glm::uvec3 brick_extent = brick_max - brick_min;
+	const glm::uvec3 region_extent = region_max - region_min;
+	const size_t row_bytes = (copy_max.x - copy_min.x) * voxel_bytes;
+
+	for (size_t z = copy_min.z; z < copy_max.z; z++) {
+		for (size_t y = copy_min.y; y < copy_max.y; y++) {
+			const size_t brick_voxel_idx = ((z - brick_min.z) * brick_extent.y + (y - brick_min.y)) * brick_extent.x + (copy_min.x - brick_min.x);
+			const size_t region_voxel_idx = ((z - region_min.z) * region_extent.y + (y - region_min.y)) * region_extent.x + (copy_min.x - region_min.x);
+			memcpy(region_data + region_voxel_idx * voxel_bytes, brick_data + brick_voxel_idx * voxel_bytes, row_bytes);
+		}
+	}
+}
+
+std::vector<char> LayerCodecs::Encode(LayerCodec codec, const char* data, size_t size, size_t element_bytes)
+{
+	switch (codec) {
+	case LayerCodec::Raw:
+		return std::vector<char>(data, data + size);
+	case LayerCodec::ShuffleRLE:
+	{
+		std::vector<char> shuffled(size);
+		LayerCodecs::Shuffle(data, size, element_bytes, shuffled.data());
+		return LayerCodecs::EncodeRLE(shuffled.data(), size);
+	}
+	default:
+		throw RadiationFieldStoreException("Unknown layer codec: " + std::to_string(static_cast<uint32_t>(codec)));
+	}
+}
+
+void LayerCodecs::Decode(LayerCodec codec, const char* data, size_t size, char* destination, size_t destination_size, size_t element_bytes)
+{
+	switch (codec) {
+	case LayerCodec::Raw:
+		if (size != destination_size)
+			throw RadiationFieldStoreException("Raw layer data does not match the expected size");
+		memcpy(destination, data, size);
+		break;
+	case LayerCodec::ShuffleRLE:
+	{
+		std::vector<char> shuffled(destination_size);
+		LayerCodecs::DecodeRLE(data, size, shuffled.data(), destination_size);
+		LayerCodecs::Unshuffle(shuffled.data(), destination_size, element_bytes, destination);
+		break;
+	}
+	default:
+		throw RadiationFieldStoreException("Unknown layer codec: " + std::to_string(static_cast<uint32_t>(codec)));
+	}
+}
+
+std::vector<char> LayerCodecs::EncodeBricks(LayerCodec codec, const char* data, size_t voxel_bytes, size_t element_bytes, const BrickLayout& layout)
+{
+	const size_t brick_count = layout.get_brick_count();
+	const size_t table_bytes = sizeof(FiledTypes::V2::BrickTableHeader) + (brick_count + 1) * sizeof(size_t);
+
+	std::vector<char> out(table_bytes);
+	FiledTypes::V2::BrickTableHeader table_desc;
+	table_desc.voxel_counts = layout.get_voxel_counts();
+	std::vector<size_t> offsets(brick_count + 1, 0);
+
+	std::vector<char> brick;
+	for (size_t i = 0; i < brick_count; i++) {
+		brick.resize(layout.get_brick_voxel_count(i) * voxel_bytes);
+		layout.gather(data, voxel_bytes, i, brick.data());
+
+		offsets[i] = out.size() - table_bytes;
+		std::vector<char> encoded_brick;
+		if (codec != LayerCodec::Raw)
+			encoded_brick = LayerCodecs::Encode(codec, brick.data(), brick.size(), element_bytes);
+		// DecodeBrick identifies raw bricks by their size, so encoded bricks must be strictly smaller
+		if (codec != LayerCodec::Raw && encoded_brick.size() < brick.size())
+			out.insert(out.end(), encoded_brick.begin(), encoded_brick.end());
+		else
+			out.insert(out.end(), brick.begin(), brick.end());
+	}
+	offsets[brick_count] = out.size() - table_bytes;
+
+	memcpy(out.data(), &table_desc, sizeof(FiledTypes::V2::BrickTableHeader));
+	memcpy(out.data() + sizeof(FiledTypes::V2::BrickTableHeader), offsets.data(), offsets.size() * sizeof(size_t));
+
+	return out;
+}
+
+void LayerCodecs::DecodeBrick(LayerCodec codec, const char* data, size_t size, char* destination, size_t destination_size, size_t element_bytes)
+{
+	if (size == destination_size)
+		memcpy(destination, data, size);
+	else
+		LayerCodecs::Decode(codec, data, size, destination, destination_size, element_bytes);
+}
+
+void LayerCodecs::Shuffle(const char* data, size_t size, size_t element_bytes, char* destination)
+{
+	if (element_bytes <= 1) {
+		memcpy(destination, data, size);
+		return;
+	}
+
+	const size_t element_count = size / element_bytes;
+	for (size_t b = 0; b < element_bytes; b++) {
+		char* dest = destination + b * element_count;
+		for (size_t i = 0; i < element_count; i++)
+			dest[i] = data[i * element_bytes + b];
+	}
+	// bytes not forming a whole element are kept at the end
+	const size_t tail = element_count * element_bytes;
+	memcpy(destination + tail, data + tail, size - tail);
+}
+
+void LayerCodecs::Unshuffle(const char* data, size_t size, size_t element_bytes, char* destination)
+{
+	if (element_bytes <= 1) {
+		memcpy(destination, data, size);
+		return;
+	}
+
+	const size_t element_count = size / element_bytes;
+	for (size_t b = 0; b < element_bytes; b++) {
+		const char* src = data + b * element_count;
+		for (size_t i = 0; i < element_count; i++)
+			destination[i * element_bytes + b] = src[i];
+	}
+	const size_t tail = element_count * element_bytes;
+	memcpy(destination + tail, data + tail, size - tail);
+}
+
+std::vector<char> LayerCodecs::EncodeRLE(const char* data, size_t size)
+{
+	std::vector<char> out;
+	out.reserve(size / 4 + 16);
+
+	size_t literal_start = 0;
+	size_t pos = 0;
+	while (pos < size) {
+		size_t run_end = pos + 1;
+		while (run_end < size && data[run_end] == data[pos])
+			run_end++;
+
+		const size_t run_length = run_end - pos;
+		if (run_length >= MIN_RUN_LENGTH) {
+			write_literals(out, data + literal_start, pos - literal_start);
+			write_varint(out, ((run_length - MIN_RUN_LENGTH) << 1) | 1);
+			out.push_back(data[pos]);
+			literal_start = run_end;
+		}
+		pos = run_end;
+	}
+	write_literals(out, data + literal_start, size - literal_start);
+
+	return out;
+}
+
+void LayerCodecs::DecodeRLE(const char* data, size_t size, char* destination, size_t destination_size)
+{
+	size_t pos = 0;
+	size_t out_pos = 0;
+	while (pos < size) {
+		const size_t token = read_varint(data, size, pos);
+		if (token & 1) {
+			const size_t run_length = (token >> 1) + MIN_RUN_LENGTH;
+			if (pos >= size || run_length > destination_size - out_pos)
+				throw RadiationFieldStoreException("Corrupted run length encoded data");
+			memset(destination + out_pos, data[pos++], run_length);
+			out_pos += run_length;
+		}
+		else {
+			const size_t literal_length = (token >> 1) + 1;
+			if (literal_length > size - pos || literal_length > destination_size - out_pos)
+				throw RadiationFieldStoreException("Corrupted run length encoded data");
+			memcpy(destination + out_pos, data + pos, literal_length);
+			pos += literal_length;
+			out_pos += literal_length;
+		}
+	}
+
+	if (out_pos != destination_size)
+		throw RadiationFieldStoreException("Run length encoded data does not match the expected size");
+}
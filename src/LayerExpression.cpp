@@ -0,0 +1,388 @@
+#include "RadFiled3D/LayerExpression.hpp"
+#include "RadFiled3D/helpers/Typing.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <sstream>
+#include <vector>
+
+
+using namespace RadFiled3D;
+
+
+struct LayerExpression::Node {
+	enum class Kind {
+		Layer,
+		Buffer,
+		Constant,
+		Operation
+	};
+
+	Kind kind = Kind::Constant;
+	Kernels::Operation op = Kernels::Operation::Add;
+	std::shared_ptr<const Node> lhs;
+	std::shared_ptr<const Node> rhs;
+	const VoxelBuffer* buffer = nullptr;
+	std::string layer_name;
+	double value = 0.0;
+};
+
+namespace {
+	/** The number of elements computed at once per node of an expression. Small enough for the scratch buffers of all nodes to stay in the L1 or L2 cache. */
+	constexpr size_t TILE_ELEMENTS = 1024;
+
+	/** A single step of a flattened expression. All steps write into their slot of the scratch buffer, operations into the slot of their left operand. */
+	struct Step {
+		LayerExpression::Node::Kind kind;
+		Kernels::Operation op;
+		size_t slot;
+		size_t rhs_slot;
+		const char* data;
+		Typing::DType dtype;
+		size_t layer_components;
+		double value;
+	};
+
+	/** An expression resolved against a destination layer */
+	struct Plan {
+		char* destination = nullptr;
+		Typing::DType destination_dtype = Typing::DType::Float;
+		size_t voxel_count = 0;
+		size_t components = 1;
+		size_t bytes_per_voxel = 0;
+		size_t slots = 0;
+		size_t result_slot = 0;
+		bool double_precision = false;
+		std::vector<Step> steps;
+	};
+
+	/** Returns the number of bytes of a single component of a layer */
+	size_t get_component_bytes(Typing::DType dtype)
+	{
+		switch (dtype)
+		{
+		case Typing::DType::Double:
+		case Typing::DType::UInt64:
+			return 8;
+		case Typing::DType::Char:
+			return 1;
+		default:
+			return 4;
+		}
+	}
+
+	// floats only represent integers up to 2^24 exactly, so layers of 32 bit and 64 bit integers are computed in double precision as well
+	bool needs_double_precision(Typing::DType dtype)
+	{
+		return dtype == Typing::DType::Double || dtype == Typing::DType::UInt64 || dtype == Typing::DType::UInt32 || dtype == Typing::DType::Int;
+	}
+
+	size_t flatten(const LayerExpression::Node& node, const VoxelBuffer& target, const std::string& layer_name, Plan& plan)
+	{
+		using Kind = LayerExpression::Node::Kind;
+
+		switch (node.kind)
+		{
+		case Kind::Layer:
+		case Kind::Buffer:
+		{
+			const std::string& name = (node.kind == Kind::Layer) ? node.layer_name : layer_name;
+			if (node.buffer->get_voxel_count() != plan.voxel_count)
+				throw VoxelBufferException("Layer: '" + name + "' has " + std::to_string(node.buffer->get_voxel_count()) + " voxels, but the destination has " + std::to_string(plan.voxel_count));
+			const VoxelLayer& layer = node.buffer->get_layer(name);
+			const Typing::DType dtype = Typing::Helper::get_dtype(node.buffer->get_type(name));
+			const size_t layer_components = layer.get_bytes_per_voxel_data() / get_component_bytes(dtype);
+			if (layer_components != plan.components && layer_components != 1)
+				throw VoxelBufferException("Layer: '" + name + "' has " + std::to_string(layer_components) + " components per voxel, but the destination has " + std::to_string(plan.components));
+			plan.double_precision |= needs_double_precision(dtype);
+			plan.bytes_per_voxel += layer.get_bytes_per_voxel_data();
+			plan.steps.push_back(Step{ node.kind, Kernels::Operation::Add, plan.slots, 0, layer.get_raw_data(), dtype, layer_components, 0.0 });
+			return plan.slots++;
+		}
+		case Kind::Constant:
+			plan.steps.push_back(Step{ node.kind, Kernels::Operation::Add, plan.slots, 0, nullptr, Typing::DType::Double, 1, node.value });
+			return plan.slots++;
+		case Kind::Operation:
+		default:
+		{
+			const size_t lhs_slot = flatten(*node.lhs, target, layer_name, plan);
+			const size_t rhs_slot = flatten(*node.rhs, target, layer_name, plan);
+			plan.steps.push_back(Step{ node.kind, node.op, lhs_slot, rhs_slot, nullptr, Typing::DType::Double, 1, 0.0 });
+			return lhs_slot;
+		}
+		}
+	}
+
+	template<typename T, typename S>
+	void load_components(T* out, const S* data, size_t first_voxel, size_t voxels, size_t layer_components, size_t components)
+	{
+		if (layer_components == components) {
+			data += first_voxel * components;
+			for (size_t i = 0; i < voxels * components; i++)
+				out[i] = static_cast<T>(data[i]);
+		}
+		else {
+			// a single component per voxel is used for all components of the destination
+			for (size_t v = 0; v < voxels; v++)
+				std::fill(out + v * components, out + (v + 1) * components, static_cast<T>(data[first_voxel + v]));
+		}
+	}
+
+	template<typename T>
+	void load(T* out, const Step& step, size_t first_voxel, size_t voxels, size_t components)
+	{
+		switch (step.dtype)
+		{
+		case Typing::DType::Float:
+		case Typing::DType::Vec2:
+		case Typing::DType::Vec3:
+		case Typing::DType::Vec4:
+		case Typing::DType::Hist:
+			load_components(out, (const float*)step.data, first_voxel, voxels, step.layer_components, components);
+			break;
+		case Typing::DType::Double:
+			load_components(out, (const double*)step.data, first_voxel, voxels, step.layer_components, components);
+			break;
+		case Typing::DType::Int:
+			load_components(out, (const int32_t*)step.data, first_voxel, voxels, step.layer_components, components);
+			break;
+		case Typing::DType::Char:
+			load_components(out, step.data, first_voxel, voxels, step.layer_components, components);
+			break;
+		case Typing::DType::UInt64:
+			load_components(out, (const uint64_t*)step.data, first_voxel, voxels, step.layer_components, components);
+			break;
+		case Typing::DType::UInt32:
+			load_components(out, (const uint32_t*)step.data, first_voxel, voxels, step.layer_components, components);
+			break;
+		}
+	}
+
+	template<typename S, typename T>
+	void store_components(S* destination, const T* values, size_t count)
+	{
+		for (size_t i = 0; i < count; i++)
+			destination[i] = static_cast<S>(values[i]);
+	}
+
+	template<typename T>
+	void store(const Plan& plan, const T* values, size_t first_voxel, size_t voxels)
+	{
+		const size_t first = first_voxel * plan.components;
+		const size_t count = voxels * plan.components;
+		switch (plan.destination_dtype)
+		{
+		case Typing::DType::Float:
+		case Typing::DType::Vec2:
+		case Typing::DType::Vec3:
+		case Typing::DType::Vec4:
+		case Typing::DType::Hist:
+			store_components((float*)plan.destination + first, values, count);
+			break;
+		case Typing::DType::Double:
+			store_components((double*)plan.destination + first, values, count);
+			break;
+		case Typing::DType::Int:
+			store_components((int32_t*)plan.destination + first, values, count);
+			break;
+		case Typing::DType::Char:
+			store_components(plan.destination + first, values, count);
+			break;
+		case Typing::DType::UInt64:
+			store_components((uint64_t*)plan.destination + first, values, count);
+			break;
+		case Typing::DType::UInt32:
+			store_components((uint32_t*)plan.destination + first, values, count);
+			break;
+		}
+	}
+
+	/** Computes the voxels [begin, end) of a plan tile by tile */
+	template<typename T>
+	void run(const Plan& plan, size_t begin, size_t end)
+	{
+		const size_t tile_voxels = std::max<size_t>(TILE_ELEMENTS / plan.components, 1);
+		const size_t tile_elements = tile_voxels * plan.components;
+		std::vector<T> scratch(plan.slots * tile_elements);
+
+		for (size_t first_voxel = begin; first_voxel < end; first_voxel += tile_voxels) {
+			const size_t voxels = std::min(tile_voxels, end - first_voxel);
+			const size_t elements = voxels * plan.components;
+			for (const Step& step : plan.steps) {
+				T* out = scratch.data() + step.slot * tile_elements;
+				switch (step.kind)
+				{
+				case LayerExpression::Node::Kind::Layer:
+				case LayerExpression::Node::Kind::Buffer:
+					load(out, step, first_voxel, voxels, plan.components);
+					break;
+				case LayerExpression::Node::Kind::Constant:
+					std::fill(out, out + elements, static_cast<T>(step.value));
+					break;
+				case LayerExpression::Node::Kind::Operation:
+					Kernels::apply(step.op, out, scratch.data() + step.rhs_slot * tile_elements, elements);
+					break;
+				}
+			}
+			store(plan, scratch.data() + plan.result_slot * tile_elements, first_voxel, voxels);
+		}
+	}
+
+	std::string to_string(const LayerExpression::Node& node)
+	{
+		using Kind = LayerExpression::Node::Kind;
+
+		switch (node.kind)
+		{
+		case Kind::Layer:
+			return node.layer_name;
+		case Kind::Buffer:
+			return "<buffer>";
+		case Kind::Constant:
+		{
+			std::ostringstream value;
+			value << node.value;
+			return value.str();
+		}
+		case Kind::Operation:
+		default:
+			switch (node.op)
+			{
+			case Kernels::Operation::Add:
+				return "(" + to_string(*node.lhs) + " + " + to_string(*node.rhs) + ")";
+			case Kernels::Operation::Subtract:
+				return "(" + to_string(*node.lhs) + " - " + to_string(*node.rhs) + ")";
+			case Kernels::Operation::Multiply:
+				return "(" + to_string(*node.lhs) + " * " + to_string(*node.rhs) + ")";
+			case Kernels::Operation::Divide:
+				return "(" + to_string(*node.lhs) + " / " + to_string(*node.rhs) + ")";
+			case Kernels::Operation::DivideOrZero:
+			default:
+				return "divide_or_zero(" + to_string(*node.lhs) + ", " + to_string(*node.rhs) + ")";
+			}
+		}
+	}
+}
+
+LayerExpression::LayerExpression(double value)
+	: LayerExpression(LayerExpression::constant(value))
+{
+}
+
+LayerExpression::LayerExpression(std::shared_ptr<const Node> root)
+	: root(root)
+{
+}
+
+LayerExpression LayerExpression::layer(const VoxelBuffer& buffer, const std::string& layer_name)
+{
+	// fail early, if the layer does not exist
+	buffer.get_layer(layer_name);
+
+	std::shared_ptr<Node> node = std::make_shared<Node>();
+	node->kind = Node::Kind::Layer;
+	node->buffer = &buffer;
+	node->layer_name = layer_name;
+	return LayerExpression(std::shared_ptr<const Node>(node));
+}
+
+LayerExpression LayerExpression::buffer(const VoxelBuffer& buffer)
+{
+	std::shared_ptr<Node> node = std::make_shared<Node>();
+	node->kind = Node::Kind::Buffer;
+	node->buffer = &buffer;
+	return LayerExpression(std::shared_ptr<const Node>(node));
+}
+
+LayerExpression LayerExpression::constant(double value)
+{
+	std::shared_ptr<Node> node = std::make_shared<Node>();
+	node->kind = Node::Kind::Constant;
+	node->value = value;
+	return LayerExpression(std::shared_ptr<const Node>(node));
+}
+
+LayerExpression LayerExpression::combine(Kernels::Operation op, const LayerExpression& lhs, const LayerExpression& rhs)
+{
+	std::shared_ptr<Node> node = std::make_shared<Node>();
+	node->kind = Node::Kind::Operation;
+	node->op = op;
+	node->lhs = lhs.root;
+	node->rhs = rhs.root;
+	return LayerExpression(std::shared_ptr<const Node>(node));
+}
+
+LayerExpression LayerExpression::divide_or_zero(const LayerExpression& dividend, const LayerExpression& divisor)
+{
+	return LayerExpression::combine(Kernels::Operation::DivideOrZero, dividend, divisor);
+}
+
+void LayerExpression::evaluate(VoxelBuffer& target, const std::string& layer_name) const
+{
+	auto found = target.layers.find(layer_name);
+	if (found == target.layers.end())
+		throw VoxelBufferException("Layer: '" + layer_name + "' not found");
+
+	Plan plan;
+	plan.destination = target.get_layer<char>(layer_name);
+	plan.destination_dtype = Typing::Helper::get_dtype(target.get_type(layer_name));
+	plan.voxel_count = target.get_voxel_count();
+	plan.components = std::max<size_t>(found->second.get_bytes_per_voxel_data() / get_component_bytes(plan.destination_dtype), 1);
+	plan.bytes_per_voxel = found->second.get_bytes_per_voxel_data();
+	plan.double_precision = needs_double_precision(plan.destination_dtype);
+	plan.result_slot = flatten(*this->root, target, layer_name, plan);
+
+	// every voxel only depends on the voxels of the same index, so the destination may be an operand as well
+	VoxelBuffer::for_each_chunk(plan.voxel_count, plan.bytes_per_voxel, [&plan](size_t begin, size_t end) {
+		if (plan.double_precision)
+			run<double>(plan, begin, end);
+		else
+			run<float>(plan, begin, end);
+	});
+}
+
+void LayerExpression::evaluate(VoxelBuffer& target) const
+{
+	// validate the expression against all layers first, so that no layer is modified if any does not match
+	for (auto& layer : target.layers) {
+		Plan plan;
+		plan.voxel_count = target.get_voxel_count();
+		plan.components = std::max<size_t>(layer.second.get_bytes_per_voxel_data() / get_component_bytes(Typing::Helper::get_dtype(target.get_type(layer.first))), 1);
+		flatten(*this->root, target, layer.first, plan);
+	}
+
+	for (auto& layer : target.layers)
+		this->evaluate(target, layer.first);
+}
+
+std::string LayerExpression::to_string() const
+{
+	return ::to_string(*this->root);
+}
+
+namespace RadFiled3D {
+	LayerExpression operator +(const LayerExpression& lhs, const LayerExpression& rhs)
+	{
+		return LayerExpression::combine(Kernels::Operation::Add, lhs, rhs);
+	}
+
+	LayerExpression operator -(const LayerExpression& lhs, const LayerExpression& rhs)
+	{
+		return LayerExpression::combine(Kernels::Operation::Subtract, lhs, rhs);
+	}
+
+	LayerExpression operator *(const LayerExpression& lhs, const LayerExpression& rhs)
+	{
+		return LayerExpression::combine(Kernels::Operation::Multiply, lhs, rhs);
+	}
+
+	LayerExpression operator /(const LayerExpression& lhs, const LayerExpression& rhs)
+	{
+		return LayerExpression::combine(Kernels::Operation::Divide, lhs, rhs);
+	}
+
+	LayerExpression operator -(const LayerExpression& operand)
+	{
+		// multiplying by -1 keeps the sign of zeros correct, in contrast to subtracting from 0
+		return LayerExpression::combine(Kernels::Operation::Multiply, LayerExpression(-1.0), operand);
+	}
+}
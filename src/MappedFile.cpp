@@ -0,0 +1,99 @@
+#include "RadFiled3D/helpers/MappedFile.hpp"
+#if defined _WIN32 || defined _WIN64
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+#endif
+
+
+using namespace RadFiled3D;
+
+
+MappedFile::MappedFile(const std::string& filename)
+{
+#if defined _WIN32 || defined _WIN64
+    hFile = CreateFile(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (hFile == INVALID_HANDLE_VALUE) {
+        throw MappedFileException("Unable to open the file: " + filename);
+    }
+
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(hFile, &file_size) || file_size.QuadPart == 0) {
+        CloseHandle(hFile);
+        throw MappedFileException("Unable to map an empty file: " + filename);
+    }
+    this->mapped_size = static_cast<size_t>(file_size.QuadPart);
+
+    hMapping = CreateFileMapping(hFile, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+    if (hMapping == NULL) {
+        CloseHandle(hFile);
+        throw MappedFileException("Unable to create a file mapping: " + filename);
+    }
+
+    this->mapped_data = (char*)MapViewOfFile(hMapping, FILE_MAP_COPY, 0, 0, 0);
+    if (this->mapped_data == nullptr) {
+        CloseHandle(hMapping);
+        CloseHandle(hFile);
+        throw MappedFileException("Unable to map the file: " + filename);
+    }
+#else
+    fd = open(filename.c_str(), O_RDONLY);
+    if (fd == -1) {
+        throw MappedFileException("Unable to open the file: " + filename);
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) == -1 || st.st_size == 0) {
+        close(fd);
+        throw MappedFileException("Unable to map an empty file: " + filename);
+    }
+    this->mapped_size = static_cast<size_t>(st.st_size);
+
+    void* mapping = mmap(nullptr, this->mapped_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    if (mapping == MAP_FAILED) {
+        close(fd);
+        throw MappedFileException("Unable to map the file: " + filename);
+    }
+    this->mapped_data = (char*)mapping;
+#endif
+}
+
+MappedFile::MappedFile(std::shared_ptr<MappedFile> parent, size_t offset, size_t size)
+    : parent(parent)
+{
+    if (offset > parent->size() || size > parent->size() - offset) {
+        throw MappedFileException("Range exceeds the mapping");
+    }
+    this->mapped_data = parent->data() + offset;
+    this->mapped_size = size;
+}
+
+MappedFile::~MappedFile()
+{
+    // a range of another mapping is released together with the parent
+    if (this->parent != nullptr) {
+        return;
+    }
+
+#if defined _WIN32 || defined _WIN64
+    if (this->mapped_data != nullptr) {
+        UnmapViewOfFile(this->mapped_data);
+    }
+    if (hMapping != nullptr) {
+        CloseHandle(hMapping);
+    }
+    if (hFile != (void*)-1) {
+        CloseHandle(hFile);
+    }
+#else
+    if (this->mapped_data != nullptr) {
+        munmap(this->mapped_data, this->mapped_size);
+    }
+    if (fd != -1) {
+        close(fd);
+    }
+#endif
+}
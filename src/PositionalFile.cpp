@@ -0,0 +1,122 @@
+#include "RadFiled3D/helpers/PositionalFile.hpp"
+#if defined _WIN32 || defined _WIN64
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/stat.h>
+    #include <cerrno>
+#endif
+
+
+using namespace RadFiled3D;
+
+
+PositionalFile::PositionalFile(const std::string& filename, bool writable)
+    : writable(writable)
+{
+#if defined _WIN32 || defined _WIN64
+    hFile = CreateFile(filename.c_str(), writable ? (GENERIC_READ | GENERIC_WRITE) : GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, NULL);
+    if (hFile == INVALID_HANDLE_VALUE) {
+        throw PositionalFileException("Unable to open the file: " + filename);
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(hFile, &size)) {
+        CloseHandle(hFile);
+        throw PositionalFileException("Unable to determine the size of the file: " + filename);
+    }
+    this->file_size = static_cast<size_t>(size.QuadPart);
+#else
+    fd = open(filename.c_str(), writable ? O_RDWR : O_RDONLY);
+    if (fd == -1) {
+        throw PositionalFileException("Unable to open the file: " + filename);
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) == -1) {
+        close(fd);
+        throw PositionalFileException("Unable to determine the size of the file: " + filename);
+    }
+    this->file_size = static_cast<size_t>(st.st_size);
+#endif
+}
+
+PositionalFile::~PositionalFile()
+{
+#if defined _WIN32 || defined _WIN64
+    if (hFile != (void*)-1) {
+        CloseHandle(hFile);
+    }
+#else
+    if (fd != -1) {
+        close(fd);
+    }
+#endif
+}
+
+void PositionalFile::read(size_t offset, char* destination, size_t size) const
+{
+    if (offset > this->file_size || size > this->file_size - offset) {
+        throw PositionalFileException("Block exceeds the file");
+    }
+
+    while (size > 0) {
+#if defined _WIN32 || defined _WIN64
+        // an OVERLAPPED offset makes ReadFile independent of the file pointer of the handle
+        OVERLAPPED overlapped = {};
+        overlapped.Offset = static_cast<DWORD>(offset & 0xFFFFFFFF);
+        overlapped.OffsetHigh = static_cast<DWORD>(static_cast<uint64_t>(offset) >> 32);
+        DWORD bytes_read = 0;
+        const DWORD chunk = static_cast<DWORD>((size > 0x40000000) ? 0x40000000 : size);
+        if (!ReadFile(hFile, destination, chunk, &bytes_read, &overlapped) || bytes_read == 0) {
+            throw PositionalFileException("Unable to read from the file");
+        }
+#else
+        const ssize_t bytes_read = pread(fd, destination, size, static_cast<off_t>(offset));
+        if (bytes_read == -1 && errno == EINTR) {
+            continue;
+        }
+        if (bytes_read <= 0) {
+            throw PositionalFileException("Unable to read from the file");
+        }
+#endif
+        offset += static_cast<size_t>(bytes_read);
+        destination += bytes_read;
+        size -= static_cast<size_t>(bytes_read);
+    }
+}
+
+void PositionalFile::write(size_t offset, const char* source, size_t size) const
+{
+    if (!this->writable) {
+        throw PositionalFileException("File was not opened for writing");
+    }
+    if (offset > this->file_size || size > this->file_size - offset) {
+        throw PositionalFileException("Block exceeds the file");
+    }
+
+    while (size > 0) {
+#if defined _WIN32 || defined _WIN64
+        OVERLAPPED overlapped = {};
+        overlapped.Offset = static_cast<DWORD>(offset & 0xFFFFFFFF);
+        overlapped.OffsetHigh = static_cast<DWORD>(static_cast<uint64_t>(offset) >> 32);
+        DWORD bytes_written = 0;
+        const DWORD chunk = static_cast<DWORD>((size > 0x40000000) ? 0x40000000 : size);
+        if (!WriteFile(hFile, source, chunk, &bytes_written, &overlapped) || bytes_written == 0) {
+            throw PositionalFileException("Unable to write to the file");
+        }
+#else
+        const ssize_t bytes_written = pwrite(fd, source, size, static_cast<off_t>(offset));
+        if (bytes_written == -1 && errno == EINTR) {
+            continue;
+        }
+        if (bytes_written <= 0) {
+            throw PositionalFileException("Unable to write to the file");
+        }
+#endif
+        offset += static_cast<size_t>(bytes_written);
+        source += bytes_written;
+        size -= static_cast<size_t>(bytes_written);
+    }
+}
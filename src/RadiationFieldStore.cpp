@@ -9,6 +9,8 @@
 #include <ios>
 #include <iostream>
 #include <fstream>
+#include <sstream>
+#include <algorithm>
 #if defined _WIN32 || defined _WIN64
 #include <filesystem>
 namespace fs = std::filesystem;
@@ -17,17 +19,337 @@ namespace fs = std::filesystem;
 namespace fs = std::experimental::filesystem;
 #endif
 #include <stdexcept>
+#include <set>
+#include <system_error>
+#include <type_traits>
+#include <thread>
+#include <cmath>
 #include "RadFiled3D/storage/FieldSerializer.hpp"
 #include <RadFiled3D/helpers/FileLock.hpp>
+#include "RadFiled3D/helpers/PositionalFile.hpp"
 
 
 using namespace RadFiled3D;
 using namespace RadFiled3D::Storage::FiledTypes;
 using namespace RadFiled3D::Storage;
 
+namespace {
+	/** Joins a range of elements of the target by the elements of the additional source. Specialized for the join mode at compile time, so the loops get inlined and vectorized.
+	* The arithmetic, including the type promotions of the weighted join, matches the join functions of ExporterHelpers::get_join_function exactly.
+	*/
+	template<FieldJoinMode mode, typename T>
+	void join_elements(T* target, const T* source, size_t count, float ratio, bool divide_by_zero_to_zero)
+	{
+		if constexpr (mode == FieldJoinMode::Add) {
+			Kernels::apply(Kernels::Operation::Add, target, source, count);
+		}
+		else if constexpr (mode == FieldJoinMode::Subtract) {
+			Kernels::apply(Kernels::Operation::Subtract, target, source, count);
+		}
+		else if constexpr (mode == FieldJoinMode::Multiply) {
+			Kernels::apply(Kernels::Operation::Multiply, target, source, count);
+		}
+		else if constexpr (mode == FieldJoinMode::Divide) {
+			Kernels::apply(divide_by_zero_to_zero ? Kernels::Operation::DivideOrZero : Kernels::Operation::Divide, target, source, count);
+		}
+		else if constexpr (mode == FieldJoinMode::Mean) {
+			for (size_t i = 0; i < count; i++)
+				target[i] = (target[i] + source[i]) / static_cast<T>(2);
+		}
+		else if constexpr (mode == FieldJoinMode::AddWeighted) {
+			const float target_ratio = 1.f - ratio;
+			for (size_t i = 0; i < count; i++)
+				target[i] = static_cast<T>((target[i] * target_ratio) + (source[i] * ratio));
+		}
+	}
+
+	/** Calls join(mode, element, divide_by_zero_to_zero) with the element type, a layer of the data type is joined as.
+	* @throws RadiationFieldStoreException if the data type can't be joined
+	*/
+	template<FieldJoinMode mode, typename JoinT>
+	void join_in_mode(Typing::DType dtype, const std::string& layer_name, const JoinT& join)
+	{
+		const std::integral_constant<FieldJoinMode, mode> mode_tag;
+		switch (dtype) {
+			case Typing::DType::Float:
+			case Typing::DType::Vec2:
+			case Typing::DType::Vec3:
+			case Typing::DType::Vec4:
+				// vectors are joined component-wise like by the glm operators
+				join(mode_tag, float(), false);
+				break;
+			case Typing::DType::Hist:
+				// a bin divided by an empty bin is 0, as by HistogramVoxel::operator/=
+				join(mode_tag, float(), true);
+				break;
+			case Typing::DType::Double:
+#if defined(__x86_64__) || defined(_M_X64)
+				join(mode_tag, double(), false);
+#else
+				throw RadiationFieldStoreException("Can't use 64-bit data type in 32-bit system!");
+#endif
+				break;
+			case Typing::DType::Char:
+				throw RadiationFieldStoreException("Unsupported data type 'char' for merging of layer: '" + layer_name + "'");
+			case Typing::DType::Int:
+				join(mode_tag, int32_t(), false);
+				break;
+			case Typing::DType::UInt64:
+#if defined(__x86_64__) || defined(_M_X64)
+				join(mode_tag, uint64_t(), false);
+#else
+				throw RadiationFieldStoreException("Can't use 64-bit data type in 32-bit system!");
+#endif
+				break;
+			case Typing::DType::UInt32:
+				join(mode_tag, uint32_t(), false);
+				break;
+		}
+	}
+
+	/** Dispatches the join mode and the data type of a layer once, so that join is instantiated for each combination of both at compile time
+	* @throws RadiationFieldStoreException if the data type can't be joined or the join mode is unknown
+	*/
+	template<typename JoinT>
+	void join_by_mode(FieldJoinMode mode, Typing::DType dtype, const std::string& layer_name, const JoinT& join)
+	{
+		switch (mode)
+		{
+		case FieldJoinMode::Identity:
+			// the target keeps its values, but the data type still needs to be joinable
+			if (dtype == Typing::DType::Char)
+				throw RadiationFieldStoreException("Unsupported data type 'char' for merging of layer: '" + layer_name + "'");
+			break;
+		case FieldJoinMode::Add:
+			join_in_mode<FieldJoinMode::Add>(dtype, layer_name, join);
+			break;
+		case FieldJoinMode::Mean:
+			join_in_mode<FieldJoinMode::Mean>(dtype, layer_name, join);
+			break;
+		case FieldJoinMode::Subtract:
+			join_in_mode<FieldJoinMode::Subtract>(dtype, layer_name, join);
+			break;
+		case FieldJoinMode::Divide:
+			join_in_mode<FieldJoinMode::Divide>(dtype, layer_name, join);
+			break;
+		case FieldJoinMode::Multiply:
+			join_in_mode<FieldJoinMode::Multiply>(dtype, layer_name, join);
+			break;
+		case FieldJoinMode::AddWeighted:
+			join_in_mode<FieldJoinMode::AddWeighted>(dtype, layer_name, join);
+			break;
+		default:
+			throw RadiationFieldStoreException("Unknown join mode");
+		}
+	}
+}
+
+void ExporterHelpers::join_layer(VoxelBuffer& target, const VoxelBuffer& additional_source, const std::string& layer_name, Typing::DType dtype, FieldJoinMode mode, float ratio)
+{
+	if (mode == FieldJoinMode::Welford) {
+		if (ExporterHelpers::is_welford_dtype(dtype)) {
+			ExporterHelpers::join_layer_welford(target, additional_source, layer_name, dtype);
+			return;
+		}
+		// layers without a mean, e.g. counters, are summed up over all joined fields
+		mode = FieldJoinMode::Add;
+	}
+
+	join_by_mode(mode, dtype, layer_name, [&target, &additional_source, &layer_name, ratio](auto mode_tag, auto element, bool divide_by_zero_to_zero) {
+		using T = decltype(element);
+		target.merge_data_chunks<T>(layer_name, additional_source, [ratio, divide_by_zero_to_zero](T* target_data, const T* source_data, size_t count) {
+			join_elements<decltype(mode_tag)::value, T>(target_data, source_data, count, ratio, divide_by_zero_to_zero);
+		});
+	});
+}
+
+void ExporterHelpers::join_layer_data(char* target, const char* additional_source, size_t bytes, const std::string& layer_name, Typing::DType dtype, FieldJoinMode mode, float ratio)
+{
+	join_by_mode(mode, dtype, layer_name, [target, additional_source, bytes, ratio](auto mode_tag, auto element, bool divide_by_zero_to_zero) {
+		using T = decltype(element);
+		join_elements<decltype(mode_tag)::value, T>((T*)target, (const T*)additional_source, bytes / sizeof(T), ratio, divide_by_zero_to_zero);
+	});
+}
+
+std::string ExporterHelpers::get_welford_value_layer(const std::string& layer_name)
+{
+	for (const std::string suffix : { ExporterHelpers::WELFORD_COUNT_SUFFIX, ExporterHelpers::WELFORD_M2_SUFFIX }) {
+		if (layer_name.size() > suffix.size() && layer_name.compare(layer_name.size() - suffix.size(), suffix.size(), suffix) == 0)
+			return layer_name.substr(0, layer_name.size() - suffix.size());
+	}
+	return "";
+}
+
+bool ExporterHelpers::is_welford_dtype(Typing::DType dtype)
+{
+	switch (dtype) {
+		case Typing::DType::Float:
+		case Typing::DType::Vec2:
+		case Typing::DType::Vec3:
+		case Typing::DType::Vec4:
+		case Typing::DType::Hist:
+		case Typing::DType::Double:
+			return true;
+		default:
+			return false;
+	}
+}
+
+void ExporterHelpers::ensure_welford_layers(VoxelBuffer& buffer, const std::string& layer_name, uint32_t samples)
+{
+	const std::string count_layer = layer_name + ExporterHelpers::WELFORD_COUNT_SUFFIX;
+	const std::string m2_layer = layer_name + ExporterHelpers::WELFORD_M2_SUFFIX;
+	if (!buffer.has_layer(count_layer))
+		buffer.add_layer<uint32_t>(count_layer, samples, "");
+	if (!buffer.has_layer(m2_layer)) {
+		// the deviations take the voxel type of the layer, so histograms keep their bins
+		buffer.add_custom_layer_unsafe(m2_layer, &buffer.get_voxel_flat(layer_name, 0), buffer.get_layer_unit(layer_name) + "^2");
+		std::memset(buffer.get_layer<char>(m2_layer), 0, buffer.get_voxel_count() * buffer.get_layer(m2_layer).get_bytes_per_voxel_data());
+	}
+}
+
+template<typename T>
+void ExporterHelpers::join_layer_welford_as(VoxelBuffer& target, const VoxelBuffer& additional_source, const std::string& layer_name)
+{
+	if (target.get_voxel_count() != additional_source.get_voxel_count() || target.get_layer(layer_name).get_bytes_per_voxel_data() != additional_source.get_layer(layer_name).get_bytes_per_voxel_data())
+		throw RadiationFieldStoreException("Layer: '" + layer_name + "' has different data sizes");
+	ExporterHelpers::ensure_welford_layers(target, layer_name, 1);
+
+	const std::string count_layer = layer_name + ExporterHelpers::WELFORD_COUNT_SUFFIX;
+	const std::string m2_layer = layer_name + ExporterHelpers::WELFORD_M2_SUFFIX;
+	const size_t elements_per_voxel = target.get_layer(layer_name).get_bytes_per_voxel_data() / sizeof(T);
+	T* mean_a = target.get_layer<T>(layer_name);
+	T* m2_a = target.get_layer<T>(m2_layer);
+	uint32_t* count_a = target.get_layer<uint32_t>(count_layer);
+
+	// a source without auxiliary layers is a single sample
+	const bool source_has_samples = additional_source.has_layer(count_layer) && additional_source.has_layer(m2_layer);
+	const T* mean_b = additional_source.get_layer<T>(layer_name);
+	const T* m2_b = source_has_samples ? additional_source.get_layer<T>(m2_layer) : nullptr;
+	const uint32_t* count_b = source_has_samples ? additional_source.get_layer<uint32_t>(count_layer) : nullptr;
+
+	VoxelBuffer::for_each_chunk(target.get_voxel_count(), 2 * elements_per_voxel * sizeof(T), [=](size_t begin, size_t end) {
+		for (size_t voxel = begin; voxel < end; voxel++) {
+			const uint32_t na = count_a[voxel];
+			const uint32_t nb = (count_b != nullptr) ? count_b[voxel] : 1;
+			if (nb == 0)
+				continue;
+
+			const size_t first = voxel * elements_per_voxel;
+			if (na == 0) {
+				for (size_t i = first; i < first + elements_per_voxel; i++) {
+					mean_a[i] = mean_b[i];
+					m2_a[i] = (m2_b != nullptr) ? m2_b[i] : static_cast<T>(0);
+				}
+			}
+			else {
+				// the update is computed in double precision, so that large sample counts don't cancel out the deviations
+				const double n = static_cast<double>(na) + static_cast<double>(nb);
+				const double mean_weight = static_cast<double>(nb) / n;
+				const double m2_weight = static_cast<double>(na) * static_cast<double>(nb) / n;
+				for (size_t i = first; i < first + elements_per_voxel; i++) {
+					const double delta = static_cast<double>(mean_b[i]) - static_cast<double>(mean_a[i]);
+					const double m2_source = (m2_b != nullptr) ? static_cast<double>(m2_b[i]) : 0.0;
+					mean_a[i] = static_cast<T>(static_cast<double>(mean_a[i]) + delta * mean_weight);
+					m2_a[i] = static_cast<T>(static_cast<double>(m2_a[i]) + m2_source + delta * delta * m2_weight);
+				}
+			}
+			count_a[voxel] = na + nb;
+		}
+	});
+
+	double relative_error_sum = 0.0;
+	size_t relative_error_count = 0;
+	for (size_t voxel = 0; voxel < target.get_voxel_count(); voxel++) {
+		const double n = static_cast<double>(count_a[voxel]);
+		if (n < 2.0)
+			continue;
+		for (size_t i = voxel * elements_per_voxel; i < (voxel + 1) * elements_per_voxel; i++) {
+			if (mean_a[i] == static_cast<T>(0))
+				continue;
+			relative_error_sum += std::sqrt(static_cast<double>(m2_a[i]) / (n * (n - 1.0))) / std::abs(static_cast<double>(mean_a[i]));
+			relative_error_count++;
+		}
+	}
+	target.set_statistical_error(layer_name, (relative_error_count > 0) ? static_cast<float>(relative_error_sum / static_cast<double>(relative_error_count)) : 0.f);
+}
+
+void ExporterHelpers::join_layer_welford(VoxelBuffer& target, const VoxelBuffer& additional_source, const std::string& layer_name, Typing::DType dtype)
+{
+	switch (dtype) {
+		case Typing::DType::Float:
+		case Typing::DType::Vec2:
+		case Typing::DType::Vec3:
+		case Typing::DType::Vec4:
+		case Typing::DType::Hist:
+			ExporterHelpers::join_layer_welford_as<float>(target, additional_source, layer_name);
+			break;
+		case Typing::DType::Double:
+#if defined(__x86_64__) || defined(_M_X64)
+			ExporterHelpers::join_layer_welford_as<double>(target, additional_source, layer_name);
+#else
+			throw RadiationFieldStoreException("Can't use 64-bit data type in 32-bit system!");
+#endif
+			break;
+		default:
+			throw RadiationFieldStoreException("Welford join requires a floating point layer, but layer: '" + layer_name + "' is not");
+	}
+}
+
+template<typename T>
+void ExporterHelpers::write_welford_uncertainty_as(VoxelBuffer& buffer, const std::string& layer_name, const std::string& uncertainty_layer_name)
+{
+	if (!buffer.has_layer(uncertainty_layer_name))
+		buffer.add_custom_layer_unsafe(uncertainty_layer_name, &buffer.get_voxel_flat(layer_name, 0), buffer.get_layer_unit(layer_name));
+	if (buffer.get_layer(uncertainty_layer_name).get_bytes_per_voxel_data() != buffer.get_layer(layer_name).get_bytes_per_voxel_data())
+		throw RadiationFieldStoreException("Layer: '" + uncertainty_layer_name + "' does not match the data size of layer: '" + layer_name + "'");
+
+	const size_t elements_per_voxel = buffer.get_layer(layer_name).get_bytes_per_voxel_data() / sizeof(T);
+	const T* m2 = buffer.get_layer<T>(layer_name + ExporterHelpers::WELFORD_M2_SUFFIX);
+	const uint32_t* count = buffer.get_layer<uint32_t>(layer_name + ExporterHelpers::WELFORD_COUNT_SUFFIX);
+	T* uncertainty = buffer.get_layer<T>(uncertainty_layer_name);
+
+	VoxelBuffer::for_each_chunk(buffer.get_voxel_count(), 2 * elements_per_voxel * sizeof(T), [=](size_t begin, size_t end) {
+		for (size_t voxel = begin; voxel < end; voxel++) {
+			const double n = static_cast<double>(count[voxel]);
+			for (size_t i = voxel * elements_per_voxel; i < (voxel + 1) * elements_per_voxel; i++)
+				uncertainty[i] = (n < 2.0) ? static_cast<T>(0) : static_cast<T>(std::sqrt(static_cast<double>(m2[i]) / (n * (n - 1.0))));
+		}
+	});
+}
+
+void ExporterHelpers::write_welford_uncertainty(VoxelBuffer& buffer, const std::string& layer_name, const std::string& uncertainty_layer_name)
+{
+	if (!buffer.has_layer(layer_name + ExporterHelpers::WELFORD_COUNT_SUFFIX) || !buffer.has_layer(layer_name + ExporterHelpers::WELFORD_M2_SUFFIX))
+		throw RadiationFieldStoreException("Layer: '" + layer_name + "' was not joined by the Welford join mode");
+
+	switch (Typing::Helper::get_dtype(buffer.get_voxel_flat(layer_name, 0).get_type())) {
+		case Typing::DType::Float:
+		case Typing::DType::Vec2:
+		case Typing::DType::Vec3:
+		case Typing::DType::Vec4:
+		case Typing::DType::Hist:
+			ExporterHelpers::write_welford_uncertainty_as<float>(buffer, layer_name, uncertainty_layer_name);
+			break;
+		case Typing::DType::Double:
+#if defined(__x86_64__) || defined(_M_X64)
+			ExporterHelpers::write_welford_uncertainty_as<double>(buffer, layer_name, uncertainty_layer_name);
+#else
+			throw RadiationFieldStoreException("Can't use 64-bit data type in 32-bit system!");
+#endif
+			break;
+		default:
+			throw RadiationFieldStoreException("Welford join requires a floating point layer, but layer: '" + layer_name + "' is not");
+	}
+}
+
 std::shared_ptr<BasicFieldStore> FieldStore::store_instance = std::shared_ptr<BasicFieldStore>(nullptr);
 StoreVersion FieldStore::store_version = StoreVersion::V1;
 bool FieldStore::file_lock_syncronization = false;
+bool FieldStore::in_place_join = false;
+LayerCodec FieldStore::layer_codec = LayerCodec::Raw;
+uint32_t FieldStore::layer_brick_size = 0;
+std::mutex FieldStore::store_instance_mutex;
 
 
 void IRadiationFieldExporter::store(std::shared_ptr<IRadiationField> field, std::shared_ptr<RadFiled3D::Storage::RadiationFieldMetadata> metadata, const std::string& file) const
@@ -41,13 +363,18 @@ void RadFiled3D::Storage::BasicFieldStore::serialize(std::ostream& stream, std::
 {
 	stream.seekp(0, std::ios::beg);
 
+	this->serialize_file_header(stream, metadata);
+
+	this->field_serializer->serializeField(field, stream);
+}
+
+void RadFiled3D::Storage::BasicFieldStore::serialize_file_header(std::ostream& stream, std::shared_ptr<RadFiled3D::Storage::RadiationFieldMetadata> metadata) const
+{
 	VersionHeader vh;
 	memcpy(&vh.version, this->file_version.c_str(), std::min<size_t>(12, this->file_version.length()));
 	stream.write((const char*)&vh, sizeof(VersionHeader));
 
 	this->metadata_serializer->serializeMetadata(stream, metadata);
-
-	this->field_serializer->serializeField(field, stream);
 }
 
 std::shared_ptr<IRadiationField> IRadiationFieldImporter::load(const std::string& file) const
@@ -109,12 +436,15 @@ FieldType Storage::BasicFieldStore::peek_field_type(std::istream& file_stream) c
 
 FieldType RadFiled3D::Storage::FieldStore::peek_field_type(std::istream& file_stream)
 {
-	if (FieldStore::store_instance.get() == nullptr) {
-		StoreVersion version = FieldAccessor::getStoreVersion(file_stream);
-		FieldStore::init_store_instance(version);
+	std::shared_ptr<BasicFieldStore> store;
+	{
+		std::lock_guard<std::mutex> lock(FieldStore::store_instance_mutex);
+		store = FieldStore::store_instance;
 	}
+	if (store.get() == nullptr)
+		store = FieldStore::get_store_instance(FieldAccessor::getStoreVersion(file_stream));
 
-	return FieldStore::store_instance->peek_field_type(file_stream);
+	return store->peek_field_type(file_stream);
 }
 
 std::shared_ptr<FieldAccessor> RadFiled3D::Storage::FieldStore::construct_accessor(const std::string& file)
@@ -128,6 +458,12 @@ std::shared_ptr<FieldAccessor> RadFiled3D::Storage::FieldStore::construct_access
 	return FieldAccessorBuilder::Construct(buffer);
 }
 
+std::shared_ptr<FieldAccessor> RadFiled3D::Storage::FieldStore::construct_accessor(const std::shared_ptr<ByteSource>& source)
+{
+	ByteSourceStream buffer(source);
+	return FieldAccessorBuilder::Construct(buffer);
+}
+
 std::shared_ptr<IRadiationField> Storage::BasicFieldStore::load(std::istream& buffer) const
 {
 	this->valdiate_file_version(buffer);
@@ -208,6 +544,32 @@ std::shared_ptr<VoxelLayer> Storage::V1::FieldStore::load_single_layer(std::istr
 	throw RadiationFieldStoreException(msg.c_str());
 }
 
+std::shared_ptr<VoxelLayer> Storage::V2::FieldStore::load_single_layer(std::istream& buffer, const std::string& channel, const std::string& layer_name) const
+{
+	this->valdiate_file_version(buffer);
+
+	Storage::V2::FieldIndex index = Storage::V2::FieldIndex::Read(buffer);
+
+	auto channel_itr = index.channels_layers_offsets.find(channel);
+	if (channel_itr == index.channels_layers_offsets.end())
+		throw RadiationFieldStoreException("Layer: '" + layer_name + "' not found in channel: " + channel);
+
+	auto layer_itr = channel_itr->second.layers.find(layer_name);
+	if (layer_itr == channel_itr->second.layers.end())
+		throw RadiationFieldStoreException("Layer: '" + layer_name + "' not found in channel: " + channel);
+
+	const AccessorTypes::MemoryBlockDefinition& channel_block = channel_itr->second.channel_block;
+	const AccessorTypes::TypedMemoryBlockDefinition& layer_block = layer_itr->second;
+
+	buffer.seekg(index.getFieldDataOffset() + channel_block.offset + sizeof(FiledTypes::V1::ChannelHeader) + layer_block.offset, std::ios::beg);
+	std::vector<char> byte_buffer(layer_block.size);
+	buffer.read(byte_buffer.data(), layer_block.size);
+	if (static_cast<size_t>(buffer.gcount()) != layer_block.size)
+		throw RadiationFieldStoreException("Layer: '" + layer_name + "' is incomplete in channel: " + channel);
+
+	return std::shared_ptr<VoxelLayer>(this->get_field_serializer().deserializeLayer(byte_buffer.data(), layer_block.size));
+}
+
 std::shared_ptr<RadFiled3D::Storage::RadiationFieldMetadata> Storage::BasicFieldStore::peek_metadata(std::istream& buffer) const
 {
 	this->valdiate_file_version(buffer);
@@ -237,10 +599,16 @@ void Storage::V1::FieldStore::join(std::shared_ptr<IRadiationField> target, std:
 		auto target_channel = target->get_generic_channel(channel.first);
 
 		for (auto& layer_name : channel.second->get_layers()) {
+			// the sample counts and deviations are joined along with their layer
+			if (join_mode == FieldJoinMode::Welford && channel.second->has_layer(ExporterHelpers::get_welford_value_layer(layer_name)))
+				continue;
+
 			if (!target_channel->has_layer(layer_name)) {
 				if (check_mode <= FieldJoinCheckMode::FieldStructureOnly)
 					throw RadiationFieldStoreException("Layer: '" + layer_name + "' not found in target field");
 				target_channel->add_custom_layer_unsafe(layer_name, &channel.second->get_voxel_flat(layer_name, 0), channel.second->get_layer_unit(layer_name));
+				if (join_mode == FieldJoinMode::Welford && ExporterHelpers::is_welford_dtype(Typing::Helper::get_dtype(channel.second->get_voxel_flat<IVoxel>(layer_name, 0).get_type())))
+					ExporterHelpers::ensure_welford_layers(*target_channel, layer_name, 0);
 			}
 
 			const Typing::DType dtype1 = Typing::Helper::get_dtype(channel.second->get_voxel_flat<IVoxel>(layer_name, 0).get_type());
@@ -253,46 +621,347 @@ void Storage::V1::FieldStore::join(std::shared_ptr<IRadiationField> target, std:
 			if (check_mode <= FieldJoinCheckMode::FieldUnitsOnly && target_channel->get_layer_unit(layer_name) != channel.second->get_layer_unit(layer_name))
 				throw RadiationFieldStoreException("Unit mismatch for layer: '" + layer_name + "' in channel: " + channel.first + ". Existing unit: " + target_channel->get_layer_unit(layer_name) + ", but target unit: " + channel.second->get_layer_unit(layer_name));
 
-			switch (dtype1) {
-				case Typing::DType::Float:
-					target_channel->merge_data_buffer<float>(layer_name, *channel.second.get(), ExporterHelpers::get_join_function<float>(join_mode, ratio));
-					break;
-				case Typing::DType::Double:
-#if defined(__x86_64__) || defined(_M_X64)
-					target_channel->merge_data_buffer<double>(layer_name, *channel.second.get(), ExporterHelpers::get_join_function<double>(join_mode, ratio));
-#else
-					throw RadiationFieldStoreException("Can't use 64-bit data type in 32-bit system!");
-#endif
-					break;
-				case Typing::DType::Char:
-					throw RadiationFieldStoreException("Unsupported data type 'char' for merging of layer: '" + layer_name + "' in channel: " + channel.first);
-					//target_channel->merge_data_buffer<char>(layer_name, *channel.second.get(), ExporterHelpers::get_join_function<char>(join_mode, ratio));
-					break;
-				case Typing::DType::Int:
-					target_channel->merge_data_buffer<int>(layer_name, *channel.second.get(), ExporterHelpers::get_join_function<int>(join_mode, ratio));
-					break;
-				case Typing::DType::UInt64:
-#if defined(__x86_64__) || defined(_M_X64)
-					target_channel->merge_data_buffer<uint64_t>(layer_name, *channel.second.get(), ExporterHelpers::get_join_function<uint64_t>(join_mode, ratio));
-#else
-					throw RadiationFieldStoreException("Can't use 64-bit data type in 32-bit system!");
-#endif
-					break;
-				case Typing::DType::Vec2:
-					target_channel->merge_data_buffer<glm::vec2>(layer_name, *channel.second.get(), ExporterHelpers::get_join_function<glm::vec2>(join_mode, ratio));
-					break;
-				case Typing::DType::Vec3:
-					target_channel->merge_data_buffer<glm::vec3>(layer_name, *channel.second.get(), ExporterHelpers::get_join_function<glm::vec3>(join_mode, ratio));
-					break;
-				case Typing::DType::Vec4:
-					target_channel->merge_data_buffer<glm::vec4>(layer_name, *channel.second.get(), ExporterHelpers::get_join_function<glm::vec4>(join_mode, ratio));
-					break;
-				case Typing::DType::Hist:
-					target_channel->merge_voxel_buffer<HistogramVoxel>(layer_name, *channel.second.get(), ExporterHelpers::get_join_function<HistogramVoxel, float>(join_mode, ratio));
-					break;
+			ExporterHelpers::join_layer(*target_channel, *channel.second, layer_name, dtype1, join_mode, ratio);
+		}
+	}
+}
+
+std::map<std::string, std::map<std::string, Storage::V1::FieldStore::LayerBlockLocation>> Storage::V1::FieldStore::locate_layer_blocks(std::istream& stream, size_t voxel_count, size_t field_data_end, const std::string& file) const
+{
+	const V1::BinayFieldBlockHandler& handler = dynamic_cast<const V1::BinayFieldBlockHandler&>(this->get_field_serializer());
+
+	std::map<std::string, std::map<std::string, LayerBlockLocation>> channels;
+	const size_t layer_headers_size = handler.getLayerCodecHeaderSize() + sizeof(FiledTypes::V1::VoxelGridLayerHeader);
+	std::vector<char> layer_headers(layer_headers_size);
+	size_t channel_pos = stream.tellg();
+	while (channel_pos < field_data_end) {
+		FiledTypes::V1::ChannelHeader ch;
+		stream.seekg(channel_pos, std::ios::beg);
+		stream.read((char*)&ch, sizeof(FiledTypes::V1::ChannelHeader));
+		if (static_cast<size_t>(stream.gcount()) != sizeof(FiledTypes::V1::ChannelHeader))
+			throw RadiationFieldStoreException("Channel header is incomplete in file: " + file);
+
+		const std::string channel_name(ch.name, strnlen(ch.name, sizeof(ch.name)));
+		std::map<std::string, LayerBlockLocation>& layers = channels[channel_name];
+		const size_t channel_end = channel_pos + sizeof(FiledTypes::V1::ChannelHeader) + ch.channel_bytes;
+		size_t layer_pos = channel_pos + sizeof(FiledTypes::V1::ChannelHeader);
+		while (layer_pos < channel_end) {
+			stream.seekg(layer_pos, std::ios::beg);
+			stream.read(layer_headers.data(), std::min<size_t>(layer_headers_size, channel_end - layer_pos));
+			const size_t layer_size = handler.getLayerBlockSize(layer_headers.data(), channel_end - layer_pos, voxel_count);
+			const FiledTypes::V1::VoxelGridLayerHeader& layer_desc = *(const FiledTypes::V1::VoxelGridLayerHeader*)(layer_headers.data() + handler.getLayerCodecHeaderSize());
+			layers[std::string(layer_desc.name, strnlen(layer_desc.name, sizeof(layer_desc.name)))] = LayerBlockLocation{
+				layer_pos,
+				layer_size,
+				Typing::Helper::get_dtype(std::string(layer_desc.dtype, strnlen(layer_desc.dtype, sizeof(layer_desc.dtype)))),
+				std::string(layer_desc.unit, strnlen(layer_desc.unit, sizeof(layer_desc.unit)))
+			};
+			layer_pos += layer_size;
+		}
+		channel_pos = channel_end;
+	}
+	return channels;
+}
+
+std::shared_ptr<IRadiationField> Storage::V1::FieldStore::load_parallel(const std::string& file, size_t worker_count) const
+{
+	const V1::BinayFieldBlockHandler& handler = dynamic_cast<const V1::BinayFieldBlockHandler&>(this->get_field_serializer());
+
+	std::ifstream stream(file.c_str(), std::ios::in | std::ios::binary);
+	if (!stream.is_open())
+		throw RadiationFieldStoreException("File " + file + " could not be opened!");
+
+	this->valdiate_file_version(stream);
+	const size_t field_data_end = handler.getFieldDataEnd(stream);
+	stream.clear();
+	this->valdiate_file_version(stream);
+	size_t metadata_size = this->get_metadata_accessor().get_metadata_size(stream);
+	stream.seekg(metadata_size, std::ios::cur);
+
+	std::shared_ptr<IRadiationField> field = handler.deserializeFieldShape(stream);
+	const size_t voxel_count = field->copy()->add_channel("")->get_voxel_count();
+	const std::map<std::string, std::map<std::string, LayerBlockLocation>> channels = this->locate_layer_blocks(stream, voxel_count, field_data_end, file);
+	stream.close();
+
+	struct LayerJob {
+		const std::string* channel_name;
+		const std::string* layer_name;
+		const LayerBlockLocation* block;
+	};
+	std::vector<LayerJob> jobs;
+	for (auto& channel : channels)
+		for (auto& layer : channel.second)
+			jobs.push_back(LayerJob{ &channel.first, &layer.first, &layer.second });
+
+	// each worker reads a whole layer block by a positional read and deserializes it on its own
+	PositionalFile source(file);
+	std::vector<std::unique_ptr<VoxelLayer>> layers(jobs.size());
+	VoxelBuffer::parallel_for(jobs.size(), worker_count, [&](size_t i) {
+		std::shared_ptr<ILayerAllocator> allocator = ILayerAllocator::get_default();
+		const size_t layer_size = jobs[i].block->size;
+		std::shared_ptr<char> layer_data(
+			allocator->allocate(layer_size),
+			[allocator, layer_size](char* data) { allocator->deallocate(data, layer_size); }
+		);
+		source.read(jobs[i].block->offset, layer_data.get(), layer_size);
+		layers[i].reset(handler.deserializeLayer(layer_data.get(), layer_size));
+	});
+
+	for (auto& channel : channels)
+		field->add_channel(channel.first);
+	for (size_t i = 0; i < jobs.size(); i++)
+		field->get_generic_channel(*jobs[i].channel_name)->insert_layer(*jobs[i].layer_name, layers[i].release());
+
+	return field;
+}
+
+void Storage::V1::FieldStore::join_file(const std::string& file, std::shared_ptr<IRadiationField> additional_source, std::shared_ptr<RadFiled3D::Storage::RadiationFieldMetadata> metadata, FieldJoinMode join_mode, FieldJoinCheckMode check_mode, float ratio) const
+{
+	const V1::BinayFieldBlockHandler& handler = dynamic_cast<const V1::BinayFieldBlockHandler&>(this->get_field_serializer());
+
+	std::ifstream target_stream(file.c_str(), std::ios::in | std::ios::binary);
+	if (!target_stream.is_open())
+		throw RadiationFieldStoreException("File " + file + " could not be opened!");
+
+	this->valdiate_file_version(target_stream);
+	const size_t field_data_end = handler.getFieldDataEnd(target_stream);
+	target_stream.clear();
+	this->valdiate_file_version(target_stream);
+	size_t metadata_size = this->get_metadata_accessor().get_metadata_size(target_stream);
+	target_stream.seekg(metadata_size, std::ios::cur);
+
+	// the target field is only read as an empty field of its shape, its layers are read one at a time below
+	std::shared_ptr<IRadiationField> target_shape = handler.deserializeFieldShape(target_stream);
+	if (target_shape->get_typename() != additional_source->get_typename()) {
+		std::string msg = "Field type mismatch! Existing field is of type: " + target_shape->get_typename() + ", but target field is of type: " + additional_source->get_typename();
+		throw RadiationFieldStoreException(msg.c_str());
+	}
+	const size_t voxel_count = target_shape->copy()->add_channel("")->get_voxel_count();
+
+	// locate all layer blocks of the target by their headers only
+	std::map<std::string, std::map<std::string, LayerBlockLocation>> target_channels = this->locate_layer_blocks(target_stream, voxel_count, field_data_end, file);
+
+	// validate the whole join before the first byte is written
+	std::set<std::string> channel_names;
+	for (auto& channel : target_channels)
+		channel_names.insert(channel.first);
+	for (auto& channel : additional_source->get_channels()) {
+		auto target_channel = target_channels.find(channel.first);
+		if (target_channel == target_channels.end() && check_mode <= FieldJoinCheckMode::FieldStructureOnly)
+			throw RadiationFieldStoreException("Channel: '" + channel.first + "' not found in target field");
+		channel_names.insert(channel.first);
+
+		for (auto& layer_name : channel.second->get_layers()) {
+			if (join_mode == FieldJoinMode::Welford && channel.second->has_layer(ExporterHelpers::get_welford_value_layer(layer_name)))
+				continue;
+			if (target_channel == target_channels.end() || target_channel->second.find(layer_name) == target_channel->second.end()) {
+				if (check_mode <= FieldJoinCheckMode::FieldStructureOnly)
+					throw RadiationFieldStoreException("Layer: '" + layer_name + "' not found in target field");
+				continue;
+			}
+			const LayerBlockLocation& target_layer = target_channel->second.at(layer_name);
+
+			if (Typing::Helper::get_dtype(channel.second->get_voxel_flat<IVoxel>(layer_name, 0).get_type()) != target_layer.dtype)
+				throw RadiationFieldStoreException("Data type mismatch for layer: '" + layer_name + "' in channel: " + channel.first);
+			if (voxel_count != channel.second->get_voxel_count())
+				throw RadiationFieldStoreException("Voxel count mismatch for layer: '" + layer_name + "' in channel: " + channel.first);
+			if (check_mode <= FieldJoinCheckMode::FieldUnitsOnly && target_layer.unit != channel.second->get_layer_unit(layer_name))
+				throw RadiationFieldStoreException("Unit mismatch for layer: '" + layer_name + "' in channel: " + channel.first + ". Existing unit: " + target_layer.unit + ", but target unit: " + channel.second->get_layer_unit(layer_name));
+		}
+	}
+
+	const std::string temp_file = file + ".join.tmp";
+	try {
+		std::ofstream temp_stream(temp_file.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+		if (!temp_stream.is_open())
+			throw RadiationFieldStoreException("File " + temp_file + " could not be created!");
+
+		this->serialize_file_header(temp_stream, metadata);
+		std::unique_ptr<FieldBlockStreamWriter> writer = handler.serializeFieldStreamed(target_shape, temp_stream);
+
+		for (auto& channel_name : channel_names) {
+			writer->beginChannel(channel_name);
+
+			std::shared_ptr<VoxelBuffer> source_channel = additional_source->has_channel(channel_name) ? additional_source->get_generic_channel(channel_name) : nullptr;
+			std::set<std::string> layer_names;
+			auto target_channel = target_channels.find(channel_name);
+			if (target_channel != target_channels.end())
+				for (auto& layer : target_channel->second)
+					layer_names.insert(layer.first);
+			if (source_channel != nullptr)
+				for (auto& layer_name : source_channel->get_layers())
+					layer_names.insert(layer_name);
+			if (join_mode == FieldJoinMode::Welford) {
+				// the sample counts and deviations are read, joined and written along with their layer
+				for (auto it = layer_names.begin(); it != layer_names.end();) {
+					const std::string value_layer = ExporterHelpers::get_welford_value_layer(*it);
+					it = (!value_layer.empty() && layer_names.find(value_layer) != layer_names.end()) ? layer_names.erase(it) : std::next(it);
+				}
+			}
+
+			auto load_target_layer = [&](VoxelBuffer& layer_channel, const std::string& layer_name) {
+				const LayerBlockLocation& target_layer = target_channel->second.at(layer_name);
+				std::shared_ptr<ILayerAllocator> allocator = ILayerAllocator::get_default();
+				const size_t layer_size = target_layer.size;
+				std::shared_ptr<char> layer_data(
+					allocator->allocate(layer_size),
+					[allocator, layer_size](char* data) { allocator->deallocate(data, layer_size); }
+				);
+				target_stream.seekg(target_layer.offset, std::ios::beg);
+				target_stream.read(layer_data.get(), layer_size);
+				if (static_cast<size_t>(target_stream.gcount()) != layer_size)
+					throw RadiationFieldStoreException("Layer: '" + layer_name + "' is incomplete in channel: " + channel_name);
+				layer_channel.insert_layer(layer_name, handler.deserializeLayerView(layer_data.get(), layer_size, layer_data));
+			};
+
+			for (auto& layer_name : layer_names) {
+				// each layer is held by a channel of its own, which is released as soon as the layer was written
+				std::shared_ptr<VoxelBuffer> layer_channel = target_shape->copy()->add_channel(channel_name);
+				const bool in_target = target_channel != target_channels.end() && target_channel->second.find(layer_name) != target_channel->second.end();
+				const bool in_source = source_channel != nullptr && source_channel->has_layer(layer_name);
+				std::vector<std::string> welford_layers;
+				if (join_mode == FieldJoinMode::Welford)
+					welford_layers = { layer_name + ExporterHelpers::WELFORD_COUNT_SUFFIX, layer_name + ExporterHelpers::WELFORD_M2_SUFFIX };
+
+				if (in_target) {
+					load_target_layer(*layer_channel, layer_name);
+					for (auto& welford_layer : welford_layers)
+						if (target_channel->second.find(welford_layer) != target_channel->second.end())
+							load_target_layer(*layer_channel, welford_layer);
+				}
+				else {
+					layer_channel->add_custom_layer_unsafe(layer_name, &source_channel->get_voxel_flat(layer_name, 0), source_channel->get_layer_unit(layer_name));
+					if (join_mode == FieldJoinMode::Welford && ExporterHelpers::is_welford_dtype(Typing::Helper::get_dtype(source_channel->get_voxel_flat<IVoxel>(layer_name, 0).get_type())))
+						ExporterHelpers::ensure_welford_layers(*layer_channel, layer_name, 0);
+				}
+
+				if (in_source)
+					ExporterHelpers::join_layer(*layer_channel, *source_channel, layer_name, Typing::Helper::get_dtype(source_channel->get_voxel_flat<IVoxel>(layer_name, 0).get_type()), join_mode, ratio);
+
+				writer->writeLayer(layer_channel, layer_name);
+				for (auto& welford_layer : welford_layers)
+					if (layer_channel->has_layer(welford_layer))
+						writer->writeLayer(layer_channel, welford_layer);
+			}
+		}
+		writer->finish();
+
+		temp_stream.close();
+		if (temp_stream.fail())
+			throw RadiationFieldStoreException("Failed to write file " + temp_file);
+		target_stream.close();
+
+		fs::rename(temp_file, file);
+	}
+	catch (...) {
+		std::error_code ec;
+		fs::remove(temp_file, ec);
+		throw;
+	}
+}
+
+bool Storage::V1::FieldStore::join_in_place(const std::string& file, std::shared_ptr<IRadiationField> additional_source, std::shared_ptr<RadFiled3D::Storage::RadiationFieldMetadata> metadata, FieldJoinMode join_mode, FieldJoinCheckMode check_mode, float ratio) const
+{
+	// the Welford join mode adds and joins auxiliary layers, which changes the structure of the file
+	if (join_mode == FieldJoinMode::Welford)
+		return false;
+
+	const V1::BinayFieldBlockHandler& handler = dynamic_cast<const V1::BinayFieldBlockHandler&>(this->get_field_serializer());
+
+	std::shared_ptr<FieldAccessor> accessor;
+	{
+		std::ifstream target_stream(file.c_str(), std::ios::in | std::ios::binary);
+		if (!target_stream.is_open())
+			throw RadiationFieldStoreException("File " + file + " could not be opened!");
+		accessor = FieldAccessorBuilder::Construct(target_stream);
+	}
+
+	const std::string target_typename = (accessor->getFieldType() == FieldType::Cartesian) ? "CartesianRadiationField" : "PolarRadiationField";
+	if (target_typename != additional_source->get_typename())
+		return false;
+
+	// the new file header replaces the stored one, so it needs to take exactly the same space
+	std::ostringstream file_header;
+	this->serialize_file_header(file_header, metadata);
+	const std::string file_header_data = file_header.str();
+	if (file_header_data.size() != accessor->getMetadataFileheaderOffset())
+		return false;
+
+	PositionalFile target(file, true);
+
+	// locate and validate all layers before the first byte is written
+	struct LayerJob {
+		std::string layer_name;
+		Typing::DType dtype;
+		size_t position;
+		size_t bytes;
+		size_t bytes_per_voxel;
+		const char* source_data;
+	};
+	std::vector<LayerJob> jobs;
+	const size_t layer_headers_size = handler.getLayerCodecHeaderSize() + sizeof(FiledTypes::V1::VoxelGridLayerHeader);
+	std::vector<char> layer_headers(layer_headers_size);
+	const std::vector<std::string> target_channels = accessor->getChannelNames();
+	for (auto& channel : additional_source->get_channels()) {
+		if (std::find(target_channels.begin(), target_channels.end(), channel.first) == target_channels.end())
+			return false;
+		if (channel.second->get_voxel_count() != accessor->getVoxelCount())
+			return false;
+
+		const std::vector<std::string> target_layers = accessor->getLayerNames(channel.first);
+		for (auto& layer_name : channel.second->get_layers()) {
+			if (std::find(target_layers.begin(), target_layers.end(), layer_name) == target_layers.end())
+				return false;
+
+			const size_t layer_position = accessor->getLayerPosition(channel.first, layer_name);
+			const size_t layer_size = accessor->getLayerDefinition(channel.first, layer_name).size;
+			if (layer_size < layer_headers_size)
+				throw RadiationFieldStoreException("Layer: '" + layer_name + "' is incomplete in channel: " + channel.first);
+			target.read(layer_position, layer_headers.data(), layer_headers_size);
+			if (!handler.isLayerRaw(layer_headers.data()))
+				return false;
+
+			const FiledTypes::V1::VoxelGridLayerHeader& layer_desc = *(const FiledTypes::V1::VoxelGridLayerHeader*)(layer_headers.data() + handler.getLayerCodecHeaderSize());
+			const Typing::DType dtype = Typing::Helper::get_dtype(std::string(layer_desc.dtype, strnlen(layer_desc.dtype, sizeof(layer_desc.dtype))));
+			const std::string unit(layer_desc.unit, strnlen(layer_desc.unit, sizeof(layer_desc.unit)));
+			const VoxelLayer& source_layer = channel.second->get_layer(layer_name);
+			const size_t data_offset = layer_headers_size + layer_desc.header_block_size;
+			const size_t bytes = channel.second->get_voxel_count() * source_layer.get_bytes_per_voxel_data();
+
+			if (dtype == Typing::DType::Char || dtype != Typing::Helper::get_dtype(channel.second->get_voxel_flat<IVoxel>(layer_name, 0).get_type()))
+				return false;
+			if (check_mode <= FieldJoinCheckMode::FieldUnitsOnly && unit != channel.second->get_layer_unit(layer_name))
+				return false;
+			if (layer_desc.bytes_per_element != source_layer.get_bytes_per_voxel_data() || data_offset > layer_size || layer_size - data_offset != bytes)
+				return false;
+
+			jobs.push_back(LayerJob{ layer_name, dtype, layer_position + data_offset, bytes, source_layer.get_bytes_per_voxel_data(), source_layer.get_raw_data() });
+		}
+	}
+
+	if (join_mode != FieldJoinMode::Identity) {
+		std::shared_ptr<ILayerAllocator> allocator = ILayerAllocator::get_default();
+		for (auto& job : jobs) {
+			// the layer is joined in blocks of whole voxels, so that the elements of a block are aligned like in the layer
+			const size_t block_bytes = std::max<size_t>(1, (4 * 1024 * 1024) / job.bytes_per_voxel) * job.bytes_per_voxel;
+			const size_t buffer_size = std::min(block_bytes, job.bytes);
+			if (buffer_size == 0)
+				continue;
+			std::shared_ptr<char> buffer(
+				allocator->allocate(buffer_size),
+				[allocator, buffer_size](char* data) { allocator->deallocate(data, buffer_size); }
+			);
+			for (size_t offset = 0; offset < job.bytes; offset += block_bytes) {
+				const size_t bytes = std::min(block_bytes, job.bytes - offset);
+				target.read(job.position + offset, buffer.get(), bytes);
+				ExporterHelpers::join_layer_data(buffer.get(), job.source_data + offset, bytes, job.layer_name, job.dtype, join_mode, ratio);
+				target.write(job.position + offset, buffer.get(), bytes);
 			}
 		}
 	}
+
+	target.write(0, file_header_data.data(), file_header_data.size());
+	return true;
 }
 
 StoreVersion RadFiled3D::Storage::FieldStore::get_store_version(const std::string& file)
@@ -306,182 +975,339 @@ StoreVersion RadFiled3D::Storage::FieldStore::get_store_version(std::istream& bu
 	return FieldAccessor::getStoreVersion(buffer);
 }
 
-void FieldStore::init_store_instance(StoreVersion version)
+void FieldStore::set_layer_codec(LayerCodec codec)
+{
+	std::lock_guard<std::mutex> lock(FieldStore::store_instance_mutex);
+	FieldStore::layer_codec = codec;
+
+	// the codec is handed to the store on construction, so a cached store needs to be replaced
+	if (FieldStore::store_instance.get() != nullptr && FieldStore::store_version == StoreVersion::V2)
+		FieldStore::store_instance = FieldStore::create_store_instance(FieldStore::store_version);
+}
+
+void FieldStore::set_layer_brick_size(uint32_t brick_size)
+{
+	std::lock_guard<std::mutex> lock(FieldStore::store_instance_mutex);
+	FieldStore::layer_brick_size = brick_size;
+
+	if (FieldStore::store_instance.get() != nullptr && FieldStore::store_version == StoreVersion::V2)
+		FieldStore::store_instance = FieldStore::create_store_instance(FieldStore::store_version);
+}
+
+std::shared_ptr<BasicFieldStore> FieldStore::create_store_instance(StoreVersion version)
 {
 	switch (version) {
 		case StoreVersion::V1:
-			FieldStore::store_instance = std::make_shared<Storage::V1::FieldStore>();
-			FieldStore::store_version = version;
-			break;
+			return std::make_shared<Storage::V1::FieldStore>();
+		case StoreVersion::V2:
+			return std::make_shared<Storage::V2::FieldStore>(FieldStore::layer_codec, FieldStore::layer_brick_size);
 		default:
 			throw RadiationFieldStoreException("Unimplemented file version!");
 	}
 }
 
-void FieldStore::store(std::shared_ptr<IRadiationField> field, std::shared_ptr<RadiationFieldMetadata> metadata, const std::string& file, StoreVersion version)
+std::shared_ptr<BasicFieldStore> FieldStore::get_store_instance(StoreVersion version)
 {
+	std::lock_guard<std::mutex> lock(FieldStore::store_instance_mutex);
 	if (FieldStore::store_instance.get() == nullptr || version != FieldStore::store_version) {
-		FieldStore::init_store_instance(version);
+		FieldStore::store_instance = FieldStore::create_store_instance(version);
+		FieldStore::store_version = version;
 	}
 
-	FieldStore::store_instance->store(field, metadata, file);
+	return FieldStore::store_instance;
 }
 
-void FieldStore::serialize(std::ostream& stream, std::shared_ptr<IRadiationField> field, std::shared_ptr<RadiationFieldMetadata> metadata, StoreVersion version)
+void FieldStore::init_store_instance(StoreVersion version)
 {
-	if (FieldStore::store_instance.get() == nullptr || version != FieldStore::store_version) {
-		FieldStore::init_store_instance(version);
-	}
+	std::lock_guard<std::mutex> lock(FieldStore::store_instance_mutex);
+	FieldStore::store_instance = FieldStore::create_store_instance(version);
+	FieldStore::store_version = version;
+}
 
-	FieldStore::store_instance->serialize(stream, field, metadata);
+void FieldStore::store(std::shared_ptr<IRadiationField> field, std::shared_ptr<RadiationFieldMetadata> metadata, const std::string& file, StoreVersion version)
+{
+	FieldStore::get_store_instance(version)->store(field, metadata, file);
+}
+
+void FieldStore::serialize(std::ostream& stream, std::shared_ptr<IRadiationField> field, std::shared_ptr<RadiationFieldMetadata> metadata, StoreVersion version)
+{
+	FieldStore::get_store_instance(version)->serialize(stream, field, metadata);
 }
 
 std::shared_ptr<IRadiationField> FieldStore::load(const std::string& file)
 {
-	StoreVersion version = FieldStore::get_store_version(file);
-	if (FieldStore::store_instance.get() == nullptr || version != FieldStore::store_version) {
-		FieldStore::init_store_instance(version);
-	}
+	std::shared_ptr<BasicFieldStore> store = FieldStore::get_store_instance(FieldStore::get_store_version(file));
 	
+	const size_t worker_count = VoxelBuffer::get_worker_count();
+	if (worker_count > 1)
+		return store->load_parallel(file, worker_count);
+
 	std::ifstream buffer(file, std::ios::in | std::ios::binary);
-	return FieldStore::store_instance->load(buffer);
+	return store->load(buffer);
 }
 
 std::shared_ptr<IRadiationField> FieldStore::load(std::istream& buffer)
 {
-	StoreVersion version = FieldStore::get_store_version(buffer);
-	if (FieldStore::store_instance.get() == nullptr || version != FieldStore::store_version) {
-		FieldStore::init_store_instance(version);
-	}
+	return FieldStore::get_store_instance(FieldStore::get_store_version(buffer))->load(buffer);
+}
 
-	return FieldStore::store_instance->load(buffer);
+std::shared_ptr<IRadiationField> FieldStore::load(const std::shared_ptr<ByteSource>& source)
+{
+	ByteSourceStream buffer(source);
+	return FieldStore::load(buffer);
+}
+
+std::shared_ptr<IRadiationField> FieldStore::load_mapped(const std::string& file)
+{
+	std::shared_ptr<MappedFile> mapped_file = std::make_shared<MappedFile>(file);
+	std::shared_ptr<FieldAccessor> accessor = FieldStore::construct_accessor(file);
+	return accessor->accessField(mapped_file);
 }
 
 std::shared_ptr<RadiationFieldMetadata> FieldStore::load_metadata(const std::string& file)
 {
-	StoreVersion version = FieldStore::get_store_version(file);
-	if (FieldStore::store_instance.get() == nullptr || version != FieldStore::store_version) {
-		FieldStore::init_store_instance(version);
-	}
+	std::shared_ptr<BasicFieldStore> store = FieldStore::get_store_instance(FieldStore::get_store_version(file));
 
 	std::ifstream buffer(file, std::ios::in | std::ios::binary);
-	return FieldStore::store_instance->load_metadata(buffer);
+	return store->load_metadata(buffer);
 }
 
 std::shared_ptr<RadiationFieldMetadata> FieldStore::load_metadata(std::istream& buffer)
 {
-	StoreVersion version = FieldStore::get_store_version(buffer);
-	if (FieldStore::store_instance.get() == nullptr || version != FieldStore::store_version) {
-		FieldStore::init_store_instance(version);
-	}
+	return FieldStore::get_store_instance(FieldStore::get_store_version(buffer))->load_metadata(buffer);
+}
 
-	return FieldStore::store_instance->load_metadata(buffer);
+std::shared_ptr<RadiationFieldMetadata> FieldStore::load_metadata(const std::shared_ptr<ByteSource>& source)
+{
+	ByteSourceStream buffer(source);
+	return FieldStore::load_metadata(buffer);
 }
 
 std::shared_ptr<VoxelLayer> FieldStore::load_single_layer(std::istream& buffer, const std::string& channel, const std::string& layer)
 {
-	StoreVersion version = FieldStore::get_store_version(buffer);
-	if (FieldStore::store_instance.get() == nullptr || version != FieldStore::store_version) {
-		FieldStore::init_store_instance(version);
-	}
-
-	return FieldStore::store_instance->load_single_layer(buffer, channel, layer);
+	return FieldStore::get_store_instance(FieldStore::get_store_version(buffer))->load_single_layer(buffer, channel, layer);
 }
 
-void FieldStore::join(std::shared_ptr<IRadiationField> field, std::shared_ptr<RadiationFieldMetadata> metadata, const std::string& file, FieldJoinMode join_mode, FieldJoinCheckMode check_mode, StoreVersion fallback_version)
+void FieldStore::check_metadata(const FiledTypes::V1::RadiationFieldMetadataHeader& target_metadata, const FiledTypes::V1::RadiationFieldMetadataHeader& source_metadata, FieldJoinCheckMode check_mode)
 {
-	FileLock file_lock(file, FieldStore::file_lock_syncronization);
-
-	if (!fs::exists(file)) {
-		if (FieldStore::store_instance.get() == nullptr)
-			FieldStore::init_store_instance(fallback_version);
-
-		FieldStore::store(field, metadata, file, FieldStore::store_version);
-		return;
-	}
-
-	Storage::V1::RadiationFieldMetadata& v1_metadata = dynamic_cast<Storage::V1::RadiationFieldMetadata&>(*metadata);
-
-	std::shared_ptr<IRadiationField> existing_field = FieldStore::load(file);
-	std::shared_ptr<RadiationFieldMetadata> _target_metadata = FieldStore::peek_metadata(file);
-	FiledTypes::V1::RadiationFieldMetadataHeader target_metadata = dynamic_cast<Storage::V1::RadiationFieldMetadata&>(*_target_metadata).get_header();
-
 	switch (check_mode) {
 		case FieldJoinCheckMode::Strict:
-			if (v1_metadata.get_header().simulation.primary_particle_count != target_metadata.simulation.primary_particle_count) {
-				std::string msg = "Primary particle count mismatch! Existing field has: " + std::to_string(target_metadata.simulation.primary_particle_count) + ", but target field has: " + std::to_string(v1_metadata.get_header().simulation.primary_particle_count);
+			if (source_metadata.simulation.primary_particle_count != target_metadata.simulation.primary_particle_count) {
+				std::string msg = "Primary particle count mismatch! Existing field has: " + std::to_string(target_metadata.simulation.primary_particle_count) + ", but target field has: " + std::to_string(source_metadata.simulation.primary_particle_count);
 				throw RadiationFieldStoreException(msg.c_str());
 			}
 			[[fallthrough]];
 		case FieldJoinCheckMode::MetadataSimulationSimilar:
-			if (std::string(v1_metadata.get_header().simulation.geometry) != std::string(target_metadata.simulation.geometry)) {
-				std::string msg = "Geometry mismatch! Existing field has: " + std::string(target_metadata.simulation.geometry) + ", but target field has: " + std::string(v1_metadata.get_header().simulation.geometry);
+			if (std::string(source_metadata.simulation.geometry) != std::string(target_metadata.simulation.geometry)) {
+				std::string msg = "Geometry mismatch! Existing field has: " + std::string(target_metadata.simulation.geometry) + ", but target field has: " + std::string(source_metadata.simulation.geometry);
 				throw RadiationFieldStoreException(msg.c_str());
 			}
-			if (std::string(v1_metadata.get_header().simulation.physics_list) != std::string(target_metadata.simulation.physics_list)) {
-				std::string msg = "Physics list mismatch! Existing field has: " + std::string(target_metadata.simulation.physics_list) + ", but target field has: " + std::string(v1_metadata.get_header().simulation.physics_list);
+			if (std::string(source_metadata.simulation.physics_list) != std::string(target_metadata.simulation.physics_list)) {
+				std::string msg = "Physics list mismatch! Existing field has: " + std::string(target_metadata.simulation.physics_list) + ", but target field has: " + std::string(source_metadata.simulation.physics_list);
 				throw RadiationFieldStoreException(msg.c_str());
 			}
-			if (v1_metadata.get_header().simulation.tube.max_energy_eV != target_metadata.simulation.tube.max_energy_eV) {
-				std::string msg = "Tube max energy mismatch! Existing field has: " + std::to_string(target_metadata.simulation.tube.max_energy_eV) + ", but target field has: " + std::to_string(v1_metadata.get_header().simulation.tube.max_energy_eV);
+			if (source_metadata.simulation.tube.max_energy_eV != target_metadata.simulation.tube.max_energy_eV) {
+				std::string msg = "Tube max energy mismatch! Existing field has: " + std::to_string(target_metadata.simulation.tube.max_energy_eV) + ", but target field has: " + std::to_string(source_metadata.simulation.tube.max_energy_eV);
 				throw RadiationFieldStoreException(msg.c_str());
 			}
-			if (v1_metadata.get_header().simulation.tube.radiation_direction != target_metadata.simulation.tube.radiation_direction) {
+			if (source_metadata.simulation.tube.radiation_direction != target_metadata.simulation.tube.radiation_direction) {
 				throw RadiationFieldStoreException("Radiation direction mismatch!");
 			}
-			if (v1_metadata.get_header().simulation.tube.radiation_origin != target_metadata.simulation.tube.radiation_origin) {
+			if (source_metadata.simulation.tube.radiation_origin != target_metadata.simulation.tube.radiation_origin) {
 				throw RadiationFieldStoreException("Radiation origin mismatch!");
 			}
-			if (std::string(v1_metadata.get_header().simulation.tube.tube_id) != std::string(target_metadata.simulation.tube.tube_id)) {
+			if (std::string(source_metadata.simulation.tube.tube_id) != std::string(target_metadata.simulation.tube.tube_id)) {
 				throw RadiationFieldStoreException("Radiation tube_id mismatch!");
 			}
 			[[fallthrough]];
 		case FieldJoinCheckMode::MetadataSoftwareEqual:
-			if (std::string(v1_metadata.get_header().software.version) != std::string(target_metadata.software.version)) {
+			if (std::string(source_metadata.software.version) != std::string(target_metadata.software.version)) {
 				throw RadiationFieldStoreException("Software version mismatch!");
 			}
-			if (std::string(v1_metadata.get_header().software.doi) != std::string(target_metadata.software.doi)) {
+			if (std::string(source_metadata.software.doi) != std::string(target_metadata.software.doi)) {
 				throw RadiationFieldStoreException("Software DOI mismatch!");
 			}
-			if (std::string(v1_metadata.get_header().software.commit) != std::string(target_metadata.software.commit)) {
+			if (std::string(source_metadata.software.commit) != std::string(target_metadata.software.commit)) {
 				throw RadiationFieldStoreException("Software commit mismatch!");
 			}
 			[[fallthrough]];
 		case FieldJoinCheckMode::MetadataSoftwareSimilar:
-			if (std::string(v1_metadata.get_header().software.name) != std::string(target_metadata.software.name)) {
+			if (std::string(source_metadata.software.name) != std::string(target_metadata.software.name)) {
 				throw RadiationFieldStoreException("Software name mismatch!");
 			}
-			if (std::string(v1_metadata.get_header().software.repository) != std::string(target_metadata.software.repository)) {
+			if (std::string(source_metadata.software.repository) != std::string(target_metadata.software.repository)) {
 				throw RadiationFieldStoreException("Software repository mismatch!");
 			}
 	}
+}
 
-	float ratio = static_cast<float>(v1_metadata.get_header().simulation.primary_particle_count) / static_cast<float>(target_metadata.simulation.primary_particle_count + v1_metadata.get_header().simulation.primary_particle_count);
+void FieldStore::join(std::shared_ptr<IRadiationField> field, std::shared_ptr<RadiationFieldMetadata> metadata, const std::string& file, FieldJoinMode join_mode, FieldJoinCheckMode check_mode, StoreVersion fallback_version)
+{
+	FileLock file_lock(file, FieldStore::file_lock_syncronization);
+
+	if (!fs::exists(file)) {
+		StoreVersion version = fallback_version;
+		{
+			std::lock_guard<std::mutex> lock(FieldStore::store_instance_mutex);
+			if (FieldStore::store_instance.get() != nullptr)
+				version = FieldStore::store_version;
+		}
+
+		FieldStore::store(field, metadata, file, version);
+		return;
+	}
+
+	Storage::V1::RadiationFieldMetadata& v1_metadata = dynamic_cast<Storage::V1::RadiationFieldMetadata&>(*metadata);
+
+	std::shared_ptr<BasicFieldStore> store = FieldStore::get_store_instance(FieldStore::get_store_version(file));
+	std::shared_ptr<RadiationFieldMetadata> _target_metadata = FieldStore::peek_metadata(file);
+	FiledTypes::V1::RadiationFieldMetadataHeader target_metadata = dynamic_cast<Storage::V1::RadiationFieldMetadata&>(*_target_metadata).get_header();
 
-	FieldStore::store_instance->join(existing_field, field, join_mode, check_mode, ratio);
+	FieldStore::check_metadata(target_metadata, v1_metadata.get_header(), check_mode);
 
-	target_metadata.simulation.primary_particle_count += v1_metadata.get_header().simulation.primary_particle_count;
+	float ratio = static_cast<float>(v1_metadata.get_header().simulation.primary_particle_count) / static_cast<float>(target_metadata.simulation.primary_particle_count + v1_metadata.get_header().simulation.primary_particle_count);
+
+	const FiledTypes::V1::RadiationFieldMetadataHeader source_metadata = v1_metadata.get_header();
+	target_metadata.simulation.primary_particle_count += source_metadata.simulation.primary_particle_count;
 	v1_metadata.set_header(target_metadata);
-	FieldStore::store_instance->store(existing_field, metadata, file);
+
+	try {
+		if (!FieldStore::in_place_join || !store->join_in_place(file, field, metadata, join_mode, check_mode, ratio))
+			store->join_file(file, field, metadata, join_mode, check_mode, ratio);
+	}
+	catch (...) {
+		v1_metadata.set_header(source_metadata);
+		throw;
+	}
 }
 
-std::shared_ptr<Storage::RadiationFieldMetadata> FieldStore::peek_metadata(const std::string& file)
+void FieldStore::merge(const std::vector<std::string>& files, const std::string& output_file, FieldJoinMode join_mode, FieldJoinCheckMode check_mode, size_t thread_count, size_t memory_budget)
 {
-	StoreVersion version = FieldStore::get_store_version(file);
-	if (FieldStore::store_instance.get() == nullptr || version != FieldStore::store_version) {
-		FieldStore::init_store_instance(version);
+	if (files.empty())
+		throw RadiationFieldStoreException("No files to merge");
+
+	switch (join_mode) {
+		case FieldJoinMode::Identity:
+		case FieldJoinMode::Add:
+		case FieldJoinMode::Multiply:
+		case FieldJoinMode::AddWeighted:
+		case FieldJoinMode::Welford:
+			break;
+		default:
+			// the result of these modes depends on the order, in which the fields are joined
+			throw RadiationFieldStoreException("Join mode " + std::to_string(static_cast<int>(join_mode)) + " can't be merged in a tree");
+	}
+
+	// the metadata of all files is checked before any field is loaded
+	const StoreVersion version = FieldStore::get_store_version(files[0]);
+	std::shared_ptr<BasicFieldStore> store = FieldStore::get_store_instance(version);
+	std::shared_ptr<RadiationFieldMetadata> metadata = FieldStore::load_metadata(files[0]);
+	const FiledTypes::V1::RadiationFieldMetadataHeader first_header = dynamic_cast<Storage::V1::RadiationFieldMetadata&>(*metadata).get_header();
+	std::vector<uint64_t> primary_particle_counts(files.size());
+	primary_particle_counts[0] = first_header.simulation.primary_particle_count;
+	for (size_t i = 1; i < files.size(); i++) {
+		std::shared_ptr<RadiationFieldMetadata> file_metadata = FieldStore::peek_metadata(files[i]);
+		const FiledTypes::V1::RadiationFieldMetadataHeader& header = dynamic_cast<Storage::V1::RadiationFieldMetadata&>(*file_metadata).get_header();
+		FieldStore::check_metadata(first_header, header, check_mode);
+		primary_particle_counts[i] = header.simulation.primary_particle_count;
 	}
 
+	struct PartialField {
+		std::shared_ptr<IRadiationField> field;
+		uint64_t primary_particle_count;
+	};
+
+	auto load_partial = [&files, &primary_particle_counts](size_t idx) {
+		return PartialField{ FieldStore::load(files[idx]), primary_particle_counts[idx] };
+	};
+
+	auto join_partials = [&store, join_mode, check_mode](PartialField& target, const PartialField& source) {
+		const float ratio = static_cast<float>(source.primary_particle_count) / static_cast<float>(target.primary_particle_count + source.primary_particle_count);
+		store->join(target.field, source.field, join_mode, check_mode, ratio);
+		target.primary_particle_count += source.primary_particle_count;
+	};
+
+	// the files are reduced along a fixed binary tree over their order, so the result does not depend on the number of threads
+	std::function<PartialField(size_t, size_t)> reduce_range = [&](size_t begin, size_t end) {
+		if (end - begin == 1)
+			return load_partial(begin);
+		const size_t middle = begin + (end - begin) / 2;
+		PartialField target = reduce_range(begin, middle);
+		PartialField source = reduce_range(middle, end);
+		join_partials(target, source);
+		return target;
+	};
+
+	size_t workers = std::min(thread_count, files.size());
+	if (workers == 0) {
+		const size_t hardware_threads = std::thread::hardware_concurrency();
+		workers = std::min<size_t>((hardware_threads > 0) ? hardware_threads : 1, files.size());
+	}
+	if (memory_budget > 0 && workers > 1) {
+		// a worker reducing a subtree holds up to one field per tree level and the one being joined into it.
+		// The size of a loaded field is taken from the layer definitions of the first file, so that it is not read an additional time
+		std::shared_ptr<FieldAccessor> accessor = FieldStore::construct_accessor(files[0]);
+		size_t field_bytes = 0;
+		for (auto& channel_name : accessor->getChannelNames()) {
+			for (auto& layer_name : accessor->getLayerNames(channel_name)) {
+				const auto& layer_block = accessor->getLayerDefinition(channel_name, layer_name);
+				field_bytes += accessor->getVoxelCount() * layer_block.elements_per_voxel * Typing::Helper::get_bytes_of_dtype(layer_block.dtype);
+			}
+		}
+		const size_t fields_per_worker = static_cast<size_t>(std::ceil(std::log2(static_cast<double>(files.size())))) + 2;
+		const size_t worker_bytes = std::max<size_t>(1, field_bytes * fields_per_worker);
+		workers = std::max<size_t>(1, std::min(workers, memory_budget / worker_bytes));
+	}
+
+	// the top levels of the tree are split into subtrees, which are reduced by the workers, and then joined on the calling thread
+	std::vector<std::pair<size_t, size_t>> subtrees;
+	std::function<void(size_t, size_t, size_t)> split_range = [&](size_t begin, size_t end, size_t depth) {
+		if (depth == 0 || end - begin == 1) {
+			subtrees.emplace_back(begin, end);
+			return;
+		}
+		const size_t middle = begin + (end - begin) / 2;
+		split_range(begin, middle, depth - 1);
+		split_range(middle, end, depth - 1);
+	};
+	size_t split_depth = 0;
+	while ((static_cast<size_t>(1) << split_depth) < workers)
+		split_depth++;
+	split_range(0, files.size(), split_depth);
+
+	std::vector<PartialField> subtree_results(subtrees.size());
+	VoxelBuffer::parallel_for(subtrees.size(), workers, [&](size_t i) {
+		subtree_results[i] = reduce_range(subtrees[i].first, subtrees[i].second);
+	});
+
+	size_t next_result = 0;
+	std::function<PartialField(size_t, size_t, size_t)> join_subtrees = [&](size_t begin, size_t end, size_t depth) {
+		if (depth == 0 || end - begin == 1)
+			return std::move(subtree_results[next_result++]);
+		const size_t middle = begin + (end - begin) / 2;
+		PartialField target = join_subtrees(begin, middle, depth - 1);
+		PartialField source = join_subtrees(middle, end, depth - 1);
+		join_partials(target, source);
+		return target;
+	};
+	PartialField result = join_subtrees(0, files.size(), split_depth);
+	subtree_results.clear();
+
+	FiledTypes::V1::RadiationFieldMetadataHeader header = first_header;
+	header.simulation.primary_particle_count = result.primary_particle_count;
+	dynamic_cast<Storage::V1::RadiationFieldMetadata&>(*metadata).set_header(header);
+	FieldStore::store(result.field, metadata, output_file, version);
+}
+
+std::shared_ptr<Storage::RadiationFieldMetadata> FieldStore::peek_metadata(const std::string& file)
+{
+	std::shared_ptr<BasicFieldStore> store = FieldStore::get_store_instance(FieldStore::get_store_version(file));
+
 	std::ifstream buffer(file, std::ios::in | std::ios::binary);
-	return FieldStore::store_instance->peek_metadata(buffer);
+	return store->peek_metadata(buffer);
 }
 
 std::shared_ptr<Storage::RadiationFieldMetadata> FieldStore::peek_metadata(std::istream& buffer)
 {
-	StoreVersion version = FieldStore::get_store_version(buffer);
-	if (FieldStore::store_instance.get() == nullptr || version != FieldStore::store_version) {
-		FieldStore::init_store_instance(version);
-	}
-
-	return FieldStore::store_instance->peek_metadata(buffer);
+	return FieldStore::get_store_instance(FieldStore::get_store_version(buffer))->peek_metadata(buffer);
 }
@@ -0,0 +1,577 @@
+#include "RadFiled3D/helpers/SIMDKernels.hpp"
+#include <atomic>
+#include <type_traits>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+    #define RF3D_SIMD_X86
+    #include <immintrin.h>
+    #if defined(_MSC_VER) && !defined(__clang__)
+        #include <intrin.h>
+    #endif
+#endif
+
+// GCC and clang only emit instructions of the extensions a function is declared for, MSVC emits all intrinsics as written
+#if defined(__GNUC__) || defined(__clang__)
+    #define RF3D_TARGET(isa) __attribute__((target(isa)))
+    #define RF3D_INLINE inline __attribute__((always_inline))
+#else
+    #define RF3D_TARGET(isa)
+    #define RF3D_INLINE __forceinline
+#endif
+
+
+using namespace RadFiled3D;
+using namespace RadFiled3D::Kernels;
+
+
+namespace {
+    template<typename T>
+    void scalar_apply(Operation op, T* dst, const T* src, size_t count)
+    {
+        switch (op) {
+        case Operation::Add:
+            for (size_t i = 0; i < count; i++)
+                dst[i] += src[i];
+            break;
+        case Operation::Subtract:
+            for (size_t i = 0; i < count; i++)
+                dst[i] -= src[i];
+            break;
+        case Operation::Multiply:
+            for (size_t i = 0; i < count; i++)
+                dst[i] *= src[i];
+            break;
+        case Operation::Divide:
+            for (size_t i = 0; i < count; i++)
+                dst[i] /= src[i];
+            break;
+        case Operation::DivideOrZero:
+            for (size_t i = 0; i < count; i++)
+                dst[i] = (src[i] == T(0)) ? T(0) : T(dst[i] / src[i]);
+            break;
+        }
+    }
+
+    template<typename T>
+    void scalar_apply(Operation op, T* dst, float scalar, size_t count)
+    {
+        switch (op) {
+        case Operation::Add:
+            for (size_t i = 0; i < count; i++)
+                dst[i] += scalar;
+            break;
+        case Operation::Subtract:
+            for (size_t i = 0; i < count; i++)
+                dst[i] -= scalar;
+            break;
+        case Operation::Multiply:
+            for (size_t i = 0; i < count; i++)
+                dst[i] *= scalar;
+            break;
+        case Operation::Divide:
+        case Operation::DivideOrZero:
+            for (size_t i = 0; i < count; i++)
+                dst[i] /= scalar;
+            break;
+        }
+    }
+
+    InstructionSet detect_instruction_set()
+    {
+#if defined(RF3D_SIMD_X86) && (defined(__GNUC__) || defined(__clang__))
+        // also checks, if the operating system saves the extended registers
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f"))
+            return InstructionSet::AVX512;
+        if (__builtin_cpu_supports("avx2"))
+            return InstructionSet::AVX2;
+        if (__builtin_cpu_supports("sse4.1"))
+            return InstructionSet::SSE4;
+#elif defined(RF3D_SIMD_X86) && defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 0);
+        const int max_leaf = info[0];
+        __cpuid(info, 1);
+        const bool sse4 = (info[2] & (1 << 19)) != 0;
+        const bool osxsave = (info[2] & (1 << 27)) != 0;
+        const unsigned long long xcr0 = osxsave ? _xgetbv(0) : 0;
+        if (max_leaf >= 7 && (xcr0 & 0x6) == 0x6) {
+            __cpuidex(info, 7, 0);
+            if ((info[1] & (1 << 16)) != 0 && (xcr0 & 0xE6) == 0xE6)
+                return InstructionSet::AVX512;
+            if ((info[1] & (1 << 5)) != 0)
+                return InstructionSet::AVX2;
+        }
+        if (sse4)
+            return InstructionSet::SSE4;
+#endif
+        return InstructionSet::Scalar;
+    }
+
+    const InstructionSet supported_instruction_set = detect_instruction_set();
+    std::atomic<InstructionSet> active_instruction_set(supported_instruction_set);
+
+#ifdef RF3D_SIMD_X86
+    /* Each instruction set provides a vector type per element type with the same static interface.
+    * The loops are defined once per instruction set, so that all intrinsics are compiled for the target of the enclosing function.
+    * run_binary returns false, if the vector type does not support the operation.
+    */
+    #define RF3D_DEFINE_KERNEL_LOOPS(TARGET) \
+        template<class V, Operation op> \
+        TARGET void binary_loop(typename V::value_type* dst, const typename V::value_type* src, size_t count) \
+        { \
+            size_t i = 0; \
+            for (; i + V::width <= count; i += V::width) \
+                V::store(dst + i, V::template apply<op>(V::load(dst + i), V::load(src + i))); \
+            scalar_apply(op, dst + i, src + i, count - i); \
+        } \
+        \
+        template<class V, Operation op> \
+        TARGET void scalar_loop(typename V::value_type* dst, typename V::value_type scalar, size_t count) \
+        { \
+            const typename V::vector_type operand = V::broadcast(scalar); \
+            size_t i = 0; \
+            for (; i + V::width <= count; i += V::width) \
+                V::store(dst + i, V::template apply<op>(V::load(dst + i), operand)); \
+            for (; i < count; i++) { \
+                typename V::value_type* element = dst + i; \
+                V::store_one(element, V::template apply<op>(V::load_one(element), operand)); \
+            } \
+        } \
+        \
+        template<class V> \
+        bool run_binary(Operation op, typename V::value_type* dst, const typename V::value_type* src, size_t count) \
+        { \
+            if (!V::supports(op)) \
+                return false; \
+            switch (op) { \
+            case Operation::Add: \
+                binary_loop<V, Operation::Add>(dst, src, count); \
+                break; \
+            case Operation::Subtract: \
+                binary_loop<V, Operation::Subtract>(dst, src, count); \
+                break; \
+            case Operation::Multiply: \
+                if constexpr (V::supports(Operation::Multiply)) \
+                    binary_loop<V, Operation::Multiply>(dst, src, count); \
+                break; \
+            case Operation::Divide: \
+                if constexpr (V::supports(Operation::Divide)) \
+                    binary_loop<V, Operation::Divide>(dst, src, count); \
+                break; \
+            case Operation::DivideOrZero: \
+                if constexpr (V::supports(Operation::DivideOrZero)) \
+                    binary_loop<V, Operation::DivideOrZero>(dst, src, count); \
+                break; \
+            } \
+            return true; \
+        } \
+        \
+        template<class V> \
+        void run_scalar(Operation op, typename V::value_type* dst, typename V::value_type scalar, size_t count) \
+        { \
+            switch (op) { \
+            case Operation::Add: \
+                scalar_loop<V, Operation::Add>(dst, scalar, count); \
+                break; \
+            case Operation::Subtract: \
+                scalar_loop<V, Operation::Subtract>(dst, scalar, count); \
+                break; \
+            case Operation::Multiply: \
+                scalar_loop<V, Operation::Multiply>(dst, scalar, count); \
+                break; \
+            case Operation::Divide: \
+            case Operation::DivideOrZero: \
+                scalar_loop<V, Operation::Divide>(dst, scalar, count); \
+                break; \
+            } \
+        }
+
+    namespace sse4 {
+        #define RF3D_SSE4 RF3D_TARGET("sse4.1")
+
+        struct Float {
+            using value_type = float;
+            using vector_type = __m128;
+            static constexpr size_t width = 4;
+            static constexpr bool supports(Operation) { return true; }
+            RF3D_SSE4 static RF3D_INLINE __m128 load(const float* p) { return _mm_loadu_ps(p); }
+            RF3D_SSE4 static RF3D_INLINE void store(float* p, __m128 v) { _mm_storeu_ps(p, v); }
+            RF3D_SSE4 static RF3D_INLINE __m128 load_one(const float* p) { return _mm_load_ss(p); }
+            RF3D_SSE4 static RF3D_INLINE void store_one(float* p, __m128 v) { _mm_store_ss(p, v); }
+            RF3D_SSE4 static RF3D_INLINE __m128 broadcast(float s) { return _mm_set1_ps(s); }
+            template<Operation op>
+            RF3D_SSE4 static RF3D_INLINE __m128 apply(__m128 a, __m128 b) {
+                if constexpr (op == Operation::Add) return _mm_add_ps(a, b);
+                else if constexpr (op == Operation::Subtract) return _mm_sub_ps(a, b);
+                else if constexpr (op == Operation::Multiply) return _mm_mul_ps(a, b);
+                else if constexpr (op == Operation::Divide) return _mm_div_ps(a, b);
+                else return _mm_andnot_ps(_mm_cmpeq_ps(b, _mm_setzero_ps()), _mm_div_ps(a, b));
+            }
+        };
+
+        struct Double {
+            using value_type = double;
+            using vector_type = __m128d;
+            static constexpr size_t width = 2;
+            static constexpr bool supports(Operation) { return true; }
+            RF3D_SSE4 static RF3D_INLINE __m128d load(const double* p) { return _mm_loadu_pd(p); }
+            RF3D_SSE4 static RF3D_INLINE void store(double* p, __m128d v) { _mm_storeu_pd(p, v); }
+            RF3D_SSE4 static RF3D_INLINE __m128d load_one(const double* p) { return _mm_load_sd(p); }
+            RF3D_SSE4 static RF3D_INLINE void store_one(double* p, __m128d v) { _mm_store_sd(p, v); }
+            RF3D_SSE4 static RF3D_INLINE __m128d broadcast(double s) { return _mm_set1_pd(s); }
+            template<Operation op>
+            RF3D_SSE4 static RF3D_INLINE __m128d apply(__m128d a, __m128d b) {
+                if constexpr (op == Operation::Add) return _mm_add_pd(a, b);
+                else if constexpr (op == Operation::Subtract) return _mm_sub_pd(a, b);
+                else if constexpr (op == Operation::Multiply) return _mm_mul_pd(a, b);
+                else if constexpr (op == Operation::Divide) return _mm_div_pd(a, b);
+                else return _mm_andnot_pd(_mm_cmpeq_pd(b, _mm_setzero_pd()), _mm_div_pd(a, b));
+            }
+        };
+
+        template<typename T>
+        struct Int32 {
+            using value_type = T;
+            using vector_type = __m128i;
+            static constexpr size_t width = 4;
+            static constexpr bool supports(Operation op) { return op == Operation::Add || op == Operation::Subtract || op == Operation::Multiply; }
+            RF3D_SSE4 static RF3D_INLINE __m128i load(const T* p) { return _mm_loadu_si128((const __m128i*)p); }
+            RF3D_SSE4 static RF3D_INLINE void store(T* p, __m128i v) { _mm_storeu_si128((__m128i*)p, v); }
+            template<Operation op>
+            RF3D_SSE4 static RF3D_INLINE __m128i apply(__m128i a, __m128i b) {
+                if constexpr (op == Operation::Add) return _mm_add_epi32(a, b);
+                else if constexpr (op == Operation::Subtract) return _mm_sub_epi32(a, b);
+                else return _mm_mullo_epi32(a, b);
+            }
+        };
+
+        struct UInt64 {
+            using value_type = uint64_t;
+            using vector_type = __m128i;
+            static constexpr size_t width = 2;
+            static constexpr bool supports(Operation op) { return op == Operation::Add || op == Operation::Subtract; }
+            RF3D_SSE4 static RF3D_INLINE __m128i load(const uint64_t* p) { return _mm_loadu_si128((const __m128i*)p); }
+            RF3D_SSE4 static RF3D_INLINE void store(uint64_t* p, __m128i v) { _mm_storeu_si128((__m128i*)p, v); }
+            template<Operation op>
+            RF3D_SSE4 static RF3D_INLINE __m128i apply(__m128i a, __m128i b) {
+                if constexpr (op == Operation::Add) return _mm_add_epi64(a, b);
+                else return _mm_sub_epi64(a, b);
+            }
+        };
+
+        RF3D_DEFINE_KERNEL_LOOPS(RF3D_SSE4)
+    }
+
+    namespace avx2 {
+        #define RF3D_AVX2 RF3D_TARGET("avx2")
+
+        struct Float {
+            using value_type = float;
+            using vector_type = __m256;
+            static constexpr size_t width = 8;
+            static constexpr bool supports(Operation) { return true; }
+            RF3D_AVX2 static RF3D_INLINE __m256 load(const float* p) { return _mm256_loadu_ps(p); }
+            RF3D_AVX2 static RF3D_INLINE void store(float* p, __m256 v) { _mm256_storeu_ps(p, v); }
+            RF3D_AVX2 static RF3D_INLINE __m256 load_one(const float* p) { return _mm256_castps128_ps256(_mm_load_ss(p)); }
+            RF3D_AVX2 static RF3D_INLINE void store_one(float* p, __m256 v) { _mm_store_ss(p, _mm256_castps256_ps128(v)); }
+            RF3D_AVX2 static RF3D_INLINE __m256 broadcast(float s) { return _mm256_set1_ps(s); }
+            template<Operation op>
+            RF3D_AVX2 static RF3D_INLINE __m256 apply(__m256 a, __m256 b) {
+                if constexpr (op == Operation::Add) return _mm256_add_ps(a, b);
+                else if constexpr (op == Operation::Subtract) return _mm256_sub_ps(a, b);
+                else if constexpr (op == Operation::Multiply) return _mm256_mul_ps(a, b);
+                else if constexpr (op == Operation::Divide) return _mm256_div_ps(a, b);
+                else return _mm256_andnot_ps(_mm256_cmp_ps(b, _mm256_setzero_ps(), _CMP_EQ_OQ), _mm256_div_ps(a, b));
+            }
+        };
+
+        struct Double {
+            using value_type = double;
+            using vector_type = __m256d;
+            static constexpr size_t width = 4;
+            static constexpr bool supports(Operation) { return true; }
+            RF3D_AVX2 static RF3D_INLINE __m256d load(const double* p) { return _mm256_loadu_pd(p); }
+            RF3D_AVX2 static RF3D_INLINE void store(double* p, __m256d v) { _mm256_storeu_pd(p, v); }
+            RF3D_AVX2 static RF3D_INLINE __m256d load_one(const double* p) { return _mm256_castpd128_pd256(_mm_load_sd(p)); }
+            RF3D_AVX2 static RF3D_INLINE void store_one(double* p, __m256d v) { _mm_store_sd(p, _mm256_castpd256_pd128(v)); }
+            RF3D_AVX2 static RF3D_INLINE __m256d broadcast(double s) { return _mm256_set1_pd(s); }
+            template<Operation op>
+            RF3D_AVX2 static RF3D_INLINE __m256d apply(__m256d a, __m256d b) {
+                if constexpr (op == Operation::Add) return _mm256_add_pd(a, b);
+                else if constexpr (op == Operation::Subtract) return _mm256_sub_pd(a, b);
+                else if constexpr (op == Operation::Multiply) return _mm256_mul_pd(a, b);
+                else if constexpr (op == Operation::Divide) return _mm256_div_pd(a, b);
+                else return _mm256_andnot_pd(_mm256_cmp_pd(b, _mm256_setzero_pd(), _CMP_EQ_OQ), _mm256_div_pd(a, b));
+            }
+        };
+
+        template<typename T>
+        struct Int32 {
+            using value_type = T;
+            using vector_type = __m256i;
+            static constexpr size_t width = 8;
+            static constexpr bool supports(Operation op) { return op == Operation::Add || op == Operation::Subtract || op == Operation::Multiply; }
+            RF3D_AVX2 static RF3D_INLINE __m256i load(const T* p) { return _mm256_loadu_si256((const __m256i*)p); }
+            RF3D_AVX2 static RF3D_INLINE void store(T* p, __m256i v) { _mm256_storeu_si256((__m256i*)p, v); }
+            template<Operation op>
+            RF3D_AVX2 static RF3D_INLINE __m256i apply(__m256i a, __m256i b) {
+                if constexpr (op == Operation::Add) return _mm256_add_epi32(a, b);
+                else if constexpr (op == Operation::Subtract) return _mm256_sub_epi32(a, b);
+                else return _mm256_mullo_epi32(a, b);
+            }
+        };
+
+        struct UInt64 {
+            using value_type = uint64_t;
+            using vector_type = __m256i;
+            static constexpr size_t width = 4;
+            static constexpr bool supports(Operation op) { return op == Operation::Add || op == Operation::Subtract; }
+            RF3D_AVX2 static RF3D_INLINE __m256i load(const uint64_t* p) { return _mm256_loadu_si256((const __m256i*)p); }
+            RF3D_AVX2 static RF3D_INLINE void store(uint64_t* p, __m256i v) { _mm256_storeu_si256((__m256i*)p, v); }
+            template<Operation op>
+            RF3D_AVX2 static RF3D_INLINE __m256i apply(__m256i a, __m256i b) {
+                if constexpr (op == Operation::Add) return _mm256_add_epi64(a, b);
+                else return _mm256_sub_epi64(a, b);
+            }
+        };
+
+        RF3D_DEFINE_KERNEL_LOOPS(RF3D_AVX2)
+    }
+
+    namespace avx512 {
+        #define RF3D_AVX512 RF3D_TARGET("avx512f")
+
+        struct Float {
+            using value_type = float;
+            using vector_type = __m512;
+            static constexpr size_t width = 16;
+            static constexpr bool supports(Operation) { return true; }
+            RF3D_AVX512 static RF3D_INLINE __m512 load(const float* p) { return _mm512_loadu_ps(p); }
+            RF3D_AVX512 static RF3D_INLINE void store(float* p, __m512 v) { _mm512_storeu_ps(p, v); }
+            RF3D_AVX512 static RF3D_INLINE __m512 load_one(const float* p) { return _mm512_maskz_loadu_ps(1, p); }
+            RF3D_AVX512 static RF3D_INLINE void store_one(float* p, __m512 v) { _mm512_mask_storeu_ps(p, 1, v); }
+            RF3D_AVX512 static RF3D_INLINE __m512 broadcast(float s) { return _mm512_set1_ps(s); }
+            template<Operation op>
+            RF3D_AVX512 static RF3D_INLINE __m512 apply(__m512 a, __m512 b) {
+                if constexpr (op == Operation::Add) return _mm512_add_ps(a, b);
+                else if constexpr (op == Operation::Subtract) return _mm512_sub_ps(a, b);
+                else if constexpr (op == Operation::Multiply) return _mm512_mul_ps(a, b);
+                else if constexpr (op == Operation::Divide) return _mm512_div_ps(a, b);
+                else return _mm512_maskz_div_ps(_mm512_cmp_ps_mask(b, _mm512_setzero_ps(), _CMP_NEQ_UQ), a, b);
+            }
+        };
+
+        struct Double {
+            using value_type = double;
+            using vector_type = __m512d;
+            static constexpr size_t width = 8;
+            static constexpr bool supports(Operation) { return true; }
+            RF3D_AVX512 static RF3D_INLINE __m512d load(const double* p) { return _mm512_loadu_pd(p); }
+            RF3D_AVX512 static RF3D_INLINE void store(double* p, __m512d v) { _mm512_storeu_pd(p, v); }
+            RF3D_AVX512 static RF3D_INLINE __m512d load_one(const double* p) { return _mm512_maskz_loadu_pd(1, p); }
+            RF3D_AVX512 static RF3D_INLINE void store_one(double* p, __m512d v) { _mm512_mask_storeu_pd(p, 1, v); }
+            RF3D_AVX512 static RF3D_INLINE __m512d broadcast(double s) { return _mm512_set1_pd(s); }
+            template<Operation op>
+            RF3D_AVX512 static RF3D_INLINE __m512d apply(__m512d a, __m512d b) {
+                if constexpr (op == Operation::Add) return _mm512_add_pd(a, b);
+                else if constexpr (op == Operation::Subtract) return _mm512_sub_pd(a, b);
+                else if constexpr (op == Operation::Multiply) return _mm512_mul_pd(a, b);
+                else if constexpr (op == Operation::Divide) return _mm512_div_pd(a, b);
+                else return _mm512_maskz_div_pd(_mm512_cmp_pd_mask(b, _mm512_setzero_pd(), _CMP_NEQ_UQ), a, b);
+            }
+        };
+
+        template<typename T>
+        struct Int32 {
+            using value_type = T;
+            using vector_type = __m512i;
+            static constexpr size_t width = 16;
+            static constexpr bool supports(Operation op) { return op == Operation::Add || op == Operation::Subtract || op == Operation::Multiply; }
+            RF3D_AVX512 static RF3D_INLINE __m512i load(const T* p) { return _mm512_loadu_si512((const void*)p); }
+            RF3D_AVX512 static RF3D_INLINE void store(T* p, __m512i v) { _mm512_storeu_si512((void*)p, v); }
+            template<Operation op>
+            RF3D_AVX512 static RF3D_INLINE __m512i apply(__m512i a, __m512i b) {
+                if constexpr (op == Operation::Add) return _mm512_add_epi32(a, b);
+                else if constexpr (op == Operation::Subtract) return _mm512_sub_epi32(a, b);
+                else return _mm512_mullo_epi32(a, b);
+            }
+        };
+
+        struct UInt64 {
+            using value_type = uint64_t;
+            using vector_type = __m512i;
+            static constexpr size_t width = 8;
+            static constexpr bool supports(Operation op) { return op == Operation::Add || op == Operation::Subtract; }
+            RF3D_AVX512 static RF3D_INLINE __m512i load(const uint64_t* p) { return _mm512_loadu_si512((const void*)p); }
+            RF3D_AVX512 static RF3D_INLINE void store(uint64_t* p, __m512i v) { _mm512_storeu_si512((void*)p, v); }
+            template<Operation op>
+            RF3D_AVX512 static RF3D_INLINE __m512i apply(__m512i a, __m512i b) {
+                if constexpr (op == Operation::Add) return _mm512_add_epi64(a, b);
+                else return _mm512_sub_epi64(a, b);
+            }
+        };
+
+        RF3D_DEFINE_KERNEL_LOOPS(RF3D_AVX512)
+    }
+
+    /** Selects the vector type for an element type and instruction set */
+    template<typename T, InstructionSet isa>
+    struct Vector {
+        using type = void;
+    };
+
+    template<> struct Vector<float, InstructionSet::SSE4> { using type = sse4::Float; };
+    template<> struct Vector<double, InstructionSet::SSE4> { using type = sse4::Double; };
+    template<> struct Vector<int32_t, InstructionSet::SSE4> { using type = sse4::Int32<int32_t>; };
+    template<> struct Vector<uint32_t, InstructionSet::SSE4> { using type = sse4::Int32<uint32_t>; };
+    template<> struct Vector<uint64_t, InstructionSet::SSE4> { using type = sse4::UInt64; };
+    template<> struct Vector<float, InstructionSet::AVX2> { using type = avx2::Float; };
+    template<> struct Vector<double, InstructionSet::AVX2> { using type = avx2::Double; };
+    template<> struct Vector<int32_t, InstructionSet::AVX2> { using type = avx2::Int32<int32_t>; };
+    template<> struct Vector<uint32_t, InstructionSet::AVX2> { using type = avx2::Int32<uint32_t>; };
+    template<> struct Vector<uint64_t, InstructionSet::AVX2> { using type = avx2::UInt64; };
+    template<> struct Vector<float, InstructionSet::AVX512> { using type = avx512::Float; };
+    template<> struct Vector<double, InstructionSet::AVX512> { using type = avx512::Double; };
+    template<> struct Vector<int32_t, InstructionSet::AVX512> { using type = avx512::Int32<int32_t>; };
+    template<> struct Vector<uint32_t, InstructionSet::AVX512> { using type = avx512::Int32<uint32_t>; };
+    template<> struct Vector<uint64_t, InstructionSet::AVX512> { using type = avx512::UInt64; };
+
+    template<typename T, InstructionSet isa>
+    bool dispatch_binary_at(Operation op, T* dst, const T* src, size_t count)
+    {
+        using V = typename Vector<T, isa>::type;
+        if constexpr (std::is_void<V>::value)
+            return false;
+        else if constexpr (isa == InstructionSet::AVX512)
+            return avx512::run_binary<V>(op, dst, src, count);
+        else if constexpr (isa == InstructionSet::AVX2)
+            return avx2::run_binary<V>(op, dst, src, count);
+        else
+            return sse4::run_binary<V>(op, dst, src, count);
+    }
+#endif
+
+    template<typename T>
+    void dispatch_binary(Operation op, T* dst, const T* src, size_t count)
+    {
+#ifdef RF3D_SIMD_X86
+        switch (active_instruction_set.load(std::memory_order_relaxed)) {
+        case InstructionSet::AVX512:
+            if (dispatch_binary_at<T, InstructionSet::AVX512>(op, dst, src, count))
+                return;
+            break;
+        case InstructionSet::AVX2:
+            if (dispatch_binary_at<T, InstructionSet::AVX2>(op, dst, src, count))
+                return;
+            break;
+        case InstructionSet::SSE4:
+            if (dispatch_binary_at<T, InstructionSet::SSE4>(op, dst, src, count))
+                return;
+            break;
+        default:
+            break;
+        }
+#endif
+        scalar_apply(op, dst, src, count);
+    }
+
+    template<typename T>
+    void dispatch_scalar(Operation op, T* dst, float scalar, size_t count)
+    {
+#ifdef RF3D_SIMD_X86
+        switch (active_instruction_set.load(std::memory_order_relaxed)) {
+        case InstructionSet::AVX512:
+            avx512::run_scalar<typename Vector<T, InstructionSet::AVX512>::type>(op, dst, scalar, count);
+            return;
+        case InstructionSet::AVX2:
+            avx2::run_scalar<typename Vector<T, InstructionSet::AVX2>::type>(op, dst, scalar, count);
+            return;
+        case InstructionSet::SSE4:
+            sse4::run_scalar<typename Vector<T, InstructionSet::SSE4>::type>(op, dst, scalar, count);
+            return;
+        default:
+            break;
+        }
+#endif
+        scalar_apply(op, dst, scalar, count);
+    }
+}
+
+InstructionSet Kernels::get_supported_instruction_set()
+{
+    return supported_instruction_set;
+}
+
+InstructionSet Kernels::get_instruction_set()
+{
+    return active_instruction_set;
+}
+
+InstructionSet Kernels::set_instruction_set(InstructionSet instruction_set)
+{
+    if (static_cast<int>(instruction_set) > static_cast<int>(supported_instruction_set))
+        instruction_set = supported_instruction_set;
+    active_instruction_set = instruction_set;
+    return instruction_set;
+}
+
+void Kernels::apply(Operation op, float* dst, const float* src, size_t count)
+{
+    dispatch_binary(op, dst, src, count);
+}
+
+void Kernels::apply(Operation op, double* dst, const double* src, size_t count)
+{
+    dispatch_binary(op, dst, src, count);
+}
+
+void Kernels::apply(Operation op, int32_t* dst, const int32_t* src, size_t count)
+{
+    dispatch_binary(op, dst, src, count);
+}
+
+void Kernels::apply(Operation op, uint32_t* dst, const uint32_t* src, size_t count)
+{
+    dispatch_binary(op, dst, src, count);
+}
+
+void Kernels::apply(Operation op, uint64_t* dst, const uint64_t* src, size_t count)
+{
+    dispatch_binary(op, dst, src, count);
+}
+
+void Kernels::apply(Operation op, char* dst, const char* src, size_t count)
+{
+    scalar_apply(op, dst, src, count);
+}
+
+void Kernels::apply(Operation op, float* dst, float scalar, size_t count)
+{
+    dispatch_scalar(op, dst, scalar, count);
+}
+
+void Kernels::apply(Operation op, double* dst, float scalar, size_t count)
+{
+    dispatch_scalar(op, dst, scalar, count);
+}
+
+void Kernels::apply(Operation op, int32_t* dst, float scalar, size_t count)
+{
+    scalar_apply(op, dst, scalar, count);
+}
+
+void Kernels::apply(Operation op, uint32_t* dst, float scalar, size_t count)
+{
+    scalar_apply(op, dst, scalar, count);
+}
+
+void Kernels::apply(Operation op, uint64_t* dst, float scalar, size_t count)
+{
+    scalar_apply(op, dst, scalar, count);
+}
+
+void Kernels::apply(Operation op, char* dst, float scalar, size_t count)
+{
+    scalar_apply(op, dst, scalar, count);
+}
@@ -2,62 +2,191 @@
 #include <glm/vec2.hpp>
 #include <glm/vec3.hpp>
 #include <glm/vec4.hpp>
+#include <thread>
+#include <exception>
+#include <mutex>
 
 
 using namespace RadFiled3D;
 
-template<typename T>
-void add_layers_together(char* this_layer_data, char* other_layer_data, size_t element_count)
-{
-	T* this_data = (T*)this_layer_data;
-	T* other_data = (T*)other_layer_data;
+std::atomic<bool> VoxelLayer::compact_by_default(false);
+std::atomic<size_t> VoxelBuffer::worker_count(1);
+
+/** The voxel objects of a compact layer are created in pages of VOXEL_PAGE_SIZE voxels, when a voxel of the page is first accessed by reference.
+* The pages never move, so references stay valid as long as the layer. Created pages are looked up without locking.
+*/
+struct VoxelLayer::VoxelPages {
+	std::mutex mutex;
+	std::unique_ptr<std::atomic<char*>[]> pages;
+	size_t page_count;
+	size_t page_bytes;
+	std::shared_ptr<ILayerAllocator> allocator;
+
+	VoxelPages(size_t voxel_count, size_t bytes_per_voxel)
+		: pages(new std::atomic<char*>[(voxel_count + VOXEL_PAGE_SIZE - 1) / VOXEL_PAGE_SIZE]),
+		page_count((voxel_count + VOXEL_PAGE_SIZE - 1) / VOXEL_PAGE_SIZE),
+		page_bytes(VOXEL_PAGE_SIZE * bytes_per_voxel),
+		allocator(ILayerAllocator::get_default())
+	{
+		for (size_t i = 0; i < this->page_count; i++)
+			this->pages[i].store(nullptr, std::memory_order_relaxed);
+	}
 
-	for (size_t i = 0; i < element_count; i++)
+	~VoxelPages()
 	{
-		this_data[i] += other_data[i];
+		for (size_t i = 0; i < this->page_count; i++)
+			this->allocator->deallocate(this->pages[i].load(std::memory_order_relaxed), this->page_bytes);
 	}
-}
+};
 
-template<typename T>
-void multiply_layers_together(char* this_layer_data, char* other_layer_data, size_t element_count)
-{
-	T* this_data = (T*)this_layer_data;
-	T* other_data = (T*)other_layer_data;
+namespace {
+	/** Applies an operation to the data buffers of two layers of the same data type
+	* Multi component layers are processed as flat arrays of their components.
+	*/
+	void apply_to_layer_data(Kernels::Operation op, Typing::DType dtype, char* this_layer_data, const char* other_layer_data, size_t voxel_count, size_t bytes_per_voxel_data)
+	{
+		switch (dtype)
+		{
+		case Typing::DType::Float:
+		case Typing::DType::Vec2:
+		case Typing::DType::Vec3:
+		case Typing::DType::Vec4:
+			Kernels::apply(op, (float*)this_layer_data, (const float*)other_layer_data, voxel_count * bytes_per_voxel_data / sizeof(float));
+			break;
+		case Typing::DType::Hist:
+			// a bin divided by an empty bin is 0, as by HistogramVoxel::operator/=
+			Kernels::apply((op == Kernels::Operation::Divide) ? Kernels::Operation::DivideOrZero : op, (float*)this_layer_data, (const float*)other_layer_data, voxel_count * bytes_per_voxel_data / sizeof(float));
+			break;
+		case Typing::DType::Double:
+#if defined(__x86_64__) || defined(_M_X64)
+			Kernels::apply(op, (double*)this_layer_data, (const double*)other_layer_data, voxel_count);
+#else
+			throw std::runtime_error("Can't use 64-bit data type in 32-bit system!");
+#endif
+			break;
+		case Typing::DType::Int:
+			Kernels::apply(op, (int32_t*)this_layer_data, (const int32_t*)other_layer_data, voxel_count);
+			break;
+		case Typing::DType::Char:
+			Kernels::apply(op, this_layer_data, other_layer_data, voxel_count);
+			break;
+		case Typing::DType::UInt64:
+#if defined(__x86_64__) || defined(_M_X64)
+			Kernels::apply(op, (uint64_t*)this_layer_data, (const uint64_t*)other_layer_data, voxel_count);
+#else
+			throw std::runtime_error("Can't use 64-bit data type in 32-bit system!");
+#endif
+			break;
+		case Typing::DType::UInt32:
+			Kernels::apply(op, (uint32_t*)this_layer_data, (const uint32_t*)other_layer_data, voxel_count);
+			break;
+		}
+	}
 
-	for (size_t i = 0; i < element_count; i++)
+	/** Applies an operation with a scalar to the data buffer of a layer */
+	void apply_to_layer_data(Kernels::Operation op, Typing::DType dtype, char* this_layer_data, float scalar, size_t voxel_count, size_t bytes_per_voxel_data)
 	{
-		this_data[i] *= other_data[i];
+		switch (dtype)
+		{
+		case Typing::DType::Float:
+		case Typing::DType::Vec2:
+		case Typing::DType::Vec3:
+		case Typing::DType::Vec4:
+		case Typing::DType::Hist:
+			Kernels::apply(op, (float*)this_layer_data, scalar, voxel_count * bytes_per_voxel_data / sizeof(float));
+			break;
+		case Typing::DType::Double:
+			Kernels::apply(op, (double*)this_layer_data, scalar, voxel_count);
+			break;
+		case Typing::DType::Int:
+			Kernels::apply(op, (int32_t*)this_layer_data, scalar, voxel_count);
+			break;
+		case Typing::DType::Char:
+			Kernels::apply(op, this_layer_data, scalar, voxel_count);
+			break;
+		case Typing::DType::UInt64:
+			Kernels::apply(op, (uint64_t*)this_layer_data, scalar, voxel_count);
+			break;
+		case Typing::DType::UInt32:
+			Kernels::apply(op, (uint32_t*)this_layer_data, scalar, voxel_count);
+			break;
+		}
 	}
 }
 
-template<typename T>
-void divide_layers_together(char* this_layer_data, char* other_layer_data, size_t element_count)
+
+VoxelBuffer::VoxelBuffer(size_t voxel_count)
+	: voxel_count(voxel_count)
 {
-	T* this_data = (T*)this_layer_data;
-	T* other_data = (T*)other_layer_data;
+}
 
-	for (size_t i = 0; i < element_count; i++)
-	{
-		this_data[i] /= other_data[i];
-	}
+void VoxelBuffer::set_worker_count(size_t worker_count)
+{
+	VoxelBuffer::worker_count = worker_count;
 }
 
-template<typename T>
-void subtract_layers_together(char* this_layer_data, char* other_layer_data, size_t element_count)
+size_t VoxelBuffer::get_worker_count()
 {
-	T* this_data = (T*)this_layer_data;
-	T* other_data = (T*)other_layer_data;
+	const size_t workers = VoxelBuffer::worker_count;
+	if (workers > 0)
+		return workers;
+	const size_t hardware_threads = std::thread::hardware_concurrency();
+	return (hardware_threads > 0) ? hardware_threads : 1;
+}
 
-	for (size_t i = 0; i < element_count; i++)
-	{
-		this_data[i] -= other_data[i];
+void VoxelBuffer::for_each_chunk(size_t count, size_t bytes_per_voxel, const std::function<void(size_t begin, size_t end)>& body)
+{
+	bytes_per_voxel = std::max<size_t>(bytes_per_voxel, 1);
+	const size_t total_bytes = count * bytes_per_voxel;
+	const size_t workers = std::min(VoxelBuffer::get_worker_count(), total_bytes / MIN_BYTES_PER_WORKER);
+	if (workers <= 1) {
+		if (count > 0)
+			body(0, count);
+		return;
 	}
-}
 
+	const size_t chunk_voxels = std::max<size_t>(CHUNK_BYTES / bytes_per_voxel, 1);
+	const size_t chunk_count = (count + chunk_voxels - 1) / chunk_voxels;
+	VoxelBuffer::parallel_for(chunk_count, workers, [&](size_t chunk) {
+		body(chunk * chunk_voxels, std::min((chunk + 1) * chunk_voxels, count));
+	});
+}
 
-VoxelBuffer::VoxelBuffer(size_t voxel_count)
-	: voxel_count(voxel_count)
+void VoxelBuffer::parallel_for(size_t count, size_t workers, const std::function<void(size_t index)>& body)
 {
+	workers = std::min(workers, count);
+	if (workers <= 1) {
+		for (size_t i = 0; i < count; i++)
+			body(i);
+		return;
+	}
+
+	// each thread takes the next index that is not yet processed, the first error is rethrown after all threads finished
+	std::atomic<size_t> next_index(0);
+	std::atomic<bool> failed(false);
+	std::vector<std::exception_ptr> errors(workers);
+	auto work = [&](size_t w) {
+		try {
+			for (size_t i = next_index++; i < count && !failed; i = next_index++)
+				body(i);
+		}
+		catch (...) {
+			errors[w] = std::current_exception();
+			failed = true;
+		}
+	};
+
+	std::vector<std::thread> threads;
+	threads.reserve(workers - 1);
+	for (size_t w = 1; w < workers; w++)
+		threads.emplace_back(work, w);
+	work(0);
+	for (auto& thread : threads)
+		thread.join();
+	for (auto& error : errors) {
+		if (error)
+			std::rethrow_exception(error);
+	}
 }
 
 bool VoxelBuffer::operator==(VoxelBuffer const& other) const
@@ -101,6 +230,41 @@ VoxelLayer::VoxelLayer(size_t bytes_per_voxel, size_t bytes_per_data_element, ch
 	this->unit = unit;
 	this->statistical_error = statistical_error;
 	this->shall_free_buffers = shall_free_buffers;
+	if (voxels != nullptr && voxel_count > 0)
+		this->bytes_per_voxel_data = ((IVoxel*)voxels)->get_bytes();
+}
+
+VoxelLayer::VoxelLayer(const IVoxel& voxel_template, size_t bytes_per_data_element, char* data, const std::string& unit, float statistical_error, size_t voxel_count, bool shall_free_buffers)
+	: VoxelLayer(voxel_template, bytes_per_data_element, data, unit, statistical_error, voxel_count, shall_free_buffers, VoxelLayer::compact_by_default && voxel_count > 1)
+{
+}
+
+VoxelLayer::VoxelLayer(const IVoxel& voxel_template, size_t bytes_per_data_element, char* data, const std::string& unit, float statistical_error, size_t voxel_count, bool shall_free_buffers, bool compact)
+{
+	this->voxel_count = voxel_count;
+	this->bytes_per_voxel = voxel_template.get_voxel_bytes();
+	this->bytes_per_data_element = bytes_per_data_element;
+	this->bytes_per_voxel_data = voxel_template.get_bytes();
+	this->data = data;
+	this->voxels = nullptr;
+	this->unit = unit;
+	this->statistical_error = statistical_error;
+	this->shall_free_buffers = shall_free_buffers;
+
+	if (compact) {
+		if (this->bytes_per_voxel > MAX_VOXEL_OBJECT_BYTES)
+			throw VoxelBufferException("Voxel objects of " + std::to_string(this->bytes_per_voxel) + " bytes are too large for compact layers");
+		std::memcpy(this->prototype, (const void*)&voxel_template, this->bytes_per_voxel);
+		this->voxel_pages = std::make_shared<VoxelPages>(voxel_count, this->bytes_per_voxel);
+		return;
+	}
+
+	this->voxel_allocator = ILayerAllocator::get_default();
+	this->voxels = this->voxel_allocator->allocate(voxel_count * this->bytes_per_voxel);
+	for (size_t i = 0; i < voxel_count; i++) {
+		std::memcpy(this->voxels + i * this->bytes_per_voxel, (const void*)&voxel_template, this->bytes_per_voxel);
+		((IVoxel*)(this->voxels + i * this->bytes_per_voxel))->set_data((void*)(data + i * this->bytes_per_voxel_data));
+	}
 }
 
 VoxelLayer::VoxelLayer()
@@ -120,15 +284,88 @@ VoxelLayer::~VoxelLayer()
 		this->free_buffers();
 }
 
+void VoxelLayer::set_compact_by_default(bool compact)
+{
+	VoxelLayer::compact_by_default = compact;
+}
+
+bool VoxelLayer::is_compact_by_default()
+{
+	return VoxelLayer::compact_by_default;
+}
+
+IVoxel* VoxelLayer::get_paged_voxel(size_t idx) const
+{
+	VoxelPages& pages = *this->voxel_pages;
+	const size_t page_idx = idx / VOXEL_PAGE_SIZE;
+	char* page = pages.pages[page_idx].load(std::memory_order_acquire);
+	if (page == nullptr) {
+		std::lock_guard<std::mutex> lock(pages.mutex);
+		page = pages.pages[page_idx].load(std::memory_order_relaxed);
+		if (page == nullptr) {
+			page = pages.allocator->allocate(pages.page_bytes);
+			const size_t first_voxel = page_idx * VOXEL_PAGE_SIZE;
+			const size_t page_voxels = std::min(VOXEL_PAGE_SIZE, this->voxel_count - first_voxel);
+			for (size_t i = 0; i < page_voxels; i++) {
+				std::memcpy(page + i * this->bytes_per_voxel, this->prototype, this->bytes_per_voxel);
+				((IVoxel*)(page + i * this->bytes_per_voxel))->set_data((void*)(this->data + (first_voxel + i) * this->bytes_per_voxel_data));
+			}
+			pages.pages[page_idx].store(page, std::memory_order_release);
+		}
+	}
+	return (IVoxel*)(page + (idx % VOXEL_PAGE_SIZE) * this->bytes_per_voxel);
+}
+
+void VoxelLayer::compact()
+{
+	if (this->voxels == nullptr)
+		return;
+	if (this->bytes_per_voxel > MAX_VOXEL_OBJECT_BYTES)
+		throw VoxelBufferException("Voxel objects of " + std::to_string(this->bytes_per_voxel) + " bytes are too large for compact layers");
+
+	std::memcpy(this->prototype, this->voxels, this->bytes_per_voxel);
+	this->free_voxels();
+	this->voxel_pages = std::make_shared<VoxelPages>(this->voxel_count, this->bytes_per_voxel);
+}
+
+VoxelLayer VoxelLayer::deep_copy() const
+{
+	std::shared_ptr<ILayerAllocator> allocator = ILayerAllocator::get_default();
+	char* data = allocator->allocate(this->voxel_count * this->bytes_per_voxel_data);
+	std::memcpy(data, this->data, this->voxel_count * this->bytes_per_voxel_data);
+
+	VoxelLayer copy(*this->get_prototype(), this->bytes_per_data_element, data, this->unit, this->statistical_error, this->voxel_count, false, this->is_compact());
+	copy.data_allocator = allocator;
+	return copy;
+}
+
 void VoxelLayer::free_buffers() noexcept
 {
-	if (this->data != nullptr)
-		delete[] this->data;
-	if (this->voxels != nullptr)
-		delete[] this->voxels;
+	if (this->data != nullptr && this->data_owner == nullptr) {
+		if (this->data_allocator != nullptr)
+			this->data_allocator->deallocate(this->data, this->voxel_count * this->bytes_per_voxel_data);
+		else
+			delete[] this->data;
+	}
+	this->free_voxels();
 
 	this->data = nullptr;
+	this->data_owner.reset();
+	this->data_allocator.reset();
+}
+
+void VoxelLayer::free_voxels() noexcept
+{
+	if (this->voxels != nullptr) {
+		if (this->voxel_allocator != nullptr)
+			this->voxel_allocator->deallocate(this->voxels, this->voxel_count * this->bytes_per_voxel);
+		else
+			delete[] this->voxels;
+	}
+
 	this->voxels = nullptr;
+	this->voxel_allocator.reset();
+	this->voxel_pages.reset();
 }
 
 VoxelBuffer::~VoxelBuffer()
@@ -139,25 +376,48 @@ VoxelBuffer::~VoxelBuffer()
 	}
 }
 
+void VoxelBuffer::insert_layer(const std::string& name, VoxelLayer* layer)
+{
+	if (layer->voxel_count != this->voxel_count) {
+		layer->free_buffers();
+		delete layer;
+		throw VoxelBufferException("Layer: '" + name + "' has a different voxel count than the buffer");
+	}
+	if (this->has_layer(name)) {
+		layer->free_buffers();
+		delete layer;
+		throw VoxelBufferException("Layer: '" + name + "' already exists in the buffer");
+	}
+
+	// The buffers are freed by the VoxelBuffer destructor, not by the copies of the layer
+	layer->shall_free_buffers = false;
+	this->layers.insert({
+		name,
+		*layer
+	});
+	delete layer;
+}
+
+void VoxelBuffer::compact_layers()
+{
+	for (auto& layer : this->layers)
+		layer.second.compact();
+}
+
 VoxelBuffer* VoxelBuffer::copy() const
 {
 	VoxelBuffer* copy = new VoxelBuffer(this->voxel_count);
 
 	for (auto& layer : this->layers)
 	{
-		auto& layer_info = layer.second;
-		auto data = new char[this->voxel_count * layer_info.bytes_per_data_element];
-		auto voxels = new char[this->voxel_count * layer_info.bytes_per_voxel];
-		memcpy(data, layer_info.data, this->voxel_count * layer_info.bytes_per_data_element);
-		memcpy(voxels, layer_info.voxels, this->voxel_count * layer_info.bytes_per_voxel);
-		copy->layers[layer.first] = VoxelLayer(layer_info.bytes_per_voxel, layer_info.bytes_per_data_element, voxels, data, layer_info.unit, layer_info.statistical_error, this->voxel_count);
+		copy->layers[layer.first] = layer.second.deep_copy();
 	}
 
 	return copy;
 }
 
 
-VoxelBuffer& VoxelBuffer::operator+=(const VoxelBuffer& other)
+void VoxelBuffer::apply_operation(const VoxelBuffer& other, Kernels::Operation op)
 {
 	if (this->voxel_count != other.voxel_count)
 		throw std::runtime_error("Voxel count mismatch");
@@ -173,612 +433,68 @@ VoxelBuffer& VoxelBuffer::operator+=(const VoxelBuffer& other)
 		auto dtype2 = Typing::Helper::get_dtype(other.get_type(layer.first));
 		if (dtype1 != dtype2)
 			throw std::runtime_error("Data type mismatch");
-		auto layer_info = this->layers.find(layer.first);
-		if (other_layer_info->second.bytes_per_data_element != layer_info->second.bytes_per_data_element)
+		if (other_layer_info->second.bytes_per_data_element != layer.second.bytes_per_data_element || other_layer_info->second.bytes_per_voxel_data != layer.second.bytes_per_voxel_data)
 			throw std::runtime_error("Data element size mismatch");
 
-		
-
-		char* other_layer_data = other.get_layer<char>(layer.first);
-		char* this_layer_data = this->get_layer<char>(layer.first);
-
-		switch (dtype1)
-		{
-		case Typing::DType::Float:
-			add_layers_together<float>(this_layer_data, other_layer_data, this->voxel_count);
-			break;
-		case Typing::DType::Double:
-#if defined(__x86_64__) || defined(_M_X64)
-			add_layers_together<double>(this_layer_data, other_layer_data, this->voxel_count);
-#else
-			throw std::runtime_error("Can't use 64-bit data type in 32-bit system!");
-#endif
-			break;
-		case Typing::DType::Int:
-			add_layers_together<int>(this_layer_data, other_layer_data, this->voxel_count);
-			break;
-		case Typing::DType::Char:
-			add_layers_together<char>(this_layer_data, other_layer_data, this->voxel_count);
-			break;
-		case Typing::DType::Vec2:
-			add_layers_together<glm::vec2>(this_layer_data, other_layer_data, this->voxel_count);
-			break;
-		case Typing::DType::Vec3:
-			add_layers_together<glm::vec3>(this_layer_data, other_layer_data, this->voxel_count);
-			break;
-		case Typing::DType::Vec4:
-			add_layers_together<glm::vec4>(this_layer_data, other_layer_data, this->voxel_count);
-			break;
-		case Typing::DType::UInt64:
-#if defined(__x86_64__) || defined(_M_X64)
-			add_layers_together<uint64_t>(this_layer_data, other_layer_data, this->voxel_count);
-#else
-			throw std::runtime_error("Can't use 64-bit data type in 32-bit system!");
-#endif
-			break;
-		case Typing::DType::UInt32:
-			add_layers_together<uint32_t>(this_layer_data, other_layer_data, this->voxel_count);
-			break;
-		case Typing::DType::Hist:
-			for (size_t i = 0; i < this->voxel_count; i++)
-			{
-				auto hist1 = (HistogramVoxel*)(layer_info->second.voxels + i * layer_info->second.bytes_per_voxel);
-				auto hist2 = (HistogramVoxel*)(other_layer_info->second.voxels + i * layer_info->second.bytes_per_voxel);
-				*hist1 += *hist2;
-			}
-			break;
-		}
+		const size_t bytes_per_voxel_data = layer.second.bytes_per_voxel_data;
+		char* this_layer_data = layer.second.data;
+		const char* other_layer_data = other_layer_info->second.data;
+		VoxelBuffer::for_each_chunk(this->voxel_count, bytes_per_voxel_data, [=](size_t begin, size_t end) {
+			apply_to_layer_data(op, dtype1, this_layer_data + begin * bytes_per_voxel_data, other_layer_data + begin * bytes_per_voxel_data, end - begin, bytes_per_voxel_data);
+		});
 	}
-
-	return *this;
 }
 
-VoxelBuffer& VoxelBuffer::operator*=(const VoxelBuffer& other) {
-	if (this->voxel_count != other.voxel_count)
-		throw std::runtime_error("Voxel count mismatch");
-
+void VoxelBuffer::apply_operation(float scalar, Kernels::Operation op)
+{
 	for (auto& layer : this->layers)
 	{
-		auto other_layer_info = other.layers.find(layer.first);
-		if (other_layer_info == other.layers.end())
-			throw std::runtime_error("Layer: '" + layer.first + "' not found in other");
-		if (layer.second.unit != other_layer_info->second.unit)
-			throw std::runtime_error("Unit mismatch");
-		auto dtype1 = Typing::Helper::get_dtype(this->get_type(layer.first));
-		auto dtype2 = Typing::Helper::get_dtype(other.get_type(layer.first));
-		if (dtype1 != dtype2)
-			throw std::runtime_error("Data type mismatch");
-		auto layer_info = this->layers.find(layer.first);
-		if (other_layer_info->second.bytes_per_data_element != layer_info->second.bytes_per_data_element)
-			throw std::runtime_error("Data element size mismatch");
-
-		char* other_layer_data = other.get_layer<char>(layer.first);
-		char* this_layer_data = this->get_layer<char>(layer.first);
-
-		switch (dtype1)
-		{
-		case Typing::DType::Float:
-			multiply_layers_together<float>(this_layer_data, other_layer_data, this->voxel_count);
-			break;
-		case Typing::DType::Double:
-#if defined(__x86_64__) || defined(_M_X64)
-			multiply_layers_together<double>(this_layer_data, other_layer_data, this->voxel_count);
-#else
-			throw std::runtime_error("Can't use 64-bit data type in 32-bit system!");
-#endif
-			break;
-		case Typing::DType::Int:
-			multiply_layers_together<int>(this_layer_data, other_layer_data, this->voxel_count);
-			break;
-		case Typing::DType::Char:
-			multiply_layers_together<char>(this_layer_data, other_layer_data, this->voxel_count);
-			break;
-		case Typing::DType::Vec2:
-			multiply_layers_together<glm::vec2>(this_layer_data, other_layer_data, this->voxel_count);
-			break;
-		case Typing::DType::Vec3:
-			multiply_layers_together<glm::vec3>(this_layer_data, other_layer_data, this->voxel_count);
-			break;
-		case Typing::DType::Vec4:
-			multiply_layers_together<glm::vec4>(this_layer_data, other_layer_data, this->voxel_count);
-			break;
-		case Typing::DType::UInt64:
-#if defined(__x86_64__) || defined(_M_X64)
-			multiply_layers_together<uint64_t>(this_layer_data, other_layer_data, this->voxel_count);
-#else
-			throw std::runtime_error("Can't use 64-bit data type in 32-bit system!");
-#endif
-			break;
-		case Typing::DType::UInt32:
-			multiply_layers_together<uint32_t>(this_layer_data, other_layer_data, this->voxel_count);
-			break;
-		case Typing::DType::Hist:
-			for (size_t i = 0; i < this->voxel_count; i++)
-			{
-				auto hist1 = (HistogramVoxel*)(layer_info->second.voxels + i * layer_info->second.bytes_per_voxel);
-				auto hist2 = (HistogramVoxel*)(other_layer_info->second.voxels + i * layer_info->second.bytes_per_voxel);
-				*hist1 *= *hist2;
-			}
-			break;
-		}
+		const Typing::DType dtype = Typing::Helper::get_dtype(this->get_type(layer.first));
+		const size_t bytes_per_voxel_data = layer.second.bytes_per_voxel_data;
+		char* this_layer_data = layer.second.data;
+		VoxelBuffer::for_each_chunk(this->voxel_count, bytes_per_voxel_data, [=](size_t begin, size_t end) {
+			apply_to_layer_data(op, dtype, this_layer_data + begin * bytes_per_voxel_data, scalar, end - begin, bytes_per_voxel_data);
+		});
 	}
+}
 
+VoxelBuffer& VoxelBuffer::operator+=(const VoxelBuffer& other)
+{
+	this->apply_operation(other, Kernels::Operation::Add);
 	return *this;
 }
 
-VoxelBuffer& VoxelBuffer::operator-=(const VoxelBuffer& other) {
-	if (this->voxel_count != other.voxel_count)
-		throw std::runtime_error("Voxel count mismatch");
-
-	for (auto& layer : this->layers)
-	{
-		auto other_layer_info = other.layers.find(layer.first);
-		if (other_layer_info == other.layers.end())
-			throw std::runtime_error("Layer: '" + layer.first + "' not found in other");
-		if (layer.second.unit != other_layer_info->second.unit)
-			throw std::runtime_error("Unit mismatch");
-		auto dtype1 = Typing::Helper::get_dtype(this->get_type(layer.first));
-		auto dtype2 = Typing::Helper::get_dtype(other.get_type(layer.first));
-		if (dtype1 != dtype2)
-			throw std::runtime_error("Data type mismatch");
-		auto layer_info = this->layers.find(layer.first);
-		if (other_layer_info->second.bytes_per_data_element != layer_info->second.bytes_per_data_element)
-			throw std::runtime_error("Data element size mismatch");
-
-		char* other_layer_data = other.get_layer<char>(layer.first);
-		char* this_layer_data = this->get_layer<char>(layer.first);
-
-		switch (dtype1)
-		{
-		case Typing::DType::Float:
-			subtract_layers_together<float>(this_layer_data, other_layer_data, this->voxel_count);
-			break;
-		case Typing::DType::Double:
-#if defined(__x86_64__) || defined(_M_X64)
-			subtract_layers_together<double>(this_layer_data, other_layer_data, this->voxel_count);
-#else
-			throw std::runtime_error("Can't use 64-bit data type in 32-bit system!");
-#endif
-			break;
-		case Typing::DType::Int:
-			subtract_layers_together<int>(this_layer_data, other_layer_data, this->voxel_count);
-			break;
-		case Typing::DType::Char:
-			subtract_layers_together<char>(this_layer_data, other_layer_data, this->voxel_count);
-			break;
-		case Typing::DType::Vec2:
-			subtract_layers_together<glm::vec2>(this_layer_data, other_layer_data, this->voxel_count);
-			break;
-		case Typing::DType::Vec3:
-			subtract_layers_together<glm::vec3>(this_layer_data, other_layer_data, this->voxel_count);
-			break;
-		case Typing::DType::Vec4:
-			subtract_layers_together<glm::vec4>(this_layer_data, other_layer_data, this->voxel_count);
-			break;
-		case Typing::DType::UInt64:
-#if defined(__x86_64__) || defined(_M_X64)
-			subtract_layers_together<uint64_t>(this_layer_data, other_layer_data, this->voxel_count);
-#else
-			throw std::runtime_error("Can't use 64-bit data type in 32-bit system!");
-#endif
-			break;
-		case Typing::DType::UInt32:
-			subtract_layers_together<uint32_t>(this_layer_data, other_layer_data, this->voxel_count);
-			break;
-		case Typing::DType::Hist:
-			for (size_t i = 0; i < this->voxel_count; i++)
-			{
-				auto hist1 = (HistogramVoxel*)(layer_info->second.voxels + i * layer_info->second.bytes_per_voxel);
-				auto hist2 = (HistogramVoxel*)(other_layer_info->second.voxels + i * layer_info->second.bytes_per_voxel);
-				*hist1 -= *hist2;
-			}
-			break;
-		}
-	}
+VoxelBuffer& VoxelBuffer::operator*=(const VoxelBuffer& other) {
+	this->apply_operation(other, Kernels::Operation::Multiply);
+	return *this;
+}
 
+VoxelBuffer& VoxelBuffer::operator-=(const VoxelBuffer& other) {
+	this->apply_operation(other, Kernels::Operation::Subtract);
 	return *this;
 }
 
 VoxelBuffer& VoxelBuffer::operator/=(const VoxelBuffer& other) {
-	if (this->voxel_count != other.voxel_count)
-		throw std::runtime_error("Voxel count mismatch");
-
-	for (auto& layer : this->layers)
-	{
-		auto other_layer_info = other.layers.find(layer.first);
-		if (other_layer_info == other.layers.end())
-			throw std::runtime_error("Layer: '" + layer.first + "' not found in other");
-		if (layer.second.unit != other_layer_info->second.unit)
-			throw std::runtime_error("Unit mismatch");
-		auto dtype1 = Typing::Helper::get_dtype(this->get_type(layer.first));
-		auto dtype2 = Typing::Helper::get_dtype(other.get_type(layer.first));
-		if (dtype1 != dtype2)
-			throw std::runtime_error("Data type mismatch");
-		auto layer_info = this->layers.find(layer.first);
-		if (other_layer_info->second.bytes_per_data_element != layer_info->second.bytes_per_data_element)
-			throw std::runtime_error("Data element size mismatch");
-
-		char* other_layer_data = other.get_layer<char>(layer.first);
-		char* this_layer_data = this->get_layer<char>(layer.first);
-
-		switch (dtype1)
-		{
-		case Typing::DType::Float:
-			divide_layers_together<float>(this_layer_data, other_layer_data, this->voxel_count);
-			break;
-		case Typing::DType::Double:
-#if defined(__x86_64__) || defined(_M_X64)
-			divide_layers_together<double>(this_layer_data, other_layer_data, this->voxel_count);
-#else
-			throw std::runtime_error("Can't use 64-bit data type in 32-bit system!");
-#endif
-			break;
-		case Typing::DType::Int:
-			divide_layers_together<int>(this_layer_data, other_layer_data, this->voxel_count);
-			break;
-		case Typing::DType::Char:
-			divide_layers_together<char>(this_layer_data, other_layer_data, this->voxel_count);
-			break;
-		case Typing::DType::Vec2:
-			divide_layers_together<glm::vec2>(this_layer_data, other_layer_data, this->voxel_count);
-			break;
-		case Typing::DType::Vec3:
-			divide_layers_together<glm::vec3>(this_layer_data, other_layer_data, this->voxel_count);
-			break;
-		case Typing::DType::Vec4:
-			divide_layers_together<glm::vec4>(this_layer_data, other_layer_data, this->voxel_count);
-			break;
-		case Typing::DType::UInt64:
-#if defined(__x86_64__) || defined(_M_X64)
-			divide_layers_together<uint64_t>(this_layer_data, other_layer_data, this->voxel_count);
-#else
-			throw std::runtime_error("Can't use 64-bit data type in 32-bit system!");
-#endif
-			break;
-		case Typing::DType::UInt32:
-			divide_layers_together<uint32_t>(this_layer_data, other_layer_data, this->voxel_count);
-			break;
-		case Typing::DType::Hist:
-			for (size_t i = 0; i < this->voxel_count; i++)
-			{
-				auto hist1 = (HistogramVoxel*)(layer_info->second.voxels + i * layer_info->second.bytes_per_voxel);
-				auto hist2 = (HistogramVoxel*)(other_layer_info->second.voxels + i * layer_info->second.bytes_per_voxel);
-				*hist1 /= *hist2;
-			}
-			break;
-		}
-	}
+	this->apply_operation(other, Kernels::Operation::Divide);
 	return *this;
 }
 
 VoxelBuffer& VoxelBuffer::operator+=(const float& scalar) {
-	for (auto& layer : this->layers)
-	{
-		auto layer_info = layer.second;
-		char* this_layer_data = layer.second.data;
-
-		switch (Typing::Helper::get_dtype(this->get_type(layer.first)))
-		{
-		case Typing::DType::Float:
-			for (size_t i = 0; i < this->voxel_count; i++)
-			{
-				float* this_data = (float*)this_layer_data;
-				this_data[i] += scalar;
-			}
-			break;
-		case Typing::DType::Double:
-			for (size_t i = 0; i < this->voxel_count; i++)
-			{
-				double* this_data = (double*)this_layer_data;
-				this_data[i] += scalar;
-			}
-			break;
-		case Typing::DType::Int:
-			for (size_t i = 0; i < this->voxel_count; i++)
-			{
-				int* this_data = (int*)this_layer_data;
-				this_data[i] += scalar;
-			}
-			break;
-		case Typing::DType::Char:
-			for (size_t i = 0; i < this->voxel_count; i++)
-			{
-				char* this_data = (char*)this_layer_data;
-				this_data[i] += scalar;
-			}
-			break;
-		case Typing::DType::Vec2:
-			for (size_t i = 0; i < this->voxel_count; i++)
-			{
-				glm::vec2* this_data = (glm::vec2*)this_layer_data;
-				this_data[i] += scalar;
-			}
-			break;
-		case Typing::DType::Vec3:
-			for (size_t i = 0; i < this->voxel_count; i++)
-			{
-				glm::vec3* this_data = (glm::vec3*)this_layer_data;
-				this_data[i] += scalar;
-			}
-			break;
-		case Typing::DType::Vec4:
-			for (size_t i = 0; i < this->voxel_count; i++)
-			{
-				glm::vec4* this_data = (glm::vec4*)this_layer_data;
-				this_data[i] += scalar;
-			}
-			break;
-		case Typing::DType::UInt64:
-			for (size_t i = 0; i < this->voxel_count; i++)
-			{
-				uint64_t* this_data = (uint64_t*)this_layer_data;
-				this_data[i] += scalar;
-			}
-			break;
-		case Typing::DType::UInt32:
-			for (size_t i = 0; i < this->voxel_count; i++)
-			{
-				uint32_t* this_data = (uint32_t*)this_layer_data;
-				this_data[i] += scalar;
-			}
-			break;
-		case Typing::DType::Hist:
-			for (size_t i = 0; i < this->voxel_count; i++)
-			{
-				auto hist = (HistogramVoxel*)(layer_info.voxels + i * layer_info.bytes_per_voxel);
-				*hist += scalar;
-			}
-			break;
-		}
-	}
+	this->apply_operation(scalar, Kernels::Operation::Add);
 	return *this;
 }
 
 VoxelBuffer& VoxelBuffer::operator-=(const float& scalar) {
-	for (auto& layer : this->layers)
-	{
-		auto layer_info = layer.second;
-		char* this_layer_data = layer.second.data;
-
-		switch (Typing::Helper::get_dtype(this->get_type(layer.first)))
-		{
-		case Typing::DType::Float:
-			for (size_t i = 0; i < this->voxel_count; i++)
-			{
-				float* this_data = (float*)this_layer_data;
-				this_data[i] -= scalar;
-			}
-			break;
-		case Typing::DType::Double:
-			for (size_t i = 0; i < this->voxel_count; i++)
-			{
-				double* this_data = (double*)this_layer_data;
-				this_data[i] -= scalar;
-			}
-			break;
-		case Typing::DType::Int:
-			for (size_t i = 0; i < this->voxel_count; i++)
-			{
-				int* this_data = (int*)this_layer_data;
-				this_data[i] -= scalar;
-			}
-			break;
-		case Typing::DType::Char:
-			for (size_t i = 0; i < this->voxel_count; i++)
-			{
-				char* this_data = (char*)this_layer_data;
-				this_data[i] -= scalar;
-			}
-			break;
-		case Typing::DType::Vec2:
-			for (size_t i = 0; i < this->voxel_count; i++)
-			{
-				glm::vec2* this_data = (glm::vec2*)this_layer_data;
-				this_data[i] -= scalar;
-			}
-			break;
-		case Typing::DType::Vec3:
-			for (size_t i = 0; i < this->voxel_count; i++)
-			{
-				glm::vec3* this_data = (glm::vec3*)this_layer_data;
-				this_data[i] -= scalar;
-			}
-			break;
-		case Typing::DType::Vec4:
-			for (size_t i = 0; i < this->voxel_count; i++)
-			{
-				glm::vec4* this_data = (glm::vec4*)this_layer_data;
-				this_data[i] -= scalar;
-			}
-			break;
-		case Typing::DType::UInt64:
-			for (size_t i = 0; i < this->voxel_count; i++)
-			{
-				uint64_t* this_data = (uint64_t*)this_layer_data;
-				this_data[i] -= scalar;
-			}
-			break;
-		case Typing::DType::UInt32:
-			for (size_t i = 0; i < this->voxel_count; i++)
-			{
-				uint32_t* this_data = (uint32_t*)this_layer_data;
-				this_data[i] -= scalar;
-			}
-			break;
-		case Typing::DType::Hist:
-			for (size_t i = 0; i < this->voxel_count; i++)
-			{
-				auto hist = (HistogramVoxel*)(layer_info.voxels + i * layer_info.bytes_per_voxel);
-				*hist -= scalar;
-			}
-			break;
-		}
-	}
+	this->apply_operation(scalar, Kernels::Operation::Subtract);
 	return *this;
 }
 
 VoxelBuffer& VoxelBuffer::operator*=(const float& scalar) {
-	for (auto& layer : this->layers)
-	{
-		auto layer_info = layer.second;
-		char* this_layer_data = layer.second.data;
-
-		switch (Typing::Helper::get_dtype(this->get_type(layer.first)))
-		{
-		case Typing::DType::Float:
-			for (size_t i = 0; i < this->voxel_count; i++)
-			{
-				float* this_data = (float*)this_layer_data;
-				this_data[i] *= scalar;
-			}
-			break;
-		case Typing::DType::Double:
-			for (size_t i = 0; i < this->voxel_count; i++)
-			{
-				double* this_data = (double*)this_layer_data;
-				this_data[i] *= scalar;
-			}
-			break;
-		case Typing::DType::Int:
-			for (size_t i = 0; i < this->voxel_count; i++)
-			{
-				int* this_data = (int*)this_layer_data;
-				this_data[i] *= scalar;
-			}
-			break;
-		case Typing::DType::Char:
-			for (size_t i = 0; i < this->voxel_count; i++)
-			{
-				char* this_data = (char*)this_layer_data;
-				this_data[i] *= scalar;
-			}
-			break;
-		case Typing::DType::Vec2:
-			for (size_t i = 0; i < this->voxel_count; i++)
-			{
-				glm::vec2* this_data = (glm::vec2*)this_layer_data;
-				this_data[i] *= scalar;
-			}
-			break;
-		case Typing::DType::Vec3:
-			for (size_t i = 0; i < this->voxel_count; i++)
-			{
-				glm::vec3* this_data = (glm::vec3*)this_layer_data;
-				this_data[i] *= scalar;
-			}
-			break;
-		case Typing::DType::Vec4:
-			for (size_t i = 0; i < this->voxel_count; i++)
-			{
-				glm::vec4* this_data = (glm::vec4*)this_layer_data;
-				this_data[i] *= scalar;
-			}
-			break;
-		case Typing::DType::UInt64:
-			for (size_t i = 0; i < this->voxel_count; i++)
-			{
-				uint64_t* this_data = (uint64_t*)this_layer_data;
-				this_data[i] *= scalar;
-			}
-			break;
-		case Typing::DType::UInt32:
-			for (size_t i = 0; i < this->voxel_count; i++)
-			{
-				uint32_t* this_data = (uint32_t*)this_layer_data;
-				this_data[i] *= scalar;
-			}
-			break;
-		case Typing::DType::Hist:
-			for (size_t i = 0; i < this->voxel_count; i++)
-			{
-				auto hist = (HistogramVoxel*)(layer_info.voxels + i * layer_info.bytes_per_voxel);
-				*hist *= scalar;
-			}
-			break;
-		}
-	}
+	this->apply_operation(scalar, Kernels::Operation::Multiply);
 	return *this;
 }
 
 VoxelBuffer& VoxelBuffer::operator/=(const float& scalar) {
-	for (auto& layer : this->layers)
-	{
-		auto layer_info = layer.second;
-		char* this_layer_data = layer.second.data;
-
-		switch (Typing::Helper::get_dtype(this->get_type(layer.first)))
-		{
-		case Typing::DType::Float:
-			for (size_t i = 0; i < this->voxel_count; i++)
-			{
-				float* this_data = (float*)this_layer_data;
-				this_data[i] /= scalar;
-			}
-			break;
-		case Typing::DType::Double:
-			for (size_t i = 0; i < this->voxel_count; i++)
-			{
-				double* this_data = (double*)this_layer_data;
-				this_data[i] /= scalar;
-			}
-			break;
-		case Typing::DType::Int:
-			for (size_t i = 0; i < this->voxel_count; i++)
-			{
-				int* this_data = (int*)this_layer_data;
-				this_data[i] /= scalar;
-			}
-			break;
-		case Typing::DType::Char:
-			for (size_t i = 0; i < this->voxel_count; i++)
-			{
-				char* this_data = (char*)this_layer_data;
-				this_data[i] /= scalar;
-			}
-			break;
-		case Typing::DType::Vec2:
-			for (size_t i = 0; i < this->voxel_count; i++)
-			{
-				glm::vec2* this_data = (glm::vec2*)this_layer_data;
-				this_data[i] /= scalar;
-			}
-			break;
-		case Typing::DType::Vec3:
-			for (size_t i = 0; i < this->voxel_count; i++)
-			{
-				glm::vec3* this_data = (glm::vec3*)this_layer_data;
-				this_data[i] /= scalar;
-			}
-			break;
-		case Typing::DType::Vec4:
-			for (size_t i = 0; i < this->voxel_count; i++)
-			{
-				glm::vec4* this_data = (glm::vec4*)this_layer_data;
-				this_data[i] /= scalar;
-			}
-			break;
-		case Typing::DType::UInt64:
-			for (size_t i = 0; i < this->voxel_count; i++)
-			{
-				uint64_t* this_data = (uint64_t*)this_layer_data;
-				this_data[i] /= scalar;
-			}
-			break;
-		case Typing::DType::UInt32:
-			for (size_t i = 0; i < this->voxel_count; i++)
-			{
-				uint32_t* this_data = (uint32_t*)this_layer_data;
-				this_data[i] /= scalar;
-			}
-			break;
-		case Typing::DType::Hist:
-			for (size_t i = 0; i < this->voxel_count; i++)
-			{
-				auto hist = (HistogramVoxel*)(layer_info.voxels + i * layer_info.bytes_per_voxel);
-				*hist /= scalar;
-			}
-			break;
-		}
-	}
+	this->apply_operation(scalar, Kernels::Operation::Divide);
 	return *this;
 }
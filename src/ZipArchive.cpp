@@ -0,0 +1,267 @@
+#include "RadFiled3D/helpers/ZipArchive.hpp"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#ifdef RADFILED3D_ZLIB
+    #include <zlib.h>
+#endif
+
+
+using namespace RadFiled3D;
+
+
+namespace {
+    constexpr uint32_t LOCAL_HEADER_SIGNATURE = 0x04034b50;
+    constexpr uint32_t CENTRAL_HEADER_SIGNATURE = 0x02014b50;
+    constexpr uint32_t END_OF_CENTRAL_DIRECTORY_SIGNATURE = 0x06054b50;
+    constexpr uint32_t ZIP64_END_OF_CENTRAL_DIRECTORY_SIGNATURE = 0x06064b50;
+    constexpr uint32_t ZIP64_END_OF_CENTRAL_DIRECTORY_LOCATOR_SIGNATURE = 0x07064b50;
+    constexpr uint16_t ZIP64_EXTRA_FIELD_ID = 0x0001;
+
+    constexpr size_t LOCAL_HEADER_SIZE = 30;
+    constexpr size_t CENTRAL_HEADER_SIZE = 46;
+    constexpr size_t END_OF_CENTRAL_DIRECTORY_SIZE = 22;
+    constexpr size_t ZIP64_END_OF_CENTRAL_DIRECTORY_SIZE = 56;
+    constexpr size_t ZIP64_END_OF_CENTRAL_DIRECTORY_LOCATOR_SIZE = 20;
+    constexpr size_t MAX_COMMENT_SIZE = 0xFFFF;
+
+    /** Reads a little endian integer from an unaligned position within the mapping */
+    template<typename T>
+    T read_le(const char* data) {
+        T value;
+        std::memcpy(&value, data, sizeof(T));
+        return value;
+    }
+}
+
+
+ZipArchive::ZipArchive(const std::string& filename)
+    : filename(filename), file(std::make_shared<MappedFile>(filename))
+{
+    this->parse_central_directory();
+}
+
+void ZipArchive::parse_central_directory()
+{
+    const char* data = this->file->data();
+    const size_t size = this->file->size();
+    if (size < END_OF_CENTRAL_DIRECTORY_SIZE) {
+        throw ZipArchiveException("File is too small to be a zip archive: " + this->filename);
+    }
+
+    // the end of central directory record is followed by a comment of up to 64 KiB, so it is searched backwards from the end
+    size_t eocd = std::numeric_limits<size_t>::max();
+    const size_t search_end = (size > END_OF_CENTRAL_DIRECTORY_SIZE + MAX_COMMENT_SIZE) ? size - END_OF_CENTRAL_DIRECTORY_SIZE - MAX_COMMENT_SIZE : 0;
+    for (size_t pos = size - END_OF_CENTRAL_DIRECTORY_SIZE + 1; pos-- > search_end;) {
+        if (read_le<uint32_t>(data + pos) == END_OF_CENTRAL_DIRECTORY_SIGNATURE) {
+            eocd = pos;
+            break;
+        }
+    }
+    if (eocd == std::numeric_limits<size_t>::max()) {
+        throw ZipArchiveException("End of central directory not found: " + this->filename);
+    }
+
+    size_t entry_count = read_le<uint16_t>(data + eocd + 10);
+    size_t directory_size = read_le<uint32_t>(data + eocd + 12);
+    size_t directory_offset = read_le<uint32_t>(data + eocd + 16);
+
+    // archives exceeding the limits of the record store the values in the ZIP64 record located right before it
+    if (entry_count == 0xFFFF || directory_size == 0xFFFFFFFF || directory_offset == 0xFFFFFFFF) {
+        if (eocd < ZIP64_END_OF_CENTRAL_DIRECTORY_LOCATOR_SIZE || read_le<uint32_t>(data + eocd - ZIP64_END_OF_CENTRAL_DIRECTORY_LOCATOR_SIZE) != ZIP64_END_OF_CENTRAL_DIRECTORY_LOCATOR_SIGNATURE) {
+            throw ZipArchiveException("ZIP64 end of central directory locator not found: " + this->filename);
+        }
+        const size_t eocd64 = static_cast<size_t>(read_le<uint64_t>(data + eocd - ZIP64_END_OF_CENTRAL_DIRECTORY_LOCATOR_SIZE + 8));
+        if (eocd64 > size || size - eocd64 < ZIP64_END_OF_CENTRAL_DIRECTORY_SIZE || read_le<uint32_t>(data + eocd64) != ZIP64_END_OF_CENTRAL_DIRECTORY_SIGNATURE) {
+            throw ZipArchiveException("ZIP64 end of central directory not found: " + this->filename);
+        }
+        entry_count = static_cast<size_t>(read_le<uint64_t>(data + eocd64 + 32));
+        directory_size = static_cast<size_t>(read_le<uint64_t>(data + eocd64 + 40));
+        directory_offset = static_cast<size_t>(read_le<uint64_t>(data + eocd64 + 48));
+    }
+    if (directory_offset > size || directory_size > size - directory_offset) {
+        throw ZipArchiveException("Central directory exceeds the archive: " + this->filename);
+    }
+
+    this->members.clear();
+    this->index.clear();
+    this->members.reserve(entry_count);
+    this->index.reserve(entry_count);
+
+    const char* directory_end = data + directory_offset + directory_size;
+    const char* pos = data + directory_offset;
+    for (size_t i = 0; i < entry_count; i++) {
+        if (static_cast<size_t>(directory_end - pos) < CENTRAL_HEADER_SIZE || read_le<uint32_t>(pos) != CENTRAL_HEADER_SIGNATURE) {
+            throw ZipArchiveException("Corrupted central directory: " + this->filename);
+        }
+        const size_t name_length = read_le<uint16_t>(pos + 28);
+        const size_t extra_length = read_le<uint16_t>(pos + 30);
+        const size_t comment_length = read_le<uint16_t>(pos + 32);
+        if (static_cast<size_t>(directory_end - pos) < CENTRAL_HEADER_SIZE + name_length + extra_length + comment_length) {
+            throw ZipArchiveException("Corrupted central directory: " + this->filename);
+        }
+
+        Member member;
+        member.flags = read_le<uint16_t>(pos + 8);
+        member.compression_method = read_le<uint16_t>(pos + 10);
+        member.crc32 = read_le<uint32_t>(pos + 16);
+        member.compressed_size = read_le<uint32_t>(pos + 20);
+        member.uncompressed_size = read_le<uint32_t>(pos + 24);
+        member.local_header_offset = read_le<uint32_t>(pos + 42);
+        member.name = std::string(pos + CENTRAL_HEADER_SIZE, name_length);
+
+        // the ZIP64 extra field holds those of the sizes and the offset in this order, which exceed 32 bits
+        const char* extra = pos + CENTRAL_HEADER_SIZE + name_length;
+        const char* extra_end = extra + extra_length;
+        while (extra_end - extra >= 4) {
+            const uint16_t field_id = read_le<uint16_t>(extra);
+            const size_t field_size = read_le<uint16_t>(extra + 2);
+            const char* field = extra + 4;
+            if (static_cast<size_t>(extra_end - field) < field_size) {
+                break;
+            }
+            if (field_id == ZIP64_EXTRA_FIELD_ID) {
+                const char* field_end = field + field_size;
+                if (member.uncompressed_size == 0xFFFFFFFF && field_end - field >= 8) {
+                    member.uncompressed_size = static_cast<size_t>(read_le<uint64_t>(field));
+                    field += 8;
+                }
+                if (member.compressed_size == 0xFFFFFFFF && field_end - field >= 8) {
+                    member.compressed_size = static_cast<size_t>(read_le<uint64_t>(field));
+                    field += 8;
+                }
+                if (member.local_header_offset == 0xFFFFFFFF && field_end - field >= 8) {
+                    member.local_header_offset = static_cast<size_t>(read_le<uint64_t>(field));
+                }
+                break;
+            }
+            extra = field + field_size;
+        }
+
+        // the first entry of a name wins, as it does for most zip tools
+        this->index.emplace(member.name, this->members.size());
+        this->members.push_back(std::move(member));
+        pos += CENTRAL_HEADER_SIZE + name_length + extra_length + comment_length;
+    }
+}
+
+bool ZipArchive::contains(const std::string& name) const
+{
+    return this->index.find(name) != this->index.end();
+}
+
+std::vector<std::string> ZipArchive::get_member_names() const
+{
+    std::vector<std::string> names;
+    names.reserve(this->members.size());
+    for (const Member& member : this->members) {
+        names.push_back(member.name);
+    }
+    return names;
+}
+
+const ZipArchive::Member& ZipArchive::get_member(const std::string& name) const
+{
+    auto itr = this->index.find(name);
+    if (itr == this->index.end()) {
+        throw ZipArchiveException("Member not found: " + name);
+    }
+    return this->members[itr->second];
+}
+
+size_t ZipArchive::get_data_offset(const Member& member) const
+{
+    const char* data = this->file->data();
+    const size_t size = this->file->size();
+    if (member.local_header_offset > size || size - member.local_header_offset < LOCAL_HEADER_SIZE || read_le<uint32_t>(data + member.local_header_offset) != LOCAL_HEADER_SIGNATURE) {
+        throw ZipArchiveException("Corrupted local header of member: " + member.name);
+    }
+
+    // the extra field of the local header may differ from the one in the central directory
+    const size_t name_length = read_le<uint16_t>(data + member.local_header_offset + 26);
+    const size_t extra_length = read_le<uint16_t>(data + member.local_header_offset + 28);
+    const size_t data_offset = member.local_header_offset + LOCAL_HEADER_SIZE + name_length + extra_length;
+    if (data_offset > size || member.compressed_size > size - data_offset) {
+        throw ZipArchiveException("Data of member exceeds the archive: " + member.name);
+    }
+    return data_offset;
+}
+
+std::shared_ptr<MappedFile> ZipArchive::map_member(const std::string& name) const
+{
+    const Member& member = this->get_member(name);
+    if ((member.flags & 0x1) != 0) {
+        throw ZipArchiveException("Encrypted members are not supported: " + name);
+    }
+    if (!member.is_stored()) {
+        throw ZipArchiveException("Only members stored uncompressed can be mapped: " + name);
+    }
+    return std::make_shared<MappedFile>(this->file, this->get_data_offset(member), member.compressed_size);
+}
+
+std::shared_ptr<ByteSource> ZipArchive::open(const std::string& name) const
+{
+    const Member& member = this->get_member(name);
+    if (member.is_stored() || (member.flags & 0x1) != 0) {
+        return std::make_shared<MappedByteSource>(this->map_member(name));
+    }
+    if (member.compression_method != 8) {
+        throw ZipArchiveException("Unsupported compression method " + std::to_string(member.compression_method) + " of member: " + name);
+    }
+
+#ifdef RADFILED3D_ZLIB
+    const size_t data_offset = this->get_data_offset(member);
+    std::vector<char> inflated(member.uncompressed_size);
+
+    // the members hold raw deflate streams without a zlib header, which is selected by negative window bits
+    z_stream stream;
+    std::memset(&stream, 0, sizeof(z_stream));
+    if (inflateInit2(&stream, -MAX_WBITS) != Z_OK) {
+        throw ZipArchiveException("Unable to initialize inflating member: " + name);
+    }
+    const char* compressed = this->file->data() + data_offset;
+    size_t consumed = 0;
+    size_t produced = 0;
+    int result = Z_OK;
+    // zlib counts in 32 bit, so large members are passed in chunks
+    const size_t chunk_size = std::numeric_limits<uInt>::max();
+    while (result == Z_OK) {
+        stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(compressed + consumed));
+        stream.avail_in = static_cast<uInt>(std::min(chunk_size, member.compressed_size - consumed));
+        stream.next_out = reinterpret_cast<Bytef*>(inflated.data() + produced);
+        stream.avail_out = static_cast<uInt>(std::min(chunk_size, inflated.size() - produced));
+        const uInt avail_in = stream.avail_in;
+        const uInt avail_out = stream.avail_out;
+        result = inflate(&stream, Z_NO_FLUSH);
+        consumed += avail_in - stream.avail_in;
+        produced += avail_out - stream.avail_out;
+        if (result == Z_BUF_ERROR && (consumed < member.compressed_size && produced < inflated.size())) {
+            result = Z_OK;
+        }
+    }
+    inflateEnd(&stream);
+    if (result != Z_STREAM_END || produced != member.uncompressed_size) {
+        throw ZipArchiveException("Unable to inflate member: " + name);
+    }
+
+    uLong crc = ::crc32(0L, Z_NULL, 0);
+    for (size_t offset = 0; offset < inflated.size(); offset += chunk_size) {
+        crc = ::crc32(crc, reinterpret_cast<const Bytef*>(inflated.data() + offset), static_cast<uInt>(std::min(chunk_size, inflated.size() - offset)));
+    }
+    if (static_cast<uint32_t>(crc) != member.crc32) {
+        throw ZipArchiveException("CRC-32 mismatch of member: " + name);
+    }
+    return std::make_shared<MemoryByteSource>(std::move(inflated));
+#else
+    throw ZipArchiveException("Compressed members are not supported, as the library was built without zlib: " + name);
+#endif
+}
+
+bool ZipArchive::supports_compressed_members()
+{
+#ifdef RADFILED3D_ZLIB
+    return true;
+#else
+    return false;
+#endif
+}
@@ -1,7 +1,11 @@
 #include <RadFiled3D/dataset/helpers.hpp>
 #include <RadFiled3D/storage/FieldAccessor.hpp>
-#include <istream>
-#include <fstream>
+#include <RadFiled3D/helpers/BatchReader.hpp>
+#include <RadFiled3D/VoxelBuffer.hpp>
+#include <algorithm>
+#include <new>
+#include <thread>
+#include <unordered_map>
 
 
 using namespace RadFiled3D;
@@ -10,37 +14,120 @@ using namespace RadFiled3D::Dataset;
 
 std::shared_ptr<VoxelCollection> RadFiled3D::Dataset::VoxelCollectionAccessor::access(const std::vector<VoxelCollectionRequest>& requests)
 {
+	// the voxels of each request are written to a disjoint slice starting at its offset
+	std::vector<size_t> requestOffsets(requests.size());
 	size_t voxelsCount = 0;
-	for (const auto& request : requests) {
-		voxelsCount += request.voxelIndices.size();
+	for (size_t i = 0; i < requests.size(); i++) {
+		requestOffsets[i] = voxelsCount;
+		voxelsCount += requests[i].voxelIndices.size();
 	}
 	std::shared_ptr<VoxelCollection> collection = std::make_shared<VoxelCollection>(this->channels, this->layers, voxelsCount);
 
-	voxelsCount = 0;
-	for (const auto& request : requests) {
-		std::ifstream buffer(request.filePath, std::ios::binary);
-		for (const std::string& channel : this->channels) {
-			for (const std::string& layer : this->layers) {
-				auto voxels = this->accessor->accessVoxelsRawFlat(buffer, channel, layer, request.voxelIndices);
-				auto& channel_data = collection->channels[channel];
-				auto& layer_data = channel_data.layers[layer];
-				size_t inner_voxels_count = 0;
-				for (auto voxel : voxels) {
-					if (voxel == nullptr) {
-						throw std::runtime_error("Failed to access voxel data for channel: " + channel + ", layer: " + layer);
-					}
-					layer_data.voxels[voxelsCount + inner_voxels_count] = std::shared_ptr<IVoxel>(voxel);
-					inner_voxels_count++;
+	// allocate the buffers of all layers at once, as the voxels of all requests are written into them
+	struct LayerTarget {
+		std::string channel;
+		std::string layer;
+		VoxelCollection::Layer* data;
+	};
+	std::vector<LayerTarget> targets;
+	for (const std::string& channel : this->channels) {
+		for (const std::string& layer : this->layers) {
+			const auto& layer_block = this->accessor->getLayerDefinition(channel, layer);
+			auto& layer_data = collection->channels[channel].layers[layer];
+			layer_data.allocate(layer_block.dtype, layer_block.elements_per_voxel, (layer_block.get_voxel_header_data_size() > 0) ? layer_block.get_voxel_header_data() : nullptr);
+			targets.push_back({ channel, layer, &layer_data });
+		}
+	}
+
+	if (this->io_queue_depth > 0) {
+		// a reader must only be used by one thread at a time, so each call takes an idle reader of the pool or creates one
+		std::shared_ptr<BatchReaderPool> pool = this->batch_readers;
+		std::shared_ptr<BatchReader> reader;
+		{
+			std::lock_guard<std::mutex> lock(pool->mutex);
+			if (!pool->idle_readers.empty()) {
+				reader = pool->idle_readers.back();
+				pool->idle_readers.pop_back();
+			}
+		}
+		if (reader == nullptr)
+			reader = std::make_shared<BatchReader>(this->io_queue_depth, this->get_worker_count());
+
+		// queue the reads of the requests first, so that they are issued at once, and keep the files open until the batch was read.
+		// Each file is opened and its layout resolved once and the batch is read whenever the number of open files reaches the limit
+		struct BatchFile {
+			std::shared_ptr<PositionalFile> file;
+			Storage::FieldAccessor::FileLayout layout;
+		};
+		std::unordered_map<std::string, BatchFile> files;
+		std::vector<BatchReadRequest> batch;
+		for (size_t i = 0; i < requests.size(); i++) {
+			const VoxelCollectionRequest& request = requests[i];
+			auto file_itr = files.find(request.filePath);
+			if (file_itr == files.end()) {
+				if (files.size() >= VoxelCollectionAccessor::MAX_BATCH_FILES) {
+					reader->read(batch);
+					batch.clear();
+					files.clear();
 				}
-				buffer.seekg(0, std::ios::beg); // Reset the buffer position for the next channel/layer
+				std::shared_ptr<PositionalFile> file = std::make_shared<PositionalFile>(request.filePath);
+				Storage::FieldAccessor::FileLayout layout = this->accessor->resolveFileLayout(file);
+				file_itr = files.emplace(request.filePath, BatchFile{ file, std::move(layout) }).first;
+			}
+			for (const LayerTarget& target : targets) {
+				VoxelCollection::Layer& layer_data = *target.data;
+				this->accessor->queueVoxelsDataFlat(
+					file_itr->second.file,
+					file_itr->second.layout,
+					target.channel,
+					target.layer,
+					request.voxelIndices,
+					layer_data.data.get() + requestOffsets[i] * layer_data.voxel_bytes,
+					request.voxelIndices.size() * layer_data.voxel_bytes,
+					batch
+				);
 			}
 		}
-		voxelsCount += request.voxelIndices.size();
+		reader->read(batch);
+
+		// a reader is only returned after a successful batch, so that a failed one is never reused
+		std::lock_guard<std::mutex> lock(pool->mutex);
+		pool->idle_readers.push_back(reader);
+		return collection;
 	}
 
+	auto load_request = [this, &requests, &requestOffsets, &targets](size_t request_idx) {
+		const VoxelCollectionRequest& request = requests[request_idx];
+		const size_t offset = requestOffsets[request_idx];
+		// a positional file is read without a shared read position, so the channels and layers can be read in any order
+		std::shared_ptr<PositionalFile> file = std::make_shared<PositionalFile>(request.filePath);
+		for (const LayerTarget& target : targets) {
+			VoxelCollection::Layer& layer_data = *target.data;
+			this->accessor->accessVoxelsDataFlat(
+				file,
+				target.channel,
+				target.layer,
+				request.voxelIndices,
+				layer_data.data.get() + offset * layer_data.voxel_bytes,
+				request.voxelIndices.size() * layer_data.voxel_bytes
+			);
+		}
+	};
+
+	// each worker takes the next request that is not yet loaded, the first error is rethrown after all workers finished
+	VoxelBuffer::parallel_for(requests.size(), this->get_worker_count(), load_request);
+
 	return collection;
 }
 
+size_t RadFiled3D::Dataset::VoxelCollectionAccessor::get_worker_count() const
+{
+	if (this->worker_count > 0)
+		return this->worker_count;
+	const size_t hardware_threads = std::thread::hardware_concurrency();
+	return (hardware_threads > 0) ? hardware_threads : 1;
+}
+
 
 RadFiled3D::Dataset::VoxelCollection::VoxelCollection(const std::vector<std::string>& channels, const std::vector<std::string>& layers, size_t voxelCount)
 {
@@ -50,24 +137,40 @@ RadFiled3D::Dataset::VoxelCollection::VoxelCollection(const std::vector<std::str
 		for (auto& layerName : layers) {
 			channel.layers[layerName] = Layer();
 			Layer& layer = channel.layers[layerName];
-			layer.voxels.resize(voxelCount);
+			layer.name = layerName;
+			layer.voxel_count = voxelCount;
 		}
 	}
 }
 
+void RadFiled3D::Dataset::VoxelCollection::Layer::allocate(Typing::DType dtype, size_t elements_per_voxel, const char* voxel_header_data)
+{
+	this->dtype = dtype;
+	this->elements_per_voxel = elements_per_voxel;
+	this->voxel_bytes = elements_per_voxel * Typing::Helper::get_bytes_of_dtype(dtype);
+	if (dtype == Typing::DType::Hist && voxel_header_data != nullptr) {
+		const HistogramVoxel::HistogramDefinition* histogram_definition = (const HistogramVoxel::HistogramDefinition*)voxel_header_data;
+		this->histogram_bins = histogram_definition->bins;
+		this->histogram_bin_width = histogram_definition->histogram_bin_width;
+	}
+
+	// sized up to a multiple of the alignment, so that vectorized code may run over the end of the last voxel
+	const size_t bytes = (this->get_bytes() + DATA_ALIGNMENT - 1) / DATA_ALIGNMENT * DATA_ALIGNMENT;
+	this->data = std::shared_ptr<char>(
+		static_cast<char*>(::operator new[](bytes, std::align_val_t(DATA_ALIGNMENT))),
+		[](char* data) { ::operator delete[](data, std::align_val_t(DATA_ALIGNMENT)); }
+	);
+}
+
 char* RadFiled3D::Dataset::VoxelCollection::extract_data_buffer_from(const std::string& channel, const std::string& layer)
 {
 	Channel& targetChannel = this->channels[channel];
 	Layer& targetLayer = targetChannel.layers[layer];
-	if (targetLayer.voxels.empty()) {
+	if (targetLayer.data == nullptr || targetLayer.voxel_count == 0) {
 		throw std::runtime_error("No voxels found in layer: " + layer);
 	}
-	auto vx_size = targetLayer.voxels[0]->get_bytes();
-	char* buffer = new char[targetLayer.voxels.size() * vx_size];
-
-	for (size_t i = 0; i < targetLayer.voxels.size(); i++) {
-		std::memcpy(buffer + i * vx_size, targetLayer.voxels[i]->get_raw(), vx_size);
-	}
+	char* buffer = new char[targetLayer.get_bytes()];
+	std::memcpy(buffer, targetLayer.data.get(), targetLayer.get_bytes());
 
 	return buffer;
 }
@@ -3,6 +3,7 @@
 #include <iostream>
 #include "RadFiled3D/storage/RadiationFieldStore.hpp"
 #include "RadFiled3D/storage/FieldAccessor.hpp"
+#include "RadFiled3D/helpers/ZipArchive.hpp"
 #include "RadFiled3D/dataset/helpers.hpp"
 #include <memory>
 #include <vector>
@@ -12,7 +13,10 @@
 #include <fstream>
 #include <cstdio>
 #include <thread>
+#include <atomic>
+#include <limits>
 #include <shared_mutex>
+#include <filesystem>
 #ifdef _WIN32
 #include <Windows.h>
 #include "psapi.h"
@@ -36,6 +40,31 @@ namespace {
 		}
 	};
 
+	/** Creates the metadata of the fields stored by the tests
+	* @param primary_particle_count The number of primary particles of the simulation
+	*/
+	std::shared_ptr<RadFiled3D::Storage::V1::RadiationFieldMetadata> make_test_metadata(size_t primary_particle_count = 100) {
+		return std::make_shared<RadFiled3D::Storage::V1::RadiationFieldMetadata>(
+			RadFiled3D::Storage::FiledTypes::V1::RadiationFieldMetadataHeader::Simulation(
+				primary_particle_count,
+				"geom",
+				"FTFP_BERT",
+				RadFiled3D::Storage::FiledTypes::V1::RadiationFieldMetadataHeader::Simulation::XRayTube(
+					glm::vec3(1.f, 0.f, 0.f),
+					glm::vec3(0.f, 0.f, 0.f),
+					100.f,
+					"XRayTube"
+				)
+			),
+			RadFiled3D::Storage::FiledTypes::V1::RadiationFieldMetadataHeader::Software(
+				"test",
+				"1.0",
+				"repo",
+				"commit"
+			)
+		);
+	}
+
 
 	TEST(Storage, FieldAccessing) {
 		std::shared_ptr<CartesianRadiationField> field = std::make_shared<CartesianRadiationField>(glm::vec3(2.5f), glm::vec3(0.05f));
@@ -203,6 +232,801 @@ namespace {
 		}
 	}
 
+	TEST(Storage, MappedAccessing) {
+		std::shared_ptr<CartesianRadiationField> field = std::make_shared<CartesianRadiationField>(glm::vec3(2.5f), glm::vec3(0.05f));
+		std::shared_ptr<VoxelGridBuffer> channel = std::static_pointer_cast<VoxelGridBuffer>(field->add_channel("test_channel"));
+
+		channel->add_layer<glm::vec3>("dirs", glm::vec3(0.f), "normalized direction");
+		channel->add_layer<float>("doserate", 25.3f, "Gy/s");
+		channel->add_custom_layer<HistogramVoxel>("spectra", HistogramVoxel(26, 10.f, nullptr), .123f, "");
+
+		ScalarVoxel<float>& vx = channel->get_voxel_flat<ScalarVoxel<float>>("doserate", 20);
+		vx = 10.f;
+
+		std::shared_ptr<RadFiled3D::Storage::V1::RadiationFieldMetadata> metadata = make_test_metadata();
+
+		EXPECT_NO_THROW(FieldStore::store(field, metadata, "test01.rf3", StoreVersion::V1));
+
+		std::shared_ptr<FieldAccessor> accessor = FieldStore::construct_accessor("test01.rf3");
+		std::shared_ptr<MappedFile> mapped_file = std::make_shared<MappedFile>("test01.rf3");
+
+		std::shared_ptr<VoxelGrid> layer = std::dynamic_pointer_cast<CartesianFieldAccessor>(accessor)->accessLayer(mapped_file, "test_channel", "doserate");
+		std::shared_ptr<VoxelGridBuffer> channel2 = std::dynamic_pointer_cast<CartesianFieldAccessor>(accessor)->accessChannel(mapped_file, "test_channel");
+		std::shared_ptr<CartesianRadiationField> field2 = std::static_pointer_cast<CartesianRadiationField>(accessor->accessField(mapped_file));
+		std::shared_ptr<OwningScalarVoxel<float>> voxel = std::shared_ptr<OwningScalarVoxel<float>>((OwningScalarVoxel<float>*)accessor->accessVoxelRawFlat(mapped_file, "test_channel", "doserate", 20));
+
+		// the views must keep the mapping alive on their own
+		mapped_file.reset();
+
+		EXPECT_TRUE(layer->get_layer()->is_view());
+		EXPECT_TRUE(channel2->get_layer("doserate").is_view());
+		EXPECT_EQ(voxel->get_data(), 10.f);
+		EXPECT_EQ(field->get_channels().at(0).second->get_layers(), field2->get_channels().at(0).second->get_layers());
+		EXPECT_EQ(channel2->get_voxel_flat<HistogramVoxel>("spectra", 3).get_bins(), 26);
+
+		auto channel1 = field->get_channel("test_channel");
+		auto channel3 = field2->get_channel("test_channel");
+		for (size_t i = 0; i < channel1->get_voxel_count(); i++) {
+			float val1 = channel1->get_voxel_flat<ScalarVoxel<float>>("doserate", i).get_data();
+			EXPECT_EQ(val1, layer->get_layer()->get_voxel_flat<ScalarVoxel<float>>(i).get_data());
+			EXPECT_EQ(val1, channel2->get_voxel_flat<ScalarVoxel<float>>("doserate", i).get_data());
+			EXPECT_EQ(val1, channel3->get_voxel_flat<ScalarVoxel<float>>("doserate", i).get_data());
+			EXPECT_EQ(channel1->get_voxel_flat<HistogramVoxel>("spectra", i).get_histogram()[5], channel3->get_voxel_flat<HistogramVoxel>("spectra", i).get_histogram()[5]);
+		}
+
+		// modifying a view must not alter the file
+		*channel3 += 1.f;
+		EXPECT_EQ(channel3->get_voxel_flat<ScalarVoxel<float>>("doserate", 20).get_data(), 11.f);
+		std::shared_ptr<CartesianRadiationField> field3 = std::static_pointer_cast<CartesianRadiationField>(FieldStore::load_mapped("test01.rf3"));
+		EXPECT_EQ(field3->get_channel("test_channel")->get_voxel_flat<ScalarVoxel<float>>("doserate", 20).get_data(), 10.f);
+	}
+
+	TEST(Storage, IndexedAccessing) {
+		std::shared_ptr<CartesianRadiationField> field = std::make_shared<CartesianRadiationField>(glm::vec3(2.5f), glm::vec3(0.05f));
+		std::shared_ptr<VoxelGridBuffer> channel = std::static_pointer_cast<VoxelGridBuffer>(field->add_channel("test_channel"));
+		field->add_channel("empty_channel");
+
+		channel->add_layer<glm::vec3>("dirs", glm::vec3(0.f), "normalized direction");
+		channel->add_layer<float>("doserate", 25.3f, "Gy/s");
+		channel->add_custom_layer<HistogramVoxel>("spectra", HistogramVoxel(26, 10.f, nullptr), .123f, "");
+
+		ScalarVoxel<float>& vx = channel->get_voxel_flat<ScalarVoxel<float>>("doserate", 20);
+		vx = 10.f;
+
+		std::shared_ptr<RadFiled3D::Storage::V1::RadiationFieldMetadata> metadata = make_test_metadata();
+
+		EXPECT_NO_THROW(FieldStore::store(field, metadata, "test_v2.rf3", StoreVersion::V2));
+		EXPECT_EQ(FieldStore::get_store_version("test_v2.rf3"), StoreVersion::V2);
+
+		std::shared_ptr<FieldAccessor> accessor = FieldStore::construct_accessor("test_v2.rf3");
+		EXPECT_EQ(accessor->getVoxelCount(), field->get_voxel_counts().x * field->get_voxel_counts().y * field->get_voxel_counts().z);
+		EXPECT_NE(std::dynamic_pointer_cast<V2::CartesianFieldAccessor>(accessor), nullptr);
+
+		std::ifstream file("test_v2.rf3", std::ios::binary);
+		std::shared_ptr<CartesianRadiationField> field2 = std::static_pointer_cast<CartesianRadiationField>(accessor->accessField(file));
+		EXPECT_EQ(field2->get_channels().size(), 2);
+		EXPECT_TRUE(field2->has_channel("empty_channel"));
+
+		std::shared_ptr<VoxelGrid> layer = std::dynamic_pointer_cast<CartesianFieldAccessor>(accessor)->accessLayer(file, "test_channel", "doserate");
+		std::shared_ptr<OwningScalarVoxel<float>> voxel = std::shared_ptr<OwningScalarVoxel<float>>((OwningScalarVoxel<float>*)accessor->accessVoxelRawFlat(file, "test_channel", "doserate", 20));
+		EXPECT_EQ(voxel->get_data(), 10.f);
+		file.close();
+
+		std::shared_ptr<CartesianRadiationField> field3 = std::static_pointer_cast<CartesianRadiationField>(FieldStore::load("test_v2.rf3"));
+		std::shared_ptr<CartesianRadiationField> field4 = std::static_pointer_cast<CartesianRadiationField>(FieldStore::load_mapped("test_v2.rf3"));
+
+		std::ifstream file2("test_v2.rf3", std::ios::binary);
+		std::shared_ptr<VoxelLayer> single_layer = FieldStore::load_single_layer(file2, "test_channel", "spectra");
+		EXPECT_THROW(FieldStore::load_single_layer(file2, "test_channel", "unknown"), RadiationFieldStoreException);
+		file2.close();
+
+		// pickled accessors keep their version
+		std::shared_ptr<FieldAccessor> accessor2 = FieldAccessor::Deserialize(FieldAccessor::Serialize(accessor.get()));
+		EXPECT_NE(std::dynamic_pointer_cast<V2::CartesianFieldAccessor>(accessor2), nullptr);
+		std::ifstream file3("test_v2.rf3", std::ios::binary);
+		std::shared_ptr<VoxelGrid> layer2 = std::dynamic_pointer_cast<CartesianFieldAccessor>(accessor2)->accessLayer(file3, "test_channel", "doserate");
+		file3.close();
+
+		auto channel1 = field->get_channel("test_channel");
+		auto channel3 = field3->get_channel("test_channel");
+		auto channel4 = field4->get_channel("test_channel");
+		for (size_t i = 0; i < channel1->get_voxel_count(); i++) {
+			float val1 = channel1->get_voxel_flat<ScalarVoxel<float>>("doserate", i).get_data();
+			EXPECT_EQ(val1, layer->get_layer()->get_voxel_flat<ScalarVoxel<float>>(i).get_data());
+			EXPECT_EQ(val1, layer2->get_layer()->get_voxel_flat<ScalarVoxel<float>>(i).get_data());
+			EXPECT_EQ(val1, channel3->get_voxel_flat<ScalarVoxel<float>>("doserate", i).get_data());
+			EXPECT_EQ(val1, channel4->get_voxel_flat<ScalarVoxel<float>>("doserate", i).get_data());
+			EXPECT_EQ(channel1->get_voxel_flat<HistogramVoxel>("spectra", i).get_histogram()[5], single_layer->get_voxel_flat<HistogramVoxel>(i).get_histogram()[5]);
+		}
+	}
+
+	TEST(Storage, EncodedLayers) {
+		std::shared_ptr<CartesianRadiationField> field = std::make_shared<CartesianRadiationField>(glm::vec3(2.5f), glm::vec3(0.05f));
+		std::shared_ptr<VoxelGridBuffer> channel = std::static_pointer_cast<VoxelGridBuffer>(field->add_channel("test_channel"));
+
+		channel->add_layer<float>("doserate", 0.f, "Gy/s");
+		channel->add_layer<glm::vec3>("noise", glm::vec3(0.f), "");
+		channel->add_custom_layer<HistogramVoxel>("spectra", HistogramVoxel(26, 10.f, nullptr), .123f, "");
+
+		channel->get_voxel_flat<ScalarVoxel<float>>("doserate", 20) = 10.f;
+		channel->get_voxel_flat<HistogramVoxel>("spectra", 7).get_histogram()[3] = 2.5f;
+		for (size_t i = 0; i < channel->get_voxel_count(); i++)
+			channel->get_voxel_flat<ScalarVoxel<glm::vec3>>("noise", i) = glm::vec3(static_cast<float>(i) * 1.37f, std::sin(static_cast<float>(i)), static_cast<float>(i % 7));
+
+		std::shared_ptr<RadFiled3D::Storage::V1::RadiationFieldMetadata> metadata = make_test_metadata();
+
+		FieldStore::set_layer_codec(LayerCodec::Raw);
+		EXPECT_NO_THROW(FieldStore::store(field, metadata, "test_raw.rf3", StoreVersion::V2));
+		FieldStore::set_layer_codec(LayerCodec::ShuffleRLE);
+		EXPECT_NO_THROW(FieldStore::store(field, metadata, "test_encoded.rf3", StoreVersion::V2));
+		FieldStore::set_layer_codec(LayerCodec::Raw);
+
+		std::ifstream raw_file("test_raw.rf3", std::ios::binary | std::ios::ate);
+		std::ifstream encoded_file("test_encoded.rf3", std::ios::binary | std::ios::ate);
+		EXPECT_LT(static_cast<size_t>(encoded_file.tellg()) * 2, static_cast<size_t>(raw_file.tellg()));
+		raw_file.close();
+		encoded_file.close();
+
+		std::shared_ptr<CartesianRadiationField> field2 = std::static_pointer_cast<CartesianRadiationField>(FieldStore::load("test_encoded.rf3"));
+		std::shared_ptr<CartesianRadiationField> field3 = std::static_pointer_cast<CartesianRadiationField>(FieldStore::load_mapped("test_encoded.rf3"));
+		EXPECT_FALSE(field3->get_channel("test_channel")->get_layer("doserate").is_view());
+
+		std::shared_ptr<FieldAccessor> accessor = FieldStore::construct_accessor("test_encoded.rf3");
+		std::ifstream file("test_encoded.rf3", std::ios::binary);
+		std::shared_ptr<OwningScalarVoxel<float>> voxel = std::shared_ptr<OwningScalarVoxel<float>>((OwningScalarVoxel<float>*)accessor->accessVoxelRawFlat(file, "test_channel", "doserate", 20));
+		EXPECT_EQ(voxel->get_data(), 10.f);
+		std::vector<IVoxel*> voxels = accessor->accessVoxelsRawFlat(file, "test_channel", "spectra", { 6, 7 });
+		EXPECT_EQ(((HistogramVoxel*)voxels[1])->get_histogram()[3], 2.5f);
+		EXPECT_EQ(((HistogramVoxel*)voxels[0])->get_histogram()[3], .123f);
+		for (IVoxel* vx : voxels)
+			delete vx;
+		std::shared_ptr<VoxelLayer> single_layer = FieldStore::load_single_layer(file, "test_channel", "noise");
+		file.close();
+
+		auto channel1 = field->get_channel("test_channel");
+		auto channel2 = field2->get_channel("test_channel");
+		auto channel3 = field3->get_channel("test_channel");
+		for (size_t i = 0; i < channel1->get_voxel_count(); i++) {
+			float val1 = channel1->get_voxel_flat<ScalarVoxel<float>>("doserate", i).get_data();
+			EXPECT_EQ(val1, channel2->get_voxel_flat<ScalarVoxel<float>>("doserate", i).get_data());
+			EXPECT_EQ(val1, channel3->get_voxel_flat<ScalarVoxel<float>>("doserate", i).get_data());
+			EXPECT_EQ(channel1->get_voxel_flat<ScalarVoxel<glm::vec3>>("noise", i).get_data(), channel2->get_voxel_flat<ScalarVoxel<glm::vec3>>("noise", i).get_data());
+			EXPECT_EQ(channel1->get_voxel_flat<ScalarVoxel<glm::vec3>>("noise", i).get_data(), single_layer->get_voxel_flat<ScalarVoxel<glm::vec3>>(i).get_data());
+			EXPECT_EQ(channel1->get_voxel_flat<HistogramVoxel>("spectra", i).get_histogram()[3], channel2->get_voxel_flat<HistogramVoxel>("spectra", i).get_histogram()[3]);
+		}
+	}
+
+	TEST(Storage, EncodedLayersAcrossFiles) {
+		// the encoded layers of both files compress differently, so that the layers of the second file are placed elsewhere than in the first one
+		auto make_field = [](bool compressible) {
+			std::shared_ptr<CartesianRadiationField> field = std::make_shared<CartesianRadiationField>(glm::vec3(1.f), glm::vec3(0.05f));
+			std::shared_ptr<VoxelGridBuffer> channel = std::static_pointer_cast<VoxelGridBuffer>(field->add_channel("test_channel"));
+			channel->add_layer<float>("background", 0.f, "");
+			channel->add_layer<float>("doserate", 0.f, "Gy/s");
+			for (size_t i = 0; i < channel->get_voxel_count(); i++) {
+				channel->get_voxel_flat<ScalarVoxel<float>>("background", i) = compressible ? 1.f : static_cast<float>((i * 7919) % 1000) * 1.37f;
+				channel->get_voxel_flat<ScalarVoxel<float>>("doserate", i) = static_cast<float>(i) + (compressible ? 0.f : 0.5f);
+			}
+			return field;
+		};
+		std::shared_ptr<RadFiled3D::Storage::V1::RadiationFieldMetadata> metadata = make_test_metadata();
+
+		FieldStore::set_layer_codec(LayerCodec::ShuffleRLE);
+		EXPECT_NO_THROW(FieldStore::store(make_field(true), metadata, "test_across_0.rf3", StoreVersion::V2));
+		EXPECT_NO_THROW(FieldStore::store(make_field(false), metadata, "test_across_1.rf3", StoreVersion::V2));
+		FieldStore::set_layer_brick_size(8);
+		EXPECT_NO_THROW(FieldStore::store(make_field(false), metadata, "test_across_2.rf3", StoreVersion::V2));
+		FieldStore::set_layer_brick_size(0);
+		FieldStore::set_layer_codec(LayerCodec::Raw);
+
+		std::shared_ptr<CartesianFieldAccessor> accessor = std::dynamic_pointer_cast<CartesianFieldAccessor>(FieldStore::construct_accessor("test_across_0.rf3"));
+		std::shared_ptr<FieldAccessor> own_accessor = FieldStore::construct_accessor("test_across_1.rf3");
+		EXPECT_NE(accessor->getLayerPosition("test_channel", "doserate"), own_accessor->getLayerPosition("test_channel", "doserate"));
+
+		const std::vector<size_t> voxel_indices = { 5, 6, 1234 };
+		for (const char* file_name : { "test_across_1.rf3", "test_across_2.rf3" }) {
+			std::ifstream file(file_name, std::ios::binary);
+			std::vector<IVoxel*> voxels = accessor->accessVoxelsRawFlat(file, "test_channel", "doserate", voxel_indices);
+			for (size_t i = 0; i < voxels.size(); i++) {
+				EXPECT_EQ(((ScalarVoxel<float>*)voxels[i])->get_data(), static_cast<float>(voxel_indices[i]) + 0.5f);
+				delete voxels[i];
+			}
+			std::shared_ptr<VoxelGrid> layer = accessor->accessLayer(file, "test_channel", "background");
+			EXPECT_EQ(layer->get_layer()->get_voxel_flat<ScalarVoxel<float>>(1234).get_data(), static_cast<float>((1234 * 7919) % 1000) * 1.37f);
+			std::shared_ptr<VoxelGrid> subvolume = accessor->accessSubvolume(file, "test_channel", "doserate", glm::uvec3(1, 2, 3), glm::uvec3(4, 5, 6));
+			EXPECT_EQ(subvolume->get_voxel<ScalarVoxel<float>>(0, 0, 0).get_data(), static_cast<float>(layer->get_voxel_idx(1, 2, 3)) + 0.5f);
+			file.close();
+
+			std::vector<float> doserates(voxel_indices.size());
+			accessor->accessVoxelsDataFlat(std::make_shared<PositionalFile>(file_name), "test_channel", "doserate", voxel_indices, (char*)doserates.data(), doserates.size() * sizeof(float));
+			EXPECT_EQ(doserates[2], 1234.5f);
+			accessor->accessVoxelsDataFlat(std::make_shared<MappedFile>(file_name), "test_channel", "doserate", voxel_indices, (char*)doserates.data(), doserates.size() * sizeof(float));
+			EXPECT_EQ(doserates[1], 6.5f);
+			std::shared_ptr<CartesianRadiationField> mapped_field = std::static_pointer_cast<CartesianRadiationField>(accessor->accessField(std::make_shared<MappedFile>(file_name)));
+			EXPECT_EQ(mapped_field->get_channel("test_channel")->get_voxel_flat<ScalarVoxel<float>>("doserate", 1234).get_data(), 1234.5f);
+
+			Dataset::VoxelCollectionAccessor collection_accessor(accessor, { "test_channel" }, { "doserate" });
+			std::vector<Dataset::VoxelCollectionRequest> requests;
+			requests.push_back(Dataset::VoxelCollectionRequest("test_across_0.rf3", voxel_indices));
+			requests.push_back(Dataset::VoxelCollectionRequest(file_name, voxel_indices));
+			std::shared_ptr<Dataset::VoxelCollection> collection = collection_accessor.access(requests);
+			const float* collected = (const float*)collection->channels["test_channel"].layers["doserate"].data.get();
+			EXPECT_EQ(collected[2], 1234.f);
+			EXPECT_EQ(collected[5], 1234.5f);
+		}
+
+		// files, whose layers store their voxels differently, are refused instead of being misread
+		std::shared_ptr<CartesianRadiationField> other_field = std::make_shared<CartesianRadiationField>(glm::vec3(1.f), glm::vec3(0.05f));
+		std::static_pointer_cast<VoxelGridBuffer>(other_field->add_channel("test_channel"))->add_layer<double>("doserate", 1.0, "Gy/s");
+		EXPECT_NO_THROW(FieldStore::store(other_field, metadata, "test_across_3.rf3", StoreVersion::V2));
+		std::ifstream other_file("test_across_3.rf3", std::ios::binary);
+		EXPECT_THROW(accessor->accessVoxelsRawFlat(other_file, "test_channel", "doserate", voxel_indices), RadiationFieldStoreException);
+		EXPECT_THROW(accessor->accessVoxelsRawFlat(other_file, "test_channel", "background", voxel_indices), RadiationFieldStoreException);
+		other_file.close();
+
+		for (const char* file_name : { "test_across_0.rf3", "test_across_1.rf3", "test_across_2.rf3", "test_across_3.rf3" })
+			std::remove(file_name);
+	}
+
+	TEST(Storage, SubvolumeAccessing) {
+		std::shared_ptr<CartesianRadiationField> field = std::make_shared<CartesianRadiationField>(glm::vec3(2.5f), glm::vec3(0.05f));
+		std::shared_ptr<VoxelGridBuffer> channel = std::static_pointer_cast<VoxelGridBuffer>(field->add_channel("test_channel"));
+
+		channel->add_layer<float>("doserate", 0.f, "Gy/s");
+		channel->add_custom_layer<HistogramVoxel>("spectra", HistogramVoxel(8, 10.f, nullptr), 0.f, "");
+		for (size_t i = 0; i < channel->get_voxel_count(); i++) {
+			channel->get_voxel_flat<ScalarVoxel<float>>("doserate", i) = static_cast<float>(i);
+			channel->get_voxel_flat<HistogramVoxel>("spectra", i).get_histogram()[i % 8] = static_cast<float>(i % 13);
+		}
+
+		std::shared_ptr<RadFiled3D::Storage::V1::RadiationFieldMetadata> metadata = make_test_metadata();
+
+		EXPECT_NO_THROW(FieldStore::store(field, metadata, "test_subvolume_v1.rf3", StoreVersion::V1));
+		FieldStore::set_layer_codec(LayerCodec::ShuffleRLE);
+		EXPECT_NO_THROW(FieldStore::store(field, metadata, "test_subvolume_encoded.rf3", StoreVersion::V2));
+		FieldStore::set_layer_brick_size(16);
+		EXPECT_NO_THROW(FieldStore::store(field, metadata, "test_subvolume_bricked.rf3", StoreVersion::V2));
+		FieldStore::set_layer_codec(LayerCodec::Raw);
+		EXPECT_NO_THROW(FieldStore::store(field, metadata, "test_subvolume_bricked_raw.rf3", StoreVersion::V2));
+		FieldStore::set_layer_brick_size(0);
+
+		const glm::uvec3 min_idx(3, 17, 30);
+		const glm::uvec3 max_idx(20, 33, 50);
+		for (const char* file_name : { "test_subvolume_v1.rf3", "test_subvolume_encoded.rf3", "test_subvolume_bricked.rf3", "test_subvolume_bricked_raw.rf3" }) {
+			std::shared_ptr<CartesianFieldAccessor> accessor = std::dynamic_pointer_cast<CartesianFieldAccessor>(FieldStore::construct_accessor(file_name));
+			std::ifstream file(file_name, std::ios::binary);
+			std::shared_ptr<VoxelGrid> doserate = accessor->accessSubvolume(file, "test_channel", "doserate", min_idx, max_idx);
+			std::shared_ptr<VoxelGrid> spectra = accessor->accessSubvolume(std::make_shared<MappedFile>(file_name), "test_channel", "spectra", min_idx, max_idx);
+			EXPECT_THROW(accessor->accessSubvolume(file, "test_channel", "doserate", min_idx, glm::uvec3(20, 33, 51)), RadiationFieldStoreException);
+			EXPECT_THROW(accessor->accessSubvolume(file, "test_channel", "doserate", min_idx, min_idx), RadiationFieldStoreException);
+			file.close();
+
+			EXPECT_EQ(doserate->get_voxel_counts(), max_idx - min_idx);
+			EXPECT_EQ(doserate->get_layer()->get_voxel_count(), 17 * 16 * 20);
+			for (size_t z = min_idx.z; z < max_idx.z; z++) {
+				for (size_t y = min_idx.y; y < max_idx.y; y++) {
+					for (size_t x = min_idx.x; x < max_idx.x; x++) {
+						const size_t idx = channel->get_voxel_idx(x, y, z);
+						EXPECT_EQ(doserate->get_voxel<ScalarVoxel<float>>(x - min_idx.x, y - min_idx.y, z - min_idx.z).get_data(), static_cast<float>(idx));
+						EXPECT_EQ(spectra->get_voxel<HistogramVoxel>(x - min_idx.x, y - min_idx.y, z - min_idx.z).get_histogram()[idx % 8], static_cast<float>(idx % 13));
+					}
+				}
+			}
+		}
+
+		std::shared_ptr<CartesianRadiationField> field2 = std::static_pointer_cast<CartesianRadiationField>(FieldStore::load("test_subvolume_bricked.rf3"));
+		std::shared_ptr<FieldAccessor> accessor = FieldStore::construct_accessor("test_subvolume_bricked.rf3");
+		std::ifstream file("test_subvolume_bricked.rf3", std::ios::binary);
+		std::shared_ptr<OwningScalarVoxel<float>> voxel = std::shared_ptr<OwningScalarVoxel<float>>((OwningScalarVoxel<float>*)accessor->accessVoxelRawFlat(file, "test_channel", "doserate", 12345));
+		EXPECT_EQ(voxel->get_data(), 12345.f);
+		file.close();
+		auto channel2 = field2->get_channel("test_channel");
+		for (size_t i = 0; i < channel->get_voxel_count(); i++) {
+			EXPECT_EQ(channel2->get_voxel_flat<ScalarVoxel<float>>("doserate", i).get_data(), static_cast<float>(i));
+			EXPECT_EQ(channel2->get_voxel_flat<HistogramVoxel>("spectra", i).get_histogram()[i % 8], static_cast<float>(i % 13));
+		}
+	}
+
+	TEST(Storage, BatchedVoxelAccessing) {
+		std::shared_ptr<CartesianRadiationField> field = std::make_shared<CartesianRadiationField>(glm::vec3(1.f), glm::vec3(0.05f));
+		std::shared_ptr<VoxelGridBuffer> channel = std::static_pointer_cast<VoxelGridBuffer>(field->add_channel("test_channel"));
+		channel->add_layer<float>("doserate", 0.f, "Gy/s");
+		channel->add_custom_layer<HistogramVoxel>("spectra", HistogramVoxel(4, 10.f, nullptr), 0.f, "");
+		for (size_t i = 0; i < channel->get_voxel_count(); i++) {
+			channel->get_voxel_flat<ScalarVoxel<float>>("doserate", i) = static_cast<float>(i);
+			channel->get_voxel_flat<HistogramVoxel>("spectra", i).get_histogram()[i % 4] = static_cast<float>(i);
+		}
+
+		std::shared_ptr<RadFiled3D::Storage::V1::RadiationFieldMetadata> metadata = make_test_metadata();
+		EXPECT_NO_THROW(FieldStore::store(field, metadata, "test_batched.rf3", StoreVersion::V1));
+
+		// unordered indices with duplicates, neighbours and far apart voxels
+		const std::vector<size_t> indices = { 7999, 5, 6, 4000, 5, 0, 1000, 1001, 7998, 3, 6000, 4000 };
+		std::shared_ptr<FieldAccessor> accessor = FieldStore::construct_accessor("test_batched.rf3");
+		std::ifstream file("test_batched.rf3", std::ios::binary);
+		for (size_t threshold : { static_cast<size_t>(0), static_cast<size_t>(64), static_cast<size_t>(4096), std::numeric_limits<size_t>::max() / 2 }) {
+			accessor->setVoxelReadGapThreshold(threshold);
+			std::vector<IVoxel*> doserates = accessor->accessVoxelsRawFlat(file, "test_channel", "doserate", indices);
+			std::vector<IVoxel*> spectra = accessor->accessVoxelsRawFlat(file, "test_channel", "spectra", indices);
+			ASSERT_EQ(doserates.size(), indices.size());
+			for (size_t i = 0; i < indices.size(); i++) {
+				std::unique_ptr<IVoxel> doserate(doserates[i]);
+				std::unique_ptr<IVoxel> spectrum(spectra[i]);
+				EXPECT_EQ(((ScalarVoxel<float>*)doserate.get())->get_data(), static_cast<float>(indices[i]));
+				EXPECT_EQ(((HistogramVoxel*)spectrum.get())->get_histogram()[indices[i] % 4], static_cast<float>(indices[i]));
+			}
+		}
+		EXPECT_THROW(accessor->accessVoxelsRawFlat(file, "test_channel", "doserate", { 3, 8000 }), RadiationFieldStoreException);
+		file.close();
+	}
+
+	TEST(Storage, ContiguousVoxelAccessing) {
+		std::shared_ptr<CartesianRadiationField> field = std::make_shared<CartesianRadiationField>(glm::vec3(1.f), glm::vec3(0.05f));
+		std::shared_ptr<VoxelGridBuffer> channel = std::static_pointer_cast<VoxelGridBuffer>(field->add_channel("test_channel"));
+		channel->add_layer<float>("doserate", 0.f, "Gy/s");
+		channel->add_layer<glm::vec3>("dirs", glm::vec3(0.f), "normalized direction");
+		channel->add_custom_layer<HistogramVoxel>("spectra", HistogramVoxel(4, 10.f, nullptr), 0.f, "");
+		for (size_t i = 0; i < channel->get_voxel_count(); i++) {
+			channel->get_voxel_flat<ScalarVoxel<float>>("doserate", i) = static_cast<float>(i);
+			channel->get_voxel_flat<ScalarVoxel<glm::vec3>>("dirs", i) = glm::vec3(static_cast<float>(i), 1.f, 2.f);
+			channel->get_voxel_flat<HistogramVoxel>("spectra", i).get_histogram()[i % 4] = static_cast<float>(i);
+		}
+
+		std::shared_ptr<RadFiled3D::Storage::V1::RadiationFieldMetadata> metadata = make_test_metadata();
+		EXPECT_NO_THROW(FieldStore::store(field, metadata, "test_contiguous.rf3", StoreVersion::V1));
+		FieldStore::set_layer_codec(LayerCodec::ShuffleRLE);
+		EXPECT_NO_THROW(FieldStore::store(field, metadata, "test_contiguous_encoded.rf3", StoreVersion::V2));
+		FieldStore::set_layer_codec(LayerCodec::Raw);
+
+		const std::vector<size_t> indices = { 7999, 5, 6, 4000, 5, 0, 1000, 1001, 3 };
+		for (const std::string file_name : { "test_contiguous.rf3", "test_contiguous_encoded.rf3" }) {
+			std::shared_ptr<FieldAccessor> accessor = FieldStore::construct_accessor(file_name);
+			std::shared_ptr<MappedFile> mapped_file = std::make_shared<MappedFile>(file_name);
+			std::ifstream file(file_name, std::ios::binary);
+
+			const auto& doserate_def = accessor->getLayerDefinition("test_channel", "doserate");
+			EXPECT_EQ(doserate_def.dtype, Typing::DType::Float);
+			EXPECT_EQ(doserate_def.elements_per_voxel, 1);
+			const auto& dirs_def = accessor->getLayerDefinition("test_channel", "dirs");
+			EXPECT_EQ(dirs_def.dtype, Typing::DType::Vec3);
+			const auto& spectra_def = accessor->getLayerDefinition("test_channel", "spectra");
+			EXPECT_EQ(spectra_def.dtype, Typing::DType::Hist);
+			EXPECT_EQ(spectra_def.elements_per_voxel, 4);
+			EXPECT_THROW(accessor->getLayerDefinition("test_channel", "missing"), RadiationFieldStoreException);
+
+			std::vector<float> doserates(indices.size());
+			std::vector<glm::vec3> dirs(indices.size());
+			std::vector<float> spectra(indices.size() * 4);
+			EXPECT_EQ(accessor->accessVoxelsDataFlat(file, "test_channel", "doserate", indices, (char*)doserates.data(), doserates.size() * sizeof(float)), doserates.size() * sizeof(float));
+			EXPECT_EQ(accessor->accessVoxelsDataFlat(file, "test_channel", "dirs", indices, (char*)dirs.data(), dirs.size() * sizeof(glm::vec3)), dirs.size() * sizeof(glm::vec3));
+			EXPECT_EQ(accessor->accessVoxelsDataFlat(mapped_file, "test_channel", "spectra", indices, (char*)spectra.data(), spectra.size() * sizeof(float)), spectra.size() * sizeof(float));
+			for (size_t i = 0; i < indices.size(); i++) {
+				EXPECT_EQ(doserates[i], static_cast<float>(indices[i]));
+				EXPECT_EQ(dirs[i], glm::vec3(static_cast<float>(indices[i]), 1.f, 2.f));
+				for (size_t b = 0; b < 4; b++)
+					EXPECT_EQ(spectra[i * 4 + b], (b == indices[i] % 4) ? static_cast<float>(indices[i]) : 0.f);
+			}
+
+			EXPECT_THROW(accessor->accessVoxelsDataFlat(file, "test_channel", "doserate", indices, (char*)doserates.data(), doserates.size() * sizeof(float) - 1), RadiationFieldStoreException);
+			EXPECT_THROW(accessor->accessVoxelsDataFlat(mapped_file, "test_channel", "doserate", { 3, 8000 }, (char*)doserates.data(), doserates.size() * sizeof(float)), RadiationFieldStoreException);
+		}
+
+		std::shared_ptr<FieldAccessor> accessor = FieldStore::construct_accessor("test_contiguous.rf3");
+		Dataset::VoxelCollectionAccessor vx_accessor = Dataset::VoxelCollectionAccessor(accessor, { "test_channel" }, { "doserate", "spectra" });
+		std::shared_ptr<Dataset::VoxelCollection> collection = vx_accessor.access({
+			Dataset::VoxelCollectionRequest("test_contiguous.rf3", { 10, 20 }),
+			Dataset::VoxelCollectionRequest("test_contiguous.rf3", { 30 })
+		});
+		auto& doserate_layer = collection->channels["test_channel"].layers["doserate"];
+		EXPECT_EQ(doserate_layer.dtype, Typing::DType::Float);
+		EXPECT_EQ(doserate_layer.voxel_bytes, sizeof(float));
+		ASSERT_EQ(doserate_layer.get_bytes(), 3 * sizeof(float));
+		const float* doserate_data = doserate_layer.get_data<float>();
+		EXPECT_EQ(doserate_data[0], 10.f);
+		EXPECT_EQ(doserate_data[1], 20.f);
+		EXPECT_EQ(doserate_data[2], 30.f);
+
+		auto& spectra_layer = collection->channels["test_channel"].layers["spectra"];
+		EXPECT_EQ(spectra_layer.elements_per_voxel, 4);
+		ASSERT_EQ(spectra_layer.get_bytes(), 3 * 4 * sizeof(float));
+		EXPECT_EQ(spectra_layer.get_data<float>()[2 * 4 + 30 % 4], 30.f);
+	}
+
+	TEST(Storage, ConcurrentAccessing) {
+		std::shared_ptr<CartesianRadiationField> field = std::make_shared<CartesianRadiationField>(glm::vec3(1.f), glm::vec3(0.05f));
+		std::shared_ptr<VoxelGridBuffer> channel = std::static_pointer_cast<VoxelGridBuffer>(field->add_channel("test_channel"));
+		channel->add_layer<float>("doserate", 0.f, "Gy/s");
+		channel->add_custom_layer<HistogramVoxel>("spectra", HistogramVoxel(4, 10.f, nullptr), 0.f, "");
+		for (size_t i = 0; i < channel->get_voxel_count(); i++) {
+			channel->get_voxel_flat<ScalarVoxel<float>>("doserate", i) = static_cast<float>(i);
+			channel->get_voxel_flat<HistogramVoxel>("spectra", i).get_histogram()[i % 4] = static_cast<float>(i);
+		}
+
+		std::shared_ptr<RadFiled3D::Storage::V1::RadiationFieldMetadata> metadata = make_test_metadata();
+		EXPECT_NO_THROW(FieldStore::store(field, metadata, "test_concurrent.rf3", StoreVersion::V1));
+
+		// one accessor and one file handle shared by all threads
+		std::shared_ptr<FieldAccessor> accessor = FieldStore::construct_accessor("test_concurrent.rf3");
+		std::shared_ptr<CartesianFieldAccessor> cartesian_accessor = std::dynamic_pointer_cast<CartesianFieldAccessor>(accessor);
+		std::shared_ptr<PositionalFile> file = std::make_shared<PositionalFile>("test_concurrent.rf3");
+		std::atomic<size_t> failures(0);
+		std::vector<std::thread> threads;
+		for (size_t t = 0; t < 8; t++) {
+			threads.emplace_back([&, t]() {
+				try {
+					for (size_t iteration = 0; iteration < 20; iteration++) {
+						std::vector<size_t> indices;
+						for (size_t i = 0; i < 16; i++)
+							indices.push_back((t * 997 + iteration * 131 + i * 17) % 8000);
+
+						std::vector<float> doserates(indices.size());
+						accessor->accessVoxelsDataFlat(file, "test_channel", "doserate", indices, (char*)doserates.data(), doserates.size() * sizeof(float));
+						std::vector<IVoxel*> spectra = accessor->accessVoxelsRawFlat(file, "test_channel", "spectra", indices);
+						for (size_t i = 0; i < indices.size(); i++) {
+							std::unique_ptr<IVoxel> spectrum(spectra[i]);
+							if (doserates[i] != static_cast<float>(indices[i]) || ((HistogramVoxel*)spectrum.get())->get_histogram()[indices[i] % 4] != static_cast<float>(indices[i]))
+								failures++;
+						}
+
+						std::shared_ptr<VoxelGrid> layer = cartesian_accessor->accessLayer(file, "test_channel", (iteration % 2 == 0) ? "doserate" : "spectra");
+						if (layer->get_layer()->get_voxel_count() != 8000)
+							failures++;
+						std::shared_ptr<VoxelGrid> subvolume = cartesian_accessor->accessSubvolume(file, "test_channel", "doserate", glm::uvec3(t, 1, 2), glm::uvec3(t + 2, 4, 5));
+						if (subvolume->get_voxel<ScalarVoxel<float>>(0, 0, 0).get_data() != static_cast<float>(channel->get_voxel_idx(t, 1, 2)))
+							failures++;
+					}
+				}
+				catch (...) {
+					failures++;
+				}
+			});
+		}
+		for (auto& thread : threads)
+			thread.join();
+		EXPECT_EQ(failures.load(), 0);
+
+		std::vector<char> beyond(16);
+		EXPECT_THROW(file->read(file->size() - 8, beyond.data(), beyond.size()), PositionalFileException);
+		EXPECT_THROW(PositionalFile("does_not_exist.rf3"), PositionalFileException);
+	}
+
+	TEST(Storage, ConcurrentLoading) {
+		std::shared_ptr<CartesianRadiationField> field = std::make_shared<CartesianRadiationField>(glm::vec3(1.f), glm::vec3(0.1f));
+		std::shared_ptr<VoxelGridBuffer> channel = std::static_pointer_cast<VoxelGridBuffer>(field->add_channel("test_channel"));
+		channel->add_layer<float>("doserate", 0.f, "Gy/s");
+		for (size_t i = 0; i < channel->get_voxel_count(); i++)
+			channel->get_voxel_flat<ScalarVoxel<float>>("doserate", i) = static_cast<float>(i);
+
+		std::shared_ptr<RadFiled3D::Storage::V1::RadiationFieldMetadata> metadata = make_test_metadata();
+		EXPECT_NO_THROW(FieldStore::store(field, metadata, "test_concurrent_v1.rf3", StoreVersion::V1));
+		EXPECT_NO_THROW(FieldStore::store(field, metadata, "test_concurrent_v2.rf3", StoreVersion::V2));
+
+		// alternating between the versions makes the threads replace the cached store of each other
+		std::atomic<size_t> failures(0);
+		std::vector<std::thread> threads;
+		for (size_t t = 0; t < 8; t++) {
+			threads.emplace_back([&, t]() {
+				try {
+					for (size_t iteration = 0; iteration < 10; iteration++) {
+						const std::string file = ((t + iteration) % 2 == 0) ? "test_concurrent_v1.rf3" : "test_concurrent_v2.rf3";
+						auto loaded = std::dynamic_pointer_cast<CartesianRadiationField>(FieldStore::load(file));
+						if (loaded->get_channel("test_channel")->get_voxel_flat<ScalarVoxel<float>>("doserate", 42).get_data() != 42.f)
+							failures++;
+						auto loaded_metadata = std::dynamic_pointer_cast<RadFiled3D::Storage::V1::RadiationFieldMetadata>(FieldStore::peek_metadata(file));
+						if (loaded_metadata->get_header().simulation.primary_particle_count != 100)
+							failures++;
+					}
+				}
+				catch (...) {
+					failures++;
+				}
+			});
+		}
+		for (auto& thread : threads)
+			thread.join();
+		EXPECT_EQ(failures.load(), 0);
+	}
+
+	TEST(Storage, ParallelLoading) {
+		std::shared_ptr<CartesianRadiationField> field = std::make_shared<CartesianRadiationField>(glm::vec3(1.f), glm::vec3(0.05f));
+		std::shared_ptr<VoxelBuffer> channel = field->add_channel("test_channel");
+		channel->add_layer<float>("doserate", 0.f, "Gy/s");
+		channel->add_layer<double>("energy", 0.0, "eV");
+		channel->add_layer<glm::vec3>("dirs", glm::vec3(0.f), "normalized direction");
+		channel->add_custom_layer<HistogramVoxel>("spectra", HistogramVoxel(16, 10.f, nullptr), .25f, "");
+		for (size_t i = 0; i < channel->get_voxel_count(); i++) {
+			channel->get_voxel_flat<ScalarVoxel<float>>("doserate", i) = static_cast<float>(i);
+			channel->get_voxel_flat<ScalarVoxel<double>>("energy", i) = static_cast<double>(i % 13);
+			channel->get_voxel_flat<HistogramVoxel>("spectra", i).get_histogram()[i % 16] = static_cast<float>(i % 5);
+		}
+		channel->set_statistical_error("doserate", 0.125f);
+		field->add_channel("empty");
+		field->add_channel("second")->add_layer<int32_t>("hits", 3, "");
+
+		std::shared_ptr<RadFiled3D::Storage::V1::RadiationFieldMetadata> metadata = make_test_metadata();
+		auto read_file = [](const std::string& file) {
+			std::ifstream stream(file, std::ios::binary);
+			return std::string((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+		};
+		auto expect_identical = [](std::shared_ptr<IRadiationField> expected, std::shared_ptr<IRadiationField> actual) {
+			ASSERT_EQ(expected->get_channels().size(), actual->get_channels().size());
+			for (auto& expected_channel : expected->get_channels()) {
+				ASSERT_TRUE(actual->has_channel(expected_channel.first));
+				std::shared_ptr<VoxelBuffer> actual_channel = actual->get_generic_channel(expected_channel.first);
+				ASSERT_EQ(expected_channel.second->get_layers().size(), actual_channel->get_layers().size());
+				for (auto& layer_name : expected_channel.second->get_layers()) {
+					ASSERT_TRUE(actual_channel->has_layer(layer_name));
+					EXPECT_EQ(expected_channel.second->get_layer_unit(layer_name), actual_channel->get_layer_unit(layer_name));
+					EXPECT_EQ(expected_channel.second->get_statistical_error(layer_name), actual_channel->get_statistical_error(layer_name));
+					EXPECT_EQ(expected_channel.second->get_voxel_flat(layer_name, 0).get_type(), actual_channel->get_voxel_flat(layer_name, 0).get_type());
+					const size_t bytes = expected_channel.second->get_voxel_count() * expected_channel.second->get_layer(layer_name).get_bytes_per_voxel_data();
+					ASSERT_EQ(bytes, actual_channel->get_voxel_count() * actual_channel->get_layer(layer_name).get_bytes_per_voxel_data());
+					EXPECT_EQ(std::memcmp(expected_channel.second->get_layer<char>(layer_name), actual_channel->get_layer<char>(layer_name), bytes), 0);
+				}
+			}
+		};
+
+		for (LayerCodec codec : { LayerCodec::Raw, LayerCodec::ShuffleRLE }) {
+			FieldStore::set_layer_codec(codec);
+			for (StoreVersion version : { StoreVersion::V1, StoreVersion::V2 }) {
+				VoxelBuffer::set_worker_count(1);
+				EXPECT_NO_THROW(FieldStore::store(field, metadata, "test_parallel_serial.rf3", version));
+				std::shared_ptr<IRadiationField> serial = FieldStore::load("test_parallel_serial.rf3");
+
+				// layers are prepared and loaded on multiple threads with the same result
+				VoxelBuffer::set_worker_count(4);
+				EXPECT_NO_THROW(FieldStore::store(field, metadata, "test_parallel.rf3", version));
+				EXPECT_TRUE(read_file("test_parallel_serial.rf3") == read_file("test_parallel.rf3"));
+				std::shared_ptr<IRadiationField> parallel = FieldStore::load("test_parallel.rf3");
+				VoxelBuffer::set_worker_count(1);
+
+				expect_identical(serial, parallel);
+				expect_identical(field, parallel);
+			}
+		}
+		FieldStore::set_layer_codec(LayerCodec::Raw);
+
+		// a truncated file fails on the workers and the error reaches the caller
+		const std::string data = read_file("test_parallel.rf3");
+		{
+			std::ofstream truncated("test_parallel.rf3", std::ios::binary | std::ios::trunc);
+			truncated.write(data.data(), data.size() / 2);
+		}
+		VoxelBuffer::set_worker_count(4);
+		EXPECT_ANY_THROW(FieldStore::load("test_parallel.rf3"));
+		VoxelBuffer::set_worker_count(1);
+
+		std::remove("test_parallel_serial.rf3");
+		std::remove("test_parallel.rf3");
+	}
+
+	TEST(Storage, ByteSources) {
+		std::shared_ptr<CartesianRadiationField> field = std::make_shared<CartesianRadiationField>(glm::vec3(1.f), glm::vec3(0.1f));
+		std::shared_ptr<VoxelBuffer> channel = field->add_channel("test_channel");
+		channel->add_layer<float>("doserate", 0.f, "Gy/s");
+		channel->add_custom_layer<HistogramVoxel>("spectra", HistogramVoxel(4, 10.f, nullptr), 0.f, "");
+		for (size_t i = 0; i < channel->get_voxel_count(); i++) {
+			channel->get_voxel_flat<ScalarVoxel<float>>("doserate", i) = static_cast<float>(i);
+			channel->get_voxel_flat<HistogramVoxel>("spectra", i).get_histogram()[i % 4] = static_cast<float>(i % 7);
+		}
+
+		std::shared_ptr<RadFiled3D::Storage::V1::RadiationFieldMetadata> metadata = make_test_metadata();
+		EXPECT_NO_THROW(FieldStore::store(field, metadata, "test_sources.rf3", StoreVersion::V2));
+
+		std::ifstream stream("test_sources.rf3", std::ios::binary);
+		std::vector<char> data((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+		stream.close();
+
+		std::shared_ptr<ThrottledByteSource> throttled = std::make_shared<ThrottledByteSource>(std::make_shared<MemoryByteSource>(data), std::chrono::microseconds(100), 512 * 1024 * 1024);
+		std::vector<std::shared_ptr<ByteSource>> sources = {
+			std::make_shared<FileByteSource>("test_sources.rf3"),
+			std::make_shared<FileByteSource>("test_sources.rf3", 8),
+			std::make_shared<MappedByteSource>("test_sources.rf3"),
+			std::make_shared<MemoryByteSource>(data),
+			std::make_shared<MemoryByteSource>(data.data(), data.size()),
+			throttled
+		};
+
+		const std::vector<size_t> voxel_indices = { 999, 3, 4, 5, 500, 0 };
+		std::shared_ptr<FieldAccessor> expected_accessor = FieldStore::construct_accessor("test_sources.rf3");
+		std::shared_ptr<PositionalFile> file = std::make_shared<PositionalFile>("test_sources.rf3");
+		std::vector<char> expected_spectra(voxel_indices.size() * 4 * sizeof(float));
+		expected_accessor->accessVoxelsDataFlat(file, "test_channel", "spectra", voxel_indices, expected_spectra.data(), expected_spectra.size());
+
+		for (auto& source : sources) {
+			EXPECT_EQ(source->size(), data.size());
+
+			std::shared_ptr<IRadiationField> loaded = FieldStore::load(source);
+			std::shared_ptr<VoxelBuffer> loaded_channel = loaded->get_generic_channel("test_channel");
+			EXPECT_EQ(memcmp(loaded_channel->get_layer<char>("doserate"), channel->get_layer<char>("doserate"), channel->get_voxel_count() * sizeof(float)), 0);
+			EXPECT_EQ(std::dynamic_pointer_cast<RadFiled3D::Storage::V1::RadiationFieldMetadata>(FieldStore::load_metadata(source))->get_header().simulation.primary_particle_count, 100);
+
+			std::shared_ptr<FieldAccessor> accessor = FieldStore::construct_accessor(source);
+			std::vector<char> spectra(expected_spectra.size());
+			EXPECT_EQ(accessor->accessVoxelsDataFlat(source, "test_channel", "spectra", voxel_indices, spectra.data(), spectra.size()), spectra.size());
+			EXPECT_EQ(spectra, expected_spectra);
+
+			std::shared_ptr<VoxelGrid> layer = std::dynamic_pointer_cast<RadFiled3D::Storage::CartesianFieldAccessor>(accessor)->accessLayer(source, "test_channel", "doserate");
+			EXPECT_EQ(layer->get_voxel<ScalarVoxel<float>>(2, 4, 0).get_data(), 42.f);
+			std::shared_ptr<VoxelGrid> region = std::dynamic_pointer_cast<RadFiled3D::Storage::CartesianFieldAccessor>(accessor)->accessSubvolume(source, "test_channel", "doserate", glm::uvec3(1, 2, 3), glm::uvec3(3, 4, 5));
+			EXPECT_EQ(region->get_voxel<ScalarVoxel<float>>(0, 0, 0).get_data(), static_cast<float>(1 + 2 * 10 + 3 * 100));
+
+			std::unique_ptr<IVoxel> voxel(accessor->accessVoxelRawFlat(source, "test_channel", "doserate", 77));
+			EXPECT_EQ(*(float*)voxel->get_raw(), 77.f);
+
+			char byte;
+			EXPECT_THROW(source->read(data.size(), &byte, 1), ByteSourceException);
+		}
+
+		// the voxel reads of a call are passed to the source as a single batch, besides reading the index of the file once per accessor.
+		// Each range of the batch is a request, so the adjacent voxels 3, 4 and 5 save two of them
+		throttled->reset_statistics();
+		std::vector<char> spectra(expected_spectra.size());
+		expected_accessor->accessVoxelsDataFlat(std::static_pointer_cast<ByteSource>(throttled), "test_channel", "spectra", voxel_indices, spectra.data(), spectra.size());
+		EXPECT_LE(throttled->get_request_count(), 1 + voxel_indices.size() - 2);
+		EXPECT_GE(throttled->get_transferred_bytes(), spectra.size());
+		EXPECT_EQ(spectra, expected_spectra);
+
+		throttled->reset_statistics();
+		expected_accessor->accessVoxelsDataFlat(std::static_pointer_cast<ByteSource>(throttled), "test_channel", "doserate", voxel_indices, spectra.data(), spectra.size());
+		EXPECT_EQ(throttled->get_request_count(), voxel_indices.size() - 2);
+
+		// each range of a batch is a request paying the latency, unless the requests are in flight at once
+		std::vector<char> range_data(4 * 8);
+		std::vector<ByteRange> ranges;
+		for (size_t i = 0; i < 4; i++)
+			ranges.push_back(ByteRange{ i * 64, 8, range_data.data() + i * 8 });
+		for (size_t max_concurrent_requests : { static_cast<size_t>(1), static_cast<size_t>(2), static_cast<size_t>(0) }) {
+			ThrottledByteSource slow(std::make_shared<MemoryByteSource>(data), std::chrono::milliseconds(5), 0, max_concurrent_requests);
+			const auto start = std::chrono::steady_clock::now();
+			slow.read_batch(ranges);
+			const auto elapsed = std::chrono::steady_clock::now() - start;
+			EXPECT_EQ(slow.get_request_count(), 4);
+			EXPECT_GE(elapsed, std::chrono::milliseconds((max_concurrent_requests == 0) ? 5 : 20 / max_concurrent_requests));
+			EXPECT_EQ(memcmp(range_data.data() + 8, data.data() + 64, 8), 0);
+		}
+
+		// mapped and in memory sources can be viewed without copies, files can't
+		EXPECT_EQ(sources[2]->view(0, 4)[0], data[0]);
+		EXPECT_EQ(sources[3]->view(8, 4), sources[3]->view(0, 4) + 8);
+		EXPECT_EQ(sources[0]->view(0, 4), nullptr);
+		EXPECT_THROW(sources[3]->view(data.size() - 2, 4), ByteSourceException);
+
+		file.reset();
+		sources.clear();
+		std::remove("test_sources.rf3");
+	}
+
+	TEST(Storage, ZipArchives) {
+		std::shared_ptr<CartesianRadiationField> field = std::make_shared<CartesianRadiationField>(glm::vec3(1.f), glm::vec3(0.1f));
+		std::shared_ptr<VoxelBuffer> channel = field->add_channel("test_channel");
+		channel->add_layer<float>("doserate", 0.f, "Gy/s");
+		for (size_t i = 0; i < channel->get_voxel_count(); i++)
+			channel->get_voxel_flat<ScalarVoxel<float>>("doserate", i) = static_cast<float>(i);
+
+		std::shared_ptr<RadFiled3D::Storage::V1::RadiationFieldMetadata> metadata = make_test_metadata();
+		EXPECT_NO_THROW(FieldStore::store(field, metadata, "test_zip.rf3", StoreVersion::V2));
+
+		std::ifstream stream("test_zip.rf3", std::ios::binary);
+		std::vector<char> data((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+		stream.close();
+
+		// write a zip archive of stored members, whose data is padded by the extra field of the local header to 64 bytes like aligning zip tools do
+		struct Member {
+			std::string name;
+			uint16_t compression_method;
+			std::vector<char> data;
+		};
+		const std::vector<Member> members = {
+			{ "readme.txt", 0, std::vector<char>({ 'a', 'b', 'c' }) },
+			{ "fields/a.rf3", 0, data },
+			{ "fields/b.rf3", 0, data },
+			{ "fields/deflated.rf3", 8, std::vector<char>(16, '\x7f') }
+		};
+		std::vector<char> archive;
+		std::vector<char> directory;
+		auto put = [](std::vector<char>& buffer, uint64_t value, size_t bytes) {
+			for (size_t i = 0; i < bytes; i++)
+				buffer.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+		};
+		for (auto& member : members) {
+			const size_t header_offset = archive.size();
+			const size_t padding = (64 - (header_offset + 30 + member.name.size()) % 64) % 64;
+			put(archive, 0x04034b50, 4);
+			put(archive, 20, 2);
+			put(archive, 0, 2);
+			put(archive, member.compression_method, 2);
+			put(archive, 0, 4);
+			put(archive, 0, 4);
+			put(archive, member.data.size(), 4);
+			put(archive, member.data.size(), 4);
+			put(archive, member.name.size(), 2);
+			put(archive, padding, 2);
+			archive.insert(archive.end(), member.name.begin(), member.name.end());
+			archive.insert(archive.end(), padding, '\0');
+			archive.insert(archive.end(), member.data.begin(), member.data.end());
+
+			put(directory, 0x02014b50, 4);
+			put(directory, 20, 2);
+			put(directory, 20, 2);
+			put(directory, 0, 2);
+			put(directory, member.compression_method, 2);
+			put(directory, 0, 4);
+			put(directory, 0, 4);
+			put(directory, member.data.size(), 4);
+			put(directory, member.data.size(), 4);
+			put(directory, member.name.size(), 2);
+			put(directory, 0, 2);
+			put(directory, 0, 2);
+			put(directory, 0, 2);
+			put(directory, 0, 2);
+			put(directory, 0, 4);
+			put(directory, header_offset, 4);
+			directory.insert(directory.end(), member.name.begin(), member.name.end());
+		}
+		const size_t directory_offset = archive.size();
+		archive.insert(archive.end(), directory.begin(), directory.end());
+		put(archive, 0x06054b50, 4);
+		put(archive, 0, 2);
+		put(archive, 0, 2);
+		put(archive, members.size(), 2);
+		put(archive, members.size(), 2);
+		put(archive, directory.size(), 4);
+		put(archive, directory_offset, 4);
+		put(archive, 0, 2);
+		std::ofstream out("test_archive.zip", std::ios::binary);
+		out.write(archive.data(), archive.size());
+		out.close();
+
+		std::shared_ptr<IRadiationField> mapped_field;
+		{
+			ZipArchive zip("test_archive.zip");
+			EXPECT_EQ(zip.get_member_count(), 4);
+			EXPECT_EQ(zip.get_member_names(), std::vector<std::string>({ "readme.txt", "fields/a.rf3", "fields/b.rf3", "fields/deflated.rf3" }));
+			EXPECT_TRUE(zip.contains("fields/b.rf3"));
+			EXPECT_FALSE(zip.contains("fields/c.rf3"));
+			EXPECT_TRUE(zip.get_member("fields/a.rf3").is_stored());
+			EXPECT_EQ(zip.get_member("fields/a.rf3").uncompressed_size, data.size());
+			EXPECT_THROW(zip.open("fields/c.rf3"), ZipArchiveException);
+			// compressed members can't be viewed and corrupted ones are rejected with or without zlib
+			EXPECT_FALSE(zip.get_member("fields/deflated.rf3").is_stored());
+			EXPECT_THROW(zip.map_member("fields/deflated.rf3"), ZipArchiveException);
+			EXPECT_THROW(zip.open("fields/deflated.rf3"), ZipArchiveException);
+
+			std::shared_ptr<ByteSource> text = zip.open("readme.txt");
+			EXPECT_EQ(text->size(), 3);
+			EXPECT_EQ(text->view(0, 3)[2], 'c');
+			EXPECT_THROW(text->view(1, 3), ByteSourceException);
+
+			// members are views onto the mapping of the archive instead of copies
+			std::shared_ptr<ByteSource> source = zip.open("fields/b.rf3");
+			EXPECT_EQ(source->size(), data.size());
+			EXPECT_EQ(source->view(0, 4), zip.open("fields/b.rf3")->view(0, 4));
+			EXPECT_EQ(zip.map_member("fields/b.rf3")->data(), source->view(0, 4));
+			EXPECT_EQ(memcmp(source->view(0, data.size()), data.data(), data.size()), 0);
+
+			std::shared_ptr<FieldAccessor> accessor = FieldStore::construct_accessor(source);
+			std::shared_ptr<IRadiationField> loaded = accessor->accessField(source);
+			const char* doserate = loaded->get_generic_channel("test_channel")->get_layer<char>("doserate");
+			EXPECT_EQ(memcmp(doserate, channel->get_layer<char>("doserate"), channel->get_voxel_count() * sizeof(float)), 0);
+			EXPECT_TRUE(doserate >= source->view(0, 1) && doserate < source->view(0, 1) + source->size());
+			EXPECT_EQ(std::dynamic_pointer_cast<RadFiled3D::Storage::V1::RadiationFieldMetadata>(FieldStore::load_metadata(source))->get_header().simulation.primary_particle_count, 100);
+
+			std::shared_ptr<VoxelGrid> layer = std::dynamic_pointer_cast<RadFiled3D::Storage::CartesianFieldAccessor>(accessor)->accessLayer(source, "test_channel", "doserate");
+			EXPECT_EQ(layer->get_voxel<ScalarVoxel<float>>(2, 4, 0).get_data(), 42.f);
+			std::unique_ptr<IVoxel> voxel(accessor->accessVoxelRawFlat(zip.open("fields/a.rf3"), "test_channel", "doserate", 77));
+			EXPECT_EQ(*(float*)voxel->get_raw(), 77.f);
+
+			mapped_field = accessor->accessField(zip.open("fields/a.rf3"));
+		}
+		// the views keep the archive mapped after it was closed
+		EXPECT_EQ(mapped_field->get_generic_channel("test_channel")->get_voxel_flat<ScalarVoxel<float>>("doserate", 999).get_data(), 999.f);
+
+		EXPECT_THROW(ZipArchive("test_zip.rf3"), ZipArchiveException);
+		std::remove("test_archive.zip");
+		std::remove("test_zip.rf3");
+	}
+
 	TEST(Storage, VoxelAccessing) {
 		std::shared_ptr<CartesianRadiationField> field = std::make_shared<CartesianRadiationField>(glm::vec3(2.5f), glm::vec3(0.05f));
 		std::shared_ptr<VoxelGridBuffer> channel = std::static_pointer_cast<VoxelGridBuffer>(field->add_channel("test_channel"));
@@ -254,6 +1078,215 @@ namespace {
 		}
 	}
 
+	TEST(Storage, StreamedJoin) {
+		auto make_field = [](float offset, bool is_target) {
+			std::shared_ptr<CartesianRadiationField> field = std::make_shared<CartesianRadiationField>(glm::vec3(1.f), glm::vec3(0.1f));
+			std::shared_ptr<VoxelBuffer> channel = field->add_channel("shared");
+			channel->add_layer<float>("doserate", offset, "Gy/s");
+			channel->add_custom_layer<HistogramVoxel>("spectra", HistogramVoxel(8, 10.f, nullptr), .1f, "");
+			for (size_t i = 0; i < channel->get_voxel_count(); i++) {
+				channel->get_voxel_flat<ScalarVoxel<float>>("doserate", i) = static_cast<float>(i) * 0.5f + offset;
+				channel->get_voxel_flat<HistogramVoxel>("spectra", i).get_histogram()[i % 8] = offset;
+			}
+			if (is_target) {
+				channel->add_layer<glm::vec3>("dirs", glm::vec3(offset), "");
+				field->add_channel("target_only")->add_layer<int>("counts", 7, "");
+				field->add_channel("empty");
+			}
+			else {
+				channel->add_layer<double>("new_layer", 2.0, "");
+				field->add_channel("source_only")->add_layer<float>("doserate", offset, "Gy/s");
+			}
+			return field;
+		};
+		auto read_file = [](const std::string& file) {
+			std::ifstream stream(file, std::ios::binary);
+			return std::string((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+		};
+
+		const std::string file = "test_streamed_join.rf3";
+		for (StoreVersion version : { StoreVersion::V1, StoreVersion::V2 }) {
+			if (version == StoreVersion::V2) {
+				FieldStore::set_layer_codec(LayerCodec::ShuffleRLE);
+				FieldStore::set_layer_brick_size(4);
+			}
+			FieldStore::store(make_field(3.f, true), make_test_metadata(), file, version);
+
+			// a failing join leaves the file untouched
+			const std::string original_bytes = read_file(file);
+			EXPECT_THROW(FieldStore::join(make_field(1.f, false), make_test_metadata(), file, FieldJoinMode::Add, FieldJoinCheckMode::FieldStructureOnly), RadiationFieldStoreException);
+			EXPECT_EQ(read_file(file), original_bytes);
+			EXPECT_FALSE(std::ifstream(file + ".join.tmp").good());
+
+			// the expected result is the field joined in memory
+			std::shared_ptr<IRadiationField> expected_field = FieldStore::load(file);
+			std::shared_ptr<IRadiationField> source = make_field(1.f, false);
+			for (FieldJoinMode mode : { FieldJoinMode::Add, FieldJoinMode::AddWeighted }) {
+				const float ratio = (mode == FieldJoinMode::Add) ? 0.5f : 1.f / 3.f;
+				if (version == StoreVersion::V1)
+					RadFiled3D::Storage::V1::FieldStore().join(expected_field, source, mode, FieldJoinCheckMode::NoChecks, ratio);
+				else
+					RadFiled3D::Storage::V2::FieldStore(LayerCodec::ShuffleRLE, 4).join(expected_field, source, mode, FieldJoinCheckMode::NoChecks, ratio);
+
+				EXPECT_NO_THROW(FieldStore::join(source, make_test_metadata(), file, mode, FieldJoinCheckMode::NoChecks));
+				EXPECT_FALSE(std::ifstream(file + ".join.tmp").good());
+				EXPECT_EQ(FieldStore::get_store_version(file), version);
+
+				std::ostringstream expected_bytes;
+				if (version == StoreVersion::V1)
+					RadFiled3D::Storage::V1::FieldStore().serialize(expected_bytes, expected_field, FieldStore::load_metadata(file));
+				else
+					RadFiled3D::Storage::V2::FieldStore(LayerCodec::ShuffleRLE, 4).serialize(expected_bytes, expected_field, FieldStore::load_metadata(file));
+				EXPECT_TRUE(read_file(file) == expected_bytes.str()) << "version: " << static_cast<int>(version) << ", mode: " << static_cast<int>(mode);
+			}
+
+			auto metadata = std::dynamic_pointer_cast<RadFiled3D::Storage::V1::RadiationFieldMetadata>(FieldStore::load_metadata(file));
+			EXPECT_EQ(metadata->get_header().simulation.primary_particle_count, 300);
+
+			std::shared_ptr<CartesianRadiationField> joined = std::static_pointer_cast<CartesianRadiationField>(FieldStore::load(file));
+			EXPECT_TRUE(joined->has_channel("empty"));
+			EXPECT_EQ(joined->get_channel("target_only")->get_voxel_flat<ScalarVoxel<int>>("counts", 5).get_data(), 7);
+			EXPECT_TRUE(joined->get_channel("shared")->has_layer("new_layer"));
+			EXPECT_TRUE(joined->get_channel("shared")->has_layer("dirs"));
+			EXPECT_TRUE(joined->has_channel("source_only"));
+
+			std::remove(file.c_str());
+		}
+		FieldStore::set_layer_codec(LayerCodec::Raw);
+		FieldStore::set_layer_brick_size(0);
+	}
+
+	TEST(Storage, InPlaceJoin) {
+		auto make_field = [](float offset, const std::string& unit, bool extra_layer) {
+			std::shared_ptr<CartesianRadiationField> field = std::make_shared<CartesianRadiationField>(glm::vec3(1.f), glm::vec3(0.1f));
+			std::shared_ptr<VoxelBuffer> channel = field->add_channel("shared");
+			channel->add_layer<float>("doserate", offset, unit);
+			channel->add_layer<glm::vec3>("dirs", glm::vec3(offset), "");
+			channel->add_layer<int>("counts", 7, "");
+			channel->add_custom_layer<HistogramVoxel>("spectra", HistogramVoxel(8, 10.f, nullptr), .1f, "");
+			for (size_t i = 0; i < channel->get_voxel_count(); i++) {
+				channel->get_voxel_flat<ScalarVoxel<float>>("doserate", i) = static_cast<float>(i) * 0.5f + offset;
+				channel->get_voxel_flat<HistogramVoxel>("spectra", i).get_histogram()[i % 8] = offset;
+			}
+			if (extra_layer)
+				channel->add_layer<double>("new_layer", 2.0, "");
+			return field;
+		};
+		auto read_file = [](const std::string& file) {
+			std::ifstream stream(file, std::ios::binary);
+			return std::string((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+		};
+
+		// joining in place results in the same file as rewriting it
+		const std::string file = "test_in_place_join.rf3";
+		const std::string rewritten_file = "test_in_place_join_rewritten.rf3";
+		for (StoreVersion version : { StoreVersion::V1, StoreVersion::V2 }) {
+			for (FieldJoinMode mode : { FieldJoinMode::Add, FieldJoinMode::AddWeighted, FieldJoinMode::Mean }) {
+				FieldStore::store(make_field(3.f, "Gy/s", false), make_test_metadata(100), file, version);
+				FieldStore::store(make_field(3.f, "Gy/s", false), make_test_metadata(100), rewritten_file, version);
+				const size_t file_size = read_file(file).size();
+
+				EXPECT_NO_THROW(FieldStore::join(make_field(1.f, "Gy/s", false), make_test_metadata(50), rewritten_file, mode, FieldJoinCheckMode::MetadataSimulationSimilar));
+				FieldStore::enable_in_place_join(true);
+				EXPECT_NO_THROW(FieldStore::join(make_field(1.f, "Gy/s", false), make_test_metadata(50), file, mode, FieldJoinCheckMode::MetadataSimulationSimilar));
+				FieldStore::enable_in_place_join(false);
+
+				EXPECT_EQ(read_file(file).size(), file_size);
+				EXPECT_TRUE(read_file(file) == read_file(rewritten_file)) << "version: " << static_cast<int>(version) << ", mode: " << static_cast<int>(mode);
+			}
+
+			auto metadata = std::dynamic_pointer_cast<RadFiled3D::Storage::V1::RadiationFieldMetadata>(FieldStore::load_metadata(file));
+			EXPECT_EQ(metadata->get_header().simulation.primary_particle_count, 150);
+			std::shared_ptr<CartesianRadiationField> joined = std::static_pointer_cast<CartesianRadiationField>(FieldStore::load(file));
+			EXPECT_FLOAT_EQ(joined->get_channel("shared")->get_voxel_flat<ScalarVoxel<float>>("doserate", 4).get_data(), 4.f);
+		}
+
+		// only structurally identical fields are joined in place, otherwise the file is left untouched
+		RadFiled3D::Storage::V1::FieldStore store;
+		FieldStore::store(make_field(3.f, "Gy/s", false), make_test_metadata(100), file, StoreVersion::V1);
+		const std::string original_bytes = read_file(file);
+		EXPECT_FALSE(store.join_in_place(file, make_field(1.f, "Gy/s", true), make_test_metadata(200), FieldJoinMode::Add, FieldJoinCheckMode::NoChecks));
+		EXPECT_FALSE(store.join_in_place(file, make_field(1.f, "mGy/s", false), make_test_metadata(200), FieldJoinMode::Add, FieldJoinCheckMode::FieldUnitsOnly));
+		EXPECT_EQ(read_file(file), original_bytes);
+		EXPECT_TRUE(store.join_in_place(file, make_field(1.f, "mGy/s", false), make_test_metadata(200), FieldJoinMode::Add, FieldJoinCheckMode::NoChecks));
+		EXPECT_EQ(std::dynamic_pointer_cast<RadFiled3D::Storage::V1::RadiationFieldMetadata>(FieldStore::load_metadata(file))->get_header().simulation.primary_particle_count, 200);
+
+		// encoded layers need to be rewritten
+		FieldStore::set_layer_codec(LayerCodec::ShuffleRLE);
+		FieldStore::store(make_field(3.f, "Gy/s", false), make_test_metadata(100), file, StoreVersion::V2);
+		EXPECT_FALSE(RadFiled3D::Storage::V2::FieldStore(LayerCodec::ShuffleRLE).join_in_place(file, make_field(1.f, "Gy/s", false), make_test_metadata(200), FieldJoinMode::Add, FieldJoinCheckMode::NoChecks));
+		EXPECT_NO_THROW(FieldStore::join(make_field(1.f, "Gy/s", false), make_test_metadata(50), file, FieldJoinMode::Add, FieldJoinCheckMode::MetadataSimulationSimilar));
+		EXPECT_FLOAT_EQ(std::static_pointer_cast<CartesianRadiationField>(FieldStore::load(file))->get_channel("shared")->get_voxel_flat<ScalarVoxel<float>>("doserate", 4).get_data(), 8.f);
+		FieldStore::set_layer_codec(LayerCodec::Raw);
+
+		std::remove(file.c_str());
+		std::remove(rewritten_file.c_str());
+	}
+
+	TEST(Storage, MergeFiles) {
+		auto make_field = [](float offset) {
+			std::shared_ptr<CartesianRadiationField> field = std::make_shared<CartesianRadiationField>(glm::vec3(1.f), glm::vec3(0.1f));
+			std::shared_ptr<VoxelBuffer> channel = field->add_channel("shared");
+			channel->add_layer<float>("doserate", offset, "Gy/s");
+			channel->add_custom_layer<HistogramVoxel>("spectra", HistogramVoxel(8, 10.f, nullptr), .1f, "");
+			for (size_t i = 0; i < channel->get_voxel_count(); i++) {
+				channel->get_voxel_flat<ScalarVoxel<float>>("doserate", i) = static_cast<float>(i) * 0.5f + offset;
+				channel->get_voxel_flat<HistogramVoxel>("spectra", i).get_histogram()[i % 8] = offset;
+			}
+			return field;
+		};
+		auto read_file = [](const std::string& file) {
+			std::ifstream stream(file, std::ios::binary);
+			return std::string((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+		};
+
+		std::vector<std::string> files;
+		for (size_t i = 0; i < 7; i++) {
+			files.push_back("test_merge_part" + std::to_string(i) + ".rf3");
+			FieldStore::store(make_field(static_cast<float>(i)), make_test_metadata((i + 1) * 10), files.back(), StoreVersion::V1);
+		}
+
+		for (FieldJoinMode mode : { FieldJoinMode::Add, FieldJoinMode::AddWeighted }) {
+			// the expected result is each file joined one after another into the first one
+			const std::string expected_file = "test_merge_expected.rf3";
+			FieldStore::store(make_field(0.f), make_test_metadata(10), expected_file, StoreVersion::V1);
+			for (size_t i = 1; i < files.size(); i++)
+				FieldStore::join(make_field(static_cast<float>(i)), make_test_metadata((i + 1) * 10), expected_file, mode);
+
+			EXPECT_NO_THROW(FieldStore::merge(files, "test_merge_serial.rf3", mode, FieldJoinCheckMode::MetadataSimulationSimilar, 1));
+			EXPECT_NO_THROW(FieldStore::merge(files, "test_merge_parallel.rf3", mode, FieldJoinCheckMode::MetadataSimulationSimilar, 3));
+			EXPECT_NO_THROW(FieldStore::merge(files, "test_merge_budget.rf3", mode, FieldJoinCheckMode::MetadataSimulationSimilar, 4, 1));
+
+			// the tree does not depend on the number of threads
+			EXPECT_TRUE(read_file("test_merge_serial.rf3") == read_file("test_merge_parallel.rf3"));
+			EXPECT_TRUE(read_file("test_merge_serial.rf3") == read_file("test_merge_budget.rf3"));
+
+			auto metadata = std::dynamic_pointer_cast<RadFiled3D::Storage::V1::RadiationFieldMetadata>(FieldStore::load_metadata("test_merge_parallel.rf3"));
+			EXPECT_EQ(metadata->get_header().simulation.primary_particle_count, 280);
+
+			auto expected = std::static_pointer_cast<CartesianRadiationField>(FieldStore::load(expected_file))->get_channel("shared");
+			auto merged = std::static_pointer_cast<CartesianRadiationField>(FieldStore::load("test_merge_parallel.rf3"))->get_channel("shared");
+			for (size_t i = 0; i < merged->get_voxel_count(); i += 97) {
+				const float expected_dose = expected->get_voxel_flat<ScalarVoxel<float>>("doserate", i).get_data();
+				EXPECT_NEAR(merged->get_voxel_flat<ScalarVoxel<float>>("doserate", i).get_data(), expected_dose, std::abs(expected_dose) * 1e-5f);
+				const float expected_bin = expected->get_voxel_flat<HistogramVoxel>("spectra", i).get_histogram()[i % 8];
+				EXPECT_NEAR(merged->get_voxel_flat<HistogramVoxel>("spectra", i).get_histogram()[i % 8], expected_bin, std::abs(expected_bin) * 1e-5f);
+			}
+
+			std::remove(expected_file.c_str());
+			std::remove("test_merge_serial.rf3");
+			std::remove("test_merge_parallel.rf3");
+			std::remove("test_merge_budget.rf3");
+		}
+
+		// modes, whose result depends on the order of joining, can't be merged in a tree
+		EXPECT_THROW(FieldStore::merge(files, "test_merge_mean.rf3", FieldJoinMode::Mean), RadiationFieldStoreException);
+		EXPECT_THROW(FieldStore::merge({}, "test_merge_empty.rf3", FieldJoinMode::Add), RadiationFieldStoreException);
+
+		for (auto& file : files)
+			std::remove(file.c_str());
+	}
+
 	TEST(Storage, AccessingFromStringStream) {
 		std::shared_ptr<CartesianRadiationField> field = std::make_shared<CartesianRadiationField>(glm::vec3(2.5f), glm::vec3(0.05f));
 		std::shared_ptr<VoxelGridBuffer> channel = std::static_pointer_cast<VoxelGridBuffer>(field->add_channel("test_channel"));
@@ -463,6 +1496,68 @@ namespace {
 		}
 	}
 
+	TEST(Serialization, UnstagedChannels) {
+		// records all writes to a buffer, which can't seek, so channels can't be completed after their layers were written
+		class WriteRecorder : public std::streambuf {
+		public:
+			std::string data;
+			size_t largest_write = 0;
+		protected:
+			std::streamsize xsputn(const char* s, std::streamsize n) override {
+				this->data.append(s, static_cast<size_t>(n));
+				this->largest_write = std::max(this->largest_write, static_cast<size_t>(n));
+				return n;
+			}
+			int_type overflow(int_type c) override {
+				if (!traits_type::eq_int_type(c, traits_type::eof()))
+					this->data.push_back(traits_type::to_char_type(c));
+				return traits_type::not_eof(c);
+			}
+		};
+
+		std::shared_ptr<CartesianRadiationField> field = std::make_shared<CartesianRadiationField>(glm::vec3(1.f), glm::vec3(0.05f));
+		std::shared_ptr<VoxelBuffer> channel = field->add_channel("test_channel");
+		channel->add_layer<float>("doserate", 25.3f, "Gy/s");
+		channel->add_custom_layer<HistogramVoxel>("spectra", HistogramVoxel(26, 10.f, nullptr), .123f, "");
+		for (size_t i = 0; i < channel->get_voxel_count(); i += 7)
+			channel->get_voxel_flat<HistogramVoxel>("spectra", i).get_histogram()[i % 26] = static_cast<float>(i);
+		field->add_channel("empty");
+		field->add_channel("second")->add_layer<glm::vec3>("dirs", glm::vec3(1.f, 0.f, 0.f), "normalized direction");
+
+		// the voxel data is written straight from the layers instead of a copy of the whole channel
+		RadFiled3D::Storage::V1::BinayFieldBlockHandler v1_handler;
+		WriteRecorder recorder;
+		std::ostream unseekable(&recorder);
+		v1_handler.serializeField(field, unseekable);
+		EXPECT_EQ(recorder.largest_write, channel->get_voxel_count() * 26 * sizeof(float));
+
+		std::istringstream input(recorder.data);
+		auto loaded = std::static_pointer_cast<CartesianRadiationField>(v1_handler.deserializeField(input));
+		EXPECT_EQ(loaded->get_channels().size(), 3);
+		for (size_t i = 0; i < channel->get_voxel_count(); i += 7) {
+			EXPECT_EQ(loaded->get_channel("test_channel")->get_voxel_flat<HistogramVoxel>("spectra", i).get_histogram()[i % 26], static_cast<float>(i));
+			EXPECT_EQ(loaded->get_channel("test_channel")->get_voxel_flat<ScalarVoxel<float>>("doserate", i).get_data(), 25.3f);
+		}
+
+		// writing the channels at once yields the same bytes as writing them layer by layer
+		RadFiled3D::Storage::V2::BinayFieldBlockHandler v2_handler(LayerCodec::ShuffleRLE);
+		for (const RadFiled3D::Storage::V1::BinayFieldBlockHandler* handler : std::vector<const RadFiled3D::Storage::V1::BinayFieldBlockHandler*>{ &v1_handler, &v2_handler }) {
+			std::ostringstream whole;
+			handler->serializeField(field, whole);
+
+			std::ostringstream streamed;
+			std::unique_ptr<FieldBlockStreamWriter> writer = handler->serializeFieldStreamed(field, streamed);
+			for (auto& named_channel : field->get_channels()) {
+				writer->beginChannel(named_channel.first);
+				for (auto& layer_name : named_channel.second->get_layers())
+					writer->writeLayer(named_channel.second, layer_name);
+			}
+			writer->finish();
+
+			EXPECT_TRUE(whole.str() == streamed.str());
+		}
+	}
+
 	TEST(Datasets, MultiVoxelAccessing) {
 		std::shared_ptr<CartesianRadiationField> field = std::make_shared<CartesianRadiationField>(glm::vec3(2.5f), glm::vec3(0.05f));
 		std::shared_ptr<VoxelGridBuffer> channel = std::static_pointer_cast<VoxelGridBuffer>(field->add_channel("test_channel"));
@@ -513,36 +1608,42 @@ namespace {
 		EXPECT_EQ(collection->channels.size(), 1);
 		EXPECT_EQ(collection->channels["test_channel"].layers.size(), 2);
 
-		EXPECT_EQ(collection->channels["test_channel"].layers["doserate"].voxels.size(), 7);
-		EXPECT_EQ(collection->channels["test_channel"].layers["spectra"].voxels.size(), 7);
+		auto& doserate_layer = collection->channels["test_channel"].layers["doserate"];
+		auto& spectra_layer = collection->channels["test_channel"].layers["spectra"];
+		EXPECT_EQ(doserate_layer.voxel_count, 7);
+		EXPECT_EQ(spectra_layer.voxel_count, 7);
+		EXPECT_EQ(doserate_layer.dtype, Typing::DType::Float);
+		EXPECT_EQ(doserate_layer.voxel_bytes, sizeof(float));
+		EXPECT_EQ(spectra_layer.dtype, Typing::DType::Hist);
+		EXPECT_EQ(spectra_layer.histogram_bins, 26);
+		EXPECT_FLOAT_EQ(spectra_layer.histogram_bin_width, 10.f);
+		EXPECT_EQ(spectra_layer.voxel_bytes, 26 * sizeof(float));
+		EXPECT_EQ(reinterpret_cast<uintptr_t>(doserate_layer.data.get()) % Dataset::VoxelCollection::DATA_ALIGNMENT, 0);
+		EXPECT_EQ(reinterpret_cast<uintptr_t>(spectra_layer.data.get()) % Dataset::VoxelCollection::DATA_ALIGNMENT, 0);
 
 		// check voxels of file01
 		for (size_t i = 0; i < 3; i++) {
-			EXPECT_EQ(collection->channels["test_channel"].layers["doserate"].voxels[i]->get_bytes(), sizeof(float));
-			auto vx = std::dynamic_pointer_cast<ScalarVoxel<float>>(collection->channels["test_channel"].layers["doserate"].voxels[i]);
-			EXPECT_EQ(vx->get_data(), 0.f); // file 01 voxels 1, 2, 3 should be zero
+			EXPECT_EQ(doserate_layer.get_data<float>()[i], 0.f); // file 01 voxels 1, 2, 3 should be zero
 
-			auto hist_vx = std::dynamic_pointer_cast<HistogramVoxel>(collection->channels["test_channel"].layers["spectra"].voxels[i]);
-			EXPECT_EQ(hist_vx->get_bins(), 26);
+			const float* histogram = spectra_layer.get_data<float>() + i * spectra_layer.histogram_bins;
 			for (size_t i = 0; i < 26; i++)
-				EXPECT_FLOAT_EQ(hist_vx->get_histogram()[i], .123f);
+				EXPECT_FLOAT_EQ(histogram[i], .123f);
 		}
 		
 		// check voxels of file02
 		for (size_t i = 3; i < 7; i++) {
-			EXPECT_EQ(collection->channels["test_channel"].layers["doserate"].voxels[i]->get_bytes(), sizeof(float));
-			auto vx = std::dynamic_pointer_cast<ScalarVoxel<float>>(collection->channels["test_channel"].layers["doserate"].voxels[i]);
+			const float doserate = doserate_layer.get_data<float>()[i];
 			if (i == 3) {
-				EXPECT_FLOAT_EQ(vx->get_data(), 1.f);
+				EXPECT_FLOAT_EQ(doserate, 1.f);
 			}
 			else if (i == 4) {
-				EXPECT_FLOAT_EQ(vx->get_data(), 2.f);
+				EXPECT_FLOAT_EQ(doserate, 2.f);
 			}
 			else if (i == 5) {
-				EXPECT_FLOAT_EQ(vx->get_data(), 3.f);
+				EXPECT_FLOAT_EQ(doserate, 3.f);
 			}
 			else if (i == 6) {
-				EXPECT_FLOAT_EQ(vx->get_data(), 25.f);
+				EXPECT_FLOAT_EQ(doserate, 25.f);
 			}
 		}
 
@@ -553,4 +1654,186 @@ namespace {
 			EXPECT_FLOAT_EQ(spectra_buffer[i], .123f);
 		}
 	}
+
+	TEST(Datasets, ParallelMultiVoxelAccessing) {
+		std::shared_ptr<CartesianRadiationField> field = std::make_shared<CartesianRadiationField>(glm::vec3(1.f), glm::vec3(0.1f));
+		std::shared_ptr<VoxelGridBuffer> channel = std::static_pointer_cast<VoxelGridBuffer>(field->add_channel("test_channel"));
+		channel->add_layer<float>("doserate", 0.f, "Gy/s");
+		channel->add_custom_layer<HistogramVoxel>("spectra", HistogramVoxel(3, 10.f, nullptr), 0.f, "");
+
+		std::shared_ptr<RadFiled3D::Storage::V1::RadiationFieldMetadata> metadata = make_test_metadata();
+
+		// every file holds its own index in all voxels
+		const size_t file_count = 12;
+		for (size_t f = 0; f < file_count; f++) {
+			for (size_t i = 0; i < channel->get_voxel_count(); i++) {
+				channel->get_voxel_flat<ScalarVoxel<float>>("doserate", i) = static_cast<float>(f * 1000 + i);
+				channel->get_voxel_flat<HistogramVoxel>("spectra", i).get_histogram()[i % 3] = static_cast<float>(f);
+			}
+			EXPECT_NO_THROW(FieldStore::store(field, metadata, "test_parallel_" + std::to_string(f) + ".rf3", StoreVersion::V1));
+		}
+
+		std::vector<Dataset::VoxelCollectionRequest> reqs;
+		for (size_t f = 0; f < file_count; f++)
+			reqs.push_back(Dataset::VoxelCollectionRequest("test_parallel_" + std::to_string(f) + ".rf3", { f, 999, f + 1, 0 }));
+
+		std::shared_ptr<FieldAccessor> accessor = FieldStore::construct_accessor("test_parallel_0.rf3");
+		Dataset::VoxelCollectionAccessor vx_accessor(accessor, { "test_channel" }, { "doserate", "spectra" });
+		EXPECT_EQ(vx_accessor.get_worker_count(), 1);
+		std::shared_ptr<Dataset::VoxelCollection> serial = vx_accessor.access(reqs);
+
+		for (size_t workers : { static_cast<size_t>(4), static_cast<size_t>(32), static_cast<size_t>(0) }) {
+			vx_accessor.set_worker_count(workers);
+			EXPECT_GE(vx_accessor.get_worker_count(), 1);
+			std::shared_ptr<Dataset::VoxelCollection> parallel = vx_accessor.access(reqs);
+			for (const std::string layer : { "doserate", "spectra" }) {
+				auto& serial_layer = serial->channels["test_channel"].layers[layer];
+				auto& parallel_layer = parallel->channels["test_channel"].layers[layer];
+				ASSERT_EQ(serial_layer.get_bytes(), parallel_layer.get_bytes());
+				EXPECT_EQ(memcmp(serial_layer.data.get(), parallel_layer.data.get(), serial_layer.get_bytes()), 0);
+			}
+
+			const float* doserates = parallel->channels["test_channel"].layers["doserate"].get_data<float>();
+			for (size_t f = 0; f < file_count; f++) {
+				EXPECT_EQ(doserates[f * 4 + 0], static_cast<float>(f * 1000 + f));
+				EXPECT_EQ(doserates[f * 4 + 1], static_cast<float>(f * 1000 + 999));
+				EXPECT_EQ(doserates[f * 4 + 3], static_cast<float>(f * 1000));
+			}
+		}
+
+		// errors of any worker are passed to the caller
+		vx_accessor.set_worker_count(4);
+		reqs.push_back(Dataset::VoxelCollectionRequest("test_parallel_missing.rf3", { 0 }));
+		EXPECT_THROW(vx_accessor.access(reqs), PositionalFileException);
+	}
+
+	TEST(Datasets, BatchedMultiVoxelAccessing) {
+		std::shared_ptr<CartesianRadiationField> field = std::make_shared<CartesianRadiationField>(glm::vec3(1.f), glm::vec3(0.1f));
+		std::shared_ptr<VoxelGridBuffer> channel = std::static_pointer_cast<VoxelGridBuffer>(field->add_channel("test_channel"));
+		channel->add_layer<float>("doserate", 0.f, "Gy/s");
+		channel->add_custom_layer<HistogramVoxel>("spectra", HistogramVoxel(3, 10.f, nullptr), 0.f, "");
+
+		std::shared_ptr<RadFiled3D::Storage::V1::RadiationFieldMetadata> metadata = make_test_metadata();
+
+		const size_t file_count = 8;
+		for (size_t f = 0; f < file_count; f++) {
+			for (size_t i = 0; i < channel->get_voxel_count(); i++) {
+				channel->get_voxel_flat<ScalarVoxel<float>>("doserate", i) = static_cast<float>(f * 1000 + i);
+				channel->get_voxel_flat<HistogramVoxel>("spectra", i).get_histogram()[i % 3] = static_cast<float>(f);
+			}
+			EXPECT_NO_THROW(FieldStore::store(field, metadata, "test_batched_" + std::to_string(f) + ".rf3", StoreVersion::V1));
+			FieldStore::set_layer_codec(LayerCodec::ShuffleRLE);
+			EXPECT_NO_THROW(FieldStore::store(field, metadata, "test_batched_v2_" + std::to_string(f) + ".rf3", StoreVersion::V2));
+			FieldStore::set_layer_codec(LayerCodec::Raw);
+		}
+
+		// adjacent voxels are read at once, all others are single reads
+		std::vector<Dataset::VoxelCollectionRequest> reqs;
+		for (size_t f = 0; f < file_count; f++)
+			reqs.push_back(Dataset::VoxelCollectionRequest("test_batched_" + std::to_string(f) + ".rf3", { f, f + 1, f + 2, 999, 0, 500 }));
+
+		std::shared_ptr<FieldAccessor> accessor = FieldStore::construct_accessor("test_batched_0.rf3");
+		Dataset::VoxelCollectionAccessor vx_accessor(accessor, { "test_channel" }, { "doserate", "spectra" });
+		EXPECT_EQ(vx_accessor.get_io_queue_depth(), 0);
+		std::shared_ptr<Dataset::VoxelCollection> unbatched = vx_accessor.access(reqs);
+
+		for (size_t queue_depth : { static_cast<size_t>(1), static_cast<size_t>(4), static_cast<size_t>(64) }) {
+			vx_accessor.set_io_queue_depth(queue_depth);
+			std::shared_ptr<Dataset::VoxelCollection> batched = vx_accessor.access(reqs);
+			for (const std::string layer : { "doserate", "spectra" }) {
+				auto& unbatched_layer = unbatched->channels["test_channel"].layers[layer];
+				auto& batched_layer = batched->channels["test_channel"].layers[layer];
+				ASSERT_EQ(unbatched_layer.get_bytes(), batched_layer.get_bytes());
+				EXPECT_EQ(memcmp(unbatched_layer.data.get(), batched_layer.data.get(), unbatched_layer.get_bytes()), 0);
+			}
+
+			const float* doserates = batched->channels["test_channel"].layers["doserate"].get_data<float>();
+			for (size_t f = 0; f < file_count; f++) {
+				EXPECT_EQ(doserates[f * 6 + 0], static_cast<float>(f * 1000 + f));
+				EXPECT_EQ(doserates[f * 6 + 2], static_cast<float>(f * 1000 + f + 2));
+				EXPECT_EQ(doserates[f * 6 + 3], static_cast<float>(f * 1000 + 999));
+				EXPECT_EQ(doserates[f * 6 + 5], static_cast<float>(f * 1000 + 500));
+			}
+		}
+
+		// the layouts of version 2 files are resolved once per file, their encoded layers are decoded and all others are batched
+		std::vector<Dataset::VoxelCollectionRequest> v2_reqs;
+		for (size_t f = 0; f < file_count; f++)
+			v2_reqs.push_back(Dataset::VoxelCollectionRequest("test_batched_v2_" + std::to_string(f) + ".rf3", { f, f + 1, f + 2, 999, 0, 500 }));
+		Dataset::VoxelCollectionAccessor v2_accessor(FieldStore::construct_accessor("test_batched_v2_0.rf3"), { "test_channel" }, { "doserate", "spectra" });
+		v2_accessor.set_io_queue_depth(16);
+		std::shared_ptr<Dataset::VoxelCollection> v2_batched = v2_accessor.access(v2_reqs);
+		for (const std::string layer : { "doserate", "spectra" }) {
+			auto& unbatched_layer = unbatched->channels["test_channel"].layers[layer];
+			auto& batched_layer = v2_batched->channels["test_channel"].layers[layer];
+			ASSERT_EQ(unbatched_layer.get_bytes(), batched_layer.get_bytes());
+			EXPECT_EQ(memcmp(unbatched_layer.data.get(), batched_layer.data.get(), unbatched_layer.get_bytes()), 0);
+		}
+
+		// requests spanning more files than a batch keeps open are read in several batches, repeated files are opened once per batch
+		std::vector<Dataset::VoxelCollectionRequest> many_reqs;
+		std::vector<std::string> copies;
+		for (size_t r = 0; r < Dataset::VoxelCollectionAccessor::MAX_BATCH_FILES + 44; r++) {
+			const std::string copy = "test_batched_copy_" + std::to_string(r) + ".rf3";
+			std::filesystem::copy_file("test_batched_" + std::to_string(r % file_count) + ".rf3", copy, std::filesystem::copy_options::overwrite_existing);
+			copies.push_back(copy);
+			many_reqs.push_back(Dataset::VoxelCollectionRequest(copy, { r % 1000, 999 }));
+			many_reqs.push_back(Dataset::VoxelCollectionRequest("test_batched_" + std::to_string(r % file_count) + ".rf3", { 7 }));
+		}
+		vx_accessor.set_io_queue_depth(0);
+		std::shared_ptr<Dataset::VoxelCollection> many_unbatched = vx_accessor.access(many_reqs);
+		vx_accessor.set_io_queue_depth(16);
+		std::shared_ptr<Dataset::VoxelCollection> many_batched = vx_accessor.access(many_reqs);
+		for (const std::string layer : { "doserate", "spectra" }) {
+			auto& unbatched_layer = many_unbatched->channels["test_channel"].layers[layer];
+			auto& batched_layer = many_batched->channels["test_channel"].layers[layer];
+			ASSERT_EQ(unbatched_layer.get_bytes(), batched_layer.get_bytes());
+			EXPECT_EQ(memcmp(unbatched_layer.data.get(), batched_layer.data.get(), unbatched_layer.get_bytes()), 0);
+		}
+		EXPECT_EQ(many_batched->channels["test_channel"].layers["doserate"].get_data<float>()[3 * 3], static_cast<float>(3 * 1000 + 3));
+
+		// threads sharing the accessor read their batches with readers of their own
+		std::vector<std::shared_ptr<Dataset::VoxelCollection>> concurrent(4);
+		std::vector<std::thread> threads;
+		for (size_t t = 0; t < concurrent.size(); t++)
+			threads.emplace_back([&vx_accessor, &many_reqs, &concurrent, t]() {
+				for (size_t repeat = 0; repeat < 3; repeat++)
+					concurrent[t] = vx_accessor.access(many_reqs);
+			});
+		for (std::thread& thread : threads)
+			thread.join();
+		for (const auto& collection : concurrent) {
+			auto& expected_layer = many_batched->channels["test_channel"].layers["spectra"];
+			auto& concurrent_layer = collection->channels["test_channel"].layers["spectra"];
+			ASSERT_EQ(expected_layer.get_bytes(), concurrent_layer.get_bytes());
+			EXPECT_EQ(memcmp(expected_layer.data.get(), concurrent_layer.data.get(), expected_layer.get_bytes()), 0);
+		}
+		for (const std::string& copy : copies)
+			std::remove(copy.c_str());
+
+		// both backends of the batch reader complete all reads into their destinations
+		std::shared_ptr<PositionalFile> file = std::make_shared<PositionalFile>("test_batched_3.rf3");
+		std::vector<char> expected(file->size());
+		file->read(0, expected.data(), expected.size());
+		for (bool allow_io_uring : { true, false }) {
+			BatchReader reader(8, 4, allow_io_uring);
+			if (!allow_io_uring) {
+				EXPECT_EQ(reader.get_backend(), BatchReader::Backend::PositionalReads);
+			}
+
+			std::vector<char> data(file->size(), 0);
+			std::vector<BatchReadRequest> batch;
+			for (size_t offset = 0; offset < data.size(); offset += 13)
+				batch.push_back({ file.get(), offset, std::min<size_t>(13, data.size() - offset), data.data() + offset });
+			EXPECT_NO_THROW(reader.read(batch));
+			EXPECT_EQ(data, expected);
+
+			batch.push_back({ file.get(), file->size() - 4, 8, data.data() });
+			EXPECT_THROW(reader.read(batch), PositionalFileException);
+		}
+
+		vx_accessor.set_io_queue_depth(16);
+		reqs.push_back(Dataset::VoxelCollectionRequest("test_batched_0.rf3", { 1000 }));
+		EXPECT_THROW(vx_accessor.access(reqs), RadiationFieldStoreException);
+	}
 }
\ No newline at end of file
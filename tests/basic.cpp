@@ -1,5 +1,6 @@
 #include "RadFiled3D/VoxelGrid.hpp"
 #include "RadFiled3D/RadiationField.hpp"
+#include "RadFiled3D/LayerExpression.hpp"
 #include <iostream>
 #include "RadFiled3D/storage/RadiationFieldStore.hpp"
 #include "RadFiled3D/storage/Types.hpp"
@@ -11,6 +12,7 @@
 #include <fstream>
 #include <cstdio>
 #include <thread>
+#include <atomic>
 #include <shared_mutex>
 
 using namespace RadFiled3D;
@@ -28,6 +30,29 @@ namespace {
 		}
 	};
 
+	/** Creates the metadata of the fields stored by the tests */
+	std::shared_ptr<RadFiled3D::Storage::V1::RadiationFieldMetadata> make_test_metadata() {
+		return std::make_shared<RadFiled3D::Storage::V1::RadiationFieldMetadata>(
+			RadFiled3D::Storage::FiledTypes::V1::RadiationFieldMetadataHeader::Simulation(
+				100,
+				"geom",
+				"FTFP_BERT",
+				RadFiled3D::Storage::FiledTypes::V1::RadiationFieldMetadataHeader::Simulation::XRayTube(
+					glm::vec3(1.f, 0.f, 0.f),
+					glm::vec3(0.f, 0.f, 0.f),
+					100.f,
+					"XRayTube"
+				)
+			),
+			RadFiled3D::Storage::FiledTypes::V1::RadiationFieldMetadataHeader::Software(
+				"test",
+				"1.0",
+				"repo",
+				"commit"
+			)
+		);
+	}
+
 	TEST(FieldCreationTest, Dimensions) {
 		std::shared_ptr<CartesianRadiationField> field = std::make_shared<CartesianRadiationField>(glm::vec3(2.5f), glm::vec3(0.05f));
 		EXPECT_EQ(field->get_field_dimensions(), glm::vec3(2.5f));
@@ -109,6 +134,11 @@ namespace {
 		EXPECT_EQ(channel->get_layer_unit("hist"), "");
 
 		EXPECT_EQ(channel->get_layers().size(), 5);
+
+		// inserted layers must not replace existing ones
+		EXPECT_THROW(channel->insert_layer("doserate", VoxelLayer::Construct<float>("Sv", channel->get_voxel_count(), -1.f, 1.f, true)), VoxelBufferException);
+		EXPECT_EQ(channel->get_layer_unit("doserate"), "Gy/s");
+		EXPECT_EQ(channel->get_layers().size(), 5);
 	}
 
 	TEST(Voxels, VoxelCreation) {
@@ -777,4 +807,365 @@ namespace {
 		metadata = std::dynamic_pointer_cast<RadFiled3D::Storage::V1::RadiationFieldMetadata>(FieldStore::load_metadata("test07.rf3"));
 		EXPECT_EQ(metadata->get_header().simulation.primary_particle_count, 100);
 	}
+
+	TEST(VoxelBuffer, Arithmetic) {
+		auto make_field = [](float offset) {
+			std::shared_ptr<CartesianRadiationField> field = std::make_shared<CartesianRadiationField>(glm::vec3(1.f), glm::vec3(0.1f));
+			std::shared_ptr<VoxelGridBuffer> channel = std::static_pointer_cast<VoxelGridBuffer>(field->add_channel("test_channel"));
+			channel->add_layer<float>("doserate", 0.f, "Gy/s");
+			channel->add_layer<double>("precise", 0.0, "Gy/s");
+			channel->add_layer<int>("counts", 0, "");
+			channel->add_layer<glm::vec3>("dirs", glm::vec3(0.f), "");
+			channel->add_custom_layer<HistogramVoxel>("spectra", HistogramVoxel(5, 10.f, nullptr), 0.f, "");
+			for (size_t i = 0; i < channel->get_voxel_count(); i++) {
+				channel->get_voxel_flat<ScalarVoxel<float>>("doserate", i) = static_cast<float>(i) * 0.37f + offset;
+				channel->get_voxel_flat<ScalarVoxel<double>>("precise", i) = static_cast<double>(i) * 0.37 + offset;
+				channel->get_voxel_flat<ScalarVoxel<int>>("counts", i) = static_cast<int>(i) + static_cast<int>(offset);
+				channel->get_voxel_flat<ScalarVoxel<glm::vec3>>("dirs", i) = glm::vec3(static_cast<float>(i), offset, -offset);
+				channel->get_voxel_flat<HistogramVoxel>("spectra", i).get_histogram()[i % 5] = offset;
+			}
+			return channel;
+		};
+
+		std::shared_ptr<VoxelGridBuffer> a = make_field(3.f);
+		std::shared_ptr<VoxelGridBuffer> b = make_field(1.f);
+		const size_t vx_count = a->get_voxel_count();
+
+		std::vector<std::shared_ptr<VoxelBuffer>> results;
+		const Kernels::InstructionSet supported = Kernels::get_supported_instruction_set();
+		for (int isa = 0; isa <= static_cast<int>(supported); isa++) {
+			EXPECT_EQ(Kernels::set_instruction_set(static_cast<Kernels::InstructionSet>(isa)), static_cast<Kernels::InstructionSet>(isa));
+			std::shared_ptr<VoxelBuffer> result(a->copy());
+			*result += *b;
+			*result *= *b;
+			*result -= 0.5f;
+			*result /= *b;
+			*result *= 2.f;
+			*result -= *b;
+			*result /= 3.f;
+			*result += 1.f;
+			results.push_back(result);
+		}
+		Kernels::set_instruction_set(supported);
+		EXPECT_EQ(Kernels::get_instruction_set(), supported);
+
+		// all instruction sets yield bitwise identical results
+		for (auto& result : results)
+			EXPECT_TRUE(*result == *results[0]);
+
+		auto& result = results.back();
+		for (size_t i = 0; i < vx_count; i++) {
+			float expected = static_cast<float>(i) * 0.37f + 3.f;
+			float other = static_cast<float>(i) * 0.37f + 1.f;
+			expected = ((((expected + other) * other - 0.5f) / other) * 2.f - other) / 3.f + 1.f;
+			EXPECT_EQ(result->get_voxel_flat<ScalarVoxel<float>>("doserate", i).get_data(), expected);
+			const float* bins = result->get_voxel_flat<HistogramVoxel>("spectra", i).get_histogram().data();
+			for (size_t bin = 0; bin < 5; bin++) {
+				// bins, which are empty in b, are divided to 0
+				const float expected_bin = (bin == i % 5) ? ((((4.f * 1.f - 0.5f) / 1.f) * 2.f - 1.f) / 3.f + 1.f) : (0.f * 2.f / 3.f + 1.f);
+				EXPECT_EQ(bins[bin], expected_bin);
+			}
+		}
+
+		std::shared_ptr<VoxelGridBuffer> mismatch = std::make_shared<VoxelGridBuffer>(glm::vec3(1.f), glm::vec3(0.1f));
+		mismatch->add_layer<float>("doserate", 0.f, "Gy/s");
+		EXPECT_THROW(*make_field(0.f) += *mismatch, std::runtime_error);
+	}
+
+	TEST(VoxelBuffer, ParallelLayerOperations) {
+		auto make_field = [](float offset) {
+			std::shared_ptr<VoxelGridBuffer> channel = std::make_shared<VoxelGridBuffer>(glm::vec3(1.f), glm::vec3(0.01f));
+			channel->add_layer<float>("doserate", 0.f, "Gy/s");
+			channel->add_custom_layer<HistogramVoxel>("spectra", HistogramVoxel(5, 10.f, nullptr), 0.f, "");
+			for (size_t i = 0; i < channel->get_voxel_count(); i++) {
+				channel->get_voxel_flat<ScalarVoxel<float>>("doserate", i) = static_cast<float>(i % 1000) * 0.37f + offset;
+				channel->get_voxel_flat<HistogramVoxel>("spectra", i).get_histogram()[i % 5] = offset;
+			}
+			return channel;
+		};
+
+		std::shared_ptr<VoxelGridBuffer> a = make_field(3.f);
+		std::shared_ptr<VoxelGridBuffer> b = make_field(1.f);
+
+		auto process = [&]() {
+			std::shared_ptr<VoxelBuffer> result(a->copy());
+			*result += *b;
+			*result *= 2.f;
+			*result /= *b;
+			result->merge_data_buffer<float>("doserate", *b, [](const float& x, const float& y) { return x * y + 1.f; });
+			result->merge_voxel_buffer<HistogramVoxel>("spectra", *b, [](const HistogramVoxel& x, const HistogramVoxel& y) {
+				HistogramVoxel merged = x;
+				merged += y;
+				return merged;
+			});
+			return result;
+		};
+
+		EXPECT_EQ(VoxelBuffer::get_worker_count(), 1);
+		std::shared_ptr<VoxelBuffer> sequential = process();
+
+		VoxelBuffer::set_worker_count(8);
+		EXPECT_EQ(VoxelBuffer::get_worker_count(), 8);
+		std::shared_ptr<VoxelBuffer> parallel = process();
+		EXPECT_TRUE(*parallel == *sequential);
+
+		parallel->reinitialize_layer<float>("doserate", 2.5f);
+		parallel->clear_layer<float>("spectra", 0.5f, 5);
+		for (size_t i = 0; i < parallel->get_voxel_count(); i += 997) {
+			EXPECT_EQ(parallel->get_voxel_flat<ScalarVoxel<float>>("doserate", i).get_data(), 2.5f);
+			EXPECT_EQ(parallel->get_voxel_flat<HistogramVoxel>("spectra", i).get_histogram()[4], 0.5f);
+		}
+		EXPECT_EQ(parallel->get_voxel_flat<ScalarVoxel<float>>("doserate", parallel->get_voxel_count() - 1).get_data(), 2.5f);
+
+		// errors of the merge function are rethrown on the calling thread
+		EXPECT_THROW(parallel->merge_data_buffer<float>("doserate", *b, [](const float& x, const float& y) -> float {
+			if (y > 100.f)
+				throw std::runtime_error("merge failed");
+			return x + y;
+		}), std::runtime_error);
+
+		// every index of a parallel loop is processed exactly once, errors are rethrown on the calling thread
+		std::vector<std::atomic<size_t>> visits(1000);
+		VoxelBuffer::parallel_for(visits.size(), 8, [&visits](size_t i) { visits[i]++; });
+		for (auto& visit : visits)
+			EXPECT_EQ(visit.load(), 1);
+		EXPECT_THROW(VoxelBuffer::parallel_for(visits.size(), 8, [](size_t i) {
+			if (i == 500)
+				throw std::runtime_error("body failed");
+		}), std::runtime_error);
+
+		VoxelBuffer::set_worker_count(0);
+		EXPECT_GE(VoxelBuffer::get_worker_count(), 1);
+		VoxelBuffer::set_worker_count(1);
+	}
+
+	TEST(VoxelBuffer, LayerExpressions) {
+		auto make_buffer = [](float offset) {
+			std::shared_ptr<VoxelGridBuffer> channel = std::make_shared<VoxelGridBuffer>(glm::vec3(1.f), glm::vec3(0.02f));
+			channel->add_layer<float>("doserate", 0.f, "Gy/s");
+			channel->add_layer<double>("precise", 0.0, "Gy/s");
+			channel->add_layer<float>("norm", 0.f, "");
+			channel->add_custom_layer<HistogramVoxel>("spectra", HistogramVoxel(32, 10.f, nullptr), 0.f, "");
+			for (size_t i = 0; i < channel->get_voxel_count(); i++) {
+				channel->get_voxel_flat<ScalarVoxel<float>>("doserate", i) = static_cast<float>(i % 1000) * 0.37f + offset;
+				channel->get_voxel_flat<ScalarVoxel<double>>("precise", i) = static_cast<double>(i % 1000) * 0.37 + offset;
+				channel->get_voxel_flat<ScalarVoxel<float>>("norm", i) = static_cast<float>(i % 3);
+				channel->get_voxel_flat<HistogramVoxel>("spectra", i).get_histogram()[i % 32] = offset;
+			}
+			return channel;
+		};
+
+		std::shared_ptr<VoxelGridBuffer> a = make_buffer(3.f);
+		std::shared_ptr<VoxelGridBuffer> b = make_buffer(1.f);
+		const size_t vx_count = a->get_voxel_count();
+
+		// weighted sum of two layers in a single pass
+		const float w1 = 0.25f;
+		const float w2 = 1.5f;
+		LayerExpression weighted = (LayerExpression::layer(*a, "doserate") * w1 + LayerExpression::layer(*b, "doserate") * w2) / (LayerExpression::layer(*b, "norm") + 1.f);
+		EXPECT_EQ(weighted.to_string(), "(((doserate * 0.25) + (doserate * 1.5)) / (norm + 1))");
+		std::shared_ptr<VoxelBuffer> result(a->copy());
+		weighted.evaluate(*result, "doserate");
+		for (size_t i = 0; i < vx_count; i++) {
+			const float expected = (a->get_voxel_flat<ScalarVoxel<float>>("doserate", i).get_data() * w1 + b->get_voxel_flat<ScalarVoxel<float>>("doserate", i).get_data() * w2) / (static_cast<float>(i % 3) + 1.f);
+			EXPECT_FLOAT_EQ(result->get_voxel_flat<ScalarVoxel<float>>("doserate", i).get_data(), expected);
+		}
+
+		// whole buffer expressions yield the same results as the operators of the buffers
+		std::shared_ptr<VoxelBuffer> reference(a->copy());
+		*reference *= 2.f;
+		*reference += *b;
+		*reference -= 0.5f;
+		std::shared_ptr<VoxelBuffer> sequential(b->copy());
+		(LayerExpression::buffer(*a) * 2.f + LayerExpression::buffer(*b) - 0.5f).evaluate(*sequential);
+		EXPECT_TRUE(*sequential == *reference);
+
+		VoxelBuffer::set_worker_count(8);
+		std::shared_ptr<VoxelBuffer> parallel(b->copy());
+		// the destination is an operand as well
+		(LayerExpression::buffer(*a) * 2.f + LayerExpression::buffer(*parallel) - 0.5f).evaluate(*parallel);
+		VoxelBuffer::set_worker_count(1);
+		EXPECT_TRUE(*parallel == *reference);
+		for (size_t i = 0; i < vx_count; i += 101) {
+			const float* expected_bins = reference->get_voxel_flat<HistogramVoxel>("spectra", i).get_histogram().data();
+			const float* bins = parallel->get_voxel_flat<HistogramVoxel>("spectra", i).get_histogram().data();
+			for (size_t bin = 0; bin < 32; bin++)
+				EXPECT_EQ(bins[bin], expected_bins[bin]);
+			EXPECT_EQ(parallel->get_voxel_flat<ScalarVoxel<double>>("precise", i).get_data(), reference->get_voxel_flat<ScalarVoxel<double>>("precise", i).get_data());
+		}
+
+		// a scalar layer is used for all bins of a histogram
+		LayerExpression::divide_or_zero(LayerExpression::layer(*a, "spectra"), LayerExpression::layer(*a, "norm")).evaluate(*result, "spectra");
+		for (size_t i = 0; i < vx_count; i += 7) {
+			const float* bins = result->get_voxel_flat<HistogramVoxel>("spectra", i).get_histogram().data();
+			const float expected = (i % 3 == 0) ? 0.f : 3.f / static_cast<float>(i % 3);
+			EXPECT_EQ(bins[i % 32], expected);
+			EXPECT_EQ(bins[(i + 1) % 32], 0.f);
+		}
+
+		// 32-bit integers above 2^24 are kept exactly
+		std::shared_ptr<VoxelGridBuffer> counts = std::make_shared<VoxelGridBuffer>(glm::vec3(1.f), glm::vec3(0.1f));
+		counts->add_layer<uint32_t>("n", 0, "");
+		counts->add_layer<int>("signed", 0, "");
+		for (size_t i = 0; i < counts->get_voxel_count(); i++) {
+			counts->get_voxel_flat<ScalarVoxel<uint32_t>>("n", i) = 16777217u + static_cast<uint32_t>(i) * 2u;
+			counts->get_voxel_flat<ScalarVoxel<int>>("signed", i) = -16777217 - static_cast<int>(i) * 2;
+		}
+		(LayerExpression::layer(*counts, "n") + 0.f).evaluate(*counts, "n");
+		(LayerExpression::layer(*counts, "signed") + 0.f).evaluate(*counts, "signed");
+		for (size_t i = 0; i < counts->get_voxel_count(); i++) {
+			EXPECT_EQ(counts->get_voxel_flat<ScalarVoxel<uint32_t>>("n", i).get_data(), 16777217u + static_cast<uint32_t>(i) * 2u);
+			EXPECT_EQ(counts->get_voxel_flat<ScalarVoxel<int>>("signed", i).get_data(), -16777217 - static_cast<int>(i) * 2);
+		}
+
+		EXPECT_THROW(LayerExpression::layer(*a, "missing"), VoxelBufferException);
+		EXPECT_THROW(LayerExpression::layer(*a, "spectra").evaluate(*result, "doserate"), VoxelBufferException);
+		std::shared_ptr<VoxelGridBuffer> other_shape = std::make_shared<VoxelGridBuffer>(glm::vec3(1.f), glm::vec3(0.1f));
+		other_shape->add_layer<float>("doserate", 0.f, "Gy/s");
+		EXPECT_THROW(LayerExpression::layer(*other_shape, "doserate").evaluate(*result, "doserate"), VoxelBufferException);
+		// nothing is written, if any layer does not match
+		std::shared_ptr<VoxelBuffer> unchanged(a->copy());
+		EXPECT_THROW((LayerExpression::buffer(*a) + LayerExpression::layer(*a, "spectra")).evaluate(*unchanged), VoxelBufferException);
+		EXPECT_TRUE(*unchanged == *a);
+	}
+
+	TEST(VoxelBuffer, JoinKernels) {
+		auto make_buffer = [](float offset) {
+			std::shared_ptr<VoxelGridBuffer> channel = std::make_shared<VoxelGridBuffer>(glm::vec3(1.f), glm::vec3(0.1f));
+			channel->add_layer<float>("float", 0.f, "");
+			channel->add_layer<double>("double", 0.0, "");
+			channel->add_layer<int>("int", 0, "");
+			channel->add_layer<uint64_t>("uint64", 0, "");
+			channel->add_layer<unsigned long>("uint32", 0, "");
+			channel->add_layer<glm::vec3>("vec3", glm::vec3(0.f), "");
+			channel->add_custom_layer<HistogramVoxel>("hist", HistogramVoxel(5, 10.f, nullptr), 0.f, "");
+			for (size_t i = 0; i < channel->get_voxel_count(); i++) {
+				channel->get_voxel_flat<ScalarVoxel<float>>("float", i) = static_cast<float>(i) * 0.37f + offset;
+				channel->get_voxel_flat<ScalarVoxel<double>>("double", i) = static_cast<double>(i) * 0.37 + offset;
+				channel->get_voxel_flat<ScalarVoxel<int>>("int", i) = static_cast<int>(i) + static_cast<int>(offset);
+				channel->get_voxel_flat<ScalarVoxel<uint64_t>>("uint64", i) = static_cast<uint64_t>(i) * 3 + static_cast<uint64_t>(offset);
+				channel->get_voxel_flat<ScalarVoxel<unsigned long>>("uint32", i) = static_cast<unsigned long>(i) * 7 + static_cast<unsigned long>(offset);
+				channel->get_voxel_flat<ScalarVoxel<glm::vec3>>("vec3", i) = glm::vec3(static_cast<float>(i), offset, -offset);
+				channel->get_voxel_flat<HistogramVoxel>("hist", i).get_histogram()[i % 5] = offset + static_cast<float>(i);
+			}
+			return channel;
+		};
+		auto layer_bytes_equal = [](const VoxelBuffer& a, const VoxelBuffer& b, const std::string& layer) {
+			const size_t bytes = a.get_layer(layer).get_bytes_per_voxel_data() * a.get_voxel_count();
+			return std::memcmp(a.get_layer<char>(layer), b.get_layer<char>(layer), bytes) == 0;
+		};
+
+		const std::vector<FieldJoinMode> modes = { FieldJoinMode::Identity, FieldJoinMode::Add, FieldJoinMode::Mean, FieldJoinMode::Subtract, FieldJoinMode::Divide, FieldJoinMode::Multiply, FieldJoinMode::AddWeighted };
+		const float ratio = 0.3f;
+		for (FieldJoinMode mode : modes) {
+			std::shared_ptr<VoxelGridBuffer> expected = make_buffer(3.f);
+			std::shared_ptr<VoxelGridBuffer> expected_source = make_buffer(1.f);
+			expected->merge_data_buffer<float>("float", *expected_source, ExporterHelpers::get_join_function<float>(mode, ratio));
+			expected->merge_data_buffer<double>("double", *expected_source, ExporterHelpers::get_join_function<double>(mode, ratio));
+			expected->merge_data_buffer<int>("int", *expected_source, ExporterHelpers::get_join_function<int>(mode, ratio));
+			expected->merge_data_buffer<uint64_t>("uint64", *expected_source, ExporterHelpers::get_join_function<uint64_t>(mode, ratio));
+			expected->merge_data_buffer<unsigned long>("uint32", *expected_source, ExporterHelpers::get_join_function<unsigned long>(mode, ratio));
+			expected->merge_data_buffer<glm::vec3>("vec3", *expected_source, ExporterHelpers::get_join_function<glm::vec3>(mode, ratio));
+			expected->merge_voxel_buffer<HistogramVoxel>("hist", *expected_source, ExporterHelpers::get_join_function<HistogramVoxel, float>(mode, ratio));
+
+			std::shared_ptr<VoxelGridBuffer> joined = make_buffer(3.f);
+			std::shared_ptr<VoxelGridBuffer> source = make_buffer(1.f);
+			for (auto& layer : joined->get_layers()) {
+				ExporterHelpers::join_layer(*joined, *source, layer, Typing::Helper::get_dtype(joined->get_type(layer)), mode, ratio);
+				EXPECT_TRUE(layer_bytes_equal(*joined, *expected, layer)) << "layer: " << layer << ", mode: " << static_cast<int>(mode);
+			}
+			// the additional source stays untouched
+			std::shared_ptr<VoxelGridBuffer> original_source = make_buffer(1.f);
+			for (auto& layer : source->get_layers())
+				EXPECT_TRUE(layer_bytes_equal(*source, *original_source, layer));
+		}
+
+		std::shared_ptr<VoxelGridBuffer> chars = std::make_shared<VoxelGridBuffer>(glm::vec3(1.f), glm::vec3(0.1f));
+		chars->add_layer<char>("char", 0, "");
+		EXPECT_THROW(ExporterHelpers::join_layer(*chars, *chars, "char", Typing::DType::Char, FieldJoinMode::Add), RadiationFieldStoreException);
+	}
+
+	TEST(VoxelBuffer, WelfordJoin) {
+		const size_t sample_count = 5;
+		// a large offset makes a naive sum of squares lose all digits of the variance
+		auto sample_value = [](size_t voxel, size_t sample) {
+			return 1000.f + static_cast<float>(voxel) * 0.01f + static_cast<float>(sample * sample) * 0.3f;
+		};
+		auto make_field = [&](size_t sample) {
+			std::shared_ptr<CartesianRadiationField> field = std::make_shared<CartesianRadiationField>(glm::vec3(1.f), glm::vec3(0.1f));
+			std::shared_ptr<VoxelBuffer> channel = field->add_channel("shared");
+			channel->add_layer<float>("doserate", 0.f, "Gy/s");
+			channel->add_layer<uint32_t>("hits", 1, "");
+			for (size_t i = 0; i < channel->get_voxel_count(); i++)
+				channel->get_voxel_flat<ScalarVoxel<float>>("doserate", i) = sample_value(i, sample);
+			return field;
+		};
+		auto join = [](std::shared_ptr<CartesianRadiationField> target, std::shared_ptr<CartesianRadiationField> source) {
+			RadFiled3D::Storage::ExporterHelpers::join_layer(*target->get_channel("shared"), *source->get_channel("shared"), "doserate", Typing::DType::Float, FieldJoinMode::Welford);
+			RadFiled3D::Storage::ExporterHelpers::join_layer(*target->get_channel("shared"), *source->get_channel("shared"), "hits", Typing::DType::UInt32, FieldJoinMode::Welford);
+			return target;
+		};
+		auto check = [&](std::shared_ptr<VoxelBuffer> channel) {
+			ASSERT_TRUE(channel->has_layer("doserate#count"));
+			ASSERT_TRUE(channel->has_layer("doserate#m2"));
+			EXPECT_FALSE(channel->has_layer("hits#count"));
+			EXPECT_FALSE(channel->has_layer("hits#m2"));
+			EXPECT_GT(channel->get_statistical_error("doserate"), 0.f);
+			for (size_t i = 0; i < channel->get_voxel_count(); i += 37) {
+				double mean = 0.0;
+				for (size_t k = 0; k < sample_count; k++)
+					mean += sample_value(i, k);
+				mean /= sample_count;
+				double m2 = 0.0;
+				for (size_t k = 0; k < sample_count; k++)
+					m2 += (sample_value(i, k) - mean) * (sample_value(i, k) - mean);
+
+				EXPECT_EQ(channel->get_voxel_flat<ScalarVoxel<uint32_t>>("doserate#count", i).get_data(), sample_count);
+				EXPECT_EQ(channel->get_voxel_flat<ScalarVoxel<uint32_t>>("hits", i).get_data(), sample_count);
+				EXPECT_NEAR(channel->get_voxel_flat<ScalarVoxel<float>>("doserate", i).get_data(), mean, mean * 1e-6);
+				EXPECT_NEAR(channel->get_voxel_flat<ScalarVoxel<float>>("doserate#m2", i).get_data(), m2, m2 * 1e-4);
+			}
+		};
+
+		// the result does not depend on the order of joining
+		std::shared_ptr<CartesianRadiationField> sequential = make_field(0);
+		for (size_t k = 1; k < sample_count; k++)
+			join(sequential, make_field(k));
+		check(sequential->get_channel("shared"));
+
+		std::shared_ptr<CartesianRadiationField> tree = join(join(make_field(3), make_field(1)), join(join(make_field(4), make_field(0)), make_field(2)));
+		check(tree->get_channel("shared"));
+
+		std::shared_ptr<VoxelBuffer> channel = tree->get_channel("shared");
+		RadFiled3D::Storage::ExporterHelpers::write_welford_uncertainty(*channel, "doserate", "doserate_error");
+		const double n = static_cast<double>(sample_count);
+		for (size_t i = 0; i < channel->get_voxel_count(); i += 37)
+			EXPECT_NEAR(channel->get_voxel_flat<ScalarVoxel<float>>("doserate_error", i).get_data(), std::sqrt(channel->get_voxel_flat<ScalarVoxel<float>>("doserate#m2", i).get_data() / (n * (n - 1.0))), 1e-5);
+
+		// stored fields keep their sample counts and deviations
+		std::vector<std::string> files;
+		for (size_t k = 0; k < sample_count; k++) {
+			files.push_back("test_welford_part" + std::to_string(k) + ".rf3");
+			FieldStore::store(make_field(k), make_test_metadata(), files.back(), StoreVersion::V1);
+		}
+		const std::string joined_file = "test_welford_joined.rf3";
+		FieldStore::store(make_field(0), make_test_metadata(), joined_file, StoreVersion::V1);
+		for (size_t k = 1; k < sample_count; k++)
+			EXPECT_NO_THROW(FieldStore::join(make_field(k), make_test_metadata(), joined_file, FieldJoinMode::Welford));
+		check(std::static_pointer_cast<CartesianRadiationField>(FieldStore::load(joined_file))->get_channel("shared"));
+
+		EXPECT_NO_THROW(FieldStore::merge(files, "test_welford_merged.rf3", FieldJoinMode::Welford, FieldJoinCheckMode::MetadataSimulationSimilar, 2));
+		check(std::static_pointer_cast<CartesianRadiationField>(FieldStore::load("test_welford_merged.rf3"))->get_channel("shared"));
+
+		// only floating point layers have a variance, all others are added
+		std::shared_ptr<CartesianRadiationField> counts = std::make_shared<CartesianRadiationField>(glm::vec3(1.f), glm::vec3(0.1f));
+		counts->add_channel("shared")->add_layer<int32_t>("hits", 1, "");
+		EXPECT_THROW(RadFiled3D::Storage::ExporterHelpers::join_layer_welford(*counts->get_channel("shared"), *counts->get_channel("shared"), "hits", Typing::DType::Int), RadiationFieldStoreException);
+		EXPECT_THROW(RadFiled3D::Storage::ExporterHelpers::write_welford_uncertainty(*counts->get_channel("shared"), "hits", "hits_error"), RadiationFieldStoreException);
+
+		std::remove(joined_file.c_str());
+		std::remove("test_welford_merged.rf3");
+		for (auto& file : files)
+			std::remove(file.c_str());
+	}
 }
@@ -10,6 +10,7 @@
 #include <fstream>
 #include <cstdio>
 #include <thread>
+#include <atomic>
 #include <shared_mutex>
 #ifdef _WIN32
 #include <Windows.h>
@@ -34,6 +35,29 @@ namespace {
 		}
 	};
 
+	/** Creates the metadata of the fields stored by the tests */
+	std::shared_ptr<RadFiled3D::Storage::V1::RadiationFieldMetadata> make_test_metadata() {
+		return std::make_shared<RadFiled3D::Storage::V1::RadiationFieldMetadata>(
+			RadFiled3D::Storage::FiledTypes::V1::RadiationFieldMetadataHeader::Simulation(
+				100,
+				"geom",
+				"FTFP_BERT",
+				RadFiled3D::Storage::FiledTypes::V1::RadiationFieldMetadataHeader::Simulation::XRayTube(
+					glm::vec3(1.f, 0.f, 0.f),
+					glm::vec3(0.f, 0.f, 0.f),
+					100.f,
+					"XRayTube"
+				)
+			),
+			RadFiled3D::Storage::FiledTypes::V1::RadiationFieldMetadataHeader::Software(
+				"test",
+				"1.0",
+				"repo",
+				"commit"
+			)
+		);
+	}
+
 	TEST(Field, CreationAndDestruction) {
 		unsigned long long field_memory_consuption = 0;
 		{
@@ -252,4 +276,123 @@ namespace {
 
 		EXPECT_TRUE(memoryUsed / 1000 < field_memory_consuption + 1);
 	}
+
+	TEST(Memory, CompactLayers) {
+		VoxelLayer::set_compact_by_default(true);
+		std::shared_ptr<CartesianRadiationField> field = std::make_shared<CartesianRadiationField>(glm::vec3(1.f), glm::vec3(0.1f));
+		std::shared_ptr<VoxelGridBuffer> channel = std::static_pointer_cast<VoxelGridBuffer>(field->add_channel("test_channel"));
+
+		channel->add_layer<float>("doserate", 25.3f, "Gy/s");
+		channel->add_custom_layer<HistogramVoxel>("spectra", HistogramVoxel(26, 10.f, nullptr), .123f, "");
+		EXPECT_TRUE(channel->get_layer("doserate").is_compact());
+		EXPECT_TRUE(channel->get_layer("spectra").is_compact());
+
+		const size_t vx_count = channel->get_voxel_count();
+		for (size_t i = 0; i < vx_count; i++) {
+			channel->get_voxel_flat<ScalarVoxel<float>>("doserate", i) = static_cast<float>(i);
+			channel->get_voxel_flat<HistogramVoxel>("spectra", i).get_histogram()[i % 26] = 1.f;
+		}
+		channel->get_voxel<ScalarVoxel<float>>("doserate", 0, 0, 0) = -1.f;
+		EXPECT_EQ(channel->get_layer<float>("doserate")[0], -1.f);
+		EXPECT_EQ(channel->get_layer<float>("doserate")[vx_count - 1], static_cast<float>(vx_count - 1));
+
+		// references stay valid as long as the layer, also when accessed by multiple threads at once
+		ScalarVoxel<float>& first = channel->get_voxel_flat<ScalarVoxel<float>>("doserate", 1);
+		std::vector<std::thread> threads;
+		std::atomic<size_t> moved_references(0);
+		for (size_t t = 0; t < 4; t++)
+			threads.emplace_back([&channel, &moved_references, vx_count]() {
+				for (size_t i = 0; i < vx_count; i++) {
+					if (&channel->get_voxel_flat<ScalarVoxel<float>>("doserate", i) != &channel->get_voxel_flat<ScalarVoxel<float>>("doserate", i))
+						moved_references++;
+				}
+			});
+		for (std::thread& thread : threads)
+			thread.join();
+		EXPECT_EQ(moved_references.load(), 0);
+		EXPECT_EQ(&first, &channel->get_voxel_flat<ScalarVoxel<float>>("doserate", 1));
+		EXPECT_EQ(first.get_data(), 1.f);
+
+		// views stay valid as long as the layer
+		ScalarVoxel<float> first_view = channel->get_voxel_view_flat<ScalarVoxel<float>>("doserate", 1);
+		HistogramVoxel spectrum_view = channel->get_voxel_view<HistogramVoxel>("spectra", 0, 0, 1);
+		for (size_t i = 0; i < vx_count; i++)
+			channel->get_voxel_flat<ScalarVoxel<float>>("doserate", i);
+		EXPECT_EQ(first_view.get_data(), 1.f);
+		first_view = 3.f;
+		EXPECT_EQ(channel->get_layer<float>("doserate")[1], 3.f);
+		first_view = 1.f;
+		EXPECT_EQ(spectrum_view.get_histogram()[channel->get_voxel_idx(0, 0, 1) % 26], 1.f);
+		EXPECT_EQ(spectrum_view.get_bins(), 26u);
+
+		std::shared_ptr<CartesianRadiationField> field_cpy = std::static_pointer_cast<CartesianRadiationField>(field->copy());
+		auto channel_cpy = std::static_pointer_cast<VoxelGridBuffer>(field_cpy->get_channel("test_channel"));
+		EXPECT_TRUE(channel_cpy->get_layer("spectra").is_compact());
+		*channel_cpy += *channel;
+		for (size_t i = 1; i < vx_count; i++) {
+			EXPECT_EQ(channel_cpy->get_voxel_flat<ScalarVoxel<float>>("doserate", i).get_data(), static_cast<float>(i * 2));
+			EXPECT_EQ(channel_cpy->get_voxel_flat<HistogramVoxel>("spectra", i).get_histogram()[i % 26], 2.f);
+		}
+
+		std::shared_ptr<RadFiled3D::Storage::V1::RadiationFieldMetadata> metadata = make_test_metadata();
+		EXPECT_NO_THROW(FieldStore::store(field, metadata, "test01.rf3", StoreVersion::V1));
+		std::shared_ptr<CartesianRadiationField> field2 = std::static_pointer_cast<CartesianRadiationField>(FieldStore::load("test01.rf3"));
+		auto channel2 = field2->get_channel("test_channel");
+		EXPECT_TRUE(channel2->get_layer("doserate").is_compact());
+		for (size_t i = 0; i < vx_count; i++) {
+			EXPECT_EQ(channel2->get_voxel_flat<ScalarVoxel<float>>("doserate", i).get_data(), channel->get_voxel_flat<ScalarVoxel<float>>("doserate", i).get_data());
+			EXPECT_EQ(channel2->get_voxel_flat<HistogramVoxel>("spectra", i).get_histogram()[i % 26], 1.f);
+		}
+		VoxelLayer::set_compact_by_default(false);
+
+		// existing layers can be compacted afterwards
+		auto field3 = std::static_pointer_cast<CartesianRadiationField>(FieldStore::load("test01.rf3"));
+		auto channel3 = field3->get_channel("test_channel");
+		EXPECT_FALSE(channel3->get_layer("doserate").is_compact());
+		channel3->compact_layers();
+		EXPECT_TRUE(channel3->get_layer("doserate").is_compact());
+		EXPECT_TRUE(*channel3 == *channel2);
+		std::remove("test01.rf3");
+	}
+
+	TEST(Memory, LayerAllocators) {
+		std::shared_ptr<CartesianRadiationField> field = std::make_shared<CartesianRadiationField>(glm::vec3(1.f), glm::vec3(0.1f));
+		std::shared_ptr<VoxelGridBuffer> channel = std::static_pointer_cast<VoxelGridBuffer>(field->add_channel("test_channel"));
+		channel->add_layer<float>("doserate", 25.3f, "Gy/s");
+		channel->add_custom_layer<HistogramVoxel>("spectra", HistogramVoxel(26, 10.f, nullptr), .123f, "");
+		EXPECT_EQ(reinterpret_cast<uintptr_t>(channel->get_layer<float>("doserate")) % AlignedLayerAllocator::DEFAULT_ALIGNMENT, 0);
+		EXPECT_EQ(reinterpret_cast<uintptr_t>(channel->get_layer<float>("spectra")) % AlignedLayerAllocator::DEFAULT_ALIGNMENT, 0);
+
+		HugePageLayerAllocator huge_pages;
+		char* huge_buffer = huge_pages.allocate(HugePageLayerAllocator::HUGE_PAGE_BYTES + 1);
+		EXPECT_EQ(reinterpret_cast<uintptr_t>(huge_buffer) % HugePageLayerAllocator::HUGE_PAGE_BYTES, 0);
+		huge_buffer[HugePageLayerAllocator::HUGE_PAGE_BYTES] = 1;
+		huge_pages.deallocate(huge_buffer, HugePageLayerAllocator::HUGE_PAGE_BYTES + 1);
+
+		std::shared_ptr<RadFiled3D::Storage::V1::RadiationFieldMetadata> metadata = make_test_metadata();
+		EXPECT_NO_THROW(FieldStore::store(field, metadata, "test01.rf3", StoreVersion::V1));
+
+		// repeated loads of the same field are served from the buffers of the previous load
+		std::shared_ptr<ArenaLayerAllocator> arena = std::make_shared<ArenaLayerAllocator>(std::make_shared<HugePageLayerAllocator>());
+		ILayerAllocator::set_default(arena);
+		FieldStore::load("test01.rf3");
+		EXPECT_GT(arena->get_cached_bytes(), 0);
+		const size_t cached_bytes = arena->get_cached_bytes();
+		for (size_t i = 0; i < 3; i++) {
+			std::shared_ptr<CartesianRadiationField> loaded = std::static_pointer_cast<CartesianRadiationField>(FieldStore::load("test01.rf3"));
+			EXPECT_TRUE(*loaded->get_channel("test_channel") == *channel);
+		}
+		EXPECT_EQ(arena->get_cached_bytes(), cached_bytes);
+		EXPECT_GT(arena->get_reuse_count(), 0);
+
+		// layers return their buffers to their own allocator, even if the default changed in between
+		std::shared_ptr<IRadiationField> loaded = FieldStore::load("test01.rf3");
+		ILayerAllocator::set_default(nullptr);
+		EXPECT_NE(std::dynamic_pointer_cast<AlignedLayerAllocator>(ILayerAllocator::get_default()), nullptr);
+		loaded.reset();
+		EXPECT_EQ(arena->get_cached_bytes(), cached_bytes);
+
+		arena->release();
+		EXPECT_EQ(arena->get_cached_bytes(), 0);
+	}
 }
\ No newline at end of file
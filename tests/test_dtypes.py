@@ -1,4 +1,4 @@
-from RadFiled3D.RadFiled3D import vec2, vec3, vec4, uvec3, CartesianRadiationField, RadiationFieldMetadataV1, RadiationFieldMetadataHeaderV1, RadiationFieldSimulationMetadataV1, RadiationFieldXRayTubeMetadataV1, RadiationFieldSoftwareMetadataV1
+from RadFiled3D.RadFiled3D import vec2, vec3, vec4, uvec3, DType, LayerExpression, CartesianRadiationField, RadiationFieldMetadataV1, RadiationFieldMetadataHeaderV1, RadiationFieldSimulationMetadataV1, RadiationFieldXRayTubeMetadataV1, RadiationFieldSoftwareMetadataV1
 import pickle
 
 
@@ -81,6 +81,28 @@ def test_radfield():
     assert field_voxels_count.x == 256 and field_voxels_count.y == 51 and field_voxels_count.z == 256
 
 
+def test_layer_expressions():
+    field = CartesianRadiationField(vec3(1, 1, 1), vec3(0.1, 0.1, 0.1))
+    channel = field.add_channel("channel1")
+    channel.add_layer("a", "Gy/s", DType.FLOAT32)
+    channel.add_layer("b", "Gy/s", DType.FLOAT32)
+    channel.add_layer("result", "Gy/s", DType.FLOAT32)
+    channel.get_layer_as_ndarray("a")[:, :, :] = 4.0
+    channel.get_layer_as_ndarray("b")[:, :, :] = 2.0
+
+    a = LayerExpression.layer(channel, "a")
+    b = LayerExpression.layer(channel, "b")
+    expression = (a * 0.5 + b * 3) / b - 1
+    assert expression.to_string() == "((((a * 0.5) + (b * 3)) / b) - 1)"
+    expression.evaluate(channel, "result")
+    result = channel.get_layer_as_ndarray("result")
+    assert result.min() == 3.0 and result.max() == 3.0
+
+    # the destination may be an operand as well
+    (2 * a - b).evaluate(channel, "a")
+    assert channel.get_layer_as_ndarray("a")[0, 0, 0] == 6.0
+
+
 def test_pickle_support():
     v = vec2(1, 2)
     pickled = pickle.dumps(v)
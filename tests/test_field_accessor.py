@@ -1,4 +1,4 @@
-from RadFiled3D.RadFiled3D import CartesianFieldAccessor, PolarFieldAccessor, uvec2, PolarRadiationField, FieldType, FieldStore, StoreVersion, CartesianRadiationField, DType, vec3, RadiationFieldMetadataV1, RadiationFieldSimulationMetadataV1, RadiationFieldXRayTubeMetadataV1, RadiationFieldSoftwareMetadataV1, VoxelCollectionAccessor, VoxelCollectionRequest, VoxelCollection
+from RadFiled3D.RadFiled3D import CartesianFieldAccessor, PolarFieldAccessor, uvec2, PolarRadiationField, FieldType, FieldStore, StoreVersion, LayerCodec, uvec3, CartesianRadiationField, DType, vec3, RadiationFieldMetadataV1, RadiationFieldSimulationMetadataV1, RadiationFieldXRayTubeMetadataV1, RadiationFieldSoftwareMetadataV1, VoxelCollectionAccessor, VoxelCollectionRequest, VoxelCollection
 import numpy as np
 import pickle
 
@@ -96,6 +96,10 @@ def test_accessing_field():
     assert field2.get_voxel_counts() == field.get_voxel_counts()
     assert field2.get_channel("channel1").get_layer_as_ndarray("layer1").dtype == np.float32
 
+    field2 = accessor.access_field_mapped("test06.rf3")
+    assert field2.get_voxel_counts() == field.get_voxel_counts()
+    assert field2.get_channel("channel1").get_layer_as_ndarray("layer1").dtype == np.float32
+
 
 def test_accessing_layer():
     field = CartesianRadiationField(vec3(1, 1, 1), vec3(0.1, 0.1, 0.1))
@@ -113,6 +117,67 @@ def test_accessing_layer():
     assert layer.get_as_ndarray().dtype == np.float32
     assert layer.get_layer().get_unit() == "unit1"
 
+    layer = accessor.access_layer_mapped("test07.rf3", "channel1", "layer1")
+    assert layer.get_as_ndarray().dtype == np.float32
+    assert layer.get_layer().get_unit() == "unit1"
+
+
+def test_indexed_store_version():
+    field = CartesianRadiationField(vec3(1, 1, 1), vec3(0.1, 0.1, 0.1))
+    field.add_channel("channel1")
+    field.get_channel("channel1").add_layer("layer1", "unit1", DType.FLOAT32)
+    FieldStore.store(field, METADATA, "test07_2.rf3", StoreVersion.V2)
+    assert FieldStore.get_store_version("test07_2.rf3") == StoreVersion.V2
+
+    accessor: CartesianFieldAccessor = FieldStore.construct_field_accessor("test07_2.rf3")
+    layer = accessor.access_layer("test07_2.rf3", "channel1", "layer1")
+    assert layer.get_as_ndarray().dtype == np.float32
+    assert layer.get_layer().get_unit() == "unit1"
+
+    loaded_accessor: CartesianFieldAccessor = pickle.loads(pickle.dumps(accessor))
+    assert repr(loaded_accessor) == repr(accessor)
+
+    field2 = FieldStore.load("test07_2.rf3")
+    assert field2.get_voxel_counts() == field.get_voxel_counts()
+
+
+def test_encoded_layers():
+    field = CartesianRadiationField(vec3(1, 1, 1), vec3(0.1, 0.1, 0.1))
+    field.add_channel("channel1")
+    field.get_channel("channel1").add_layer("layer1", "unit1", DType.FLOAT32)
+    field.get_channel("channel1").get_layer_as_ndarray("layer1")[0, 1, 2] = 2.34
+    FieldStore.set_layer_codec(LayerCodec.SHUFFLE_RLE)
+    try:
+        FieldStore.store(field, METADATA, "test07_3.rf3", StoreVersion.V2)
+    finally:
+        FieldStore.set_layer_codec(LayerCodec.RAW)
+
+    accessor: CartesianFieldAccessor = FieldStore.construct_field_accessor("test07_3.rf3")
+    voxel = accessor.access_voxel("test07_3.rf3", "channel1", "layer1", uvec3(0, 1, 2))
+    assert abs(voxel.get_data() - 2.34) < 0.001
+
+    field2 = FieldStore.load("test07_3.rf3")
+    assert np.allclose(field2.get_channel("channel1").get_layer_as_ndarray("layer1"), field.get_channel("channel1").get_layer_as_ndarray("layer1"))
+
+
+def test_subvolume_access():
+    field = CartesianRadiationField(vec3(1, 1, 1), vec3(0.1, 0.1, 0.1))
+    field.add_channel("channel1")
+    field.get_channel("channel1").add_layer("layer1", "unit1", DType.FLOAT32)
+    field.get_channel("channel1").get_layer_as_ndarray("layer1")[:, :, :] = np.arange(1000, dtype=np.float32).reshape((10, 10, 10))
+    FieldStore.set_layer_brick_size(4)
+    try:
+        FieldStore.store(field, METADATA, "test07_4.rf3", StoreVersion.V2)
+    finally:
+        FieldStore.set_layer_brick_size(0)
+
+    accessor: CartesianFieldAccessor = FieldStore.construct_field_accessor("test07_4.rf3")
+    subvolume = accessor.access_subvolume("test07_4.rf3", "channel1", "layer1", uvec3(1, 2, 3), uvec3(5, 6, 7))
+    expected = field.get_channel("channel1").get_layer_as_ndarray("layer1")[3:7, 2:6, 1:5]
+    assert np.array_equal(subvolume.get_as_ndarray(), expected)
+    subvolume = accessor.access_subvolume_mapped("test07_4.rf3", "channel1", "layer1", uvec3(1, 2, 3), uvec3(5, 6, 7))
+    assert np.array_equal(subvolume.get_as_ndarray(), expected)
+
 
 def test_accessing_voxel():
     field = CartesianRadiationField(vec3(1, 1, 1), vec3(0.1, 0.1, 0.1))
@@ -181,6 +246,11 @@ def test_multi_voxel_accessing():
     assert histogram1.shape[0] == 7
     assert histogram1.shape[-1] == hist1_target.shape[-1]
 
+    # the arrays are views onto the buffers of the collection and keep them alive
+    assert not layer1.flags.owndata
+    del collection
+    assert layer1[0] == 1.0
+
     for i in range(0, 4):
         assert layer1[i] == 1.0
         assert layer2[i] == 2.0
@@ -191,3 +261,46 @@ def test_multi_voxel_accessing():
 
     for i in range(0, 6):
         assert (histogram1[i] == hist1_target[i, 0, 0]).all(), "Histograms should be equal after accessing the first field"
+
+
+def test_parallel_multi_voxel_accessing():
+    test_multi_voxel_accessing()
+    accessor = FieldStore.construct_field_accessor("test09.rf3")
+    req = [
+        VoxelCollectionRequest("test10.rf3" if i % 2 else "test09.rf3", np.array([i % 5, 2, 0], dtype=np.int32))
+        for i in range(0, 16)
+    ]
+
+    serial = VoxelCollectionAccessor(accessor, ["channel1"], ["layer1", "histogram1"]).access(req)
+    vx_accessor = VoxelCollectionAccessor(accessor, ["channel1"], ["layer1", "histogram1"], worker_count=4)
+    assert vx_accessor.get_worker_count() == 4
+    parallel = vx_accessor.access(req)
+
+    for layer in ["layer1", "histogram1"]:
+        assert (serial.get_as_ndarray("channel1", layer) == parallel.get_as_ndarray("channel1", layer)).all()
+
+
+def test_threaded_accessing():
+    from concurrent.futures import ThreadPoolExecutor
+
+    field = CartesianRadiationField(vec3(1, 1, 1), vec3(0.1, 0.1, 0.1))
+    field.add_channel("channel1")
+    field.get_channel("channel1").add_layer("layer1", "unit1", DType.FLOAT32)
+    field.get_channel("channel1").get_layer_as_ndarray("layer1")[:] = 4.0
+    FieldStore.store(field, METADATA, "test12.rf3", StoreVersion.V1)
+
+    # accessors and the field store are shared between threads, while the GIL is released during loading
+    accessor: CartesianFieldAccessor = FieldStore.construct_field_accessor("test12.rf3")
+
+    def load(i: int) -> float:
+        if i % 3 == 0:
+            return float(FieldStore.load("test12.rf3").get_channel("channel1").get_layer_as_ndarray("layer1").sum())
+        elif i % 3 == 1:
+            return float(accessor.access_layer("test12.rf3", "channel1", "layer1").get_as_ndarray().sum())
+        return float(accessor.access_field("test12.rf3").get_channel("channel1").get_layer_as_ndarray("layer1").sum())
+
+    expected = float(field.get_channel("channel1").get_layer_as_ndarray("layer1").sum())
+    with ThreadPoolExecutor(max_workers=4) as executor:
+        sums = list(executor.map(load, range(0, 24)))
+
+    assert all(s == expected for s in sums)